@@ -2,16 +2,16 @@
  * Description: Contains functions for Rigid Body Dynamics.
  */
 
-#include "physics.h"
+#include "simulation.h"
 
 /* Function: defaultDeform
  * Description: Turns off the Rigid Body Dynamics.
- * Input: None
+ * Input: world - world holding the default stiffness
  * Output: None
  */
-void defaultDeform(phyzx *phyzxObj)
+void defaultDeform(phyzx *phyzxObj, simWorld *world)
 {
-	phyzxObj->alpha = gAlpha;
+	phyzxObj->alpha = world->alpha;
 } //end defaultDeform
 
 /* Function: rigidBody
@@ -0,0 +1,168 @@
+/* Source: broadPhase
+ * Description: Sweep and prune broad phase finding the models whose bounding spheres touch.
+ */
+
+#include <stdlib.h>
+#include "broadPhase.h"
+
+// qsort order of the entries: lowest x first, model array index for equal x
+static int compareEntries(const void *a, const void *b)
+{
+	const sapEntry *first = (const sapEntry *)a;
+	const sapEntry *second = (const sapEntry *)b;
+
+	if (first->min != second->min)
+		return (first->min < second->min) ? -1 : 1;
+	return first->slot - second->slot;
+}
+
+// qsort order of the pairs: by first model, then by second model
+static int comparePairs(const void *a, const void *b)
+{
+	const int *first = (const int *)a;
+	const int *second = (const int *)b;
+
+	if (first[0] != second[0])
+		return first[0] - second[0];
+	return first[1] - second[1];
+}
+
+// Constructor
+broadPhase::broadPhase()
+{
+	numPairs = 0;
+	pairs = NULL;
+	entries = NULL;
+	numEntries = 0;
+	entryCapacity = 0;
+	pairCapacity = 0;
+	partnerStart = (int *)calloc(1, sizeof(int));
+	partners = NULL;
+	fill = NULL;
+}
+
+// Destructor
+broadPhase::~broadPhase()
+{
+	free(pairs);
+	free(entries);
+	free(partnerStart);
+	free(partners);
+	free(fill);
+}
+
+/* Function: Update
+ * Description: Finds every pair of models whose bounding spheres touch, and the partners of every model
+ * Input: models - the models, with their bounding spheres (cModel, radius) up to date
+ *		  numModels - number of models
+ *		  reordered - the models array changed since the last Update (models added or removed)
+ * Output: None
+ */
+void broadPhase::Update(pModel **models, int numModels, bool reordered)
+{
+	sapEntry entry;
+	pModel *first, *second;
+	int j;
+
+	if (reordered || numModels != numEntries)
+	{
+		Resize(numModels);
+		for (int i = 0; i < numModels; i++)
+		{
+			entries[i].min = models[i]->cModel.x - models[i]->radius;
+			entries[i].max = models[i]->cModel.x + models[i]->radius;
+			entries[i].slot = i;
+		}
+		qsort(entries, numModels, sizeof(sapEntry), compareEntries);
+	} //end if
+	else
+	{
+		// Insertion sort of the order of the last timestep
+		for (int i = 0; i < numModels; i++)
+		{
+			first = models[entries[i].slot];
+			entries[i].min = first->cModel.x - first->radius;
+			entries[i].max = first->cModel.x + first->radius;
+		}
+		for (int i = 1; i < numModels; i++)
+		{
+			entry = entries[i];
+			for (j = i; j > 0 && compareEntries(&entry, &entries[j - 1]) < 0; j--)
+				entries[j] = entries[j - 1];
+			entries[j] = entry;
+		}
+	} //end else
+
+	// Sweep: only the models starting inside the x interval of a model can touch it
+	numPairs = 0;
+	for (int i = 0; i < numModels; i++)
+	{
+		first = models[entries[i].slot];
+		for (j = i + 1; j < numModels && entries[j].min <= entries[i].max; j++)
+		{
+			second = models[entries[j].slot];
+			if (SphereCollisionDetection(first->cModel, second->cModel, first->radius, second->radius))
+			{
+				if (entries[i].slot < entries[j].slot)
+					AddPair(entries[i].slot, entries[j].slot);
+				else
+					AddPair(entries[j].slot, entries[i].slot);
+			} //end if
+		} //end for
+	} //end for
+
+	qsort(pairs, numPairs, 2 * sizeof(int), comparePairs);
+
+	// Partner lists. The pairs are sorted, so every list comes out sorted
+	memset( (void*)partnerStart, 0, (numModels + 1) * sizeof(int));
+	for (int i = 0; i < numPairs; i++)
+	{
+		partnerStart[pairs[2*i] + 1]++;
+		partnerStart[pairs[2*i + 1] + 1]++;
+	}
+	for (int i = 0; i < numModels; i++)
+	{
+		partnerStart[i + 1] += partnerStart[i];
+		fill[i] = partnerStart[i];
+	}
+	for (int i = 0; i < numPairs; i++)
+	{
+		partners[fill[pairs[2*i]]++] = pairs[2*i + 1];
+		partners[fill[pairs[2*i + 1]]++] = pairs[2*i];
+	}
+} //end Update
+
+/* Function: Resize
+ * Description: Makes room for the entries and partner lists of numModels models
+ * Input: numModels - number of models
+ * Output: None
+ */
+void broadPhase::Resize(int numModels)
+{
+	if (numModels > entryCapacity)
+	{
+		entryCapacity = numModels;
+		entries = (sapEntry *)realloc(entries, entryCapacity * sizeof(sapEntry));
+		partnerStart = (int *)realloc(partnerStart, (entryCapacity + 1) * sizeof(int));
+		fill = (int *)realloc(fill, entryCapacity * sizeof(int));
+	}
+	numEntries = numModels;
+}
+
+/* Function: AddPair
+ * Description: Appends the pair (a, b) to the pairs and makes room for it in the partner lists
+ * Input: a, b - model array indices of the two models, a < b
+ * Output: None
+ */
+void broadPhase::AddPair(int a, int b)
+{
+	if (numPairs == pairCapacity)
+	{
+		pairCapacity = (pairCapacity == 0) ? 64 : 2 * pairCapacity;
+		pairs = (int *)realloc(pairs, 2 * pairCapacity * sizeof(int));
+		partners = (int *)realloc(partners, 2 * pairCapacity * sizeof(int));
+	}
+	pairs[2*numPairs] = a;
+	pairs[2*numPairs + 1] = b;
+	numPairs++;
+}
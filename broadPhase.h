@@ -0,0 +1,52 @@
+/* Header: broadPhase
+ * Description: Header file for the broad phase of the model-model collisions.
+ *				The bounding spheres of the models are swept along the x axis (sweep and prune):
+ *				the models are kept sorted by the lowest x of their sphere, and only the models
+ *				whose x intervals overlap are tested against each other. The order of the last
+ *				timestep is sorted again with an insertion sort, which is close to linear since
+ *				the models move little between two timesteps.
+ *				Update emits every touching pair once, and the partners of every model sorted by
+ *				their index in the model array, so the contact forces are always added in the
+ *				same order.
+ */
+
+#ifndef _BROADPHASE_H_
+#define _BROADPHASE_H_
+
+#include "physics.h"
+
+// x interval of the bounding sphere of one model
+struct sapEntry
+{
+	double min;
+	double max;
+	int slot;						// Index of the model in the model array
+};
+
+class broadPhase
+{
+public:
+		broadPhase();
+		~broadPhase();
+
+		void Update(pModel **models, int numModels, bool reordered);
+		int NumPartners(int slot) { return partnerStart[slot + 1] - partnerStart[slot]; }
+		int * Partners(int slot) { return partners + partnerStart[slot]; }
+
+		int numPairs;					// Number of touching pairs found by the last Update
+		int *pairs;						// Pairs (pairs[2i] < pairs[2i + 1]) as model array indices, sorted
+
+protected:
+		void Resize(int numModels);
+		void AddPair(int a, int b);
+
+		sapEntry *entries;				// Models sorted by the lowest x of their bounding sphere
+		int numEntries;
+		int entryCapacity;
+		int pairCapacity;
+		int *partnerStart;				// Partners of model i are partners[partnerStart[i] .. partnerStart[i + 1])
+		int *partners;
+		int *fill;						// Next free partner of every model while building the lists
+};
+
+#endif
@@ -0,0 +1,487 @@
+/* Source: bvh
+ * Description: Bounding volume hierarchy of the triangles of a model, refitted every timestep.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bvh.h"
+
+// Squared distance from p to the box of node, 0 inside
+static double boxDistance2(const bvhNode *node, point p)
+{
+	double c[3] = { p.x, p.y, p.z };
+	double d, dist = 0.0;
+
+	for (int k = 0; k < 3; k++)
+	{
+		d = 0.0;
+		if (c[k] < node->min[k])
+			d = node->min[k] - c[k];
+		else if (c[k] > node->max[k])
+			d = c[k] - node->max[k];
+		dist += d * d;
+	}
+	return dist;
+}
+
+// The boxes of a and b, grown by margin, overlap
+static bool boxOverlap(const bvhNode *a, const bvhNode *b, double margin)
+{
+	for (int k = 0; k < 3; k++)
+		if (a->min[k] - margin > b->max[k] || b->min[k] - margin > a->max[k])
+			return false;
+	return true;
+}
+
+/* Function: closestPointOnTriangle
+ * Description: Closest point of the triangle abc to p, by the Voronoi region of p
+ * Input: p - point
+ *		  a, b, c - vertices of the triangle
+ * Output: bary - weights of a, b and c giving the closest point
+ */
+static void closestPointOnTriangle(point p, point a, point b, point c, double bary[3])
+{
+	point ab, ac, ap, bp, cp;
+	double d1, d2, d3, d4, d5, d6, va, vb, vc, v, w, denom;
+
+	pDIFFERENCE(b, a, ab);
+	pDIFFERENCE(c, a, ac);
+	pDIFFERENCE(p, a, ap);
+	d1 = dotProd(ab, ap);
+	d2 = dotProd(ac, ap);
+	if (d1 <= 0.0 && d2 <= 0.0)
+	{
+		bary[0] = 1.0; bary[1] = 0.0; bary[2] = 0.0;		// vertex a
+		return;
+	}
+
+	pDIFFERENCE(p, b, bp);
+	d3 = dotProd(ab, bp);
+	d4 = dotProd(ac, bp);
+	if (d3 >= 0.0 && d4 <= d3)
+	{
+		bary[0] = 0.0; bary[1] = 1.0; bary[2] = 0.0;		// vertex b
+		return;
+	}
+
+	vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+	{
+		v = d1 / (d1 - d3);									// edge ab
+		bary[0] = 1.0 - v; bary[1] = v; bary[2] = 0.0;
+		return;
+	}
+
+	pDIFFERENCE(p, c, cp);
+	d5 = dotProd(ab, cp);
+	d6 = dotProd(ac, cp);
+	if (d6 >= 0.0 && d5 <= d6)
+	{
+		bary[0] = 0.0; bary[1] = 0.0; bary[2] = 1.0;		// vertex c
+		return;
+	}
+
+	vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+	{
+		w = d2 / (d2 - d6);									// edge ac
+		bary[0] = 1.0 - w; bary[1] = 0.0; bary[2] = w;
+		return;
+	}
+
+	va = d3 * d6 - d5 * d4;
+	if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+	{
+		w = (d4 - d3) / ((d4 - d3) + (d5 - d6));			// edge bc
+		bary[0] = 0.0; bary[1] = 1.0 - w; bary[2] = w;
+		return;
+	}
+
+	denom = 1.0 / (va + vb + vc);							// inside the face
+	v = vb * denom;
+	w = vc * denom;
+	bary[0] = 1.0 - v - w; bary[1] = v; bary[2] = w;
+}
+
+/* Function: bvh
+ * Description: Builds the tree of the triangles around the given positions
+ * Input: triangles - vertex indices of the triangles, 3 per triangle, starting from 0
+ *		  numTriangles - number of triangles
+ *		  position - positions of the vertices
+ */
+bvh::bvh(const int *triangles, int numTriangles, soaVec position)
+{
+	double *centers;
+
+	this->numTriangles = numTriangles;
+	this->triangles = (int *)malloc(3 * (numTriangles > 0 ? numTriangles : 1) * sizeof(int));
+	memcpy(this->triangles, triangles, 3 * numTriangles * sizeof(int));
+	order = (int *)malloc((numTriangles > 0 ? numTriangles : 1) * sizeof(int));
+	nodes = (bvhNode *)calloc(2 * numTriangles + 1, sizeof(bvhNode));
+	numNodes = 1;
+
+	centers = (double *)malloc(3 * (numTriangles > 0 ? numTriangles : 1) * sizeof(double));
+	for (int t = 0; t < numTriangles; t++)
+	{
+		order[t] = t;
+		centers[3*t] = (position.x[triangles[3*t]] + position.x[triangles[3*t + 1]] + position.x[triangles[3*t + 2]]) / 3.0;
+		centers[3*t + 1] = (position.y[triangles[3*t]] + position.y[triangles[3*t + 1]] + position.y[triangles[3*t + 2]]) / 3.0;
+		centers[3*t + 2] = (position.z[triangles[3*t]] + position.z[triangles[3*t + 1]] + position.z[triangles[3*t + 2]]) / 3.0;
+	}
+
+	Build(0, 0, numTriangles, centers);
+	free(centers);
+
+	Refit(position);
+}
+
+/* Function: bvh
+ * Description: Copies the tree of other, to be refitted to positions of its own
+ * Input: other - tree of the same triangles
+ */
+bvh::bvh(const bvh *other)
+{
+	int size;
+
+	numTriangles = other->numTriangles;
+	size = (numTriangles > 0 ? numTriangles : 1);
+	numNodes = other->numNodes;
+	triangles = (int *)malloc(3 * size * sizeof(int));
+	memcpy(triangles, other->triangles, 3 * numTriangles * sizeof(int));
+	order = (int *)malloc(size * sizeof(int));
+	memcpy(order, other->order, numTriangles * sizeof(int));
+	nodes = (bvhNode *)malloc((2 * numTriangles + 1) * sizeof(bvhNode));
+	memcpy(nodes, other->nodes, (2 * numTriangles + 1) * sizeof(bvhNode));
+}
+
+// Empty tree, filled in by Read
+bvh::bvh()
+{
+	numTriangles = 0;
+	triangles = NULL;
+	nodes = NULL;
+	numNodes = 0;
+	order = NULL;
+}
+
+// Destructor
+bvh::~bvh()
+{
+	free(triangles);
+	free(order);
+	free(nodes);
+}
+
+/* Function: Read
+ * Description: Reads a tree written by Write
+ * Input: file - file positioned at the tree
+ *		  numTriangles - number of triangles the tree has to be made of
+ * Output: the tree, or NULL if the file holds another tree or ends before it
+ */
+bvh * bvh::Read(FILE *file, int numTriangles)
+{
+	bvh *tree = new bvh();
+	int size = (numTriangles > 0 ? numTriangles : 1);
+
+	if (fread(&tree->numTriangles, sizeof(int), 1, file) != 1 || fread(&tree->numNodes, sizeof(int), 1, file) != 1 ||
+		tree->numTriangles != numTriangles || tree->numNodes < 1 || tree->numNodes > 2 * numTriangles + 1)
+	{
+		delete tree;
+		return NULL;
+	} //end if
+
+	tree->triangles = (int *)malloc(3 * size * sizeof(int));
+	tree->order = (int *)malloc(size * sizeof(int));
+	tree->nodes = (bvhNode *)calloc(2 * numTriangles + 1, sizeof(bvhNode));
+	if (fread(tree->triangles, sizeof(int), 3 * numTriangles, file) != (size_t)(3 * numTriangles) ||
+		fread(tree->order, sizeof(int), numTriangles, file) != (size_t)numTriangles ||
+		fread(tree->nodes, sizeof(bvhNode), tree->numNodes, file) != (size_t)tree->numNodes)
+	{
+		delete tree;
+		return NULL;
+	} //end if
+
+	return tree;
+}
+
+/* Function: Write
+ * Description: Writes the triangles and the nodes of the tree, to be read back by Read
+ * Input: file - file to write to
+ * Output: true if everything was written
+ */
+bool bvh::Write(FILE *file)
+{
+	return fwrite(&numTriangles, sizeof(int), 1, file) == 1 && fwrite(&numNodes, sizeof(int), 1, file) == 1 &&
+		fwrite(triangles, sizeof(int), 3 * numTriangles, file) == (size_t)(3 * numTriangles) &&
+		fwrite(order, sizeof(int), numTriangles, file) == (size_t)numTriangles &&
+		fwrite(nodes, sizeof(bvhNode), numNodes, file) == (size_t)numNodes;
+}
+
+/* Function: Build
+ * Description: Makes node a leaf of the triangles order[begin .. end), or splits them in two halves
+ *				along the longest axis of their centers and builds the two children
+ * Input: node - index of the node
+ *		  begin, end - range of triangles in order
+ *		  centers - centers of the triangles
+ * Output: None
+ */
+void bvh::Build(int node, int begin, int end, const double *centers)
+{
+	double lo[3], hi[3], pivot;
+	int axis, mid, left, right, i, j, swap;
+
+	nodes[node].first = begin;
+	nodes[node].count = end - begin;
+	if (end - begin <= BVHLEAF)
+		return;
+
+	for (int k = 0; k < 3; k++)
+	{
+		lo[k] = HUGE_VAL;
+		hi[k] = -HUGE_VAL;
+	}
+	for (i = begin; i < end; i++)
+		for (int k = 0; k < 3; k++)
+		{
+			if (centers[3*order[i] + k] < lo[k])
+				lo[k] = centers[3*order[i] + k];
+			if (centers[3*order[i] + k] > hi[k])
+				hi[k] = centers[3*order[i] + k];
+		}
+
+	axis = 0;
+	if (hi[1] - lo[1] > hi[axis] - lo[axis])
+		axis = 1;
+	if (hi[2] - lo[2] > hi[axis] - lo[axis])
+		axis = 2;
+
+	// Quickselect: order[begin .. mid) have centers no greater than order[mid .. end)
+	mid = (begin + end) / 2;
+	left = begin;
+	right = end - 1;
+	while (left < right)
+	{
+		pivot = centers[3*order[(left + right) / 2] + axis];
+		i = left;
+		j = right;
+		while (i <= j)
+		{
+			while (centers[3*order[i] + axis] < pivot)
+				i++;
+			while (centers[3*order[j] + axis] > pivot)
+				j--;
+			if (i <= j)
+			{
+				swap = order[i];
+				order[i] = order[j];
+				order[j] = swap;
+				i++;
+				j--;
+			}
+		}
+		if (mid <= j)
+			right = j;
+		else if (mid >= i)
+			left = i;
+		else
+			break;
+	}
+
+	nodes[node].first = numNodes;
+	nodes[node].count = 0;
+	numNodes += 2;
+	Build(nodes[node].first, begin, mid, centers);
+	Build(nodes[node].first + 1, mid, end, centers);
+}
+
+/* Function: LeafBox
+ * Description: Box around the triangles of a leaf
+ * Input: node - leaf
+ *		  position - positions of the vertices
+ * Output: None
+ */
+void bvh::LeafBox(bvhNode *node, soaVec position)
+{
+	int v;
+
+	for (int k = 0; k < 3; k++)
+	{
+		node->min[k] = HUGE_VAL;
+		node->max[k] = -HUGE_VAL;
+	}
+
+	for (int t = node->first; t < node->first + node->count; t++)
+		for (int corner = 0; corner < 3; corner++)
+		{
+			v = triangles[3*order[t] + corner];
+			if (position.x[v] < node->min[0]) node->min[0] = position.x[v];
+			if (position.x[v] > node->max[0]) node->max[0] = position.x[v];
+			if (position.y[v] < node->min[1]) node->min[1] = position.y[v];
+			if (position.y[v] > node->max[1]) node->max[1] = position.y[v];
+			if (position.z[v] < node->min[2]) node->min[2] = position.z[v];
+			if (position.z[v] > node->max[2]) node->max[2] = position.z[v];
+		}
+}
+
+/* Function: Refit
+ * Description: Fits every box to the current positions, leaves first and then the inner nodes
+ *				from the bottom of the tree up
+ * Input: position - positions of the vertices
+ * Output: None
+ */
+void bvh::Refit(soaVec position)
+{
+	bvhNode *node, *left, *right;
+
+	for (int n = numNodes - 1; n >= 0; n--)
+	{
+		node = &nodes[n];
+		if (node->count > 0 || numTriangles == 0)
+		{
+			LeafBox(node, position);
+			continue;
+		}
+
+		left = &nodes[node->first];
+		right = &nodes[node->first + 1];
+		for (int k = 0; k < 3; k++)
+		{
+			node->min[k] = (left->min[k] < right->min[k]) ? left->min[k] : right->min[k];
+			node->max[k] = (left->max[k] > right->max[k]) ? left->max[k] : right->max[k];
+		}
+	}
+}
+
+/* Function: Candidates
+ * Description: Vertices of this tree's triangles lying within margin of the box of other. Only the
+ *				nodes of this tree overlapping that box are visited; the exact distances to the
+ *				triangles of other are left to ClosestTriangle.
+ * Input: position - positions of the vertices of this tree
+ *		  other - tree of the other model
+ *		  margin - distance added to the boxes
+ *		  stamp - one entry per vertex, set to stampValue for the vertices already listed
+ *		  stampValue - value not yet found in stamp
+ * Output: list - the vertices found. Returns their number
+ */
+int bvh::Candidates(soaVec position, const bvh *other, double margin, int *stamp, int stampValue, int *list)
+{
+	int stack[BVHSTACK];
+	int top, count = 0, v;
+	const bvhNode *node, *box = &other->nodes[0];
+	point p;
+
+	if (numTriangles == 0 || other->numTriangles == 0)
+		return 0;
+
+	stack[0] = 0;
+	top = 1;
+	while (top > 0)
+	{
+		node = &nodes[stack[--top]];
+		if (!boxOverlap(node, box, margin))
+			continue;
+
+		if (node->count == 0)
+		{
+			if (top + 2 > BVHSTACK)
+				continue;				// Deeper than any tree split in halves can be
+			stack[top++] = node->first + 1;
+			stack[top++] = node->first;
+			continue;
+		}
+
+		for (int t = node->first; t < node->first + node->count; t++)
+			for (int corner = 0; corner < 3; corner++)
+			{
+				v = triangles[3*order[t] + corner];
+				if (stamp[v] == stampValue)
+					continue;
+				stamp[v] = stampValue;
+
+				p.x = position.x[v];
+				p.y = position.y[v];
+				p.z = position.z[v];
+				if (boxDistance2(box, p) <= margin * margin)
+					list[count++] = v;
+			}
+	} //end while
+
+	return count;
+}
+
+/* Function: ClosestTriangle
+ * Description: Triangle closest to p, among those nearer than maxDist
+ * Input: position - positions of the vertices of this tree
+ *		  p - point
+ *		  maxDist - largest distance searched
+ * Output: closest - closest point of the triangle
+ *		   bary - weights of the triangle vertices giving closest
+ *		   Returns the triangle, or -1 when none is nearer than maxDist
+ */
+int bvh::ClosestTriangle(soaVec position, point p, double maxDist, point *closest, double bary[3])
+{
+	int stack[BVHSTACK];
+	int top, found = -1, tri, *v;
+	double best = maxDist * maxDist, dist, weights[3];
+	const bvhNode *node;
+	point a, b, c, q, d;
+
+	if (numTriangles == 0)
+		return -1;
+
+	stack[0] = 0;
+	top = 1;
+	while (top > 0)
+	{
+		node = &nodes[stack[--top]];
+		if (boxDistance2(node, p) > best)
+			continue;
+
+		if (node->count == 0)
+		{
+			if (top + 2 > BVHSTACK)
+				continue;
+
+			// Nearer child on top, so that best shrinks early
+			if (boxDistance2(&nodes[node->first], p) <= boxDistance2(&nodes[node->first + 1], p))
+			{
+				stack[top++] = node->first + 1;
+				stack[top++] = node->first;
+			}
+			else
+			{
+				stack[top++] = node->first;
+				stack[top++] = node->first + 1;
+			}
+			continue;
+		}
+
+		for (int t = node->first; t < node->first + node->count; t++)
+		{
+			tri = order[t];
+			v = &triangles[3*tri];
+			a.x = position.x[v[0]]; a.y = position.y[v[0]]; a.z = position.z[v[0]];
+			b.x = position.x[v[1]]; b.y = position.y[v[1]]; b.z = position.z[v[1]];
+			c.x = position.x[v[2]]; c.y = position.y[v[2]]; c.z = position.z[v[2]];
+
+			closestPointOnTriangle(p, a, b, c, weights);
+			q.x = weights[0] * a.x + weights[1] * b.x + weights[2] * c.x;
+			q.y = weights[0] * a.y + weights[1] * b.y + weights[2] * c.y;
+			q.z = weights[0] * a.z + weights[1] * b.z + weights[2] * c.z;
+			pDIFFERENCE(p, q, d);
+			dist = dotProd(d, d);
+
+			if (dist < best)
+			{
+				best = dist;
+				found = tri;
+				*closest = q;
+				bary[0] = weights[0];
+				bary[1] = weights[1];
+				bary[2] = weights[2];
+			}
+		} //end for
+	} //end while
+
+	return found;
+}
@@ -0,0 +1,55 @@
+/* Header: bvh
+ * Description: Header file for the bounding volume hierarchy of the triangles of a model.
+ *				The tree is built once from the rest positions, with every node splitting its
+ *				triangles in two halves along the longest axis of their centers. After that only
+ *				the boxes are refitted to the deformed positions, bottom up, since a deformation
+ *				keeps neighbouring triangles close to each other.
+ *				Used by the vertex against triangle narrow phase of the model-model contacts.
+ */
+
+#ifndef _BVH_H_
+#define _BVH_H_
+
+#include <stdio.h>
+#include "vector.h"
+
+#define BVHLEAF 4					// Most triangles in a leaf
+#define BVHSTACK 128				// Depth of the traversal stacks, far above the depth of a tree split in halves
+
+// Axis aligned box of a node, with its triangles (leaf) or its children (inner node)
+struct bvhNode
+{
+	double min[3];
+	double max[3];
+	int first;						// Leaf: first triangle in bvh::order. Inner node: index of the left child
+	int count;						// Leaf: number of triangles. Inner node: 0, the right child is first + 1
+};
+
+class bvh
+{
+public:
+		bvh(const int *triangles, int numTriangles, soaVec position);
+		bvh(const bvh *other);
+		~bvh();
+
+		static bvh * Read(FILE *file, int numTriangles);
+		bool Write(FILE *file);
+
+		void Refit(soaVec position);
+		int Candidates(soaVec position, const bvh *other, double margin, int *stamp, int stampValue, int *list);
+		int ClosestTriangle(soaVec position, point p, double maxDist, point *closest, double bary[3]);
+
+		int numTriangles;
+		int *triangles;					// Vertex indices of the triangles, 3 per triangle, starting from 0
+
+protected:
+		bvh();
+		void Build(int node, int begin, int end, const double *centers);
+		void LeafBox(bvhNode *node, soaVec position);
+
+		bvhNode *nodes;					// Root first, the children of a node always come after it
+		int numNodes;
+		int *order;						// Triangles sorted so that every leaf covers a contiguous range
+};
+
+#endif
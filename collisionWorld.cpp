@@ -0,0 +1,244 @@
+/* Source: collisionWorld
+ * Description: Contains the planes and oriented boxes the vertices of the bodies collide with.
+ */
+
+#include "collisionWorld.h"
+
+// Constructor
+collisionWorld::collisionWorld()
+{
+	SetArena(ARENASIZE);
+}
+
+/* Function: Clear
+ * Description: Removes every plane and box, the vertices then collide with nothing
+ * Input: None
+ * Output: None
+ */
+void collisionWorld::Clear()
+{
+	numPlanes = 0;
+	numBoxes = 0;
+	floorY = -HUGE_VAL;
+}
+
+/* Function: SetArena
+ * Description: Replaces the geometry by the six walls of a cube centered on the origin. The walls stand
+ *				as far inside the cube as WALLDIST inside the box of the GUI, so that size ARENASIZE gives
+ *				the walls of the box.
+ * Input: size - half size of the cube
+ * Output: None
+ */
+void collisionWorld::SetArena(double size)
+{
+	double wallDist = size * (WALLDIST / ARENASIZE);
+	point n;
+
+	Clear();
+	this->size = size;
+
+	// Right, left, top, bottom, back and front walls
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			n.x = n.y = n.z = 0.0;
+			if (axis == 0)
+				n.x = (side == 0) ? -1.0 : 1.0;
+			else if (axis == 1)
+				n.y = (side == 0) ? -1.0 : 1.0;
+			else
+				n.z = (side == 0) ? -1.0 : 1.0;
+			AddPlane(n, -wallDist);
+		} //end for
+	} //end for
+
+	floorY = -wallDist;
+}
+
+/* Function: AddPlane
+ * Description: Adds a plane the vertices are kept on the free side of
+ * Input: normal - normal of the plane towards the free side, of any length
+ *		  offset - the vertices x with normal . x <= offset touch the plane, normal taken of unit length
+ * Output: false if there is no room left or the normal is zero
+ */
+bool collisionWorld::AddPlane(point normal, double offset)
+{
+	double len = sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+
+	if (numPlanes == CONTACTPLANES || !(len > 0.0))
+		return false;
+
+	this->normal[numPlanes].x = normal.x / len;
+	this->normal[numPlanes].y = normal.y / len;
+	this->normal[numPlanes].z = normal.z / len;
+	this->offset[numPlanes] = offset;
+	numPlanes++;
+	return true;
+}
+
+/* Function: AddBox
+ * Description: Adds an oriented box the vertices are kept out of. Its third axis is axisX x axisY, and
+ *				axisY is made orthogonal to axisX.
+ * Input: center - center of the box
+ *		  axisX, axisY - directions of the first two axes of the box, of any length
+ *		  half - half extents of the box along its axes
+ * Output: false if there is no room left or the axes are parallel
+ */
+bool collisionWorld::AddBox(point center, point axisX, point axisY, point half)
+{
+	simdContactBox *box;
+	double axis[3][3], len, dot, extent;
+
+	if (numBoxes == CONTACTBOXES)
+		return false;
+
+	len = sqrt(axisX.x * axisX.x + axisX.y * axisX.y + axisX.z * axisX.z);
+	if (!(len > 0.0))
+		return false;
+	axis[0][0] = axisX.x / len;
+	axis[0][1] = axisX.y / len;
+	axis[0][2] = axisX.z / len;
+
+	dot = axis[0][0] * axisY.x + axis[0][1] * axisY.y + axis[0][2] * axisY.z;
+	axis[1][0] = axisY.x - dot * axis[0][0];
+	axis[1][1] = axisY.y - dot * axis[0][1];
+	axis[1][2] = axisY.z - dot * axis[0][2];
+	len = sqrt(axis[1][0] * axis[1][0] + axis[1][1] * axis[1][1] + axis[1][2] * axis[1][2]);
+	if (!(len > 0.0))
+		return false;
+	for (int k = 0; k < 3; k++)
+		axis[1][k] /= len;
+
+	axis[2][0] = axis[0][1] * axis[1][2] - axis[0][2] * axis[1][1];
+	axis[2][1] = axis[0][2] * axis[1][0] - axis[0][0] * axis[1][2];
+	axis[2][2] = axis[0][0] * axis[1][1] - axis[0][1] * axis[1][0];
+
+	box = &boxes[numBoxes];
+	box->center[0] = center.x;
+	box->center[1] = center.y;
+	box->center[2] = center.z;
+	box->half[0] = fabs(half.x);
+	box->half[1] = fabs(half.y);
+	box->half[2] = fabs(half.z);
+	memcpy( (void*)box->axis, axis, sizeof(axis));
+
+	for (int k = 0; k < 3; k++)
+	{
+		extent = BOXSLACK;
+		for (int a = 0; a < 3; a++)
+			extent += fabs(axis[a][k]) * box->half[a];
+		boxLo[numBoxes][k] = box->center[k] - extent;
+		boxHi[numBoxes][k] = box->center[k] + extent;
+	} //end for
+
+	numBoxes++;
+	return true;
+}
+
+/* Function: Gather
+ * Description: Keeps the planes and boxes some vertex of an axis aligned bounding box may touch, in the
+ *				order they were added. A plane is kept when the lowest normal . x over the bounding box
+ *				reaches its offset; as it is rounded like the normal . x of the vertices, no touching
+ *				plane is missed. A box is kept when its own bounding box overlaps.
+ * Input: lo, hi - corners of the bounding box of the vertices
+ * Output: contacts - planes and boxes kept, the other members are left as they are
+ */
+void collisionWorld::Gather(const double lo[3], const double hi[3], simdContactParams *contacts)
+{
+	double nearest[3], n[3];
+	int count = 0;
+
+	for (int i = 0; i < numPlanes; i++)
+	{
+		n[0] = normal[i].x;
+		n[1] = normal[i].y;
+		n[2] = normal[i].z;
+		for (int k = 0; k < 3; k++)
+			nearest[k] = (n[k] * lo[k] < n[k] * hi[k]) ? n[k] * lo[k] : n[k] * hi[k];
+
+		if (nearest[0] + nearest[1] + nearest[2] > offset[i])
+			continue;
+
+		contacts->nx[count] = n[0];
+		contacts->ny[count] = n[1];
+		contacts->nz[count] = n[2];
+		contacts->offset[count] = offset[i];
+		contacts->anchor[count] = offset[i] + WALLPRELOAD;
+		count++;
+	} //end for
+	contacts->numPlanes = count;
+
+	count = 0;
+	for (int i = 0; i < numBoxes; i++)
+	{
+		if (lo[0] > boxHi[i][0] || hi[0] < boxLo[i][0] || lo[1] > boxHi[i][1] || hi[1] < boxLo[i][1] ||
+			lo[2] > boxHi[i][2] || hi[2] < boxLo[i][2])
+			continue;
+		contacts->boxes[count++] = boxes[i];
+	} //end for
+	contacts->numBoxes = count;
+	contacts->preload = WALLPRELOAD;
+}
+
+/* Function: SphereTouches
+ * Description: Tells whether a sphere reaches a plane or the bounding box of a box
+ * Input: center, radius - sphere
+ * Output: true if it does
+ */
+bool collisionWorld::SphereTouches(point center, double radius)
+{
+	double c[3] = { center.x, center.y, center.z };
+
+	for (int i = 0; i < numPlanes; i++)
+		if (normal[i].x * center.x + normal[i].y * center.y + normal[i].z * center.z - radius <= offset[i])
+			return true;
+
+	for (int i = 0; i < numBoxes; i++)
+	{
+		bool overlap = true;
+		for (int k = 0; k < 3; k++)
+			if (c[k] - radius > boxHi[i][k] || c[k] + radius < boxLo[i][k])
+				overlap = false;
+		if (overlap)
+			return true;
+	} //end for
+
+	return false;
+}
+
+/* Function: BoxContact
+ * Description: Tells whether a vertex is inside a box, and the spring pushing it out through the nearest face
+ * Input: box - oriented box
+ *		  preload - spring length at depth 0
+ *		  vertex - position of the vertex
+ * Output: direction - outward normal of the nearest face
+ *		   length - length of the spring, the depth of the vertex below that face plus preload
+ *		   true if the vertex is inside
+ */
+bool collisionWorld::BoxContact(const simdContactBox *box, double preload, point vertex, point *direction, double *length)
+{
+	double d[3], l[3], gap[3], sign;
+	int face = 0;
+
+	d[0] = vertex.x - box->center[0];
+	d[1] = vertex.y - box->center[1];
+	d[2] = vertex.z - box->center[2];
+	for (int a = 0; a < 3; a++)
+	{
+		l[a] = box->axis[a][0] * d[0] + box->axis[a][1] * d[1] + box->axis[a][2] * d[2];
+		gap[a] = box->half[a] - fabs(l[a]);
+		if (!(gap[face] <= gap[a]))
+			face = a;
+	} //end for
+
+	if (gap[face] <= 0.0)
+		return false;
+
+	sign = (0.0 <= l[face]) ? 1.0 : -1.0;
+	direction->x = sign * box->axis[face][0];
+	direction->y = sign * box->axis[face][1];
+	direction->z = sign * box->axis[face][2];
+	*length = gap[face] + preload;
+	return true;
+}
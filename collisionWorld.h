@@ -0,0 +1,53 @@
+/* Header: collisionWorld
+ * Description: Header file for the static geometry the vertices of the bodies collide with: planes that
+ *				keep them on their free side, and oriented boxes that keep them out. By default the planes
+ *				are the six walls of the box drawn by the GUI; SetArena moves them for an arena of any size,
+ *				and AddPlane and AddBox add tilted floors and obstacles.
+ *				A wall is a spring anchored WALLPRELOAD behind the plane, as the walls of the box always
+ *				were: a vertex at depth d is pushed by kWall * m * (d + WALLPRELOAD), plus the damping.
+ *				The preload is the response kWall is tuned for, not an offset to remove.
+ *				Gather keeps the planes and boxes a range of vertices can reach from the bounding box of the
+ *				range, so that the ranges far from every wall, most of a large arena, only pay for the
+ *				reset of their external forces.
+ */
+
+#ifndef _COLLISIONWORLD_H_
+#define _COLLISIONWORLD_H_
+
+#include "physics.h"
+#include "simd.h"
+
+#define ARENASIZE 2.0				// Half size of the default arena, the box drawn by the GUI
+#define WALLPRELOAD (1.0 + WALLDIST)	// Spring length of a wall at depth 0
+#define BOXSLACK 1.0e-9				// Added around the bounding boxes of the boxes, against their rounding
+
+class collisionWorld
+{
+public:
+		collisionWorld();
+
+		void SetArena(double size);
+		void Clear();
+		bool AddPlane(point normal, double offset);
+		bool AddBox(point center, point axisX, point axisY, point half);
+		void Gather(const double lo[3], const double hi[3], simdContactParams *contacts);
+		bool SphereTouches(point center, double radius);
+
+		static bool BoxContact(const simdContactBox *box, double preload, point vertex, point *direction, double *length);
+
+		double size;					// Half size of the arena
+		double floorY;					// y of the floor of the arena, the vertices at or below it rest on it (sticky floor)
+
+		int numPlanes;
+		point normal[CONTACTPLANES];	// Unit normals, towards the free side
+		double offset[CONTACTPLANES];	// A vertex x touches plane i when normal[i] . x <= offset[i]
+
+		int numBoxes;
+		simdContactBox boxes[CONTACTBOXES];
+
+protected:
+		double boxLo[CONTACTBOXES][3];	// Axis aligned bounding box of every box
+		double boxHi[CONTACTBOXES][3];
+};
+
+#endif
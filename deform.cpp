@@ -2,7 +2,7 @@
  * Description: Contains functions that controls the deformation simulation.
  */
 
-//#include "render.h"
+#include "render.h"
 #include "physics.h"
 #include "ui.h"
 #include "world.h"
@@ -46,10 +46,18 @@ void resetModel(phyzx *phyzxObj)
 		phyzxObj->model->vertices[3*i+0] = phyzxObj->model->verticesRest[3*i+0];
 		phyzxObj->model->vertices[3*i+1] = phyzxObj->model->verticesRest[3*i+1];
 		phyzxObj->model->vertices[3*i+2] = phyzxObj->model->verticesRest[3*i+2];
-		phyzxObj->velocity[i] = vMake(0.0);
-		phyzxObj->avgVel = vMake(0.0);
-		phyzxObj->extForce[i] = vMake(0.0);
 	} //end for
+
+	for (int i = 0; i < phyzxObj->numVertices; i++)
+	{
+		phyzxObj->position.x[i] = phyzxObj->model->verticesRest[3*(i+STARTFROM)+0];
+		phyzxObj->position.y[i] = phyzxObj->model->verticesRest[3*(i+STARTFROM)+1];
+		phyzxObj->position.z[i] = phyzxObj->model->verticesRest[3*(i+STARTFROM)+2];
+		soaSet(phyzxObj->velocity, i, vMake(0.0));
+		soaSet(phyzxObj->extForce, i, vMake(0.0));
+	} //end for
+	phyzxObj->avgVel = vMake(0.0);
+	WakeModel(phyzxObj);
 } //end resetModel
 
 /* Function: modelCopy
@@ -79,6 +87,8 @@ void modelCopy(GLMmodel *src, GLMmodel *dest)
     dest->position[0]   = 0.0;
     dest->position[1]   = 0.0;
     dest->position[2]   = 0.0;
+    dest->mapping       = NULL;
+    dest->mappingSize   = 0;
     
 	/* allocate memory for the triangles in each group */
 	GLMgroup *group;
@@ -3,6 +3,7 @@
    domain Java Matrix library JAMA. */
 
 #include <math.h>
+#include "eig3.h"
 
 #ifdef MAX
 #undef MAX
@@ -263,3 +264,229 @@ void eigen_decomposition(double A[n][n], double V[n][n], double d[n]) {
   tred2(V, d, e);
   tql2(V, d, e);
 }
+
+#undef n
+
+/* Closed form eigen decomposition, after D. Eberly, "A Robust Eigensolver for
+   3 x 3 Symmetric Matrices". The vector kernel eigen3 (simdKernels.h) follows
+   the same steps. */
+
+/* Function: eigenIsolated
+ * Description: Eigenvector of an eigenvalue of multiplicity one: the largest cross product of two rows
+ *				of B - lambda I, which are all orthogonal to it
+ * Input: B - shifted and scaled matrix
+ *		  lambda - eigenvalue of B
+ * Output: v - unit eigenvector
+ */
+static void eigenIsolated(const double B[3][3], double lambda, double v[3])
+{
+	double r[3][3], c[3][3], len2[3];
+	int best = 0;
+
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			r[i][j] = B[i][j] - (i == j ? lambda : 0.0);
+
+	for (int k = 0; k < 3; k++)
+	{
+		const double *a = r[k == 2 ? 1 : 0], *b = r[k == 0 ? 1 : 2];
+		c[k][0] = a[1] * b[2] - a[2] * b[1];
+		c[k][1] = a[2] * b[0] - a[0] * b[2];
+		c[k][2] = a[0] * b[1] - a[1] * b[0];
+		len2[k] = c[k][0] * c[k][0] + c[k][1] * c[k][1] + c[k][2] * c[k][2];
+		if (len2[k] > len2[best])
+			best = k;
+	} //end for
+
+	if (len2[best] > 0.0)
+	{
+		double inv = 1.0 / sqrt(len2[best]);
+		v[0] = c[best][0] * inv;
+		v[1] = c[best][1] * inv;
+		v[2] = c[best][2] * inv;
+	} //end if
+	else
+	{
+		v[0] = 1.0;
+		v[1] = v[2] = 0.0;
+	} //end else
+} //end eigenIsolated
+
+/* Function: eigenPlane
+ * Description: Eigenvectors of the two other eigenvalues, in the plane orthogonal to the eigenvector of
+ *				the isolated one. B reduced to an orthonormal basis (u, t) of the plane is a 2x2 symmetric
+ *				matrix, diagonalized by one Jacobi rotation, which stays accurate when the two
+ *				eigenvalues are close or equal.
+ * Input: B - shifted and scaled matrix
+ *		  w - unit eigenvector of the isolated eigenvalue
+ * Output: lo, hi - unit eigenvectors of the smaller and the larger eigenvalue, with lo x hi = w
+ *		   d - smaller and larger eigenvalue
+ */
+static void eigenPlane(const double B[3][3], const double w[3], double lo[3], double hi[3], double d[2])
+{
+	double u[3], t[3], Bu[3], Bt[3], e1[3], e2[3];
+	double inv, m00, m01, m11, tau, tn = 0.0, cs, sn, d1, d2;
+
+	// u, t: orthonormal basis of the plane orthogonal to w, with u x t = w
+	if (fabs(w[0]) > fabs(w[1]))
+	{
+		inv = 1.0 / sqrt(w[0] * w[0] + w[2] * w[2]);
+		u[0] = -w[2] * inv;
+		u[1] = 0.0;
+		u[2] = w[0] * inv;
+	} //end if
+	else
+	{
+		inv = 1.0 / sqrt(w[1] * w[1] + w[2] * w[2]);
+		u[0] = 0.0;
+		u[1] = w[2] * inv;
+		u[2] = -w[1] * inv;
+	} //end else
+	t[0] = w[1] * u[2] - w[2] * u[1];
+	t[1] = w[2] * u[0] - w[0] * u[2];
+	t[2] = w[0] * u[1] - w[1] * u[0];
+
+	for (int i = 0; i < 3; i++)
+	{
+		Bu[i] = B[i][0] * u[0] + B[i][1] * u[1] + B[i][2] * u[2];
+		Bt[i] = B[i][0] * t[0] + B[i][1] * t[1] + B[i][2] * t[2];
+	} //end for
+	m00 = u[0] * Bu[0] + u[1] * Bu[1] + u[2] * Bu[2];
+	m01 = u[0] * Bt[0] + u[1] * Bt[1] + u[2] * Bt[2];
+	m11 = t[0] * Bt[0] + t[1] * Bt[1] + t[2] * Bt[2];
+
+	// Jacobi rotation zeroing m01, tn = tan of its angle
+	if (m01 != 0.0)
+	{
+		tau = (m11 - m00) / (2.0 * m01);
+		tn = 1.0 / (fabs(tau) + sqrt(1.0 + tau * tau));
+		if (tau < 0.0)
+			tn = -tn;
+	} //end if
+	cs = 1.0 / sqrt(1.0 + tn * tn);
+	sn = tn * cs;
+	d1 = m00 - tn * m01;
+	d2 = m11 + tn * m01;
+	for (int i = 0; i < 3; i++)
+	{
+		e1[i] = cs * u[i] - sn * t[i];
+		e2[i] = sn * u[i] + cs * t[i];
+	} //end for
+
+	// e1 x e2 = w, the order is swapped by turning e1 around
+	if (d1 <= d2)
+	{
+		d[0] = d1;
+		d[1] = d2;
+		for (int i = 0; i < 3; i++)
+		{
+			lo[i] = e1[i];
+			hi[i] = e2[i];
+		} //end for
+	} //end if
+	else
+	{
+		d[0] = d2;
+		d[1] = d1;
+		for (int i = 0; i < 3; i++)
+		{
+			lo[i] = e2[i];
+			hi[i] = -e1[i];
+		} //end for
+	} //end else
+} //end eigenPlane
+
+/* Function: eigen_analytic
+ * Description: Eigen decomposition of a symmetric 3x3 matrix in closed form. The matrix is scaled by its
+ *				largest entry and shifted by q = trace / 3, B = (A - q I) / p with p^2 = trace(B^2) / 6, so
+ *				that its eigenvalues are 2 cos(phi + 2 k PI / 3) with cos(3 phi) = det(B) / 2.
+ *				The eigenvalue farthest from the other two (the largest when det(B) >= 0, else the
+ *				smallest) is at least 1.7 away from them, so its eigenvector comes accurately from cross
+ *				products. The two others come from a 2x2 problem orthogonal to it, which does not need
+ *				their roots, so they stay accurate when the roots are close or repeated, and the
+ *				eigenvalues are then taken from the eigenvectors. V is always a rotation.
+ * Input: A - symmetric matrix (only the upper triangle is read)
+ * Output: V - eigenvectors in its columns
+ *		   d - eigenvalues in increasing order
+ */
+void eigen_analytic(const double A[3][3], double V[3][3], double d[3])
+{
+	double B[3][3], w[3], Bw[3], lo[3], hi[3], plane[2];
+	double scale = 0.0, q, p2, p, r, phi, isolated;
+
+	for (int i = 0; i < 3; i++)
+		for (int j = i; j < 3; j++)
+			if (fabs(A[i][j]) > scale)
+				scale = fabs(A[i][j]);
+	if (scale == 0.0)
+		scale = 1.0;
+
+	for (int i = 0; i < 3; i++)
+		for (int j = i; j < 3; j++)
+			B[i][j] = B[j][i] = A[i][j] / scale;
+
+	q = (B[0][0] + B[1][1] + B[2][2]) / 3.0;
+	B[0][0] -= q;
+	B[1][1] -= q;
+	B[2][2] -= q;
+	p2 = (B[0][0] * B[0][0] + B[1][1] * B[1][1] + B[2][2] * B[2][2] +
+		  2.0 * (B[0][1] * B[0][1] + B[0][2] * B[0][2] + B[1][2] * B[1][2])) / 6.0;
+
+	if (p2 < EIG3DEGENERATE)
+	{
+		// A multiple of the identity up to rounding: every vector is an eigenvector
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+				V[i][j] = (i == j) ? 1.0 : 0.0;
+			d[i] = q * scale;
+		} //end for
+		return;
+	} //end if
+
+	p = sqrt(p2);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			B[i][j] /= p;
+
+	r = 0.5 * (B[0][0] * (B[1][1] * B[2][2] - B[1][2] * B[1][2]) -
+			   B[0][1] * (B[0][1] * B[2][2] - B[1][2] * B[0][2]) +
+			   B[0][2] * (B[0][1] * B[1][2] - B[1][1] * B[0][2]));
+	if (r < -1.0)
+		r = -1.0;
+	if (r > 1.0)
+		r = 1.0;
+
+	phi = acos(r) / 3.0;
+	if (r >= 0.0)
+		eigenIsolated(B, 2.0 * cos(phi), w);						// largest
+	else
+		eigenIsolated(B, -cos(phi) - SQRT3 * sin(phi), w);			// smallest
+
+	for (int i = 0; i < 3; i++)
+		Bw[i] = B[i][0] * w[0] + B[i][1] * w[1] + B[i][2] * w[2];
+	isolated = w[0] * Bw[0] + w[1] * Bw[1] + w[2] * Bw[2];
+	eigenPlane(B, w, lo, hi, plane);
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (r >= 0.0)
+		{
+			V[i][0] = lo[i];
+			V[i][1] = hi[i];
+			V[i][2] = w[i];
+		} //end if
+		else
+		{
+			V[i][0] = w[i];
+			V[i][1] = lo[i];
+			V[i][2] = hi[i];
+		} //end else
+	} //end for
+
+	d[0] = (r >= 0.0) ? plane[0] : isolated;
+	d[1] = (r >= 0.0) ? plane[1] : plane[0];
+	d[2] = (r >= 0.0) ? isolated : plane[1];
+	for (int i = 0; i < 3; i++)
+		d[i] = (q + p * d[i]) * scale;
+} //end eigen_analytic
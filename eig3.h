@@ -1,11 +1,21 @@
-
 /* Eigen-decomposition for symmetric 3x3 real matrices.
    Public domain, copied from the public domain Java library JAMA. */
 
 #ifndef _eig_h
+#define _eig_h
+
+#define SQRT3 1.7320508075688772
+#define EIG3DEGENERATE 4.9e-32		/* (trace(A'^2) / 6 of the scaled matrix without its trace) below which
+									   the eigenvalues are taken as equal: DBL_EPSILON^2 */
 
 /* Symmetric matrix A => eigenvectors in columns of V, corresponding
    eigenvalues in d. */
 void eigen_decomposition(double A[3][3], double V[3][3], double d[3]);
 
+/* Same output as eigen_decomposition (eigenvalues in increasing order, V a
+   rotation), from the closed form roots of the characteristic cubic instead
+   of iterations. The batched version for many matrices at once is the eigen3
+   kernel of simd.h. */
+void eigen_analytic(const double A[3][3], double V[3][3], double d[3]);
+
 #endif
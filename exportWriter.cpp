@@ -0,0 +1,352 @@
+/* Source: exportWriter
+ * Description: Thread writing the exported frames, fed through a ring of preallocated jobs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "exportWriter.h"
+#include "performanceCounter.h"
+
+#ifdef WIN32
+  #include <process.h>
+#endif
+
+#ifdef WIN32
+static unsigned __stdcall writerMain(void *writer)
+{
+	((exportWriter *)writer)->writerLoop();
+	return 0;
+}
+#else
+static void * writerMain(void *writer)
+{
+	((exportWriter *)writer)->writerLoop();
+	return NULL;
+}
+#endif
+
+/* Function: exportWriter
+ * Description: Allocates the ring of jobs, the thread is started by the first job
+ * Input: numSlots - jobs of the ring (at least 1)
+ *		  policy - EXPORTBLOCK, EXPORTDROP or EXPORTGROW
+ */
+exportWriter::exportWriter(int numSlots, int policy)
+{
+	if (numSlots < 1)
+		numSlots = 1;
+
+	this->numSlots = numSlots;
+	this->policy = policy;
+	slots = (exportJob **)malloc(numSlots * sizeof(exportJob *));
+	for (int i = 0; i < numSlots; i++)
+		slots[i] = (exportJob *)calloc(1, sizeof(exportJob));
+	head = 0;
+	queued = 0;
+	running = false;
+	quit = false;
+	ResetStats();
+
+#ifdef WIN32
+	InitializeCriticalSection(&lock);
+	InitializeConditionVariable(&jobReady);
+	InitializeConditionVariable(&jobDone);
+#else
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&jobReady, NULL);
+	pthread_cond_init(&jobDone, NULL);
+#endif
+}
+
+/* Function: ~exportWriter
+ * Description: Writes the jobs left and stops the thread
+ */
+exportWriter::~exportWriter()
+{
+	Stop();
+
+	for (int i = 0; i < numSlots; i++)
+	{
+		free(slots[i]->data);
+		free(slots[i]);
+	}
+	free(slots);
+
+#ifdef WIN32
+	DeleteCriticalSection(&lock);
+#else
+	pthread_cond_destroy(&jobDone);
+	pthread_cond_destroy(&jobReady);
+	pthread_mutex_destroy(&lock);
+#endif
+}
+
+/* Function: Begin
+ * Description: Takes the next free job of the ring for a frame. If all the jobs are waiting to be
+ *				written, waits for the writer, drops the frame or grows the ring, following the policy.
+ *				Only one thread may export through a writer.
+ * Input: size - bytes the frame is expected to copy, the job grows if more are appended
+ * Output: The empty job, handed to the writer with Commit, or NULL if the frame is dropped
+ */
+exportJob * exportWriter::Begin(size_t size)
+{
+	PerformanceCounter counter;
+	exportJob *job, **grown;
+
+	Lock();
+	if (queued == numSlots && policy == EXPORTDROP)
+	{
+		jobsDropped++;
+		Unlock();
+		return NULL;
+	}
+	else if (queued == numSlots && policy == EXPORTGROW)
+	{
+		// Unroll the ring from head into twice as many jobs
+		grown = (exportJob **)malloc(2 * numSlots * sizeof(exportJob *));
+		for (int i = 0; i < numSlots; i++)
+			grown[i] = slots[(head + i) % numSlots];
+		for (int i = numSlots; i < 2 * numSlots; i++)
+			grown[i] = (exportJob *)calloc(1, sizeof(exportJob));
+		free(slots);
+		slots = grown;
+		head = 0;
+		numSlots *= 2;
+	}
+	else if (queued == numSlots)
+	{
+		counter.StartCounter();
+		while (queued == numSlots)
+		{
+#ifdef WIN32
+			SleepConditionVariableCS(&jobDone, &lock, INFINITE);
+#else
+			pthread_cond_wait(&jobDone, &lock);
+#endif
+		}
+		counter.StopCounter();
+		waitTime += counter.GetElapsedTime();
+	} //end if
+	job = slots[(head + queued) % numSlots];
+	Unlock();
+
+	if (size > job->capacity)
+	{
+		job->capacity = size;
+		job->data = (unsigned char *)realloc(job->data, job->capacity);
+	}
+	job->encode = NULL;
+	job->context = NULL;
+	job->name[0] = '\0';
+	job->width = 0;
+	job->height = 0;
+	job->size = 0;
+	return job;
+}
+
+/* Function: Commit
+ * Description: Hands a job filled by the exporting thread to the writer thread
+ * Input: job - job given by the last Begin, with its encoder set. Any other job aborts, as the writer
+ *				 thread would write the slot Begin gave instead.
+ * Output: None
+ */
+void exportWriter::Commit(exportJob *job)
+{
+	if (!running)
+		Start();
+
+	Lock();
+	if (job == NULL || job != slots[(head + queued) % numSlots])
+	{
+		Unlock();
+		fprintf(stderr, "exportWriter::Commit: job not given by the last Begin, aborting\n");
+		exit(1);
+	} //end if
+	queued++;
+	if (queued > maxQueued)
+		maxQueued = queued;
+#ifdef WIN32
+	WakeConditionVariable(&jobReady);
+#else
+	pthread_cond_signal(&jobReady);
+#endif
+	Unlock();
+}
+
+/* Function: Drain
+ * Description: Waits until every committed job is written
+ * Input: None
+ * Output: None
+ */
+void exportWriter::Drain()
+{
+	Lock();
+	while (queued > 0)
+	{
+#ifdef WIN32
+		SleepConditionVariableCS(&jobDone, &lock, INFINITE);
+#else
+		pthread_cond_wait(&jobDone, &lock);
+#endif
+	}
+	Unlock();
+}
+
+/* Function: Stop
+ * Description: Writes the jobs left and joins the thread, the next job starts it again
+ * Input: None
+ * Output: None
+ */
+void exportWriter::Stop()
+{
+	if (!running)
+		return;
+
+	Lock();
+	quit = true;
+#ifdef WIN32
+	WakeConditionVariable(&jobReady);
+#else
+	pthread_cond_signal(&jobReady);
+#endif
+	Unlock();
+
+#ifdef WIN32
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, NULL);
+#endif
+	running = false;
+	quit = false;
+}
+
+/* Function: ResetStats
+ * Description: Clears the counters, to measure one recording
+ * Input: None
+ * Output: None
+ */
+void exportWriter::ResetStats()
+{
+	jobsWritten = 0;
+	jobsDropped = 0;
+	jobsFailed = 0;
+	maxQueued = 0;
+	bytesWritten = 0;
+	writeTime = 0.0;
+	waitTime = 0.0;
+}
+
+/* Function: PrintStats
+ * Description: Prints the counters: frames and bytes written, disk throughput, dropped frames and how
+ *				long the exports waited for the writer
+ * Input: what - name of the export
+ * Output: None
+ */
+void exportWriter::PrintStats(const char *what)
+{
+	double megabytes = bytesWritten / (1024.0 * 1024.0);
+
+	printf("%s: %d frames, %.1f MB written in %.2f s (%.1f MB/s), %d dropped, %d failed, %.2f s waited, at most %d of %d queued\n",
+		what, jobsWritten, megabytes, writeTime, (writeTime > 0.0) ? megabytes / writeTime : 0.0,
+		jobsDropped, jobsFailed, waitTime, maxQueued, numSlots);
+}
+
+/* Function: Append
+ * Description: Copies bytes at the end of a job, growing its buffer if needed
+ * Input: job - job given by Begin
+ *		  data - bytes to copy
+ *		  size - number of bytes
+ * Output: None
+ */
+void exportWriter::Append(exportJob *job, const void *data, size_t size)
+{
+	if (job->size + size > job->capacity)
+	{
+		job->capacity = 2 * job->capacity + size;
+		job->data = (unsigned char *)realloc(job->data, job->capacity);
+	}
+	memcpy(job->data + job->size, data, size);
+	job->size += size;
+}
+
+/* Function: writerLoop
+ * Description: Writes the committed jobs in order until Stop
+ * Input: None
+ * Output: None
+ */
+void exportWriter::writerLoop()
+{
+	PerformanceCounter counter;
+	exportJob *job;
+	bool written;
+
+	Lock();
+	for (;;)
+	{
+		while (!quit && queued == 0)
+		{
+#ifdef WIN32
+			SleepConditionVariableCS(&jobReady, &lock, INFINITE);
+#else
+			pthread_cond_wait(&jobReady, &lock);
+#endif
+		}
+		if (queued == 0)
+			break;
+		job = slots[head];
+		Unlock();
+
+		// The exporting thread does not touch the job until head moves past it
+		counter.StartCounter();
+		written = job->encode(job);
+		counter.StopCounter();
+
+		Lock();
+		writeTime += counter.GetElapsedTime();
+		if (written)
+		{
+			jobsWritten++;
+			bytesWritten += job->size;
+		}
+		else
+			jobsFailed++;
+		head = (head + 1) % numSlots;
+		queued--;
+#ifdef WIN32
+		WakeAllConditionVariable(&jobDone);
+#else
+		pthread_cond_broadcast(&jobDone);
+#endif
+	} //end for
+	Unlock();
+}
+
+// Starts the writer thread
+void exportWriter::Start()
+{
+	running = true;
+#ifdef WIN32
+	thread = (HANDLE)_beginthreadex(NULL, 0, writerMain, this, 0, NULL);
+#else
+	pthread_create(&thread, NULL, writerMain, this);
+#endif
+}
+
+void exportWriter::Lock()
+{
+#ifdef WIN32
+	EnterCriticalSection(&lock);
+#else
+	pthread_mutex_lock(&lock);
+#endif
+}
+
+void exportWriter::Unlock()
+{
+#ifdef WIN32
+	LeaveCriticalSection(&lock);
+#else
+	pthread_mutex_unlock(&lock);
+#endif
+}
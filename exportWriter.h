@@ -0,0 +1,101 @@
+/* Header: exportWriter
+ * Description: Header file for the thread writing exported frames to disk. The thread exporting a frame
+ *				only copies its data into a job of a ring of preallocated jobs and hands it over; the
+ *				writer thread takes the jobs in order and encodes and writes them (the frame cache chunks,
+ *				the OBJ files or the screenshots), so the exporting thread never waits for the disk.
+ *				When every job of the ring is still waiting to be written, the policy decides: the export
+ *				waits for the writer (EXPORTBLOCK), the frame is dropped (EXPORTDROP), or the ring gets
+ *				more jobs (EXPORTGROW). The counters of the writer show the throughput of the disk and
+ *				whether the export keeps up with it.
+ *				Same interface under Windows (Win32 threads, Vista or later) and Linux / Mac OS X (pthreads).
+ */
+
+#ifndef _EXPORTWRITER_H_
+#define _EXPORTWRITER_H_
+
+#ifdef WIN32
+  #include <windows.h>
+#else
+  #include <pthread.h>
+#endif
+#include <stddef.h>
+
+// What an export does when all the jobs are waiting to be written
+#define EXPORTBLOCK 0				// Wait until the writer frees a job
+#define EXPORTDROP 1				// Drop the frame
+#define EXPORTGROW 2				// Allocate more jobs
+
+#define EXPORTSLOTS 8				// Jobs of the ring of a new writer
+
+struct exportJob;
+
+// Encodes and writes a job, on the writer thread; false if it could not be written
+typedef bool (*exportEncoder)(exportJob *job);
+
+// One exported frame
+struct exportJob
+{
+	exportEncoder encode;			// Writes the job
+	void *context;					// What the job is written to (file, model)
+	char name[64];					// File written by the job, for the exports writing one file per frame
+	int width;						// Size of a screenshot
+	int height;
+	unsigned char *data;			// Bytes copied by the export
+	size_t size;
+	size_t capacity;				// Allocated bytes of data, kept for the next frames using the job
+};
+
+class exportWriter
+{
+public:
+		exportWriter(int numSlots, int policy);
+		~exportWriter();
+
+		exportJob * Begin(size_t size);
+		void Commit(exportJob *job);
+		void Drain();
+		void Stop();
+		void ResetStats();
+		void PrintStats(const char *what);
+
+		static void Append(exportJob *job, const void *data, size_t size);
+
+		void writerLoop();				// Body of the writer thread, not to be called directly
+
+		int policy;						// EXPORTBLOCK, EXPORTDROP or EXPORTGROW
+
+		// Counters since the last ResetStats
+		int jobsWritten;				// Jobs written
+		int jobsDropped;				// Frames dropped by EXPORTDROP
+		int jobsFailed;					// Jobs whose encoder failed
+		int maxQueued;					// Most jobs waiting to be written at once
+		long long bytesWritten;			// Bytes copied into the jobs written
+		double writeTime;				// Seconds the writer spent encoding and writing
+		double waitTime;				// Seconds the exports waited for a free job (EXPORTBLOCK)
+
+protected:
+		void Start();
+		void Lock();
+		void Unlock();
+
+		exportJob **slots;				// Ring of jobs
+		int numSlots;
+		int head;						// Oldest job waiting to be written, or being written
+		int queued;						// Jobs committed and not written yet, from head on
+		bool running;
+		bool quit;
+
+#ifdef WIN32
+		HANDLE thread;
+		CRITICAL_SECTION lock;
+		CONDITION_VARIABLE jobReady;
+		CONDITION_VARIABLE jobDone;
+#else
+		pthread_t thread;
+		pthread_mutex_t lock;
+		pthread_cond_t jobReady;
+		pthread_cond_t jobDone;
+#endif
+};
+
+#endif
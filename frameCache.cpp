@@ -0,0 +1,709 @@
+/* Source: frameCache
+ * Description: Binary file recording the positions of the bodies of a world frame after frame.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "frameCache.h"
+
+#define CACHEBUFFER (1 << 20)		// Bytes of the stdio buffer of a file being written
+
+// Moves to a byte of a file that may be larger than 2 GB
+static bool SeekFile(FILE *file, long long offset, int origin)
+{
+#ifdef WIN32
+	return _fseeki64(file, offset, origin) == 0;
+#else
+	return fseeko(file, (off_t)offset, origin) == 0;
+#endif
+}
+
+static long long TellFile(FILE *file)
+{
+#ifdef WIN32
+	return _ftelli64(file);
+#else
+	return (long long)ftello(file);
+#endif
+}
+
+// Writes count elements of size bytes
+static bool WriteArray(FILE *file, const void *data, size_t size, size_t count)
+{
+	return fwrite(data, size, count, file) == count;
+}
+
+// Writes the bytes of a job to its file, on the writer thread
+static bool WriteJob(exportJob *job)
+{
+	return WriteArray( (FILE *)job->context, job->data, 1, job->size);
+}
+
+// Reads count elements of size bytes
+static bool ReadArray(FILE *file, void *data, size_t size, size_t count)
+{
+	return fread(data, size, count, file) == count;
+}
+
+// Constructor
+frameCache::frameCache()
+{
+	file = NULL;
+	writer = NULL;
+	job = NULL;
+	failedJobs = 0;
+	numFrames = 0;
+	numBytes = 0;
+	shapeFiles = NULL;
+	numShapes = 0;
+	shapeCapacity = 0;
+	bodies = NULL;
+	bodyIndices = NULL;
+	numBodies = -1;
+	bodyCapacity = 0;
+	numValues = 0;
+	shapeOffsets = NULL;
+	bodiesOffsets = NULL;
+	frameOffsets = NULL;
+	numBodiesChunks = 0;
+	bodiesCapacity = 0;
+	frameCapacity = 0;
+}
+
+// Destructor, closes the file
+frameCache::~frameCache()
+{
+	Close();
+	free(shapeFiles);
+	free(bodies);
+	free(bodyIndices);
+	free(shapeOffsets);
+	free(bodiesOffsets);
+	free(frameOffsets);
+}
+
+/* Function: Create
+ * Description: Starts a new frame cache file, replacing the file of that name
+ * Input: filename - name of the frame cache file
+ *		  writer - thread writing the frames until Close, NULL to write them in WriteFrame
+ * Output: true if the file could be written
+ */
+bool frameCache::Create(char *filename, exportWriter *writer)
+{
+	cacheFileHeader header;
+
+	Close();
+	file = fopen(filename, "wb");
+	if (file == NULL)
+		return false;
+	setvbuf(file, NULL, _IOFBF, CACHEBUFFER);
+
+	memset( (void*)&header, 0, sizeof(header));
+	memcpy(header.magic, "FRMC", 4);
+	header.version = FRAMECACHEVERSION;
+	if (!WriteArray(file, &header, sizeof(header), 1))
+	{
+		fclose(file);
+		file = NULL;
+		return false;
+	} //end if
+
+	this->writer = writer;
+	failedJobs = (writer != NULL) ? writer->jobsFailed : 0;
+	numFrames = 0;
+	numBytes = sizeof(header);
+	numShapes = 0;
+	numBodies = -1;
+	numValues = 0;
+	numBodiesChunks = 0;
+	return true;
+}
+
+/* Function: WriteFrame
+ * Description: Appends the render positions (model vertices) of every body of world, preceded by the new
+ *				list of bodies and the shapes not written yet if bodies were added or deleted since the
+ *				last frame. The positions are read from the GLMmodel vertices: the interactive application
+ *				records the frames it got from the simulation thread, a world stepped on the calling
+ *				thread has to write its render positions first. With a writer, the frame is only copied
+ *				and may be dropped by its policy, which leaves the file as if it had not been recorded.
+ * Input: world - world whose bodies are recorded
+ *		  time - simulated time of the frame
+ * Output: true if the frame was written, copied or dropped
+ */
+bool frameCache::WriteFrame(simWorld *world, double time)
+{
+	cacheFrame frame;
+	pModel *temp;
+	long long size;
+	bool written;
+
+	if (file == NULL)
+		return false;
+
+	// With a writer, the chunks are only copied into a job here and written by the writer thread
+	if (writer != NULL)
+	{
+		job = writer->Begin(sizeof(cacheChunk) + sizeof(frame) + (size_t)numValues * sizeof(GLfloat));
+		if (job == NULL)
+			return true;
+		job->encode = WriteJob;
+		job->context = file;
+	} //end if
+
+	written = !BodiesChanged(world) || WriteBodies(world);
+	if (written)
+	{
+		memset( (void*)&frame, 0, sizeof(frame));
+		frame.bodies = numBodiesChunks - 1;
+		frame.time = time;
+		size = sizeof(frame) + (long long)numValues * sizeof(GLfloat);
+
+		AddOffset(&frameOffsets, numFrames, &frameCapacity, numBytes);
+		written = WriteChunk(CHUNKFRAME, numFrames, size) && Put(&frame, sizeof(frame), 1);
+		for (temp = world->models; temp->next != NULL && written; temp = temp->next)
+			written = Put(temp->pObj->model->vertices + 3*STARTFROM, 3 * sizeof(GLfloat), temp->pObj->numVertices);
+	} //end if
+	if (written)
+	{
+		numBytes += size;
+		numFrames++;
+	} //end if
+
+	if (job != NULL)
+	{
+		writer->Commit(job);
+		job = NULL;
+	}
+	return written;
+}
+
+/* Function: Close
+ * Description: Appends the index of the chunks and closes the file
+ * Input: None
+ * Output: true if the whole file was written
+ */
+bool frameCache::Close()
+{
+	cacheFileHeader header;
+	cacheIndex index;
+	bool written;
+
+	if (file == NULL)
+		return true;
+
+	// The index is written after the frames still queued
+	written = true;
+	if (writer != NULL)
+	{
+		writer->Drain();
+		written = (writer->jobsFailed == failedJobs);
+		writer = NULL;
+	} //end if
+
+	memset( (void*)&index, 0, sizeof(index));
+	index.numShapes = numShapes;
+	index.numBodies = numBodiesChunks;
+	index.numFrames = numFrames;
+
+	memset( (void*)&header, 0, sizeof(header));
+	memcpy(header.magic, "FRMC", 4);
+	header.version = FRAMECACHEVERSION;
+	header.indexOffset = numBytes;
+
+	written = written && WriteChunk(CHUNKINDEX, 0, sizeof(index) + sizeof(long long) * ((long long)numShapes + numBodiesChunks + numFrames)) &&
+		WriteArray(file, &index, sizeof(index), 1) &&
+		WriteArray(file, shapeOffsets, sizeof(long long), numShapes) &&
+		WriteArray(file, bodiesOffsets, sizeof(long long), numBodiesChunks) &&
+		WriteArray(file, frameOffsets, sizeof(long long), numFrames) &&
+		SeekFile(file, 0, SEEK_SET) &&
+		WriteArray(file, &header, sizeof(header), 1);
+	written = (fclose(file) == 0) && written;
+	file = NULL;
+
+	return written;
+}
+
+/* Function: WriteChunk
+ * Description: Writes the header of a chunk and counts it in numBytes
+ * Input: type - kind of chunk
+ *		  id - number of the chunk among the chunks of its kind
+ *		  size - bytes of the chunk after its header
+ * Output: true if the header was written
+ */
+bool frameCache::WriteChunk(int type, int id, long long size)
+{
+	cacheChunk chunk;
+
+	chunk.type = type;
+	chunk.id = id;
+	chunk.size = size;
+	numBytes += sizeof(chunk);
+	return Put(&chunk, sizeof(chunk), 1);
+}
+
+/* Function: WriteShape
+ * Description: Writes the topology of a shape: its rest positions, triangles and texture coordinates
+ * Input: shape - shape not written yet
+ * Output: true if the shape was written
+ */
+bool frameCache::WriteShape(restShape *shape)
+{
+	GLMmodel *model = shape->model;
+	cacheShape header;
+	unsigned int *indices;
+	long long size;
+	int capacity;
+	bool written;
+
+	memset( (void*)&header, 0, sizeof(header));
+	strncpy(header.file, shape->file, sizeof(header.file) - 1);
+	header.numVertices = shape->numVertices;
+	header.numTriangles = model->numtriangles;
+	header.numTexCoords = (model->texcoords != NULL) ? model->numtexcoords : 0;
+
+	size = sizeof(header) + 3 * sizeof(GLfloat) * (long long)header.numVertices + 3 * sizeof(unsigned int) * (long long)header.numTriangles;
+	if (header.numTexCoords > 0)
+		size += 2 * sizeof(GLfloat) * (long long)header.numTexCoords + 3 * sizeof(unsigned int) * (long long)header.numTriangles;
+
+	capacity = shapeCapacity;
+	AddOffset(&shapeOffsets, numShapes, &shapeCapacity, numBytes);
+	if (shapeCapacity != capacity)
+		shapeFiles = (char (*)[64])realloc(shapeFiles, shapeCapacity * sizeof(*shapeFiles));
+	memcpy(shapeFiles[numShapes], header.file, sizeof(header.file));
+
+	// Vertex numbers from 0, the GLMmodel numbers them from STARTFROM
+	indices = (unsigned int *)malloc(3 * sizeof(unsigned int) * (header.numTriangles + 1));
+	for (int i = 0; i < header.numTriangles; i++)
+		for (int j = 0; j < 3; j++)
+			indices[3*i + j] = model->triangles[i].vindices[j] - STARTFROM;
+
+	written = WriteChunk(CHUNKSHAPE, numShapes, size) &&
+		Put(&header, sizeof(header), 1) &&
+		Put(model->vertices + 3*STARTFROM, 3 * sizeof(GLfloat), header.numVertices) &&
+		Put(indices, 3 * sizeof(unsigned int), header.numTriangles);
+
+	if (written && header.numTexCoords > 0)
+	{
+		for (int i = 0; i < header.numTriangles; i++)
+			for (int j = 0; j < 3; j++)
+				indices[3*i + j] = model->triangles[i].tindices[j] - 1;
+		written = Put(model->texcoords + 2, 2 * sizeof(GLfloat), header.numTexCoords) &&
+			Put(indices, 3 * sizeof(unsigned int), header.numTriangles);
+	} //end if
+	free(indices);
+
+	numBytes += size;
+	numShapes++;
+	return written;
+}
+
+/* Function: BodiesChanged
+ * Description: Compares the bodies of world with the ones of the last bodies chunk
+ * Input: world - world being recorded
+ * Output: true if a body was added or deleted
+ */
+bool frameCache::BodiesChanged(simWorld *world)
+{
+	pModel *temp;
+	int count = 0;
+
+	for (temp = world->models; temp->next != NULL; temp = temp->next, count++)
+		if (count >= numBodies || bodies[count] != temp || bodyIndices[count] != temp->mIndex)
+			return true;
+
+	return count != numBodies;
+}
+
+/* Function: WriteBodies
+ * Description: Writes the list of the bodies of world with their shapes, writing the shapes first if needed
+ * Input: world - world being recorded
+ * Output: true if the list was written
+ */
+bool frameCache::WriteBodies(simWorld *world)
+{
+	cacheBody *list;
+	pModel *temp;
+	int count = 0, shape;
+	bool written = true;
+
+	for (temp = world->models; temp->next != NULL; temp = temp->next)
+		count++;
+	if (count > bodyCapacity)
+	{
+		bodyCapacity = count;
+		bodies = (pModel **)realloc(bodies, bodyCapacity * sizeof(pModel *));
+		bodyIndices = (int *)realloc(bodyIndices, bodyCapacity * sizeof(int));
+	}
+	list = (cacheBody *)calloc(count + 1, sizeof(cacheBody));
+
+	numBodies = 0;
+	numValues = 0;
+	for (temp = world->models; temp->next != NULL && written; temp = temp->next)
+	{
+		for (shape = 0; shape < numShapes; shape++)
+			if (strncmp(shapeFiles[shape], temp->pObj->shape->file, sizeof(shapeFiles[shape]) - 1) == 0)
+				break;
+		if (shape == numShapes)
+			written = WriteShape(temp->pObj->shape);
+
+		list[numBodies].mIndex = temp->mIndex;
+		list[numBodies].shape = shape;
+		list[numBodies].numVertices = temp->pObj->numVertices;
+		bodies[numBodies] = temp;
+		bodyIndices[numBodies] = temp->mIndex;
+		numBodies++;
+		numValues += 3 * temp->pObj->numVertices;
+	} //end for
+
+	if (written)
+	{
+		AddOffset(&bodiesOffsets, numBodiesChunks, &bodiesCapacity, numBytes);
+		written = WriteChunk(CHUNKBODIES, numBodiesChunks, (long long)numBodies * sizeof(cacheBody)) &&
+			Put(list, sizeof(cacheBody), numBodies);
+		numBytes += (long long)numBodies * sizeof(cacheBody);
+		numBodiesChunks++;
+	} //end if
+	free(list);
+
+	return written;
+}
+
+/* Function: Put
+ * Description: Writes count elements of size bytes to the file, or copies them into the job of the frame
+ * Input: data - elements
+ *		  size - bytes of an element
+ *		  count - number of elements
+ * Output: true if the elements were written or copied
+ */
+bool frameCache::Put(const void *data, size_t size, size_t count)
+{
+	if (job == NULL)
+		return WriteArray(file, data, size, count);
+
+	exportWriter::Append(job, data, size * count);
+	return true;
+}
+
+/* Function: AddOffset
+ * Description: Appends the offset of a chunk to one of the lists of the index
+ * Input: offsets - list
+ *		  count - offsets in the list
+ *		  capacity - allocated size of the list
+ *		  offset - offset of the chunk
+ * Output: None
+ */
+void frameCache::AddOffset(long long **offsets, int count, int *capacity, long long offset)
+{
+	if (count >= *capacity)
+	{
+		*capacity = 2 * *capacity + 64;
+		*offsets = (long long *)realloc(*offsets, *capacity * sizeof(long long));
+	}
+	(*offsets)[count] = offset;
+}
+
+// Constructor
+frameCacheReader::frameCacheReader()
+{
+	file = NULL;
+	numFrames = 0;
+	numShapes = 0;
+	shapes = NULL;
+	restPositions = NULL;
+	triangles = NULL;
+	texCoords = NULL;
+	texTriangles = NULL;
+	time = 0.0;
+	numBodies = 0;
+	bodies = NULL;
+	offsets = NULL;
+	positions = NULL;
+	fileSize = 0;
+	shapeOffsets = NULL;
+	bodiesOffsets = NULL;
+	frameOffsets = NULL;
+	numBodiesChunks = 0;
+	currentBodies = -1;
+	positionCapacity = 0;
+}
+
+// Destructor
+frameCacheReader::~frameCacheReader()
+{
+	Close();
+}
+
+/* Function: Open
+ * Description: Opens a frame cache file and reads its shapes. The chunks are found through the index, or
+ *				by walking them when the file was not closed; a chunk cut short ends the file.
+ * Input: filename - name of the frame cache file
+ * Output: true if the file is a frame cache file that could be read
+ */
+bool frameCacheReader::Open(char *filename)
+{
+	cacheFileHeader header;
+	bool valid;
+
+	Close();
+	file = fopen(filename, "rb");
+	if (file == NULL)
+		return false;
+
+	valid = SeekFile(file, 0, SEEK_END) && (fileSize = TellFile(file)) >= (long long)sizeof(header) &&
+		SeekFile(file, 0, SEEK_SET) && ReadArray(file, &header, sizeof(header), 1) &&
+		memcmp(header.magic, "FRMC", 4) == 0 && header.version == FRAMECACHEVERSION;
+	if (valid)
+		valid = (header.indexOffset != 0) ? ReadIndex(header.indexOffset) : ScanChunks();
+	valid = valid && ReadShapes();
+
+	if (!valid)
+		Close();
+	return valid;
+}
+
+/* Function: Close
+ * Description: Closes the file and frees what was read
+ * Input: None
+ * Output: None
+ */
+void frameCacheReader::Close()
+{
+	if (file != NULL)
+		fclose(file);
+	file = NULL;
+
+	for (int i = 0; i < numShapes; i++)
+	{
+		if (restPositions)
+			free(restPositions[i]);
+		if (triangles)
+			free(triangles[i]);
+		if (texCoords)
+			free(texCoords[i]);
+		if (texTriangles)
+			free(texTriangles[i]);
+	}
+	free(shapes);
+	free(restPositions);
+	free(triangles);
+	free(texCoords);
+	free(texTriangles);
+	free(bodies);
+	free(offsets);
+	free(positions);
+	free(shapeOffsets);
+	free(bodiesOffsets);
+	free(frameOffsets);
+
+	shapes = NULL;
+	restPositions = NULL;
+	triangles = NULL;
+	texCoords = NULL;
+	texTriangles = NULL;
+	bodies = NULL;
+	offsets = NULL;
+	positions = NULL;
+	shapeOffsets = NULL;
+	bodiesOffsets = NULL;
+	frameOffsets = NULL;
+	numFrames = 0;
+	numShapes = 0;
+	numBodies = 0;
+	numBodiesChunks = 0;
+	currentBodies = -1;
+	positionCapacity = 0;
+}
+
+/* Function: ReadIndex
+ * Description: Reads the offsets of the chunks from the index chunk
+ * Input: indexOffset - offset of the index chunk
+ * Output: true if the index could be read
+ */
+bool frameCacheReader::ReadIndex(long long indexOffset)
+{
+	cacheChunk chunk;
+	cacheIndex index;
+	bool valid;
+
+	valid = indexOffset < fileSize && SeekFile(file, indexOffset, SEEK_SET) &&
+		ReadArray(file, &chunk, sizeof(chunk), 1) && chunk.type == CHUNKINDEX &&
+		ReadArray(file, &index, sizeof(index), 1) &&
+		index.numShapes >= 0 && index.numBodies >= 0 && index.numFrames >= 0 &&
+		chunk.size == (long long)sizeof(index) + (long long)sizeof(long long) * ((long long)index.numShapes + index.numBodies + index.numFrames);
+	if (!valid)
+		return false;
+
+	numShapes = index.numShapes;
+	numBodiesChunks = index.numBodies;
+	numFrames = index.numFrames;
+	shapeOffsets = (long long *)malloc((numShapes + 1) * sizeof(long long));
+	bodiesOffsets = (long long *)malloc((numBodiesChunks + 1) * sizeof(long long));
+	frameOffsets = (long long *)malloc((numFrames + 1) * sizeof(long long));
+
+	return ReadArray(file, shapeOffsets, sizeof(long long), numShapes) &&
+		ReadArray(file, bodiesOffsets, sizeof(long long), numBodiesChunks) &&
+		ReadArray(file, frameOffsets, sizeof(long long), numFrames);
+}
+
+/* Function: ScanChunks
+ * Description: Finds the chunks of a file that has no index by walking from chunk to chunk
+ * Input: None
+ * Output: true if the file could be read
+ */
+bool frameCacheReader::ScanChunks()
+{
+	cacheChunk chunk;
+	long long offset = sizeof(cacheFileHeader);
+	int shapeCapacity = 0, bodiesCapacity = 0, frameCapacity = 0;
+
+	while (offset + (long long)sizeof(chunk) <= fileSize && SeekFile(file, offset, SEEK_SET) &&
+		ReadArray(file, &chunk, sizeof(chunk), 1))
+	{
+		if (chunk.size < 0 || offset + (long long)sizeof(chunk) + chunk.size > fileSize)
+			break;
+
+		if (chunk.type == CHUNKSHAPE && chunk.id == numShapes)
+		{
+			if (numShapes == shapeCapacity)
+				shapeOffsets = (long long *)realloc(shapeOffsets, (shapeCapacity = 2 * shapeCapacity + 8) * sizeof(long long));
+			shapeOffsets[numShapes++] = offset;
+		}
+		else if (chunk.type == CHUNKBODIES && chunk.id == numBodiesChunks)
+		{
+			if (numBodiesChunks == bodiesCapacity)
+				bodiesOffsets = (long long *)realloc(bodiesOffsets, (bodiesCapacity = 2 * bodiesCapacity + 8) * sizeof(long long));
+			bodiesOffsets[numBodiesChunks++] = offset;
+		}
+		else if (chunk.type == CHUNKFRAME && chunk.id == numFrames)
+		{
+			if (numFrames == frameCapacity)
+				frameOffsets = (long long *)realloc(frameOffsets, (frameCapacity = 2 * frameCapacity + 1024) * sizeof(long long));
+			frameOffsets[numFrames++] = offset;
+		}
+		else if (chunk.type != CHUNKINDEX)
+			break;
+
+		offset += sizeof(chunk) + chunk.size;
+	} //end while
+
+	return true;
+}
+
+/* Function: ReadShapes
+ * Description: Reads the topology of every shape of the file
+ * Input: None
+ * Output: true if the shapes could be read
+ */
+bool frameCacheReader::ReadShapes()
+{
+	cacheChunk chunk;
+	cacheShape *shape;
+	bool valid = true;
+
+	shapes = (cacheShape *)calloc(numShapes + 1, sizeof(cacheShape));
+	restPositions = (float **)calloc(numShapes + 1, sizeof(float *));
+	triangles = (unsigned int **)calloc(numShapes + 1, sizeof(unsigned int *));
+	texCoords = (float **)calloc(numShapes + 1, sizeof(float *));
+	texTriangles = (unsigned int **)calloc(numShapes + 1, sizeof(unsigned int *));
+
+	for (int i = 0; i < numShapes && valid; i++)
+	{
+		shape = &shapes[i];
+		valid = SeekFile(file, shapeOffsets[i], SEEK_SET) && ReadArray(file, &chunk, sizeof(chunk), 1) &&
+			chunk.type == CHUNKSHAPE && ReadArray(file, shape, sizeof(cacheShape), 1) &&
+			shape->numVertices >= 0 && shape->numTriangles >= 0 && shape->numTexCoords >= 0 &&
+			chunk.size >= (long long)sizeof(cacheShape) + 12LL * shape->numVertices + 12LL * shape->numTriangles;
+		if (!valid)
+			break;
+		shape->file[sizeof(shape->file) - 1] = '\0';
+
+		restPositions[i] = (float *)malloc(3 * sizeof(float) * (shape->numVertices + 1));
+		triangles[i] = (unsigned int *)malloc(3 * sizeof(unsigned int) * (shape->numTriangles + 1));
+		valid = ReadArray(file, restPositions[i], 3 * sizeof(float), shape->numVertices) &&
+			ReadArray(file, triangles[i], 3 * sizeof(unsigned int), shape->numTriangles);
+
+		if (valid && shape->numTexCoords > 0)
+		{
+			texCoords[i] = (float *)malloc(2 * sizeof(float) * shape->numTexCoords);
+			texTriangles[i] = (unsigned int *)malloc(3 * sizeof(unsigned int) * (shape->numTriangles + 1));
+			valid = ReadArray(file, texCoords[i], 2 * sizeof(float), shape->numTexCoords) &&
+				ReadArray(file, texTriangles[i], 3 * sizeof(unsigned int), shape->numTriangles);
+		} //end if
+	} //end for
+
+	return valid;
+}
+
+/* Function: ReadBodies
+ * Description: Reads a list of bodies and where their positions are in a frame
+ * Input: id - number of the bodies chunk
+ * Output: true if the list could be read
+ */
+bool frameCacheReader::ReadBodies(int id)
+{
+	cacheChunk chunk;
+	bool valid;
+
+	if (id < 0 || id >= numBodiesChunks)
+		return false;
+	valid = SeekFile(file, bodiesOffsets[id], SEEK_SET) && ReadArray(file, &chunk, sizeof(chunk), 1) &&
+		chunk.type == CHUNKBODIES && chunk.size % sizeof(cacheBody) == 0;
+	if (!valid)
+		return false;
+
+	numBodies = (int)(chunk.size / sizeof(cacheBody));
+	bodies = (cacheBody *)realloc(bodies, (numBodies + 1) * sizeof(cacheBody));
+	offsets = (int *)realloc(offsets, (numBodies + 1) * sizeof(int));
+	if (!ReadArray(file, bodies, sizeof(cacheBody), numBodies))
+		return false;
+
+	offsets[0] = 0;
+	for (int i = 0; i < numBodies; i++)
+	{
+		if (bodies[i].shape < 0 || bodies[i].shape >= numShapes || bodies[i].numVertices != shapes[bodies[i].shape].numVertices)
+			return false;
+		offsets[i + 1] = offsets[i] + 3 * bodies[i].numVertices;
+	}
+	currentBodies = id;
+
+	return true;
+}
+
+/* Function: ReadFrame
+ * Description: Reads the positions of all the bodies at one frame, and the list of the bodies if it is
+ *				not the one of the last frame read
+ * Input: frame - number of the frame, from 0
+ * Output: true if the frame could be read
+ */
+bool frameCacheReader::ReadFrame(int frame)
+{
+	cacheChunk chunk;
+	cacheFrame header;
+	bool valid;
+
+	if (file == NULL || frame < 0 || frame >= numFrames)
+		return false;
+
+	valid = SeekFile(file, frameOffsets[frame], SEEK_SET) && ReadArray(file, &chunk, sizeof(chunk), 1) &&
+		chunk.type == CHUNKFRAME && chunk.id == frame && ReadArray(file, &header, sizeof(header), 1);
+	if (!valid)
+		return false;
+
+	if (header.bodies != currentBodies)
+	{
+		currentBodies = -1;
+		if (!ReadBodies(header.bodies) || !SeekFile(file, frameOffsets[frame] + sizeof(chunk) + sizeof(header), SEEK_SET))
+			return false;
+	} //end if
+	if (chunk.size != (long long)sizeof(header) + (long long)sizeof(float) * offsets[numBodies])
+		return false;
+
+	if (offsets[numBodies] > positionCapacity)
+	{
+		positionCapacity = offsets[numBodies];
+		positions = (float *)realloc(positions, positionCapacity * sizeof(float));
+	}
+	time = header.time;
+
+	return ReadArray(file, positions, sizeof(float), offsets[numBodies]);
+}
@@ -0,0 +1,174 @@
+/* Header: frameCache
+ * Description: Header file for the frame cache, a binary file recording the positions of every body of
+ *				a simulation frame after frame. The file is a header followed by chunks, each one starting
+ *				with its kind, its number and its size so that a reader can skip the ones it does not need:
+ *				the topology of every model file is written once (a shape chunk: rest positions, triangles
+ *				and texture coordinates), the list of bodies and of their shapes whenever it changes (a
+ *				bodies chunk), and every frame only holds the positions of all the bodies, as floats in the
+ *				order of the last bodies chunk. Closing the file appends an index of all the chunks, so
+ *				that any frame can be read with one seek; a file left without its index (the program
+ *				stopped while recording) is indexed again by walking its chunks.
+ */
+
+#ifndef _FRAMECACHE_H_
+#define _FRAMECACHE_H_
+
+#include <stdio.h>
+#include "simulation.h"
+#include "exportWriter.h"
+
+#define FRAMECACHEVERSION 1			// Version of the frame cache files, changed with their layout
+#define FRAMECACHESUFFIX ".fcache"	// Suffix of the frame cache files
+
+// Kinds of chunks
+#define CHUNKSHAPE 1				// Topology of a model file
+#define CHUNKBODIES 2				// Bodies of the frames that follow
+#define CHUNKFRAME 3				// Positions of the bodies at one frame
+#define CHUNKINDEX 4				// Offsets of all the other chunks, written last
+
+// First bytes of a frame cache file
+struct cacheFileHeader
+{
+	char magic[4];					// "FRMC"
+	int version;					// FRAMECACHEVERSION
+	long long indexOffset;			// Offset of the index chunk, 0 until the file is closed
+};
+
+// First bytes of every chunk
+struct cacheChunk
+{
+	int type;						// CHUNKSHAPE .. CHUNKINDEX
+	int id;							// Number of the shape, bodies list or frame, counted from 0 for each kind
+	long long size;					// Bytes of the chunk after this header
+};
+
+// Shape chunk: followed by the rest positions (3 floats per vertex), the triangles (3 vertex numbers
+// from 0 each) and, when there are texture coordinates, the coordinates (2 floats each) and their
+// triangles (3 coordinate numbers from 0 each)
+struct cacheShape
+{
+	char file[64];					// Model file
+	int numVertices;
+	int numTriangles;
+	int numTexCoords;
+	int reserved;
+};
+
+// Bodies chunk: numBodies of these
+struct cacheBody
+{
+	int mIndex;						// Index of the body in the world
+	int shape;						// Number of its shape chunk
+	int numVertices;				// Positions of the body in every frame
+	int reserved;
+};
+
+// Frame chunk: followed by the positions of all the bodies
+struct cacheFrame
+{
+	int bodies;						// Number of the bodies chunk giving the bodies of the frame
+	int reserved;
+	double time;					// Simulated time of the frame
+};
+
+// Index chunk: followed by the offsets (long long) of the shape, bodies and frame chunks
+struct cacheIndex
+{
+	int numShapes;
+	int numBodies;					// Number of bodies chunks
+	int numFrames;
+	int reserved;
+};
+
+// Records the frames of a world into a frame cache file
+class frameCache
+{
+public:
+		frameCache();
+		~frameCache();
+
+		bool Create(char *filename, exportWriter *writer = NULL);
+		bool IsOpen() { return file != NULL; }
+		bool WriteFrame(simWorld *world, double time);
+		bool Close();
+
+		int numFrames;					// Frames written to the open file
+		long long numBytes;				// Bytes written to the open file
+
+protected:
+		bool Put(const void *data, size_t size, size_t count);
+		bool WriteChunk(int type, int id, long long size);
+		bool WriteShape(restShape *shape);
+		bool WriteBodies(simWorld *world);
+		bool BodiesChanged(simWorld *world);
+		void AddOffset(long long **offsets, int count, int *capacity, long long offset);
+
+		FILE *file;
+		exportWriter *writer;			// Thread writing the frames, NULL if they are written directly
+		exportJob *job;					// Job of the frame being copied
+		int failedJobs;					// Failed jobs of the writer before the file was created
+
+		// Files of the shapes written to the file, in the order of their chunks
+		char (*shapeFiles)[64];
+		int numShapes;
+		int shapeCapacity;
+
+		// Bodies of the last bodies chunk
+		pModel **bodies;
+		int *bodyIndices;				// Their mIndex
+		int numBodies;
+		int bodyCapacity;
+		int numValues;					// Floats of a frame
+
+		// Offsets of the chunks, for the index
+		long long *shapeOffsets;
+		long long *bodiesOffsets;
+		long long *frameOffsets;
+		int numBodiesChunks;
+		int bodiesCapacity;
+		int frameCapacity;
+};
+
+// Reads back the frames of a frame cache file
+class frameCacheReader
+{
+public:
+		frameCacheReader();
+		~frameCacheReader();
+
+		bool Open(char *filename);
+		void Close();
+		bool ReadFrame(int frame);
+
+		int numFrames;
+		int numShapes;
+		cacheShape *shapes;				// Shapes of the file
+		float **restPositions;			// Rest positions of every shape
+		unsigned int **triangles;		// Triangles of every shape
+		float **texCoords;				// Texture coordinates of every shape (NULL without any)
+		unsigned int **texTriangles;	// Texture coordinate triangles of every shape (NULL without any)
+
+		// Frame read last
+		double time;
+		int numBodies;
+		cacheBody *bodies;				// Bodies of the frame
+		int *offsets;					// First float of every body in positions
+		float *positions;				// Positions of all the bodies, 3 floats per vertex
+
+protected:
+		bool ReadIndex(long long indexOffset);
+		bool ScanChunks();
+		bool ReadShapes();
+		bool ReadBodies(int id);
+
+		FILE *file;
+		long long fileSize;
+		long long *shapeOffsets;
+		long long *bodiesOffsets;
+		long long *frameOffsets;
+		int numBodiesChunks;
+		int currentBodies;				// Bodies chunk of bodies, -1 if none is read
+		int positionCapacity;
+};
+
+#endif
@@ -1,4 +1,20 @@
-#include "render.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <float.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "openGL-headers.h"
+#include "glme.h"
+#include "threadPool.h"
+
+#ifdef WIN32
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
 
 #define T(x) (model->triangles[(x)])
 
@@ -17,6 +33,79 @@ static char * glmDuplicateString(char * s)
   return p;
 }
 
+/* glmMapFile: maps a whole file into memory, privately: writes to the
+ * pages copy them and never reach the file. Returns NULL on failure.
+ *
+ * filename - name of the file
+ * size     - will contain the size of the file on return
+ */
+static void* glmMapFile(char* filename, size_t* size)
+{
+  void* mapping;
+
+#ifdef WIN32
+  HANDLE file, view;
+  LARGE_INTEGER fileSize;
+
+  file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return NULL;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+  {
+    CloseHandle(file);
+    return NULL;
+  }
+  view = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(file);
+  if (view == NULL)
+    return NULL;
+  mapping = MapViewOfFile(view, FILE_MAP_COPY, 0, 0, 0);
+  CloseHandle(view);
+  *size = (size_t)fileSize.QuadPart;
+#else
+  struct stat status;
+  int file;
+
+  file = open(filename, O_RDONLY);
+  if (file < 0)
+    return NULL;
+  if (fstat(file, &status) != 0 || status.st_size == 0)
+  {
+    close(file);
+    return NULL;
+  }
+  mapping = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+  close(file);
+  if (mapping == MAP_FAILED)
+    return NULL;
+  *size = status.st_size;
+#endif
+
+  return mapping;
+}
+
+/* glmUnmapFile: unmaps a file mapped by glmMapFile */
+static GLvoid glmUnmapFile(void* mapping, size_t size)
+{
+#ifdef WIN32
+  UnmapViewOfFile(mapping);
+#else
+  munmap(mapping, size);
+#endif
+}
+
+/* glmFreeArray: frees an array of the model, unless it points into the
+ * binary file the model was mapped from */
+static GLvoid glmFreeArray(GLMmodel* model, void* p)
+{
+  if (p == NULL)
+    return;
+  if (model->mapping && (char*)p >= (char*)model->mapping && 
+      (char*)p < (char*)model->mapping + model->mappingSize)
+    return;
+  free(p);
+}
+
 /* glmMax: returns the maximum of two floats */
 static GLfloat
 glmMax(GLfloat a, GLfloat b) 
@@ -863,6 +952,707 @@ glmSecondPass(GLMmodel* model, FILE* file)
 }
 
 
+/* glmAllocateArrays: allocates the arrays of a model and of its groups
+ * once the counts of a first pass are known. The group counts are reset
+ * to 0, to be counted again while the arrays are filled.
+ *
+ * model - model with its counts and its groups
+ */
+static GLvoid glmAllocateArrays(GLMmodel* model)
+{
+    GLMgroup * group;
+
+    if (memoryAllocationMode == GLM_TIGHT)
+    {
+      /* allocate memory for the triangles in each group */
+      group = model->groups;
+      while(group)
+      {
+        group->triangles = (GLuint*)malloc(sizeof(GLuint) * group->numtriangles);
+        group->numtriangles = 0;
+        group->edges = (GLuint*)malloc(sizeof(GLuint) * group->numEdges * 2);
+        group->numEdges = 0;
+        group = group->next;
+      }
+
+      //printf("--------- Allocator: num vertices = %d\n", model->numvertices);
+      model->vertices = (GLfloat*)malloc(sizeof(GLfloat) * 3 * (model->numvertices + 1));
+
+      model->verticesRest = (GLfloat*)malloc(sizeof(GLfloat) * 3 * (model->numvertices + 1));
+
+      model->triangles = (GLMtriangle*)malloc(sizeof(GLMtriangle) * model->numtriangles);
+
+      if (model->numnormals)
+      {
+          model->normals = (GLfloat*)malloc(sizeof(GLfloat) *
+              3 * (model->numnormals + 1));
+      }
+
+      if (model->numtexcoords)
+      {
+          model->texcoords = (GLfloat*)malloc(sizeof(GLfloat) *
+              2 * (model->numtexcoords + 1));
+      }
+    }
+    else
+    {
+      /* allocate memory */
+
+      group = model->groups;
+      while(group)
+      {
+        group->triangles = (GLuint*)malloc(sizeof(GLuint) * maxNumTriangles);
+        group->numtriangles = 0;
+        group->edges = (GLuint*)malloc(sizeof(GLuint) * group->numEdges * 2);
+        group->numEdges = 0;
+        group = group->next;
+      }
+
+      model->vertices = (GLfloat*)malloc(sizeof(GLfloat) *
+          3 * (maxNumVertices + 1));
+
+      model->verticesRest = (GLfloat*)malloc(sizeof(GLfloat) *
+        3 * (maxNumVertices + 1));
+
+      model->triangles = (GLMtriangle*)malloc(sizeof(GLMtriangle) *
+          maxNumTriangles);
+
+      model->normals = (GLfloat*)malloc(sizeof(GLfloat) *
+              3 * (maxNumNormals + 1));
+
+      model->texcoords = (GLfloat*)malloc(sizeof(GLfloat) *
+              2 * (maxNumTexCoords + 1));
+    }
+}
+
+
+/* Parallel reader of Wavefront .OBJ files, used by glmReadOBJ instead of
+ * the two passes above whenever the file can be mapped. The file is cut
+ * into chunks of whole lines and every chunk is parsed by a task of its
+ * own into its own arrays. Faces refer to vertices, normals and texcoords
+ * by their 1-based number in the whole file, so a chunk needs nothing from
+ * the chunks before it; the arrays are simply put one after the other, in
+ * file order. The statements naming things (mtllib, usemtl, g) are kept as
+ * commands at the face where they appeared and replayed in order when the
+ * groups are built, which gives the groups, materials and edges of the two
+ * pass reader. */
+
+#define GLM_CHUNK_SIZE (1 << 20)  /* bytes of the file parsed by one task */
+
+enum { GLM_MTLLIB, GLM_USEMTL, GLM_GROUP };
+
+/* what the vertices of a face give besides v */
+#define GLM_FACE_T  1           /* v/t or v/t/n */
+#define GLM_FACE_N  2           /* v/t/n or v//n */
+#define GLM_FACE_VN 4           /* v//n */
+
+/* GLMcommand: a naming statement found in a chunk */
+typedef struct _GLMcommand {
+  int    type;                  /* GLM_MTLLIB, GLM_USEMTL or GLM_GROUP */
+  GLuint face;                  /* faces of the chunk before the command */
+  char*  name;                  /* in the mapped file, not terminated */
+  int    length;                /* characters of the name */
+} GLMcommand;
+
+/* GLMchunk: lines of the file parsed by one task, and what was read */
+typedef struct _GLMchunk {
+  char*        begin;           /* first character of the chunk */
+  char*        end;             /* one past its last character */
+
+  GLuint       numvertices, maxvertices;
+  GLfloat*     vertices;
+  GLuint       numnormals, maxnormals;
+  GLfloat*     normals;
+  GLuint       numtexcoords, maxtexcoords;
+  GLfloat*     texcoords;
+  GLuint       numtriangles, maxtriangles;
+  GLMtriangle* triangles;
+  GLuint       numfaces, maxfaces;
+  GLuint*      faces;           /* first triangle of every face, and numtriangles after the last one */
+  GLuint       numcommands, maxcommands;
+  GLMcommand*  commands;
+
+  /* first vertex, normal, texcoord and triangle of the chunk in the model */
+  GLuint       firstvertex, firstnormal, firsttexcoord, firsttriangle;
+
+  char*        error;           /* unknown token the chunk stopped at, or NULL */
+  int          errorLength;
+} GLMchunk;
+
+/* GLMreader: context of the tasks of the parallel reader */
+typedef struct _GLMreader {
+  GLMmodel* model;
+  GLMchunk* chunks;
+} GLMreader;
+
+/* glmGrow: makes room for one more item in an array of a chunk */
+static void* glmGrow(void* array, GLuint count, GLuint* capacity, size_t size)
+{
+  if (count < *capacity)
+    return array;
+  *capacity = 2 * *capacity + 256;
+  return realloc(array, *capacity * size);
+}
+
+/* glmBlank: white space within a line */
+static int glmBlank(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/* glmParseInt: reads an integer like "%d" of scanf. Returns the end of
+ * the number, or p if there is none (value is then left alone).
+ *
+ * p     - where to start reading, white space is skipped
+ * end   - end of the line
+ * value - will contain the integer
+ */
+static char* glmParseInt(char* p, char* end, int* value)
+{
+  char* q = p;
+  int negative = 0, result = 0;
+
+  while (q < end && glmBlank(*q))
+    q++;
+  if (q < end && (*q == '-' || *q == '+'))
+    negative = (*q++ == '-');
+  if (q >= end || *q < '0' || *q > '9')
+    return p;
+  while (q < end && *q >= '0' && *q <= '9')
+    result = 10 * result + (*q++ - '0');
+
+  *value = negative ? -result : result;
+  return q;
+}
+
+/* glmParseFloat: reads a float like "%f" of scanf, without the locale
+ * and stream overhead, for the plain decimal numbers of OBJ files. The
+ * number is computed from its digits in double precision, which is exact
+ * when the digits and the power of ten both fit in a double, and rounded
+ * to float. That rounding gives the float strtof gives unless the double
+ * lies exactly halfway between two floats; those numbers, and any other
+ * syntax (more digits, large exponents, inf, nan, hexadecimal), are read
+ * by strtof itself. Returns the end of the number, or p if there is none.
+ *
+ * p     - where to start reading, white space is skipped
+ * end   - end of the line
+ * value - will contain the float
+ */
+static char* glmParseFloat(char* p, char* end, GLfloat* value)
+{
+  static const double powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  unsigned long long mantissa = 0, bits;
+  int negative = 0, digits = 0, exponent = 0, scale, scaleNegative, any = 0, slow = 0;
+  char buf[64], *start, *q, *stop;
+  double d;
+  int i;
+
+  q = p;
+  while (q < end && glmBlank(*q))
+    q++;
+  start = q;
+
+  if (q < end && (*q == '-' || *q == '+'))
+    negative = (*q++ == '-');
+  while (q < end && *q >= '0' && *q <= '9') {
+    if (mantissa || *q != '0') {
+      if (digits++ < 19)
+        mantissa = 10 * mantissa + (*q - '0');
+      else
+        slow = 1;
+    }
+    any = 1;
+    q++;
+  }
+  if (q < end && *q == '.') {
+    q++;
+    while (q < end && *q >= '0' && *q <= '9') {
+      if (mantissa || *q != '0') {
+        if (digits++ < 19)
+          mantissa = 10 * mantissa + (*q - '0');
+        else
+          slow = 1;
+      }
+      exponent--;
+      any = 1;
+      q++;
+    }
+  }
+  if (any && q < end && (*q == 'e' || *q == 'E')) {
+    stop = q + 1;
+    scale = 0;
+    scaleNegative = 0;
+    if (stop < end && (*stop == '-' || *stop == '+'))
+      scaleNegative = (*stop++ == '-');
+    if (stop < end && *stop >= '0' && *stop <= '9') {
+      while (stop < end && *stop >= '0' && *stop <= '9') {
+        if (scale < 10000)
+          scale = 10 * scale + (*stop - '0');
+        stop++;
+      }
+      exponent += scaleNegative ? -scale : scale;
+      q = stop;
+    }
+  }
+
+  if (any && !slow) {
+    if (mantissa == 0) {
+      *value = negative ? -0.0f : 0.0f;
+      return q;
+    }
+    if (mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+      d = (double)mantissa;
+      d = (exponent < 0) ? d / powers[-exponent] : d * powers[exponent];
+      memcpy(&bits, &d, sizeof(bits));
+      if (d >= FLT_MIN && d <= FLT_MAX && (bits & 0x1FFFFFFFULL) != 0x10000000ULL) {
+        *value = negative ? -(GLfloat)d : (GLfloat)d;
+        return q;
+      }
+    }
+  }
+
+  /* anything else is read by strtof, from a terminated copy */
+  for (i = 0; start + i < end && !glmBlank(start[i]) && i < (int)sizeof(buf) - 1; i++)
+    buf[i] = start[i];
+  buf[i] = '\0';
+  *value = strtof(buf, &stop);
+  if (stop == buf)
+    return p;
+  return start + (stop - buf);
+}
+
+/* glmParseIndices: reads one vertex of a face, one of v, v/t, v/t/n and
+ * v//n. Returns the end of the vertex, or p if there is none.
+ *
+ * p      - where to start reading, white space is skipped
+ * end    - end of the line
+ * v,t,n  - will contain the indices read, the others are set to 0
+ * format - will contain the GLM_FACE_ flags of the vertex
+ */
+static char* glmParseIndices(char* p, char* end, int* v, int* t, int* n, int* format)
+{
+  char* q;
+
+  *t = *n = 0;
+  *format = 0;
+  q = glmParseInt(p, end, v);
+  if (q == p)
+    return p;
+  if (q < end && *q == '/') {
+    q++;
+    if (q < end && *q == '/') {
+      *format |= GLM_FACE_VN;
+      q++;
+    } else if (q < end && !glmBlank(*q)) {
+      q = glmParseInt(q, end, t);
+      *format |= GLM_FACE_T;
+      if (q < end && *q == '/')
+        q++;
+    }
+    if (q < end && !glmBlank(*q) && *q != '/') {
+      q = glmParseInt(q, end, n);
+      *format |= GLM_FACE_N;
+    }
+  }
+  while (q < end && !glmBlank(*q))
+    q++;
+  return q;
+}
+
+/* glmChunkCommand: records a naming statement of a chunk */
+static GLvoid glmChunkCommand(GLMchunk* chunk, int type, char* name, int length)
+{
+  GLMcommand* command;
+
+  chunk->commands = (GLMcommand*)glmGrow(chunk->commands, chunk->numcommands,
+    &chunk->maxcommands, sizeof(GLMcommand));
+  command = &chunk->commands[chunk->numcommands++];
+  command->type = type;
+  command->face = chunk->numfaces;
+  command->name = name;
+  command->length = length;
+}
+
+/* glmChunkFace: reads the vertices of a face and tessellates it into a
+ * fan of triangles, like glmSecondPass.
+ *
+ * chunk - chunk the face is in
+ * p     - first character after the "f" token
+ * end   - end of the line
+ */
+static GLvoid glmChunkFace(GLMchunk* chunk, char* p, char* end)
+{
+  GLMtriangle* triangle = NULL;
+  GLuint first[3], last[3];
+  int v, t, n, format, faceFormat = 0, count = 0;
+  char* q;
+
+  chunk->faces = (GLuint*)glmGrow(chunk->faces, chunk->numfaces, &chunk->maxfaces, sizeof(GLuint));
+  chunk->faces[chunk->numfaces++] = chunk->numtriangles;
+
+  first[0] = first[1] = first[2] = 0;
+  last[0] = last[1] = last[2] = 0;
+  while (count < 3 || p < end) {
+    v = t = n = 0;
+    q = glmParseIndices(p, end, &v, &t, &n, &format);
+    if (q == p && count >= 3)
+      break;
+    if (q == p) {
+      /* missing vertices of the first triangle repeat the last one read */
+      v = last[0];
+      t = last[1];
+      n = last[2];
+    }
+    p = q;
+
+    /* the first vertex decides what the face is made of */
+    if (count == 0)
+      faceFormat = (format & GLM_FACE_VN) ? GLM_FACE_N : format;
+    if (!(faceFormat & GLM_FACE_T))
+      t = 0;
+    if (!(faceFormat & GLM_FACE_N))
+      n = 0;
+
+    if (count < 3) {
+      if (count == 0)
+      {
+        chunk->triangles = (GLMtriangle*)glmGrow(chunk->triangles, chunk->numtriangles,
+          &chunk->maxtriangles, sizeof(GLMtriangle));
+        triangle = &chunk->triangles[chunk->numtriangles++];
+        triangle->findex = 0;
+        first[0] = v;
+        first[1] = t;
+        first[2] = n;
+      }
+      triangle->vindices[count] = v;
+      triangle->tindices[count] = t;
+      triangle->nindices[count] = n;
+    } else {
+      /* tessellating the polygon on the fly */
+      chunk->triangles = (GLMtriangle*)glmGrow(chunk->triangles, chunk->numtriangles,
+        &chunk->maxtriangles, sizeof(GLMtriangle));
+      triangle = &chunk->triangles[chunk->numtriangles++];
+      triangle->findex = 0;
+      triangle->vindices[0] = first[0];
+      triangle->tindices[0] = first[1];
+      triangle->nindices[0] = first[2];
+      triangle->vindices[1] = last[0];
+      triangle->tindices[1] = last[1];
+      triangle->nindices[1] = last[2];
+      triangle->vindices[2] = v;
+      triangle->tindices[2] = t;
+      triangle->nindices[2] = n;
+    }
+    last[0] = v;
+    last[1] = t;
+    last[2] = n;
+    count++;
+  }
+}
+
+/* glmParseChunk: parses the lines of chunks [begin, end) into their own
+ * arrays. A task of the parallel reader.
+ *
+ * context - the GLMreader
+ */
+static void glmParseChunk(void* context, int begin, int end)
+{
+  GLMchunk* chunk;
+  GLfloat* values;
+  char *p, *line, *token, *tokenEnd, *name;
+  int c;
+
+  for (c = begin; c < end; c++) {
+    chunk = &((GLMreader*)context)->chunks[c];
+    for (p = chunk->begin; p < chunk->end && !chunk->error; p = line + 1) {
+      line = (char*)memchr(p, '\n', chunk->end - p);
+      if (!line)
+        line = chunk->end;
+
+      /* first token of the line */
+      while (p < line && glmBlank(*p))
+        p++;
+      if (p == line)
+        continue;
+      token = p;
+      while (p < line && !glmBlank(*p))
+        p++;
+      tokenEnd = p;
+
+      switch (token[0]) {
+      case '#':               /* comment */
+        break;
+      case 'v':               /* v, vn, vt */
+        switch ((tokenEnd - token > 1) ? token[1] : '\0') {
+        case '\0':          /* vertex */
+          chunk->vertices = (GLfloat*)glmGrow(chunk->vertices, chunk->numvertices,
+            &chunk->maxvertices, 3 * sizeof(GLfloat));
+          values = &chunk->vertices[3 * chunk->numvertices++];
+          values[0] = values[1] = values[2] = 0.0;
+          p = glmParseFloat(p, line, &values[0]);
+          p = glmParseFloat(p, line, &values[1]);
+          p = glmParseFloat(p, line, &values[2]);
+          break;
+        case 'n':           /* normal */
+          chunk->normals = (GLfloat*)glmGrow(chunk->normals, chunk->numnormals,
+            &chunk->maxnormals, 3 * sizeof(GLfloat));
+          values = &chunk->normals[3 * chunk->numnormals++];
+          values[0] = values[1] = values[2] = 0.0;
+          p = glmParseFloat(p, line, &values[0]);
+          p = glmParseFloat(p, line, &values[1]);
+          p = glmParseFloat(p, line, &values[2]);
+          break;
+        case 't':           /* texcoord */
+          chunk->texcoords = (GLfloat*)glmGrow(chunk->texcoords, chunk->numtexcoords,
+            &chunk->maxtexcoords, 2 * sizeof(GLfloat));
+          values = &chunk->texcoords[2 * chunk->numtexcoords++];
+          values[0] = values[1] = 0.0;
+          p = glmParseFloat(p, line, &values[0]);
+          p = glmParseFloat(p, line, &values[1]);
+          break;
+        default:
+          chunk->error = token;
+          chunk->errorLength = (int)(tokenEnd - token);
+          break;
+        }
+        break;
+      case 'm':               /* material library */
+      case 'u':               /* material of the group */
+        while (p < line && glmBlank(*p))
+          p++;
+        name = p;
+        while (p < line && !glmBlank(*p))
+          p++;
+        glmChunkCommand(chunk, (token[0] == 'm') ? GLM_MTLLIB : GLM_USEMTL, name, (int)(p - name));
+        break;
+      case 'g':               /* group */
+        /* the name is the rest of the line */
+        glmChunkCommand(chunk, GLM_GROUP, tokenEnd, (int)(line - tokenEnd));
+        break;
+      case 'f':               /* face */
+        glmChunkFace(chunk, p, line);
+        break;
+      default:
+        break;
+      }
+    }
+
+    /* close the last face */
+    chunk->faces = (GLuint*)glmGrow(chunk->faces, chunk->numfaces, &chunk->maxfaces, sizeof(GLuint));
+    chunk->faces[chunk->numfaces] = chunk->numtriangles;
+  }
+}
+
+/* glmCopyChunk: copies the arrays of chunks [begin, end) into the arrays
+ * of the model and frees them. A task of the parallel reader.
+ *
+ * context - the GLMreader
+ */
+static void glmCopyChunk(void* context, int begin, int end)
+{
+  GLMmodel* model = ((GLMreader*)context)->model;
+  GLMchunk* chunk;
+  int c;
+
+  for (c = begin; c < end; c++) {
+    chunk = &((GLMreader*)context)->chunks[c];
+    if (chunk->numvertices)
+      memcpy(&model->vertices[3 * (chunk->firstvertex + 1)], chunk->vertices,
+        sizeof(GLfloat) * 3 * chunk->numvertices);
+    if (chunk->numnormals)
+      memcpy(&model->normals[3 * (chunk->firstnormal + 1)], chunk->normals,
+        sizeof(GLfloat) * 3 * chunk->numnormals);
+    if (chunk->numtexcoords)
+      memcpy(&model->texcoords[2 * (chunk->firsttexcoord + 1)], chunk->texcoords,
+        sizeof(GLfloat) * 2 * chunk->numtexcoords);
+    if (chunk->numtriangles)
+      memcpy(&model->triangles[chunk->firsttriangle], chunk->triangles,
+        sizeof(GLMtriangle) * chunk->numtriangles);
+
+    free(chunk->vertices);
+    free(chunk->normals);
+    free(chunk->texcoords);
+    free(chunk->triangles);
+    chunk->vertices = chunk->normals = chunk->texcoords = NULL;
+    chunk->triangles = NULL;
+  }
+}
+
+/* glmReplayChunks: goes through the faces and commands of all the chunks
+ * in file order. The first time (fill = 0) it reads the material
+ * libraries, makes the groups and counts their triangles and edges, like
+ * glmFirstPass; the second time it sets the materials of the groups and
+ * lists their triangles and edges, like glmSecondPass. As in
+ * glmSecondPass, the statements before the first group statement apply to
+ * the group made last (the head of the list), which is "default" when the
+ * file has no groups; their faces are also counted in that group.
+ *
+ * model     - model being read
+ * chunks    - parsed chunks, with their first triangles in the model
+ * numChunks - number of chunks
+ * fill      - 0 to count, 1 to fill the groups
+ */
+static GLvoid glmReplayChunks(GLMmodel* model, GLMchunk* chunks, int numChunks, int fill)
+{
+  GLMchunk* chunk;
+  GLMcommand* command;
+  GLMgroup* group;
+  GLMgroup leading;
+  GLuint material = 0, face, last, start, end, i;
+  char buf[128];
+  static char defaultGroup[] = "default";
+  int c, k, length;
+
+  /* counts of the faces before the first group statement */
+  leading.numtriangles = 0;
+  leading.numEdges = 0;
+
+  if (fill)
+    group = model->groups;
+  else {
+    glmAddGroup(model, defaultGroup);
+    group = &leading;
+  }
+
+  for (c = 0; c < numChunks; c++) {
+    chunk = &chunks[c];
+    face = 0;
+    for (k = 0; k <= (int)chunk->numcommands; k++) {
+      command = (k < (int)chunk->numcommands) ? &chunk->commands[k] : NULL;
+      last = command ? command->face : chunk->numfaces;
+
+      /* faces before the command */
+      if (!fill) {
+        group->numtriangles += chunk->faces[last] - chunk->faces[face];
+        group->numEdges += chunk->faces[last] - chunk->faces[face] + 2 * (last - face);
+        face = last;
+      }
+      for (; face < last; face++) {
+        start = chunk->firsttriangle + chunk->faces[face];
+        end = chunk->firsttriangle + chunk->faces[face + 1];
+        for (i = start; i < end; i++)
+          group->triangles[group->numtriangles++] = i;
+        AddEdges(model, group, start, end - 1);
+      }
+
+      if (!command)
+        break;
+      length = (command->length < (int)sizeof(buf)) ? command->length : (int)sizeof(buf) - 1;
+      memcpy(buf, command->name, length);
+      buf[length] = '\0';
+
+      switch (command->type) {
+      case GLM_MTLLIB:
+        if (!fill) {
+          model->mtllibname = glmDuplicateString(buf);
+          glmReadMTL(model, model->mtllibname);
+        }
+        break;
+      case GLM_USEMTL:
+        if (fill)
+          group->material = material = glmFindMaterial(model, buf);
+        break;
+      case GLM_GROUP:
+        if (fill) {
+          group = glmFindGroup(model, buf);
+          group->material = material;
+        } else
+          group = glmAddGroup(model, buf);
+        break;
+      }
+    }
+  }
+
+  if (!fill) {
+    model->groups->numtriangles += leading.numtriangles;
+    model->groups->numEdges += leading.numEdges;
+  }
+}
+
+/* glmParallelRead: reads the model from the mapped text of an OBJ file
+ * with the parallel reader.
+ *
+ * model - properly initialized GLMmodel structure
+ * text  - the mapped file
+ * size  - bytes of the file
+ */
+static GLvoid glmParallelRead(GLMmodel* model, char* text, size_t size)
+{
+  GLMreader reader;
+  GLMchunk* chunks;
+  GLMchunk* chunk;
+  static threadPool* loaderPool = NULL;	/* kept for every model read */
+  threadPool* pool = NULL;
+  char* split;
+  int numChunks, c;
+
+  /* cut the file into chunks of whole lines */
+  numChunks = (int)(size / GLM_CHUNK_SIZE) + 1;
+  chunks = (GLMchunk*)calloc(numChunks, sizeof(GLMchunk));
+  for (c = 0; c < numChunks; c++) {
+    chunk = &chunks[c];
+    chunk->begin = c ? chunks[c - 1].end : text;
+    chunk->end = text + size;
+    if (c < numChunks - 1) {
+      split = text + (size / numChunks) * (c + 1);
+      if (split < chunk->begin)
+        split = chunk->begin;
+      split = (char*)memchr(split, '\n', text + size - split);
+      if (split)
+        chunk->end = split + 1;
+    }
+  }
+
+  reader.model = model;
+  reader.chunks = chunks;
+  if (numChunks > 1) {
+    if (!loaderPool)
+      loaderPool = new threadPool(threadPool::hardwareThreads());
+    pool = loaderPool;
+  }
+
+  if (pool)
+    pool->parallelFor(numChunks, 1, glmParseChunk, &reader);
+  else
+    glmParseChunk(&reader, 0, numChunks);
+
+  /* place the chunks in the model */
+  for (c = 0; c < numChunks; c++) {
+    chunk = &chunks[c];
+    if (chunk->error) {
+      printf("glmReadOBJ(): Unknown token \"%.*s\".\n", chunk->errorLength, chunk->error);
+      exit(1);
+    }
+    chunk->firstvertex = model->numvertices;
+    chunk->firstnormal = model->numnormals;
+    chunk->firsttexcoord = model->numtexcoords;
+    chunk->firsttriangle = model->numtriangles;
+    model->numvertices += chunk->numvertices;
+    model->numnormals += chunk->numnormals;
+    model->numtexcoords += chunk->numtexcoords;
+    model->numtriangles += chunk->numtriangles;
+  }
+
+  glmReplayChunks(model, chunks, numChunks, 0);
+  glmAllocateArrays(model);
+
+  if (pool)
+    pool->parallelFor(numChunks, 1, glmCopyChunk, &reader);
+  else
+    glmCopyChunk(&reader, 0, numChunks);
+
+  glmReplayChunks(model, chunks, numChunks, 1);
+
+  for (c = 0; c < numChunks; c++) {
+    free(chunks[c].faces);
+    free(chunks[c].commands);
+  }
+  free(chunks);
+}
+
+
 /* public functions */
 
 
@@ -1053,7 +1843,7 @@ GLvoid glmFacetNormals(GLMmodel* model)
     
     /* clobber any old facetnormals */
     if (model->facetnorms)
-        free(model->facetnorms);
+        glmFreeArray(model, model->facetnorms);
     
     /* allocate memory for the new facet normals */
     model->numfacetnorms = model->numtriangles;
@@ -1086,7 +1876,7 @@ GLvoid glmSetNormalsToFaceNormals(GLMmodel* model)
 {
   /* nuke any previous normals */
   if (model->normals)
-    free(model->normals);
+    glmFreeArray(model, model->normals);
     
   /* allocate space for new normals */
   model->numnormals = model->numtriangles; /* 1 normal per triangle */
@@ -1146,12 +1936,143 @@ GLMnode ** glmBuildNeighborStructure(GLMmodel* model)
   return members;
 }
 
+/* glmAdjacencyRows: sorts every row of an adjacency and removes the
+ * repeated entries, moving the rows together.  Rows are short (the
+ * triangles around a vertex), so they are sorted by insertion, except
+ * for the rare long fans.
+ */
+static int glmCompareIndex(const void* a, const void* b)
+{
+  GLuint x = *(const GLuint*)a, y = *(const GLuint*)b;
+  return (x < y) ? -1 : (x > y);
+}
+
+static GLvoid glmAdjacencyRows(GLMadjacency* adjacency)
+{
+  GLuint i, j, k, begin, end, value, count = 0;
+  GLuint* row;
+
+  for (i = 1; i <= adjacency->numvertices; i++)
+  {
+    begin = adjacency->offset[i];
+    end = adjacency->offset[i+1];
+    row = adjacency->index + begin;
+
+    if (end - begin > 32)
+      qsort(row, end - begin, sizeof(GLuint), glmCompareIndex);
+    else
+      for (j = 1; j < end - begin; j++)
+      {
+        value = row[j];
+        for (k = j; k > 0 && row[k-1] > value; k--)
+          row[k] = row[k-1];
+        row[k] = value;
+      }
+
+    /* row i starts at count now, which is never after begin */
+    adjacency->offset[i] = count;
+    for (j = begin; j < end; j++)
+      if (j == begin || adjacency->index[j] != adjacency->index[j-1])
+        adjacency->index[count++] = adjacency->index[j];
+  }
+  adjacency->offset[adjacency->numvertices + 1] = count;
+}
+
+/* glmBuildTriangleAdjacency: lists the triangles of every vertex, by a
+ * counting sort of the triangle corners: one pass counts the corners
+ * of every vertex, a prefix sum turns the counts into row offsets, and
+ * a second pass drops every triangle into the rows of its corners, in
+ * increasing order.  Two allocations in all, instead of one per corner.
+ *
+ * model - initialized GLMmodel structure
+ */
+GLMadjacency * glmBuildTriangleAdjacency(GLMmodel* model)
+{
+  GLMadjacency* adjacency;
+  GLuint* fill;
+  GLuint i, j, v;
+
+  adjacency = (GLMadjacency*)malloc(sizeof(GLMadjacency));
+  adjacency->numvertices = model->numvertices;
+  adjacency->offset = (GLuint*)calloc(model->numvertices + 2, sizeof(GLuint));
+  adjacency->index = (GLuint*)malloc(sizeof(GLuint) * (3 * model->numtriangles + 1));
+
+  /* offset[v+1] counts the corners of vertex v first */
+  for (i = 0; i < model->numtriangles; i++)
+    for (j = 0; j < 3; j++)
+      adjacency->offset[T(i).vindices[j] + 1]++;
+  for (v = 1; v <= model->numvertices; v++)
+    adjacency->offset[v+1] += adjacency->offset[v];
+
+  /* offset[v] is where the next triangle of v goes, and ends at the
+     start of row v+1, so the offsets are shifted back afterwards */
+  fill = adjacency->offset;
+  for (i = 0; i < model->numtriangles; i++)
+    for (j = 0; j < 3; j++)
+      adjacency->index[fill[T(i).vindices[j]]++] = i;
+  for (v = model->numvertices + 1; v > 1; v--)
+    adjacency->offset[v] = adjacency->offset[v-1];
+  adjacency->offset[1] = 0;
+
+  return adjacency;
+}
+
+/* glmBuildVertexAdjacency: lists the neighbouring vertices of every
+ * vertex, the other corners of its triangles, sorted and without
+ * repeats.
+ *
+ * model - initialized GLMmodel structure
+ * triangles - triangles of every vertex, from glmBuildTriangleAdjacency
+ */
+GLMadjacency * glmBuildVertexAdjacency(GLMmodel* model, GLMadjacency * triangles)
+{
+  GLMadjacency* adjacency;
+  GLuint i, v, t, count = 0;
+
+  adjacency = (GLMadjacency*)malloc(sizeof(GLMadjacency));
+  adjacency->numvertices = model->numvertices;
+  adjacency->offset = (GLuint*)malloc(sizeof(GLuint) * (model->numvertices + 2));
+  adjacency->index = (GLuint*)malloc(sizeof(GLuint) * (2 * triangles->offset[model->numvertices + 1] + 1));
+
+  adjacency->offset[0] = 0;
+  for (v = 1; v <= model->numvertices; v++)
+  {
+    adjacency->offset[v] = count;
+    for (i = triangles->offset[v]; i < triangles->offset[v+1]; i++)
+    {
+      t = triangles->index[i];
+      if (T(t).vindices[0] != v)
+        adjacency->index[count++] = T(t).vindices[0];
+      if (T(t).vindices[1] != v)
+        adjacency->index[count++] = T(t).vindices[1];
+      if (T(t).vindices[2] != v)
+        adjacency->index[count++] = T(t).vindices[2];
+    }
+  }
+  adjacency->offset[model->numvertices + 1] = count;
+
+  glmAdjacencyRows(adjacency);
+  adjacency->index = (GLuint*)realloc(adjacency->index,
+    sizeof(GLuint) * (adjacency->offset[model->numvertices + 1] + 1));
+
+  return adjacency;
+}
+
+GLvoid glmDeleteAdjacency(GLMadjacency * adjacency)
+{
+  if (!adjacency)
+    return;
+  free(adjacency->offset);
+  free(adjacency->index);
+  free(adjacency);
+}
+
 GLvoid glmSetNormalsToFaceNormalsThresholded(GLMmodel* model, GLMnode ** neighborStructure, float thresholdAngle)
 {
   // deallocate any previous normals 
   if ((model->numnormals < 3*model->numtriangles) && (model->normals))
   {
-    free(model->normals);
+    glmFreeArray(model, model->normals);
     // allocate space for new normals 
     model->numnormals = 3*model->numtriangles; /* 3 normals per triangle */
     model->normals = (GLfloat*)malloc(sizeof(GLfloat)* 3 * (model->numnormals+1)); // 3 floats per each normal
@@ -1227,14 +2148,13 @@ GLvoid glmSetNormalsToFaceNormalsThresholded(GLMmodel* model, GLMnode ** neighbo
  */
 GLvoid glmVertexNormals(GLMmodel* model, GLfloat angle)
 {
-    GLMnode*    node;
-    GLMnode*    tail;
-    GLMnode** members;
+    GLMadjacency* members;
+    GLboolean*  averaged;
     GLfloat*    normals;
     GLuint  numnormals;
     GLfloat average[3];
     GLfloat dot, cos_angle;
-    GLuint  i, avg;
+    GLuint  i, avg, n, first = 0, t;
     
     assert(model);
     assert(model->facetnorms);
@@ -1244,63 +2164,45 @@ GLvoid glmVertexNormals(GLMmodel* model, GLfloat angle)
     
     /* nuke any previous normals */
     if (model->normals)
-        free(model->normals);
+        glmFreeArray(model, model->normals);
     
     /* allocate space for new normals */
     model->numnormals = model->numtriangles * 3; /* 3 normals per triangle */
     model->normals = (GLfloat*)malloc(sizeof(GLfloat)* 3* (model->numnormals+1));
     
-    /* allocate a structure that will hold a linked list of triangle
-    indices for each vertex */
-    members = (GLMnode**)malloc(sizeof(GLMnode*) * (model->numvertices + 1));
-    for (i = 1; i <= model->numvertices; i++)
-        members[i] = NULL;
-    
-    /* for every triangle, create a node for each vertex in it */
-    for (i = 0; i < model->numtriangles; i++) {
-        node = (GLMnode*)malloc(sizeof(GLMnode));
-        node->index = i;
-        node->next  = members[T(i).vindices[0]];
-        members[T(i).vindices[0]] = node;
-        
-        node = (GLMnode*)malloc(sizeof(GLMnode));
-        node->index = i;
-        node->next  = members[T(i).vindices[1]];
-        members[T(i).vindices[1]] = node;
-        
-        node = (GLMnode*)malloc(sizeof(GLMnode));
-        node->index = i;
-        node->next  = members[T(i).vindices[2]];
-        members[T(i).vindices[2]] = node;
-    }
+    /* the triangles of every vertex, visited from the last one down
+    (the order the lists were built in), and whether each was averaged */
+    members = glmBuildTriangleAdjacency(model);
+    averaged = (GLboolean*)malloc(sizeof(GLboolean) * (3 * model->numtriangles + 1));
     
     /* calculate the average normal for each vertex */
     numnormals = 1;
     for (i = 1; i <= model->numvertices; i++) {
     /* calculate an average normal for this vertex by averaging the
         facet normal of every triangle this vertex is in */
-        node = members[i];
-        //if (!node)
+        //if (members->offset[i] == members->offset[i+1])
             //fprintf(stderr, "glmVertexNormals(): vertex w/o a triangle\n");
         average[0] = 0.0; average[1] = 0.0; average[2] = 0.0;
         avg = 0;
-        while (node) {
+        if (members->offset[i+1] > members->offset[i])
+            first = members->index[members->offset[i+1] - 1];
+        for (n = members->offset[i+1]; n > members->offset[i]; n--) {
+            t = members->index[n - 1];
         /* only average if the dot product of the angle between the two
         facet normals is greater than the cosine of the threshold
         angle -- or, said another way, the angle between the two
             facet normals is less than (or equal to) the threshold angle */
-            dot = glmDot(&model->facetnorms[3 * T(node->index).findex],
-                &model->facetnorms[3 * T(members[i]->index).findex]);
+            dot = glmDot(&model->facetnorms[3 * T(t).findex],
+                &model->facetnorms[3 * T(first).findex]);
             if (dot > cos_angle) {
-                node->averaged = GL_TRUE;
-                average[0] += model->facetnorms[3 * T(node->index).findex + 0];
-                average[1] += model->facetnorms[3 * T(node->index).findex + 1];
-                average[2] += model->facetnorms[3 * T(node->index).findex + 2];
+                averaged[n - 1] = GL_TRUE;
+                average[0] += model->facetnorms[3 * T(t).findex + 0];
+                average[1] += model->facetnorms[3 * T(t).findex + 1];
+                average[2] += model->facetnorms[3 * T(t).findex + 2];
                 avg = 1;            /* we averaged at least one normal! */
             } else {
-                node->averaged = GL_FALSE;
+                averaged[n - 1] = GL_FALSE;
             }
-            node = node->next;
         }
         
         if (avg) {
@@ -1316,48 +2218,40 @@ GLvoid glmVertexNormals(GLMmodel* model, GLfloat angle)
         }
         
         /* set the normal of this vertex in each triangle it is in */
-        node = members[i];
-        while (node) {
-            if (node->averaged) {
+        for (n = members->offset[i+1]; n > members->offset[i]; n--) {
+            t = members->index[n - 1];
+            if (averaged[n - 1]) {
                 /* if this node was averaged, use the average normal */
-                if (T(node->index).vindices[0] == i)
-                    T(node->index).nindices[0] = avg;
-                else if (T(node->index).vindices[1] == i)
-                    T(node->index).nindices[1] = avg;
-                else if (T(node->index).vindices[2] == i)
-                    T(node->index).nindices[2] = avg;
+                if (T(t).vindices[0] == i)
+                    T(t).nindices[0] = avg;
+                else if (T(t).vindices[1] == i)
+                    T(t).nindices[1] = avg;
+                else if (T(t).vindices[2] == i)
+                    T(t).nindices[2] = avg;
             } else {
                 /* if this node wasn't averaged, use the facet normal */
                 model->normals[3 * numnormals + 0] = 
-                    model->facetnorms[3 * T(node->index).findex + 0];
+                    model->facetnorms[3 * T(t).findex + 0];
                 model->normals[3 * numnormals + 1] = 
-                    model->facetnorms[3 * T(node->index).findex + 1];
+                    model->facetnorms[3 * T(t).findex + 1];
                 model->normals[3 * numnormals + 2] = 
-                    model->facetnorms[3 * T(node->index).findex + 2];
-                if (T(node->index).vindices[0] == i)
-                    T(node->index).nindices[0] = numnormals;
-                else if (T(node->index).vindices[1] == i)
-                    T(node->index).nindices[1] = numnormals;
-                else if (T(node->index).vindices[2] == i)
-                    T(node->index).nindices[2] = numnormals;
+                    model->facetnorms[3 * T(t).findex + 2];
+                if (T(t).vindices[0] == i)
+                    T(t).nindices[0] = numnormals;
+                else if (T(t).vindices[1] == i)
+                    T(t).nindices[1] = numnormals;
+                else if (T(t).vindices[2] == i)
+                    T(t).nindices[2] = numnormals;
                 numnormals++;
             }
-            node = node->next;
         }
     }
     
     model->numnormals = numnormals - 1;
     
     /* free the member information */
-    for (i = 1; i <= model->numvertices; i++) {
-        node = members[i];
-        while (node) {
-            tail = node;
-            node = node->next;
-            free(tail);
-        }
-    }
-    free(members);
+    free(averaged);
+    glmDeleteAdjacency(members);
     
     /* pack the normals array (we previously allocated the maximum
     number of normals that could possibly be created (numtriangles *
@@ -1391,7 +2285,7 @@ GLvoid glmLinearTexture(GLMmodel* model)
     assert(model);
     
     if (model->texcoords)
-        free(model->texcoords);
+        glmFreeArray(model, model->texcoords);
     model->numtexcoords = model->numvertices;
     model->texcoords=(GLfloat*)malloc(sizeof(GLfloat)*2*(model->numtexcoords+1));
     
@@ -1445,7 +2339,7 @@ GLvoid glmSpheremapTexture(GLMmodel* model)
     assert(model->normals);
     
     if (model->texcoords)
-        free(model->texcoords);
+        glmFreeArray(model, model->texcoords);
     model->numtexcoords = model->numnormals;
     model->texcoords=(GLfloat*)malloc(sizeof(GLfloat)*2*(model->numtexcoords+1));
     
@@ -1500,12 +2394,12 @@ GLvoid glmDelete(GLMmodel* model)
     
     if (model->pathname)     free(model->pathname);
     if (model->mtllibname) free(model->mtllibname);
-    if (model->vertices)     free(model->vertices);
-    if (model->verticesRest)     free(model->verticesRest);
-    if (model->normals)  free(model->normals);
-    if (model->texcoords)  free(model->texcoords);
-    if (model->facetnorms) free(model->facetnorms);
-    if (model->triangles)  free(model->triangles);
+    glmFreeArray(model, model->vertices);
+    glmFreeArray(model, model->verticesRest);
+    glmFreeArray(model, model->normals);
+    glmFreeArray(model, model->texcoords);
+    glmFreeArray(model, model->facetnorms);
+    glmFreeArray(model, model->triangles);
     if (model->materials) 
       glmDeleteMaterials(model);
     while(model->groups) 
@@ -1513,11 +2407,12 @@ GLvoid glmDelete(GLMmodel* model)
       group = model->groups;
       model->groups = model->groups->next;
       free(group->name);
-      free(group->triangles);
-      free(group->edges);
+      glmFreeArray(model, group->triangles);
+      glmFreeArray(model, group->edges);
       free(group);
     }
     if (model->directory)  free(model->directory);
+    if (model->mapping)  glmUnmapFile(model->mapping, model->mappingSize);
     
     free(model);
 }
@@ -1539,7 +2434,7 @@ void glmSetMemoryAllocationSizes(
 
 /* glmReadOBJ: Reads a model description from a Wavefront .OBJ file.
  * Returns a pointer to the created object which should be free'd with
- * glmDelete().
+ * glmDelete(). The file is parsed by glmParallelRead.
  *
  * filename - name of the file containing the Wavefront .OBJ format data.  
  */
@@ -1547,6 +2442,8 @@ GLMmodel * glmReadOBJ(char* filename)
 {
     GLMmodel * model;
     FILE * file;
+    char * text;
+    size_t size;
     
     /* open the file */
     file = fopen(filename, "r");
@@ -1579,6 +2476,8 @@ GLMmodel * glmReadOBJ(char* filename)
     model->position[0]   = 0.0;
     model->position[1]   = 0.0;
     model->position[2]   = 0.0;
+    model->mapping       = NULL;
+    model->mappingSize   = 0;
     
     // now directory is known
     // make a copy for possible future use (as in loading textures)
@@ -1587,83 +2486,32 @@ GLMmodel * glmReadOBJ(char* filename)
     // make one default material just in case there is no usemtl tag
     glmMakeDefaultMaterials(model,1);
 
-    /* make a first pass through the file to get a count of the number
-    of vertices, normals, texcoords & triangles */
-
-    glmFirstPass(model, file);
-    
-    GLMgroup * group;
-
-    if (memoryAllocationMode == GLM_TIGHT)
+    /* read the mapped file in parallel chunks, or in two passes through
+    the stream when it can't be mapped (empty files) */
+    text = (char*)glmMapFile(filename, &size);
+    if (text)
     {
-      /* allocate memory for the triangles in each group */
-      group = model->groups;
-      while(group) 
-      {
-        group->triangles = (GLuint*)malloc(sizeof(GLuint) * group->numtriangles);
-        group->numtriangles = 0;
-        group->edges = (GLuint*)malloc(sizeof(GLuint) * group->numEdges * 2);
-        group->numEdges = 0;
-        group = group->next;
-      }
-
-      //printf("--------- Allocator: num vertices = %d\n", model->numvertices);
-      model->vertices = (GLfloat*)malloc(sizeof(GLfloat) * 3 * (model->numvertices + 1));
-
-      model->verticesRest = (GLfloat*)malloc(sizeof(GLfloat) * 3 * (model->numvertices + 1));
-
-      model->triangles = (GLMtriangle*)malloc(sizeof(GLMtriangle) * model->numtriangles);
-
-      if (model->numnormals) 
-      {
-          model->normals = (GLfloat*)malloc(sizeof(GLfloat) *
-              3 * (model->numnormals + 1));
-      }
-
-      if (model->numtexcoords) 
-      {
-          model->texcoords = (GLfloat*)malloc(sizeof(GLfloat) *
-              2 * (model->numtexcoords + 1));
-      }
+      fclose(file);
+      glmParallelRead(model, text, size);
+      glmUnmapFile(text, size);
     }
     else
     {
-      /* allocate memory */
-
-      group = model->groups;
-      while(group) 
-      {
-        group->triangles = (GLuint*)malloc(sizeof(GLuint) * maxNumTriangles);
-        group->numtriangles = 0;
-        group->edges = (GLuint*)malloc(sizeof(GLuint) * group->numEdges * 2);
-        group->numEdges = 0;
-        group = group->next;
-      }
+      /* make a first pass through the file to get a count of the number
+      of vertices, normals, texcoords & triangles */
 
-      model->vertices = (GLfloat*)malloc(sizeof(GLfloat) *
-          3 * (maxNumVertices + 1));
+      glmFirstPass(model, file);
+      glmAllocateArrays(model);
 
-      model->verticesRest = (GLfloat*)malloc(sizeof(GLfloat) *
-        3 * (maxNumVertices + 1));
+      /* rewind to beginning of file and read in the data this pass */
+      rewind(file);
 
-      model->triangles = (GLMtriangle*)malloc(sizeof(GLMtriangle) *
-          maxNumTriangles);
-
-      model->normals = (GLfloat*)malloc(sizeof(GLfloat) *
-              3 * (maxNumNormals + 1));
+      glmSecondPass(model, file);
 
-      model->texcoords = (GLfloat*)malloc(sizeof(GLfloat) *
-              2 * (maxNumTexCoords + 1));
+      /* close the file */
+      fclose(file);
     }
 
-    /* rewind to beginning of file and read in the data this pass */
-    rewind(file);
-    
-    glmSecondPass(model, file);
-    
-    /* close the file */
-    fclose(file);
-
     // copy vertices into their rest position
     for (unsigned int i=1; i <= model->numvertices; i++)
     {
@@ -1876,6 +2724,7 @@ glmWriteOBJ(GLMmodel* model, char* filename, GLuint mode, int writeMTL)
     fclose(file);
 }
 
+#ifndef HEADLESS
 int glmSetUpTextures(GLMmodel* model, int mode)
 {
   if (!model->texcoords) 
@@ -2288,6 +3137,7 @@ GLuint glmListEdges(GLMmodel* model)
     
     return list;
 }
+#endif
 
 /* glmWeld: eliminate (weld) vectors that are within an epsilon of
  * each other.
@@ -2322,7 +3172,7 @@ glmWeld(GLMmodel* model, GLfloat epsilon)
     }
     
     /* free space for old vertices */
-    free(vectors);
+    glmFreeArray(model, vectors);
     
     /* allocate space for the new vertices */
     model->numvertices = numvectors;
@@ -2465,6 +3315,7 @@ GLvoid glmApplyDeformation(GLMmodel * model, double * u, int * mask)
   }
 }
 
+#ifndef HEADLESS
 GLvoid glmDrawPoints(GLMmodel * model)
 {
   glBegin(GL_POINTS);
@@ -2568,6 +3419,7 @@ GLvoid glmDrawNormals(GLMmodel * model)
     }
 
 }
+#endif
 
 int glmCopyVertex(GLMmodel * model, int i)
 {
@@ -2722,39 +3574,16 @@ void glmPermuteVertices(GLMmodel * model, int * permutation)
 // assumed normals has been pre-allocated, to the size of 3 * sizeof(float) * model->numvertices
 GLvoid glmVertexAveragedNormals(GLMmodel* model, float * normals)
 {
-    GLMnode*    node;
-    GLMnode*    tail;
-    GLMnode** members;
+    GLMadjacency* members;
     GLuint  numnormals;
     GLfloat average[3];
-    GLuint  i, avg;
+    GLuint  i, avg, n, t;
     
     assert(model);
     assert(model->facetnorms);
 
-    /* allocate a structure that will hold a linked list of triangle
-    indices for each vertex */
-    members = (GLMnode**)malloc(sizeof(GLMnode*) * (model->numvertices + 1));
-    for (i = 1; i <= model->numvertices; i++)
-      members[i] = NULL;
-    
-    /* for every triangle, create a node for each vertex in it */
-    for (i = 0; i < model->numtriangles; i++) {
-        node = (GLMnode*)malloc(sizeof(GLMnode));
-        node->index = i;
-        node->next  = members[T(i).vindices[0]];
-        members[T(i).vindices[0]] = node;
-        
-        node = (GLMnode*)malloc(sizeof(GLMnode));
-        node->index = i;
-        node->next  = members[T(i).vindices[1]];
-        members[T(i).vindices[1]] = node;
-        
-        node = (GLMnode*)malloc(sizeof(GLMnode));
-        node->index = i;
-        node->next  = members[T(i).vindices[2]];
-        members[T(i).vindices[2]] = node;
-    }
+    /* the triangles of every vertex */
+    members = glmBuildTriangleAdjacency(model);
     
     // for each vertex i:
     //   traverse the list of all faces that contain the vertex i
@@ -2772,18 +3601,17 @@ GLvoid glmVertexAveragedNormals(GLMmodel* model, float * normals)
 	{
         /* calculate an average normal for this vertex by averaging the
         facet normal of every triangle this vertex is in */
-        node = members[i];  // list of triangles containing node i
-        //if (!node)
+        // triangles containing node i, from the last one down
+        //if (members->offset[i] == members->offset[i+1])
             //printf("glmVertexNormals(): vertex w/o a triangle\n");
         average[0] = 0.0; average[1] = 0.0; average[2] = 0.0;
         avg = 0;
-        while (node) { // average the normals
-            node->averaged = GL_TRUE;
-            average[0] += model->facetnorms[3 * T(node->index).findex + 0];
-            average[1] += model->facetnorms[3 * T(node->index).findex + 1];
-            average[2] += model->facetnorms[3 * T(node->index).findex + 2];
+        for (n = members->offset[i+1]; n > members->offset[i]; n--) { // average the normals
+            t = members->index[n - 1];
+            average[0] += model->facetnorms[3 * T(t).findex + 0];
+            average[1] += model->facetnorms[3 * T(t).findex + 1];
+            average[2] += model->facetnorms[3 * T(t).findex + 2];
             avg = 1;            /* we averaged at least one normal! */
-            node = node->next;
         }
         
         if (avg) 
@@ -2810,15 +3638,7 @@ GLvoid glmVertexAveragedNormals(GLMmodel* model, float * normals)
     }
     
     /* free the member information */
-    for (i = 1; i <= model->numvertices; i++) {
-        node = members[i];
-        while (node) {
-            tail = node;
-            node = node->next;
-            free(tail);
-        }
-    }
-    free(members);
+    glmDeleteAdjacency(members);
 
 }
 /*
@@ -2941,6 +3761,7 @@ GLvoid saveToFlatFormat(GLMmodel* model, char * filename)
   fclose(fout);
 }
 
+#ifndef HEADLESS
 GLvoid glmPrint_bitmap_string(float x,float y, float z, char* s)
 {
    glRasterPos3f(x,y,z);
@@ -2961,6 +3782,7 @@ GLvoid glmPrint_bitmap_integer(float x,float y, float z,long i)
   glmPrint_bitmap_string(x,y,z,s);
 
 }
+#endif
 
 int glmClosestVertex(GLMmodel * model, double queryPosX, double queryPosY, double queryPosZ)
 {
@@ -2991,6 +3813,7 @@ int glmClosestVertex(GLMmodel * model, double queryPosX, double queryPosY, doubl
 
 
 
+#ifndef HEADLESS
 // shows all point labels, 1-indexing
 GLvoid glmShowPointLabels(GLMmodel* model)
 {
@@ -3008,6 +3831,7 @@ GLvoid glmShowPointLabels(GLMmodel* model, int k, int l)
   for (int i=k; i<=l; i++)
     glmPrint_bitmap_integer(model->vertices[3*i],model->vertices[3*i+1],model->vertices[3*i+2],i);
 }
+#endif
 
 GLvoid glmMeshGeometricParameters(GLMmodel * mesh, double * centerX, double * centerY, double * centerZ, double * radius)
 {
@@ -3078,3 +3902,442 @@ GLvoid glmMeshData(GLMmodel * mesh, int * numVertices, double ** vertices, int *
     (*vertices)[i] = mesh->vertices[i+3];
 }
 
+
+#define GLM_BINARY_NONE 0xFFFFFFFF   /* string offset of a NULL string */
+
+/* GLMbinaryHeader: first bytes of a file written by glmWriteBinary. The
+ * arrays are at the given offsets from the start of the file. */
+typedef struct _GLMbinaryHeader {
+  char      magic[4];           /* "GLMB" */
+  GLuint    version;            /* GLM_BINARY_VERSION */
+  GLuint    headerSize;         /* sizes of the structures, the file is */
+  GLuint    triangleSize;       /* only read back with the same layout */
+  GLuint    materialSize;
+  GLuint    groupSize;
+  unsigned long long fileSize;
+  long long objSize;            /* .obj file the model was read from */
+  unsigned long long objHash;
+  long long mtlSize;            /* its material library, -1 if none */
+  unsigned long long mtlHash;
+  GLuint    numvertices;
+  GLuint    numnormals;
+  GLuint    numtexcoords;
+  GLuint    numtriangles;
+  GLuint    nummaterials;
+  GLuint    numgroups;
+  GLfloat   position[3];
+  GLuint    mtllibname;         /* offset in the strings */
+  unsigned long long vertices;  /* 3 * (numvertices + 1) GLfloats */
+  unsigned long long verticesRest;
+  unsigned long long normals;   /* 3 * (numnormals + 1) GLfloats */
+  unsigned long long texcoords; /* 2 * (numtexcoords + 1) GLfloats */
+  unsigned long long triangles; /* numtriangles GLMtriangles */
+  unsigned long long materials; /* nummaterials GLMbinaryMaterials */
+  unsigned long long groups;    /* numgroups GLMbinaryGroups, in the order of the group list */
+  unsigned long long strings;   /* nul terminated strings */
+  unsigned long long stringsSize;
+} GLMbinaryHeader;
+
+typedef struct _GLMbinaryMaterial {
+  GLuint  name;                 /* offsets in the strings */
+  GLuint  textureFile;
+  GLfloat diffuse[4];
+  GLfloat ambient[4];
+  GLfloat specular[4];
+  GLfloat emmissive[4];
+  GLfloat shininess;
+} GLMbinaryMaterial;
+
+typedef struct _GLMbinaryGroup {
+  GLuint  name;                 /* offset in the strings */
+  GLuint  material;
+  GLuint  numtriangles;
+  GLuint  numEdges;
+  unsigned long long triangles; /* numtriangles GLuints */
+  unsigned long long edges;     /* 2 * numEdges GLuints */
+} GLMbinaryGroup;
+
+/* glmFileStamp: size of a file and hash of its bytes (64 bit FNV-1a over
+ * 32 bit words, as the rest files of shapeCache), so that an edit is seen
+ * whatever the resolution of the modification time. The size is -1 if the
+ * file can't be read. */
+static GLvoid glmFileStamp(char* filename, long long* size, unsigned long long* hash)
+{
+  struct stat status;
+  unsigned char* data;
+  size_t length, i;
+  unsigned int word;
+
+  *size = -1;
+  *hash = 14695981039346656037ULL;
+  if (filename == NULL || stat(filename, &status) != 0)
+    return;
+  if (status.st_size == 0)
+  {
+    *size = 0;
+    return;
+  }
+
+  data = (unsigned char*)glmMapFile(filename, &length);
+  if (data == NULL)
+    return;
+  for (i = 0; i + sizeof(word) <= length; i += sizeof(word))
+  {
+    memcpy(&word, data + i, sizeof(word));
+    *hash = (*hash ^ word) * 1099511628211ULL;
+  }
+  for (; i < length; i++)
+    *hash = (*hash ^ data[i]) * 1099511628211ULL;
+  glmUnmapFile(data, length);
+  *size = (long long)length;
+}
+
+/* glmSourceStamps: stamps of an .obj file and of its material library,
+ * which glmReadMTL looks for in the folder of the .obj file */
+static GLvoid glmSourceStamps(char* objfilename, char* mtllibname, long long sizes[2], unsigned long long hashes[2])
+{
+  char* dir;
+  char* filename;
+
+  glmFileStamp(objfilename, &sizes[0], &hashes[0]);
+  sizes[1] = -1;
+  hashes[1] = 0;
+  if (mtllibname)
+  {
+    dir = glmDirName(objfilename);
+    filename = (char*)malloc(sizeof(char) * (strlen(dir) + strlen(mtllibname) + 2));
+    strcpy(filename, dir);
+    strcat(filename, "/");
+    strcat(filename, mtllibname);
+    glmFileStamp(filename, &sizes[1], &hashes[1]);
+    free(filename);
+    free(dir);
+  }
+}
+
+/* glmBinarySection: reserves size bytes at the end of the file, starting
+ * on a GLM_BINARY_ALIGN boundary, and returns their offset */
+static unsigned long long glmBinarySection(unsigned long long* end, unsigned long long size)
+{
+  unsigned long long offset;
+
+  offset = (*end + GLM_BINARY_ALIGN - 1) / GLM_BINARY_ALIGN * GLM_BINARY_ALIGN;
+  *end = offset + size;
+  return offset;
+}
+
+/* glmBinaryString: reserves a string at the end of the strings and
+ * returns its offset */
+static GLuint glmBinaryString(char* string, unsigned long long* end)
+{
+  GLuint offset;
+
+  if (string == NULL)
+    return GLM_BINARY_NONE;
+  offset = (GLuint)*end;
+  *end += strlen(string) + 1;
+  return offset;
+}
+
+int glmWriteBinary(GLMmodel* model, char* filename)
+{
+  GLMbinaryHeader header;
+  GLMbinaryMaterial* materials;
+  GLMbinaryGroup* groups;
+  GLMgroup* group;
+  long long sizes[2];
+  unsigned long long hashes[2];
+  unsigned long long end, size;
+  char* data;
+  char* strings;
+  FILE* file;
+  GLuint i;
+  int failed, error;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "GLMB", 4);
+  header.version = GLM_BINARY_VERSION;
+  header.headerSize = sizeof(GLMbinaryHeader);
+  header.triangleSize = sizeof(GLMtriangle);
+  header.materialSize = sizeof(GLMbinaryMaterial);
+  header.groupSize = sizeof(GLMbinaryGroup);
+  glmSourceStamps(model->pathname, model->mtllibname, sizes, hashes);
+  header.objSize = sizes[0];
+  header.objHash = hashes[0];
+  header.mtlSize = sizes[1];
+  header.mtlHash = hashes[1];
+  header.numvertices = model->numvertices;
+  header.numnormals = model->numnormals;
+  header.numtexcoords = model->numtexcoords;
+  header.numtriangles = model->numtriangles;
+  header.nummaterials = model->nummaterials;
+  header.numgroups = model->numgroups;
+  memcpy(header.position, model->position, sizeof(header.position));
+
+  /* lay the arrays out */
+  materials = (GLMbinaryMaterial*)calloc(model->nummaterials + 1, sizeof(GLMbinaryMaterial));
+  groups = (GLMbinaryGroup*)calloc(model->numgroups + 1, sizeof(GLMbinaryGroup));
+  end = sizeof(GLMbinaryHeader);
+  header.vertices = glmBinarySection(&end, sizeof(GLfloat) * 3 * (model->numvertices + 1));
+  header.verticesRest = glmBinarySection(&end, sizeof(GLfloat) * 3 * (model->numvertices + 1));
+  if (model->numnormals)
+    header.normals = glmBinarySection(&end, sizeof(GLfloat) * 3 * (model->numnormals + 1));
+  if (model->numtexcoords)
+    header.texcoords = glmBinarySection(&end, sizeof(GLfloat) * 2 * (model->numtexcoords + 1));
+  header.triangles = glmBinarySection(&end, sizeof(GLMtriangle) * model->numtriangles);
+  header.materials = glmBinarySection(&end, sizeof(GLMbinaryMaterial) * model->nummaterials);
+  header.groups = glmBinarySection(&end, sizeof(GLMbinaryGroup) * model->numgroups);
+  for (group = model->groups, i = 0; group; group = group->next, i++)
+  {
+    groups[i].material = group->material;
+    groups[i].numtriangles = group->numtriangles;
+    groups[i].numEdges = group->numEdges;
+    groups[i].triangles = glmBinarySection(&end, sizeof(GLuint) * group->numtriangles);
+    groups[i].edges = glmBinarySection(&end, sizeof(GLuint) * 2 * group->numEdges);
+  }
+
+  size = 0;
+  header.mtllibname = glmBinaryString(model->mtllibname, &size);
+  for (i = 0; i < model->nummaterials; i++)
+  {
+    materials[i].name = glmBinaryString(model->materials[i].name, &size);
+    materials[i].textureFile = glmBinaryString(model->materials[i].textureFile, &size);
+    memcpy(materials[i].diffuse, model->materials[i].diffuse, sizeof(materials[i].diffuse));
+    memcpy(materials[i].ambient, model->materials[i].ambient, sizeof(materials[i].ambient));
+    memcpy(materials[i].specular, model->materials[i].specular, sizeof(materials[i].specular));
+    memcpy(materials[i].emmissive, model->materials[i].emmissive, sizeof(materials[i].emmissive));
+    materials[i].shininess = model->materials[i].shininess;
+  }
+  for (group = model->groups, i = 0; group; group = group->next, i++)
+    groups[i].name = glmBinaryString(group->name, &size);
+  header.strings = glmBinarySection(&end, size);
+  header.stringsSize = size;
+  header.fileSize = end;
+
+  /* fill them in */
+  data = (char*)calloc(end, 1);
+  memcpy(data, &header, sizeof(header));
+  memcpy(data + header.vertices + 3 * sizeof(GLfloat), model->vertices + 3, 
+    sizeof(GLfloat) * 3 * model->numvertices);
+  memcpy(data + header.verticesRest + 3 * sizeof(GLfloat), model->verticesRest + 3, 
+    sizeof(GLfloat) * 3 * model->numvertices);
+  if (model->numnormals)
+    memcpy(data + header.normals, model->normals, sizeof(GLfloat) * 3 * (model->numnormals + 1));
+  if (model->numtexcoords)
+    memcpy(data + header.texcoords, model->texcoords, sizeof(GLfloat) * 2 * (model->numtexcoords + 1));
+  memcpy(data + header.triangles, model->triangles, sizeof(GLMtriangle) * model->numtriangles);
+  memcpy(data + header.materials, materials, sizeof(GLMbinaryMaterial) * model->nummaterials);
+  memcpy(data + header.groups, groups, sizeof(GLMbinaryGroup) * model->numgroups);
+
+  strings = data + header.strings;
+  if (model->mtllibname)
+    strcpy(strings + header.mtllibname, model->mtllibname);
+  for (i = 0; i < model->nummaterials; i++)
+  {
+    if (model->materials[i].name)
+      strcpy(strings + materials[i].name, model->materials[i].name);
+    if (model->materials[i].textureFile)
+      strcpy(strings + materials[i].textureFile, model->materials[i].textureFile);
+  }
+  for (group = model->groups, i = 0; group; group = group->next, i++)
+  {
+    memcpy(data + groups[i].triangles, group->triangles, sizeof(GLuint) * group->numtriangles);
+    memcpy(data + groups[i].edges, group->edges, sizeof(GLuint) * 2 * group->numEdges);
+    strcpy(strings + groups[i].name, group->name);
+  }
+
+  /* a file cut short is removed, errno tells why it failed */
+  failed = 1;
+  file = fopen(filename, "wb");
+  error = errno;
+  if (file)
+  {
+    failed = (fwrite(data, 1, end, file) != end);
+    failed |= (fclose(file) != 0);
+    error = errno;
+    if (failed)
+      remove(filename);
+  }
+
+  free(data);
+  free(groups);
+  free(materials);
+  errno = error;
+  return failed;
+}
+
+/* glmBinarySectionValid: the array of size bytes at offset lies in the
+ * file */
+static int glmBinarySectionValid(unsigned long long offset, unsigned long long size, size_t fileSize)
+{
+  return (offset <= fileSize) && (size <= fileSize - offset);
+}
+
+/* glmBinaryValid: the mapped file is a complete binary model of this
+ * version, whose arrays and strings all lie inside it */
+static int glmBinaryValid(char* data, size_t size)
+{
+  GLMbinaryHeader* header = (GLMbinaryHeader*)data;
+  GLMbinaryMaterial* materials;
+  GLMbinaryGroup* groups;
+  GLuint i;
+
+  if (size < sizeof(GLMbinaryHeader) || memcmp(header->magic, "GLMB", 4) != 0 ||
+      header->version != GLM_BINARY_VERSION || header->headerSize != sizeof(GLMbinaryHeader) ||
+      header->triangleSize != sizeof(GLMtriangle) || header->materialSize != sizeof(GLMbinaryMaterial) ||
+      header->groupSize != sizeof(GLMbinaryGroup) || header->fileSize != size)
+    return 0;
+
+  if (!glmBinarySectionValid(header->vertices, sizeof(GLfloat) * 3 * ((unsigned long long)header->numvertices + 1), size) ||
+      !glmBinarySectionValid(header->verticesRest, sizeof(GLfloat) * 3 * ((unsigned long long)header->numvertices + 1), size) ||
+      (header->numnormals && !glmBinarySectionValid(header->normals, sizeof(GLfloat) * 3 * ((unsigned long long)header->numnormals + 1), size)) ||
+      (header->numtexcoords && !glmBinarySectionValid(header->texcoords, sizeof(GLfloat) * 2 * ((unsigned long long)header->numtexcoords + 1), size)) ||
+      !glmBinarySectionValid(header->triangles, sizeof(GLMtriangle) * (unsigned long long)header->numtriangles, size) ||
+      !glmBinarySectionValid(header->materials, sizeof(GLMbinaryMaterial) * (unsigned long long)header->nummaterials, size) ||
+      !glmBinarySectionValid(header->groups, sizeof(GLMbinaryGroup) * (unsigned long long)header->numgroups, size) ||
+      !glmBinarySectionValid(header->strings, header->stringsSize, size) ||
+      (header->stringsSize && data[header->strings + header->stringsSize - 1] != '\0'))
+    return 0;
+
+#define GLM_BINARY_STRING_VALID(s) ((s) == GLM_BINARY_NONE || (s) < header->stringsSize)
+  if (!GLM_BINARY_STRING_VALID(header->mtllibname))
+    return 0;
+  materials = (GLMbinaryMaterial*)(data + header->materials);
+  for (i = 0; i < header->nummaterials; i++)
+    if (!GLM_BINARY_STRING_VALID(materials[i].name) || !GLM_BINARY_STRING_VALID(materials[i].textureFile))
+      return 0;
+  groups = (GLMbinaryGroup*)(data + header->groups);
+  for (i = 0; i < header->numgroups; i++)
+    if (groups[i].name == GLM_BINARY_NONE || !GLM_BINARY_STRING_VALID(groups[i].name) ||
+        !glmBinarySectionValid(groups[i].triangles, sizeof(GLuint) * (unsigned long long)groups[i].numtriangles, size) ||
+        !glmBinarySectionValid(groups[i].edges, sizeof(GLuint) * 2 * (unsigned long long)groups[i].numEdges, size))
+      return 0;
+#undef GLM_BINARY_STRING_VALID
+
+  return 1;
+}
+
+GLMmodel* glmReadBinary(char* filename, char* objfilename)
+{
+  GLMbinaryHeader* header;
+  GLMbinaryMaterial* materials;
+  GLMbinaryGroup* groups;
+  GLMgroup* group;
+  GLMgroup** last;
+  GLMmodel* model;
+  long long sizes[2];
+  unsigned long long hashes[2];
+  char* data;
+  char* strings;
+  size_t size;
+  GLuint i;
+
+  data = (char*)glmMapFile(filename, &size);
+  if (data == NULL)
+    return NULL;
+
+  header = (GLMbinaryHeader*)data;
+  if (!glmBinaryValid(data, size))
+  {
+    glmUnmapFile(data, size);
+    return NULL;
+  }
+
+  /* out of date if the bytes of the .obj or .mtl file changed since it was written */
+  strings = data + header->strings;
+  glmSourceStamps(objfilename, header->mtllibname == GLM_BINARY_NONE ? NULL : strings + header->mtllibname, sizes, hashes);
+  if (sizes[0] != header->objSize || hashes[0] != header->objHash ||
+      sizes[1] != header->mtlSize || hashes[1] != header->mtlHash)
+  {
+    glmUnmapFile(data, size);
+    return NULL;
+  }
+
+  model = (GLMmodel*) malloc (sizeof(GLMmodel));
+  model->pathname      = glmDuplicateString(objfilename);
+  model->mtllibname    = NULL;
+  if (header->mtllibname != GLM_BINARY_NONE)
+    model->mtllibname  = glmDuplicateString(strings + header->mtllibname);
+  model->numvertices   = header->numvertices;
+  model->vertices      = (GLfloat*)(data + header->vertices);
+  model->verticesRest  = (GLfloat*)(data + header->verticesRest);
+  model->numnormals    = header->numnormals;
+  model->normals       = header->numnormals ? (GLfloat*)(data + header->normals) : NULL;
+  model->numtexcoords  = header->numtexcoords;
+  model->texcoords     = header->numtexcoords ? (GLfloat*)(data + header->texcoords) : NULL;
+  model->numfacetnorms = 0;
+  model->facetnorms    = NULL;
+  model->numtriangles  = header->numtriangles;
+  model->triangles     = (GLMtriangle*)(data + header->triangles);
+  model->textureMode   = 0;
+  model->position[0]   = header->position[0];
+  model->position[1]   = header->position[1];
+  model->position[2]   = header->position[2];
+  model->directory     = glmDirName(objfilename);
+  model->mapping       = data;
+  model->mappingSize   = size;
+
+  /* the materials are copied, since textures get loaded into them */
+  materials = (GLMbinaryMaterial*)(data + header->materials);
+  model->nummaterials  = header->nummaterials;
+  model->materials     = (GLMmaterial*)malloc(sizeof(GLMmaterial) * (header->nummaterials + 1));
+  for (i = 0; i < header->nummaterials; i++)
+  {
+    model->materials[i].name = NULL;
+    if (materials[i].name != GLM_BINARY_NONE)
+      model->materials[i].name = glmDuplicateString(strings + materials[i].name);
+    model->materials[i].textureFile = NULL;
+    if (materials[i].textureFile != GLM_BINARY_NONE)
+      model->materials[i].textureFile = glmDuplicateString(strings + materials[i].textureFile);
+    model->materials[i].textureData = NULL;
+    model->materials[i].textureName = 0;
+    memcpy(model->materials[i].diffuse, materials[i].diffuse, sizeof(materials[i].diffuse));
+    memcpy(model->materials[i].ambient, materials[i].ambient, sizeof(materials[i].ambient));
+    memcpy(model->materials[i].specular, materials[i].specular, sizeof(materials[i].specular));
+    memcpy(model->materials[i].emmissive, materials[i].emmissive, sizeof(materials[i].emmissive));
+    model->materials[i].shininess = materials[i].shininess;
+  }
+
+  /* the group list, in the same order */
+  groups = (GLMbinaryGroup*)(data + header->groups);
+  model->numgroups = header->numgroups;
+  model->groups = NULL;
+  last = &model->groups;
+  for (i = 0; i < header->numgroups; i++)
+  {
+    group = (GLMgroup*)malloc(sizeof(GLMgroup));
+    group->name = glmDuplicateString(strings + groups[i].name);
+    group->material = groups[i].material;
+    group->numtriangles = groups[i].numtriangles;
+    group->triangles = (GLuint*)(data + groups[i].triangles);
+    group->numEdges = groups[i].numEdges;
+    group->edges = (GLuint*)(data + groups[i].edges);
+    group->next = NULL;
+    *last = group;
+    last = &group->next;
+  }
+
+  return model;
+}
+
+GLMmodel* glmReadOBJCached(char* filename)
+{
+  GLMmodel* model;
+  char* binary;
+
+  binary = (char*)malloc(sizeof(char) * (strlen(filename) + strlen(GLM_BINARY_SUFFIX) + 1));
+  strcpy(binary, filename);
+  strcat(binary, GLM_BINARY_SUFFIX);
+
+  model = glmReadBinary(binary, filename);
+  if (model == NULL)
+  {
+    model = glmReadOBJ(filename);
+    /* a read-only folder just keeps reading the .obj file */
+    if (glmWriteBinary(model, binary) != 0 && errno != EACCES && errno != EPERM && errno != EROFS)
+      printf("glmReadOBJCached() warning: can't write binary file %s.\n", binary);
+  }
+
+  free(binary);
+  return model;
+}
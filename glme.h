@@ -23,6 +23,7 @@
 #define _GLME_H_
 
 #include <math.h>
+#include <stddef.h>
 #include <assert.h>
 
 #ifndef M_PI
@@ -122,6 +123,9 @@ typedef struct _GLMmodel {
 
   char * directory;             /* the folder where the model is */
 
+  void * mapping;               /* binary file the arrays point into (NULL if read from text), see glmReadBinary */
+  size_t mappingSize;
+
 } GLMmodel;
 
 
@@ -226,6 +230,46 @@ GLvoid glmDelete(GLMmodel* model);
  */
 GLMmodel* glmReadOBJ(char* filename);
 
+/* glmWriteBinary: Writes a model, as read by glmReadOBJ, to a binary file
+ * that glmReadBinary maps back into memory. The vertices, normals,
+ * texcoords, triangles and group indices are stored as they are in
+ * GLMmodel, every array starting on a GLM_BINARY_ALIGN boundary, together
+ * with the size and a hash of the bytes of the .obj and .mtl files they
+ * come from. Returns 0 on success; on failure no file is left behind and
+ * errno tells why.
+ *
+ * model    - initialized GLMmodel structure
+ * filename - name of the binary file
+ */
+#define GLM_BINARY_VERSION 2
+#define GLM_BINARY_ALIGN 64
+#define GLM_BINARY_SUFFIX ".glmb"
+int glmWriteBinary(GLMmodel* model, char* filename);
+
+/* glmReadBinary: Maps a file written by glmWriteBinary into memory and
+ * points the arrays of the returned model straight into it; only the
+ * materials and the group headers are copied. The mapping is private, so
+ * the arrays can be changed (their pages are copied on the first write)
+ * without changing the file. Returns NULL if the file is missing, of
+ * another version or if the .obj or .mtl file it was made from changed
+ * (their size or the hash of their bytes differs).
+ * The model is free'd with glmDelete().
+ *
+ * filename    - name of the binary file
+ * objfilename - name of the .obj file it was made from
+ */
+GLMmodel* glmReadBinary(char* filename, char* objfilename);
+
+/* glmReadOBJCached: Reads a model from the binary file next to the .obj
+ * file (filename + GLM_BINARY_SUFFIX), or from the .obj file when the
+ * binary file is missing or out of date, writing it for the next time.
+ * A folder the binary file can't be written to is read from the .obj
+ * file every time, without a warning.
+ *
+ * filename - name of the file containing the Wavefront .OBJ format data.
+ */
+GLMmodel* glmReadOBJCached(char* filename);
+
 /* glmWriteOBJ: Writes a model description in Wavefront .OBJ format to
  * a file.
  *
@@ -263,7 +307,9 @@ GLvoid glmDrawEdges(GLMmodel * model, char * groupName=0); // if groupName is NU
 GLvoid glmDrawPoints(GLMmodel * model);
 GLvoid glmDrawPoints(GLMmodel * model, int * selectedVertices, int numSelectedVertices);
 GLvoid glmDrawPoints(GLMmodel * model, int start, int end);
+#ifndef HEADLESS
 inline GLvoid glmDrawPoint(GLMmodel * model, int vertex) { glVertex3fv(&model->vertices[3*vertex+3]); }
+#endif
 GLvoid glmDrawUnselectedPoints(GLMmodel * model, int * selectionArray);
 GLvoid glmDrawSelectedPoints(GLMmodel * model, int * selectedVertices, int numSelectedVertices, int oneIndexed=1);
 GLvoid glmDrawPointsSelection(GLMmodel * model);
@@ -392,6 +438,20 @@ typedef struct _GLMnode {
 GLMnode ** glmBuildNeighborStructure(GLMmodel* model); 
 GLvoid glmDeleteNeighborStructure(GLMmodel* model, GLMnode ** structure);
 
+/* _GLMadjacency: compressed (CSR) adjacency lists of the vertices. The
+   entries of vertex i (1-based, as in GLMmodel) are
+   index[offset[i]] .. index[offset[i+1] - 1], all in one array. */
+typedef struct _GLMadjacency {
+    GLuint  numvertices;
+    GLuint* offset;         /* numvertices + 2 offsets, offset[0] = offset[1] = 0 */
+    GLuint* index;          /* offset[numvertices + 1] entries */
+} GLMadjacency;
+// for every vertex, the indices (0-based) of the incident triangles, in increasing order
+GLMadjacency * glmBuildTriangleAdjacency(GLMmodel* model);
+// for every vertex, the other vertices of its incident triangles, in increasing order and without repeats
+GLMadjacency * glmBuildVertexAdjacency(GLMmodel* model, GLMadjacency * triangles);
+GLvoid glmDeleteAdjacency(GLMadjacency * adjacency);
+
 // sets the normal of every face to the averaged normal of the neighboring faces
 // neighboring faces where the angle with the face normal is too small are excluded from the average
 GLvoid glmSetNormalsToFaceNormalsThresholded(GLMmodel* model, GLMnode ** neighborStructure, float thresholdAngle);
@@ -41,3 +41,53 @@ void saveScreenshot(int windowWidth, int windowHeight, char *filename)
 
   pic_free(in);
 }
+
+/* Writes a screenshot copied by queueScreenshot, on the writer thread */
+static bool writeScreenshotJob(exportJob *job)
+{
+  Pic pic;
+  int rowSize = 3 * job->width;
+  unsigned char *row = (unsigned char *)malloc(rowSize);
+
+  // glReadPixels gives the rows from the bottom up, the PPM file from the top down
+  for (int i = 0; i < job->height / 2; i++)
+  {
+    memcpy(row, &job->data[i * rowSize], rowSize);
+    memcpy(&job->data[i * rowSize], &job->data[(job->height - i - 1) * rowSize], rowSize);
+    memcpy(&job->data[(job->height - i - 1) * rowSize], row, rowSize);
+  }
+  free(row);
+
+  pic.nx = job->width;
+  pic.ny = job->height;
+  pic.bpp = 3;
+  pic.pix = job->data;
+  return ppm_write(job->name, &pic) != 0;
+}
+
+/* Copy a screenshot into a job of writer, which writes it to the specified filename, in PPM format.
+   Returns false if the writer dropped the frame. */
+bool queueScreenshot(exportWriter *writer, int windowWidth, int windowHeight, char *filename)
+{
+  exportJob *job;
+
+  if (filename == NULL)
+    return false;
+
+  job = writer->Begin(3 * windowWidth * windowHeight);
+  if (job == NULL)
+    return false;
+
+  job->encode = writeScreenshotJob;
+  strncpy(job->name, filename, sizeof(job->name) - 1);
+  job->name[sizeof(job->name) - 1] = '\0';
+  job->width = windowWidth;
+  job->height = windowHeight;
+  job->size = 3 * windowWidth * windowHeight;
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, windowWidth, windowHeight, GL_RGB, GL_UNSIGNED_BYTE, job->data);
+
+  writer->Commit(job);
+  return true;
+}
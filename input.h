@@ -6,9 +6,13 @@
 #ifndef _INPUT_H_
 #define _INPUT_H_
 
+#include "exportWriter.h"
+
 void inputInit();
 /* Write a screenshot to the specified filename, in PPM format */
 void saveScreenshot (int windowWidth, int windowHeight, char *filename);
+/* Copy the window into a job of writer, which writes it to the specified filename, in PPM format */
+bool queueScreenshot (exportWriter *writer, int windowWidth, int windowHeight, char *filename);
 
 #endif
 
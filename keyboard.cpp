@@ -70,6 +70,9 @@ void keyboardKeys(unsigned char key, int x, int y)
 		case 'p':
 			saveScreenToFile = 1 - saveScreenToFile;
 				break;
+		case 't':
+			dumpTiming();
+			break;
 	} //end switch
 } //end keyboardKeys
 
@@ -0,0 +1,748 @@
+/* Source: matBench
+ * Description: Microbenchmark of the matrix kernels (matrix.cpp, eig3.cpp and the eigen3 kernel of simd.h).
+ *				Every kernel runs over BENCHCASES inputs of three sets: random matrices, nearly singular
+ *				matrices and rotations with a small stretch (symmetric matrices with close eigenvalues for
+ *				the square roots and eigen decompositions). For every kernel and set it reports:
+ *				- the latency of a call, each call waiting for the result of the previous one,
+ *				- the throughput of independent calls,
+ *				- the largest error against a reference computed in long double (relative to the largest
+ *				  element of the reference; for the eigen decompositions the largest of the eigenvalue
+ *				  error, the residual |A v - d v| and the loss of orthogonality of V).
+ *				The batched kernels only have a throughput. Where long double is double (Visual C++) the
+ *				reference is only as precise as the kernels.
+ *				Usage: matBench [kernel name or its start, all (default) or list] [results file, .json or .csv, default none]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "vector.h"
+#include "matrix.h"
+#include "eig3.h"
+#include "simd.h"
+#include "profiler.h"
+
+#define BENCHCASES 1024				// Inputs of every input set
+#define BENCHTRIALS 5				// Timed runs over the inputs, the fastest is kept
+#define BENCHMINTIME 0.02			// Seconds a timed run lasts at least, going over the inputs several times
+#define MAXBENCHKERNELS 32
+
+// Input sets
+#define INPUT_RANDOM 0				// Elements in [-1, 1]
+#define INPUT_SINGULAR 1			// One row (or eigenvalue) nearly dependent on the others, condition about 1e6
+#define INPUT_ROTATION 2			// Rotations stretched by less than 1%
+#define NUMINPUTS 3
+
+static const char *inputNames[NUMINPUTS] = {"random", "near_singular", "rotation"};
+
+// What a kernel computes, which decides its inputs and its reference
+#define KIND_MULT33 0				// a x b of 3x3 matrices
+#define KIND_INVERSE33 1			// Inverse of a 3x3 matrix
+#define KIND_SQRT33 2				// Square root of a symmetric positive semi-definite 3x3 matrix
+#define KIND_EIGEN33 3				// Eigenvectors and eigenvalues of a symmetric 3x3 matrix
+#define KIND_MULT99 4				// a x b of 9x9 matrices
+#define KIND_INVERSE99 5			// Inverse of a 9x9 matrix
+
+// One call on the input at a (and b) with the result in out (and the eigenvalues in d)
+typedef void (*benchCall)(const double *a, const double *b, double *out, double *d);
+
+// Calls on count inputs at once, of size*size elements each
+typedef void (*benchBatch)(const double *a, double *out, double *d, int count, int simdLevel);
+
+struct benchKernel
+{
+	char name[40];
+	int kind;						// KIND_MULT33 .. KIND_INVERSE99
+	benchCall call;					// NULL for a batched kernel
+	benchBatch batch;
+	int simdLevel;					// Instruction set of a batched kernel
+};
+
+// Measures of a kernel over an input set
+struct benchResult
+{
+	benchKernel *kernel;
+	int input;
+	double latency;					// Seconds per call waiting for the previous one, 0 for a batched kernel
+	double throughput;				// Independent calls per second
+	double maxError;
+};
+
+// Bits of an output the next call of a latency run depends on, always 0 but unknown to the compiler
+static volatile unsigned long long chainMask = 0;
+
+static int matrixSize(int kind)
+{
+	return (kind == KIND_MULT99 || kind == KIND_INVERSE99) ? 9 : 3;
+}
+
+// Kernels measured
+
+static void callMatMult33(const double *a, const double *b, double *out, double *)
+{
+	matMult33( (double (*)[3])a, (double (*)[3])b, (matrix33 *)out);
+}
+
+static void callFixedMult33(const double *a, const double *b, double *out, double *)
+{
+	matMult(*(const fixedMatrix<3, 3> *)a, *(const fixedMatrix<3, 3> *)b, (fixedMatrix<3, 3> *)out);
+}
+
+static void callMatInverse33(const double *a, const double *, double *out, double *)
+{
+	matInverse33( (double (*)[3])a, (matrix33 *)out);
+}
+
+static void callFixedInverse33(const double *a, const double *, double *out, double *)
+{
+	matInverse(*(const fixedMatrix<3, 3> *)a, (fixedMatrix<3, 3> *)out);
+}
+
+static void callMatSqrt33(const double *a, const double *, double *out, double *)
+{
+	matSqrt33( (double (*)[3])a, (matrix33 *)out);
+}
+
+// Square root through the iterative eigen decomposition, as matSqrt33 did before eigen_analytic
+static void callSqrtJAMA(const double *a, const double *, double *out, double *)
+{
+	matrix33 A, eigVec;
+	double eigVal[3];
+
+	memcpy(A, a, sizeof(A));
+	eigen_decomposition(A, eigVec, eigVal);
+	matSqrtFromEigen33(eigVec, eigVal, (matrix33 *)out);
+}
+
+static void batchMatSqrt33(const double *a, double *out, double *, int count, int simdLevel)
+{
+	matSqrt33Batch( (const matrix33 *)a, (matrix33 *)out, count, simdLevel);
+}
+
+static void callEigenJAMA(const double *a, const double *, double *out, double *d)
+{
+	matrix33 A;
+
+	memcpy(A, a, sizeof(A));
+	eigen_decomposition(A, (double (*)[3])out, d);
+}
+
+static void callEigenAnalytic(const double *a, const double *, double *out, double *d)
+{
+	eigen_analytic( (const double (*)[3])a, (double (*)[3])out, d);
+}
+
+static void batchEigen3(const double *a, double *out, double *d, int count, int simdLevel)
+{
+	simdGetKernels(simdLevel)->eigen3(a, out, d, count);
+}
+
+// matMult on heap matrices, allocating its result as it does when called from the physics
+static void callMatMult99(const double *a, const double *b, double *out, double *)
+{
+	matrix m1, m2, result;
+
+	m1.row = m1.col = m2.row = m2.col = 9;
+	m1.data = (double *)a;
+	m2.data = (double *)b;
+	matMult(m1, m2, &result);
+	memcpy(out, result.data, 81 * sizeof(double));
+	delete[] result.data;
+}
+
+static void callFixedMult99(const double *a, const double *b, double *out, double *)
+{
+	matMult(*(const fixedMatrix<9, 9> *)a, *(const fixedMatrix<9, 9> *)b, (fixedMatrix<9, 9> *)out);
+}
+
+// matInverse through GSL, on a copy since the LU decomposition overwrites its input
+static void callMatInverse99(const double *a, const double *, double *out, double *)
+{
+	matrix m1, result;
+
+	matInit(&m1, 9, 9);
+	memcpy(m1.data, a, 81 * sizeof(double));
+	matInverse(m1, &result);
+	memcpy(out, result.data, 81 * sizeof(double));
+	delete[] m1.data;
+	delete[] result.data;
+}
+
+static void callFixedInverse99(const double *a, const double *, double *out, double *)
+{
+	matInverse(*(const fixedMatrix<9, 9> *)a, (fixedMatrix<9, 9> *)out);
+}
+
+/* Function: listKernels
+ * Description: Fills the table of the kernels, with the batched ones once per instruction set compiled in
+ * Input: kernels - table of MAXBENCHKERNELS kernels
+ * Output: number of kernels
+ */
+static int listKernels(benchKernel *kernels)
+{
+	static const struct { const char *name; int kind; benchCall call; } calls[] =
+	{
+		{"matMult33", KIND_MULT33, callMatMult33},
+		{"fixed matMult 3x3", KIND_MULT33, callFixedMult33},
+		{"matInverse33", KIND_INVERSE33, callMatInverse33},
+		{"fixed matInverse 3x3", KIND_INVERSE33, callFixedInverse33},
+		{"matSqrt33", KIND_SQRT33, callMatSqrt33},
+		{"matSqrt33 JAMA", KIND_SQRT33, callSqrtJAMA},
+		{"eigen_decomposition", KIND_EIGEN33, callEigenJAMA},
+		{"eigen_analytic", KIND_EIGEN33, callEigenAnalytic},
+		{"matMult 9x9", KIND_MULT99, callMatMult99},
+		{"fixed matMult 9x9", KIND_MULT99, callFixedMult99},
+		{"matInverse 9x9", KIND_INVERSE99, callMatInverse99},
+		{"fixed matInverse 9x9", KIND_INVERSE99, callFixedInverse99},
+	};
+	int count = 0;
+
+	memset( (void*)kernels, 0, MAXBENCHKERNELS * sizeof(benchKernel));
+	for (int i = 0; i < (int)(sizeof(calls) / sizeof(calls[0])); i++, count++)
+	{
+		strcpy(kernels[count].name, calls[i].name);
+		kernels[count].kind = calls[i].kind;
+		kernels[count].call = calls[i].call;
+	} //end for
+
+	for (int level = SIMD_SCALAR; level <= simdDetect(); level++)
+	{
+		if (simdClamp(level) != level)
+			continue;
+
+		sprintf(kernels[count].name, "matSqrt33Batch %s", simdName(level));
+		kernels[count].kind = KIND_SQRT33;
+		kernels[count].batch = batchMatSqrt33;
+		kernels[count++].simdLevel = level;
+
+		sprintf(kernels[count].name, "eigen3 %s", simdName(level));
+		kernels[count].kind = KIND_EIGEN33;
+		kernels[count].batch = batchEigen3;
+		kernels[count++].simdLevel = level;
+	} //end for
+
+	return count;
+}
+
+// Element in [-1, 1]
+static double randomElement()
+{
+	return 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+// Random rotation, from a random unit quaternion
+static void randomRotation(double *m)
+{
+	double q[4], length = 0.0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		q[i] = randomElement();
+		length += q[i] * q[i];
+	}
+	for (int i = 0; i < 4; i++)
+		q[i] /= sqrt(length);
+	quatToMat33(q, (matrix33 *)m);
+}
+
+// Random size x size matrix of the input set, not symmetric
+static void randomMatrix(double *m, int size, int input)
+{
+	double v[9], length, reflected[81];
+
+	for (int i = 0; i < size * size; i++)
+		m[i] = randomElement();
+
+	if (input == INPUT_SINGULAR)
+	{
+		// Last row a combination of the first two, off by 1e-6
+		for (int col = 0; col < size; col++)
+			m[(size - 1) * size + col] = 0.6 * m[col] - 0.8 * m[size + col] + 1.0e-6 * randomElement();
+	}
+	else if (input == INPUT_ROTATION && size == 3)
+	{
+		randomRotation(m);
+		for (int col = 0; col < 3; col++)
+		{
+			length = 1.0 + 0.01 * randomElement();
+			for (int row = 0; row < 3; row++)
+				m[row * 3 + col] *= length;
+		}
+	}
+	else if (input == INPUT_ROTATION)
+	{
+		// Product of three Householder reflections, stretched
+		for (int i = 0; i < size * size; i++)
+			m[i] = (i % (size + 1) == 0) ? 1.0 + 0.01 * randomElement() : 0.0;
+		for (int reflection = 0; reflection < 3; reflection++)
+		{
+			length = 0.0;
+			for (int i = 0; i < size; i++)
+			{
+				v[i] = randomElement();
+				length += v[i] * v[i];
+			}
+			for (int row = 0; row < size; row++)
+				for (int col = 0; col < size; col++)
+				{
+					reflected[row * size + col] = m[row * size + col];
+					for (int k = 0; k < size; k++)
+						reflected[row * size + col] -= 2.0 * v[row] * v[k] / length * m[k * size + col];
+				}
+			memcpy(m, reflected, size * size * sizeof(double));
+		} //end for
+	} //end if
+}
+
+// Random symmetric positive semi-definite 3x3 matrix of the input set
+static void randomSymmetric(double *m, int input)
+{
+	double M[9], scale[3];
+
+	if (input == INPUT_ROTATION)
+	{
+		// Q D QT with eigenvalues within 2% of each other
+		randomRotation(M);
+		for (int k = 0; k < 3; k++)
+			scale[k] = 1.0 + 0.01 * randomElement();
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				m[row * 3 + col] = M[row * 3 + 0] * scale[0] * M[col * 3 + 0] +
+								   M[row * 3 + 1] * scale[1] * M[col * 3 + 1] +
+								   M[row * 3 + 2] * scale[2] * M[col * 3 + 2];
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < row; col++)
+				m[row * 3 + col] = m[col * 3 + row];
+		return;
+	} //end if
+
+	// MT M, with one eigenvalue near 0 for a nearly singular M
+	randomMatrix(M, 3, input);
+	for (int row = 0; row < 3; row++)
+		for (int col = row; col < 3; col++)
+		{
+			m[row * 3 + col] = M[0 * 3 + row] * M[0 * 3 + col] + M[1 * 3 + row] * M[1 * 3 + col] + M[2 * 3 + row] * M[2 * 3 + col];
+			m[col * 3 + row] = m[row * 3 + col];
+		}
+}
+
+/* Function: referenceEigen
+ * Description: Eigen decomposition of a symmetric 3x3 matrix by cyclic Jacobi rotations in long double
+ * Input: a - symmetric matrix, row major
+ * Output: V - eigenvectors in the columns
+ *		   d - eigenvalues in increasing order
+ */
+static void referenceEigen(const double *a, long double V[3][3], long double d[3])
+{
+	long double A[3][3], theta, t, c, s, x, y, off, norm = 0.0L;
+	int p, q, first;
+
+	for (int row = 0; row < 3; row++)
+		for (int col = 0; col < 3; col++)
+		{
+			A[row][col] = a[row * 3 + col];
+			V[row][col] = (row == col) ? 1.0L : 0.0L;
+			norm += fabsl(A[row][col]);
+		}
+
+	for (int sweep = 0; sweep < 64; sweep++)
+	{
+		off = fabsl(A[0][1]) + fabsl(A[0][2]) + fabsl(A[1][2]);
+		if (off <= LDBL_EPSILON * LDBL_EPSILON * norm)
+			break;
+
+		for (int pair = 0; pair < 3; pair++)
+		{
+			p = (pair == 2) ? 1 : 0;
+			q = (pair == 0) ? 1 : 2;
+			if (A[p][q] == 0.0L)
+				continue;
+
+			theta = (A[q][q] - A[p][p]) / (2.0L * A[p][q]);
+			t = ((theta >= 0.0L) ? 1.0L : -1.0L) / (fabsl(theta) + sqrtl(theta * theta + 1.0L));
+			c = 1.0L / sqrtl(t * t + 1.0L);
+			s = t * c;
+			for (int k = 0; k < 3; k++)
+			{
+				x = A[k][p]; y = A[k][q];
+				A[k][p] = c * x - s * y;
+				A[k][q] = s * x + c * y;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				x = A[p][k]; y = A[q][k];
+				A[p][k] = c * x - s * y;
+				A[q][k] = s * x + c * y;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				x = V[k][p]; y = V[k][q];
+				V[k][p] = c * x - s * y;
+				V[k][q] = s * x + c * y;
+			}
+		} //end for
+	} //end for
+
+	for (int k = 0; k < 3; k++)
+		d[k] = A[k][k];
+
+	// Selection sort of the eigenvalues with their vectors
+	for (int k = 0; k < 2; k++)
+	{
+		first = k;
+		for (int i = k + 1; i < 3; i++)
+			if (d[i] < d[first])
+				first = i;
+		if (first == k)
+			continue;
+		x = d[k]; d[k] = d[first]; d[first] = x;
+		for (int row = 0; row < 3; row++)
+		{
+			x = V[row][k]; V[row][k] = V[row][first]; V[row][first] = x;
+		}
+	} //end for
+}
+
+/* Function: reference
+ * Description: Result of a kernel of the given kind in long double
+ * Input: kind - KIND_MULT33 .. KIND_INVERSE99
+ *		  a, b - input
+ * Output: ref - result (size x size), eigenvalues for KIND_EIGEN33
+ */
+static void reference(int kind, const double *a, const double *b, long double *ref)
+{
+	int size = matrixSize(kind), pivot;
+	long double work[81], factor, swap, V[3][3], d[3];
+
+	if (kind == KIND_MULT33 || kind == KIND_MULT99)
+	{
+		for (int row = 0; row < size; row++)
+			for (int col = 0; col < size; col++)
+			{
+				ref[row * size + col] = 0.0L;
+				for (int k = 0; k < size; k++)
+					ref[row * size + col] += (long double)a[row * size + k] * b[k * size + col];
+			}
+	}
+	else if (kind == KIND_INVERSE33 || kind == KIND_INVERSE99)
+	{
+		// Gauss-Jordan elimination with partial pivoting
+		for (int i = 0; i < size * size; i++)
+		{
+			work[i] = a[i];
+			ref[i] = (i % (size + 1) == 0) ? 1.0L : 0.0L;
+		}
+		for (int col = 0; col < size; col++)
+		{
+			pivot = col;
+			for (int row = col + 1; row < size; row++)
+				if (fabsl(work[row * size + col]) > fabsl(work[pivot * size + col]))
+					pivot = row;
+			for (int i = 0; i < size; i++)
+			{
+				swap = work[col * size + i]; work[col * size + i] = work[pivot * size + i]; work[pivot * size + i] = swap;
+				swap = ref[col * size + i]; ref[col * size + i] = ref[pivot * size + i]; ref[pivot * size + i] = swap;
+			}
+			factor = 1.0L / work[col * size + col];
+			for (int i = 0; i < size; i++)
+			{
+				work[col * size + i] *= factor;
+				ref[col * size + i] *= factor;
+			}
+			for (int row = 0; row < size; row++)
+			{
+				if (row == col)
+					continue;
+				factor = work[row * size + col];
+				for (int i = 0; i < size; i++)
+				{
+					work[row * size + i] -= factor * work[col * size + i];
+					ref[row * size + i] -= factor * ref[col * size + i];
+				}
+			} //end for
+		} //end for
+	}
+	else
+	{
+		referenceEigen(a, V, d);
+		if (kind == KIND_EIGEN33)
+		{
+			for (int k = 0; k < 3; k++)
+				ref[k] = d[k];
+			return;
+		} //end if
+
+		for (int k = 0; k < 3; k++)
+			d[k] = (d[k] > 0.0L) ? sqrtl(d[k]) : 0.0L;
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				ref[row * 3 + col] = V[row][0] * d[0] * V[col][0] + V[row][1] * d[1] * V[col][1] + V[row][2] * d[2] * V[col][2];
+	} //end if
+}
+
+/* Function: kernelError
+ * Description: Error of the result of a kernel against the reference
+ * Input: kind - KIND_MULT33 .. KIND_INVERSE99
+ *		  a, b - input
+ *		  out, d - result of the kernel
+ * Output: largest error relative to the largest element of the reference, infinite for a result that is not finite
+ */
+static double kernelError(int kind, const double *a, const double *b, const double *out, const double *d)
+{
+	long double ref[81], scale = 0.0L, error = 0.0L, value;
+	int size = matrixSize(kind);
+
+	reference(kind, a, b, ref);
+
+	if (kind != KIND_EIGEN33)
+	{
+		for (int i = 0; i < size * size; i++)
+		{
+			if (!(fabs(out[i]) <= DBL_MAX))
+				return HUGE_VAL;
+			if (fabsl(ref[i]) > scale)
+				scale = fabsl(ref[i]);
+			if (fabsl(out[i] - ref[i]) > error)
+				error = fabsl(out[i] - ref[i]);
+		} //end for
+		return (scale > 0.0L) ? (double)(error / scale) : (double)error;
+	} //end if
+
+	for (int k = 0; k < 3; k++)
+	{
+		if (!(fabs(d[k]) <= DBL_MAX))
+			return HUGE_VAL;
+		if (fabsl(ref[k]) > scale)
+			scale = fabsl(ref[k]);
+	}
+	if (scale == 0.0L)
+		scale = 1.0L;
+
+	for (int k = 0; k < 3; k++)
+	{
+		// Eigenvalue
+		if (fabsl(d[k] - ref[k]) / scale > error)
+			error = fabsl(d[k] - ref[k]) / scale;
+
+		for (int row = 0; row < 3; row++)
+		{
+			// Residual (A v - d v)[row] of the eigenvector in column k
+			value = -(long double)d[k] * out[row * 3 + k];
+			for (int i = 0; i < 3; i++)
+				value += (long double)a[row * 3 + i] * out[i * 3 + k];
+			if (fabsl(value) / scale > error)
+				error = fabsl(value) / scale;
+
+			// Orthogonality (VT V - I)[row][k]
+			value = (row == k) ? -1.0L : 0.0L;
+			for (int i = 0; i < 3; i++)
+				value += (long double)out[i * 3 + row] * out[i * 3 + k];
+			if (fabsl(value) > error)
+				error = fabsl(value);
+		} //end for
+	} //end for
+	return (double)error;
+}
+
+/* Function: runKernel
+ * Description: Measures a kernel over the inputs of a set
+ * Input: kernel - kernel to measure
+ *		  input - INPUT_RANDOM .. INPUT_ROTATION
+ *		  a, b - BENCHCASES inputs of the kernel
+ *		  out, d - room for BENCHCASES results
+ * Output: result - measures
+ */
+static void runKernel(benchKernel *kernel, int input, const double *a, const double *b, double *out, double *d, benchResult *result)
+{
+	int stride = matrixSize(kernel->kind) * matrixSize(kernel->kind), repeats, index;
+	unsigned long long mask = chainMask, bits;
+	double start, seconds, best, error;
+
+	result->kernel = kernel;
+	result->input = input;
+	result->latency = 0.0;
+
+	// Throughput, going over the inputs enough times to last BENCHMINTIME
+	repeats = 1;
+	for (int trial = -1; trial < BENCHTRIALS; trial++)
+	{
+		start = profileClock();
+		for (int repeat = 0; repeat < repeats; repeat++)
+		{
+			if (kernel->batch != NULL)
+				kernel->batch(a, out, d, BENCHCASES, kernel->simdLevel);
+			else
+				for (int i = 0; i < BENCHCASES; i++)
+					kernel->call(a + i * stride, b + i * stride, out + i * stride, d + 3 * i);
+		} //end for
+		seconds = (profileClock() - start) / repeats;
+
+		if (trial < 0)
+		{
+			repeats = (int)ceil(BENCHMINTIME / (seconds + 1e-9));
+			best = seconds;
+		}
+		else if (seconds < best || trial == 0)
+			best = seconds;
+	} //end for
+	result->throughput = BENCHCASES / best;
+
+	result->maxError = 0.0;
+	for (int i = 0; i < BENCHCASES; i++)
+	{
+		error = kernelError(kernel->kind, a + i * stride, b + i * stride, out + i * stride, d + 3 * i);
+		if (!(error <= result->maxError))
+			result->maxError = error;
+	} //end for
+
+	if (kernel->call == NULL)
+		return;
+
+	// Latency, the next input taken from an index depending on the last result
+	for (int trial = 0; trial < BENCHTRIALS; trial++)
+	{
+		index = 0;
+		start = profileClock();
+		for (int repeat = 0; repeat < repeats; repeat++)
+			for (int i = 0; i < BENCHCASES; i++)
+			{
+				kernel->call(a + index * stride, b + index * stride, out + index * stride, d + 3 * index);
+				memcpy(&bits, out + index * stride, sizeof(bits));
+				index = (i + 1) % BENCHCASES + (int)(bits & mask);
+			}
+		seconds = (profileClock() - start) / ((double)repeats * BENCHCASES);
+		if (trial == 0 || seconds < result->latency)
+			result->latency = seconds;
+	} //end for
+}
+
+/* Function: writeResults
+ * Description: Writes the measures, as JSON if the name ends in .json and as CSV otherwise
+ * Input: filename - results file
+ *		  results - measures
+ *		  numResults - number of measures
+ * Output: true if the file was written
+ */
+static bool writeResults(const char *filename, benchResult *results, int numResults)
+{
+	FILE *file = fopen(filename, "w");
+	size_t len = strlen(filename);
+	bool json = (len > 5 && strcmp(filename + len - 5, ".json") == 0);
+	benchResult *result;
+
+	if (file == NULL)
+		return false;
+
+	if (json)
+		fprintf(file, "{\n  \"cases\": %d,\n  \"reference_digits\": %d,\n  \"results\": [", BENCHCASES, LDBL_DIG);
+	else
+		fprintf(file, "kernel,input,latency_ns,calls_per_s,max_error\n");
+
+	for (int i = 0; i < numResults; i++)
+	{
+		result = &results[i];
+		if (json)
+		{
+			fprintf(file, "%s\n    {\"kernel\": \"%s\", \"input\": \"%s\", \"latency_ns\": ", (i > 0) ? "," : "",
+				result->kernel->name, inputNames[result->input]);
+			if (result->latency > 0.0)
+				fprintf(file, "%.3f", 1e9 * result->latency);
+			else
+				fprintf(file, "null");
+			fprintf(file, ", \"calls_per_s\": %.1f, \"max_error\": ", result->throughput);
+			if (result->maxError <= DBL_MAX)
+				fprintf(file, "%.3e}", result->maxError);
+			else
+				fprintf(file, "null}");
+		}
+		else
+		{
+			fprintf(file, "%s,%s,", result->kernel->name, inputNames[result->input]);
+			if (result->latency > 0.0)
+				fprintf(file, "%.3f", 1e9 * result->latency);
+			fprintf(file, ",%.1f,%.3e\n", result->throughput, result->maxError);
+		} //end if
+	} //end for
+
+	if (json)
+		fprintf(file, "\n  ]\n}\n");
+	return (fclose(file) == 0);
+}
+
+/* Main Loop */
+int main(int argc, char** argv)
+{
+	const char *kernelName = "all";
+	char *resultsName = NULL;
+	benchKernel kernels[MAXBENCHKERNELS];
+	benchResult *results, *result;
+	int numKernels, numResults = 0, size;
+	double *a, *b, *out, *d;
+
+	if (argc > 1)
+		kernelName = argv[1];
+	if (argc > 2 && strcmp(argv[2], "-") != 0)
+		resultsName = argv[2];
+
+	numKernels = listKernels(kernels);
+	if (strcmp(kernelName, "list") == 0)
+	{
+		for (int i = 0; i < numKernels; i++)
+			printf("%s\n", kernels[i].name);
+		return 0;
+	} //end if
+
+	results = (benchResult *)calloc(numKernels * NUMINPUTS, sizeof(benchResult));
+	a = (double *)malloc(BENCHCASES * 81 * sizeof(double));
+	b = (double *)malloc(BENCHCASES * 81 * sizeof(double));
+	out = (double *)calloc(BENCHCASES * 81, sizeof(double));
+	d = (double *)calloc(BENCHCASES * 3, sizeof(double));
+
+	printf("%-24s %-14s %12s %14s %12s\n", "kernel", "input", "latency ns", "calls/s", "max error");
+	for (int k = 0; k < numKernels; k++)
+	{
+		if (strcmp(kernelName, "all") != 0 && strncmp(kernelName, kernels[k].name, strlen(kernelName)) != 0)
+			continue;
+
+		size = matrixSize(kernels[k].kind);
+		for (int input = 0; input < NUMINPUTS; input++)
+		{
+			// The same inputs for every kernel of a kind
+			srand(1 + input);
+			for (int i = 0; i < BENCHCASES; i++)
+			{
+				if (kernels[k].kind == KIND_SQRT33 || kernels[k].kind == KIND_EIGEN33)
+					randomSymmetric(a + i * size * size, input);
+				else
+				{
+					randomMatrix(a + i * size * size, size, input);
+					randomMatrix(b + i * size * size, size, input);
+				} //end if
+			} //end for
+
+			result = &results[numResults++];
+			runKernel(&kernels[k], input, a, b, out, d, result);
+
+			printf("%-24s %-14s ", kernels[k].name, inputNames[input]);
+			if (result->latency > 0.0)
+				printf("%12.1f", 1e9 * result->latency);
+			else
+				printf("%12s", "-");
+			printf(" %14.0f %12.3e\n", result->throughput, result->maxError);
+		} //end for
+	} //end for
+
+	if (numResults == 0)
+		printf("No kernel named %s, matBench list shows the kernels\n", kernelName);
+	else if (resultsName != NULL && !writeResults(resultsName, results, numResults))
+		printf("Cannot write the results to %s\n", resultsName);
+
+	free(results);
+	free(a);
+	free(b);
+	free(out);
+	free(d);
+	return (numResults == 0) ? 1 : 0;
+}
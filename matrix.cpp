@@ -2,9 +2,12 @@
  * Description: Contains functions that compute matrix calculations
  */
 
-#include "render.h"
+#include <string.h>
+#include <gsl/gsl_linalg.h>
+#include "vector.h"
 #include "matrix.h"
 #include "eig3.h"
+#include "simd.h"
 
 /* Function: matInit
  * Description: Allocates memory and initializes values of the sparse matrix
@@ -478,6 +481,9 @@ void matInverse(matrix m1, matrix *mat)
 
 	for(int i = 0; i < ((*mat).row * (*mat).col); i++)
 		(*mat).data[i] = inverse->data[i];
+
+	gsl_permutation_free(perm);
+	gsl_matrix_free(inverse);
 }
 
 /* Function: matMult33
@@ -546,37 +552,172 @@ void colSwap(matrix33 m1, matrix33 *mat)
 } //end colSwap
 
 /* Function: matSqrt33
- * Description: Computes the Inverse of the Square Root of a 3x3 matrix
+ * Description: Computes the Square Root of a symmetric positive semi-definite 3x3 matrix,
+ *				V sqrt(D) VT from its closed form eigen decomposition
  * Input: m1 - 3x3 input matrix
- *        mat - resulting Inverse of the Square Root of the 3x3 matrix
+ *        mat - resulting Square Root of the 3x3 matrix
  * Output: None
  */
 void matSqrt33(matrix33 m1, matrix33 *mat)
 {
-	matrix33 eigVec, eigVecTrans, temp, matDiag;
+	matrix33 eigVec;
 	double eigVal[3];
 
-	memset( (void*)&eigVec, 0, sizeof(eigVec));
-	memset( (void*)&eigVecTrans, 0, sizeof(eigVecTrans));
-	memset( (void*)&temp, 0, sizeof(temp));
-	memset( (void*)&eigVal, 0, sizeof(eigVal));
+	eigen_analytic(m1, eigVec, eigVal);
+	matSqrtFromEigen33(eigVec, eigVal, mat);
+} //end matSqrt33
+
+/* Function: matSqrt33Batch
+ * Description: Computes the Square Roots of count symmetric positive semi-definite 3x3 matrices,
+ *				with the eigen decompositions of SQRTBATCH matrices at a time done in one call of the
+ *				eigen3 kernel
+ * Input: m1 - count input matrices
+ *        mat - resulting Square Roots
+ *        count - number of matrices
+ *        simdLevel - instruction set of the eigen3 kernel (SIMD_SCALAR .. SIMD_AVX512)
+ * Output: None
+ */
+void matSqrt33Batch(const matrix33 *m1, matrix33 *mat, int count, int simdLevel)
+{
+	const simdKernels *kernels = simdGetKernels(simdLevel);
+	matrix33 eigVec[SQRTBATCH];
+	double eigVal[SQRTBATCH][3];
+	int size;
+
+	for (int first = 0; first < count; first += SQRTBATCH)
+	{
+		size = (count - first < SQRTBATCH) ? count - first : SQRTBATCH;
+		kernels->eigen3( (const double *)(m1 + first), (double *)eigVec, (double *)eigVal, size);
+
+		for (int i = 0; i < size; i++)
+			matSqrtFromEigen33(eigVec[i], eigVal[i], &mat[first + i]);
+	} //end for
+} //end matSqrt33Batch
+
+/* Function: matSqrtFromEigen33
+ * Description: Assembles V sqrt(D) VT; eigenvalues rounded below zero are taken as zero
+ * Input: eigVec - eigenvectors in the columns
+ *        eigVal - eigenvalues
+ *        mat - resulting Square Root
+ * Output: None
+ */
+void matSqrtFromEigen33(matrix33 eigVec, const double eigVal[3], matrix33 *mat)
+{
+	double root[3];
 
-	eigen_decomposition(m1, eigVec, eigVal);
+	for (int k = 0; k < 3; k++)
+		root[k] = (eigVal[k] > 0.0) ? sqrt(eigVal[k]) : 0.0;
 
 	for (int row = 0; row < 3; row++)
-		for (int col = 0; col < 3; col++)
+		for (int col = row; col < 3; col++)
 		{
-			if (row != col)
-				matDiag[row][col] = 0;
-			else
-				matDiag[row][col] = sqrt(eigVal[row]);
+			(*mat)[row][col] = eigVec[row][0] * root[0] * eigVec[col][0] +
+							   eigVec[row][1] * root[1] * eigVec[col][1] +
+							   eigVec[row][2] * root[2] * eigVec[col][2];
+			(*mat)[col][row] = (*mat)[row][col];
 		} //end for
+} //end matSqrtFromEigen33
+
+/* Function: quatToMat33
+ * Description: Converts a unit quaternion to its rotation matrix
+ * Input: quat - quaternion (w, x, y, z), of length 1
+ *        mat - Output rotation matrix
+ * Output: None
+ */
+void quatToMat33(const double quat[4], matrix33 *mat)
+{
+	double w = quat[0], x = quat[1], y = quat[2], z = quat[3];
+
+	(*mat)[0][0] = 1.0 - 2.0 * (y * y + z * z);
+	(*mat)[0][1] = 2.0 * (x * y - w * z);
+	(*mat)[0][2] = 2.0 * (x * z + w * y);
+	(*mat)[1][0] = 2.0 * (x * y + w * z);
+	(*mat)[1][1] = 1.0 - 2.0 * (x * x + z * z);
+	(*mat)[1][2] = 2.0 * (y * z - w * x);
+	(*mat)[2][0] = 2.0 * (x * z - w * y);
+	(*mat)[2][1] = 2.0 * (y * z + w * x);
+	(*mat)[2][2] = 1.0 - 2.0 * (x * x + y * y);
+} //end quatToMat33
+
+/* Function: matRotation33
+ * Description: Extracts the rotational part R of a 3x3 matrix A, the rotation maximizing trace(RT x A), by
+ *				iterations on a quaternion starting from a guess of it (after Muller et al., A Robust Method
+ *				to Extract the Rotational Part of Deformations). Every iteration turns R by omega, from the
+ *				columns of B = RT x A:
+ *				b = Summation(ei x bi),  S = (B + BT) / 2,  omega = (trace(S) I - S)^-1 b  (Newton step)
+ *				When trace(S) I - S is not positive definite, which happens when A is singular or inverted
+ *				(det(A) <= 0), the Newton step is replaced by the gradient step omega = b / |trace(B)|.
+ *				Always gives a rotation, and needs 1 to 3 iterations when the guess is the rotation of the
+ *				last timestep.
+ * Input: A - matrix whose rotation is extracted
+ *        quat - guess of the rotation as a unit quaternion (w, x, y, z), receives the rotation
+ *        maxIterations - most iterations to perform
+ *        R - Output rotation matrix
+ * Output: number of iterations performed
+ */
+int matRotation33(matrix33 A, double quat[4], int maxIterations, matrix33 *R)
+{
+	matrix33 B, H, Hinv;
+	double b[3], local[3], omega[3], trace, det, angle, c, s, length, q[4];
+	int iteration;
 
-	matTranspose33(eigVec, &eigVecTrans);
-	matMult33(eigVec, matDiag, &temp);	
-	matMult33(temp, eigVecTrans, mat);
+	for (iteration = 0; iteration < maxIterations; iteration++)
+	{
+		quatToMat33(quat, R);
+
+		// B = RT x A
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				B[row][col] = (*R)[0][row] * A[0][col] + (*R)[1][row] * A[1][col] + (*R)[2][row] * A[2][col];
+
+		b[0] = B[2][1] - B[1][2];
+		b[1] = B[0][2] - B[2][0];
+		b[2] = B[1][0] - B[0][1];
+		trace = B[0][0] + B[1][1] + B[2][2];
+
+		// H = trace(S) I - S
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				H[row][col] = ((row == col) ? trace : 0.0) - 0.5 * (B[row][col] + B[col][row]);
+
+		// Positive definite when its leading minors are positive
+		det = matDeterminant33(H);
+		if (H[0][0] > 0.0 && H[0][0] * H[1][1] - H[0][1] * H[1][0] > 0.0 && det > 1.0e-12 * trace * trace * trace)
+		{
+			matInverse33(H, &Hinv);
+			for (int row = 0; row < 3; row++)
+				local[row] = Hinv[row][0] * b[0] + Hinv[row][1] * b[1] + Hinv[row][2] * b[2];
+		} //end if
+		else
+		{
+			for (int row = 0; row < 3; row++)
+				local[row] = b[row] / (fabs(trace) + 1.0e-9);
+		} //end else
+
+		// Turn in the world frame: omega = R x local
+		for (int row = 0; row < 3; row++)
+			omega[row] = (*R)[row][0] * local[0] + (*R)[row][1] * local[1] + (*R)[row][2] * local[2];
+
+		angle = sqrt(omega[0] * omega[0] + omega[1] * omega[1] + omega[2] * omega[2]);
+		if (angle < ROTATIONTOLERANCE)
+			return iteration;
+
+		// quat = rotation of angle about omega / angle, times quat
+		c = cos(0.5 * angle);
+		s = sin(0.5 * angle) / angle;
+		q[0] = c * quat[0] - s * (omega[0] * quat[1] + omega[1] * quat[2] + omega[2] * quat[3]);
+		q[1] = c * quat[1] + s * (omega[0] * quat[0] + omega[1] * quat[3] - omega[2] * quat[2]);
+		q[2] = c * quat[2] + s * (omega[1] * quat[0] + omega[2] * quat[1] - omega[0] * quat[3]);
+		q[3] = c * quat[3] + s * (omega[2] * quat[0] + omega[0] * quat[2] - omega[1] * quat[1]);
+
+		length = 1.0 / sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+		for (int i = 0; i < 4; i++)
+			quat[i] = q[i] * length;
+	} //end for
 
-} //end matSqrt33
+	quatToMat33(quat, R);
+	return iteration;
+} //end matRotation33
 
 /* Function: matTest
  * Description: Modifiable function for testing matrix calculations
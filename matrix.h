@@ -5,8 +5,13 @@
 #ifndef _MATRIX_H_
 #define _MATRIX_H_
 
+#include <math.h>
+
 typedef double matrix33[3][3];
 
+#define SQRTBATCH 64					// Matrices per eigen3 call of matSqrt33Batch
+#define ROTATIONTOLERANCE 1.0e-9		// matRotation33 stops once the correction turns by less (radians)
+
 struct matrix
 {
 	int row;
@@ -44,6 +49,174 @@ void matMult33(matrix33 m1, matrix33 m2, matrix33 *mat);
 void vecToMat(point v1, matrix33 *mat);
 void colSwap(matrix33 m1, matrix33 *mat);
 void matSqrt33(matrix33 m1, matrix33 *mat);
+void matSqrt33Batch(const matrix33 *m1, matrix33 *mat, int count, int simdLevel);
+void matSqrtFromEigen33(matrix33 eigVec, const double eigVal[3], matrix33 *mat);
+void quatToMat33(const double quat[4], matrix33 *mat);
+int matRotation33(matrix33 A, double quat[4], int maxIterations, matrix33 *R);
 void matTest();
 
+// Matrix whose size is known at compile time, stored in place (no heap) and row major like matrix.
+// The loops below have fixed bounds, so the compiler unrolls them for the small sizes.
+template <int ROWS, int COLS>
+struct fixedMatrix
+{
+	double data[ROWS * COLS];
+};
+
+typedef fixedMatrix<3, 9> matrix39;		// Quadratic rotation [R 0 0] and TApq
+typedef fixedMatrix<9, 1> matrix91;		// Quadratic rest coordinates q of a vertex
+typedef fixedMatrix<9, 9> matrix99;		// TAqq
+
+/* Function: matZero
+ * Description: Sets every element of a fixed size matrix to 0
+ * Input: mat - matrix to clear
+ * Output: None
+ */
+template <int ROWS, int COLS>
+inline void matZero(fixedMatrix<ROWS, COLS> *mat)
+{
+	for (int index = 0; index < ROWS * COLS; index++)
+		(*mat).data[index] = 0.0;
+}
+
+/* Function: matMult
+ * Description: Multiplies two fixed size matrices, mat = mat1 x mat2. mat may be one of the inputs.
+ * Input: mat1 - ROWS x INNER matrix
+ *        mat2 - INNER x COLS matrix
+ *        mat - ROWS x COLS result
+ * Output: None
+ */
+template <int ROWS, int INNER, int COLS>
+inline void matMult(const fixedMatrix<ROWS, INNER> &mat1, const fixedMatrix<INNER, COLS> &mat2, fixedMatrix<ROWS, COLS> *mat)
+{
+	fixedMatrix<ROWS, COLS> result;
+	double sum;
+
+	for (int row = 0; row < ROWS; row++)
+		for (int col = 0; col < COLS; col++)
+		{
+			sum = 0.0;
+			for (int i = 0; i < INNER; i++)
+				sum += mat1.data[row * INNER + i] * mat2.data[i * COLS + col];
+			result.data[row * COLS + col] = sum;
+		}
+
+	*mat = result;
+}
+
+/* Function: matSMult
+ * Description: Multiplies a fixed size matrix by a scalar, mat = s * mat1
+ * Input: s - scalar
+ *        mat1 - matrix
+ *        mat - result, may be mat1
+ * Output: None
+ */
+template <int ROWS, int COLS>
+inline void matSMult(double s, const fixedMatrix<ROWS, COLS> &mat1, fixedMatrix<ROWS, COLS> *mat)
+{
+	for (int index = 0; index < ROWS * COLS; index++)
+		(*mat).data[index] = s * mat1.data[index];
+}
+
+/* Function: matAdd
+ * Description: Adds two fixed size matrices, mat = mat1 + mat2
+ * Input: mat1, mat2 - matrices
+ *        mat - result, may be one of the inputs
+ * Output: None
+ */
+template <int ROWS, int COLS>
+inline void matAdd(const fixedMatrix<ROWS, COLS> &mat1, const fixedMatrix<ROWS, COLS> &mat2, fixedMatrix<ROWS, COLS> *mat)
+{
+	for (int index = 0; index < ROWS * COLS; index++)
+		(*mat).data[index] = mat1.data[index] + mat2.data[index];
+}
+
+/* Function: matTranspose
+ * Description: Transposes a fixed size matrix
+ * Input: mat1 - ROWS x COLS matrix
+ *        mat - COLS x ROWS result, not mat1
+ * Output: None
+ */
+template <int ROWS, int COLS>
+inline void matTranspose(const fixedMatrix<ROWS, COLS> &mat1, fixedMatrix<COLS, ROWS> *mat)
+{
+	for (int row = 0; row < ROWS; row++)
+		for (int col = 0; col < COLS; col++)
+			(*mat).data[col * ROWS + row] = mat1.data[row * COLS + col];
+}
+
+/* Function: matInverse
+ * Description: Inverts a fixed size square matrix by Gauss-Jordan elimination with partial pivoting
+ * Input: m1 - SIZE x SIZE matrix
+ *        mat - inverse of m1, may be m1
+ * Output: false if m1 is singular (mat is then left unchanged)
+ */
+template <int SIZE>
+inline bool matInverse(const fixedMatrix<SIZE, SIZE> &m1, fixedMatrix<SIZE, SIZE> *mat)
+{
+	fixedMatrix<SIZE, SIZE> a = m1, inv;
+	double factor, swap;
+	int pivot;
+
+	for (int row = 0; row < SIZE; row++)
+		for (int col = 0; col < SIZE; col++)
+			inv.data[row * SIZE + col] = (row == col) ? 1.0 : 0.0;
+
+	for (int col = 0; col < SIZE; col++)
+	{
+		// Largest element of the column as the pivot
+		pivot = col;
+		for (int row = col + 1; row < SIZE; row++)
+			if (fabs(a.data[row * SIZE + col]) > fabs(a.data[pivot * SIZE + col]))
+				pivot = row;
+		if (a.data[pivot * SIZE + col] == 0.0)
+			return false;
+
+		if (pivot != col)
+			for (int i = 0; i < SIZE; i++)
+			{
+				swap = a.data[col * SIZE + i]; a.data[col * SIZE + i] = a.data[pivot * SIZE + i]; a.data[pivot * SIZE + i] = swap;
+				swap = inv.data[col * SIZE + i]; inv.data[col * SIZE + i] = inv.data[pivot * SIZE + i]; inv.data[pivot * SIZE + i] = swap;
+			}
+
+		factor = 1.0 / a.data[col * SIZE + col];
+		for (int i = 0; i < SIZE; i++)
+		{
+			a.data[col * SIZE + i] *= factor;
+			inv.data[col * SIZE + i] *= factor;
+		}
+
+		for (int row = 0; row < SIZE; row++)
+		{
+			if (row == col || a.data[row * SIZE + col] == 0.0)
+				continue;
+			factor = a.data[row * SIZE + col];
+			for (int i = 0; i < SIZE; i++)
+			{
+				a.data[row * SIZE + i] -= factor * a.data[col * SIZE + i];
+				inv.data[row * SIZE + i] -= factor * inv.data[col * SIZE + i];
+			}
+		} //end for
+	} //end for
+
+	*mat = inv;
+	return true;
+}
+
+/* Function: matToPoint
+ * Description: Converts a fixed size 3x1 matrix to point data type
+ * Input: mat - 3x1 matrix
+ * Output: Point data type of the input matrix
+ */
+inline point matToPoint(const fixedMatrix<3, 1> &mat)
+{
+	point p;
+
+	p.x = mat.data[0];
+	p.y = mat.data[1];
+	p.z = mat.data[2];
+
+	return p;
+}
+
 #endif
@@ -70,7 +70,7 @@ void selection(GLint hits, GLuint *buffer)
 		// Compute closest vertice to mouse selection coordinate
 		for (index = 0; index < hits; index++)
 		{
-			pModel *temp = phyzxModels; 
+			pModel *temp = gWorld.models; 
 			// Search through selection buffer
 			minObj = (int)buffer[index * 4 + 3];
 			
@@ -137,7 +137,7 @@ void motion(int x, int y)
 	if(leftButton && lMouseVal == 2 && objectName != -1 && pause == 0 && !rightButton)
 	{
 		point vertex;
-		pModel *temp = phyzxModels;
+		pModel *temp = gWorld.models;
 
 		while(temp->next != NULL)
 		{
@@ -158,7 +158,7 @@ void motion(int x, int y)
 			//pMULTIPLY(userForce, (log(length + 1.0)/log(10.0)), userForce);
 			pMULTIPLY(userForce, 3.0, userForce);
 
-/*			pModel *temp = phyzxModels;
+/*			pModel *temp = gWorld.models;
 			while(temp->next != NULL)
 			{
 				if(temp->mIndex == iMouseModel)
@@ -218,7 +218,7 @@ void mouse(int button, int state, int x, int y)
 						
 						if(lMouseVal == 1)
 						{
-							pModel *temp = phyzxModels;
+							pModel *temp = gWorld.models;
 							while(temp->next != NULL)
 							{
 								glLoadName(temp->mIndex);
@@ -228,7 +228,7 @@ void mouse(int button, int state, int x, int y)
 						}
 						else if(lMouseVal == 2)
 						{
-							pModel *temp = phyzxModels;
+							pModel *temp = gWorld.models;
 							while(temp->next != NULL)
 							{
 								if(temp->mIndex == iMouseModel)
@@ -261,7 +261,7 @@ void mouse(int button, int state, int x, int y)
 					if (objectName != -1 && lMouseVal == 1)
 					{
 						iMouseModel = objectName;
-						pModel *temp = phyzxModels;
+						pModel *temp = gWorld.models;
 						while(temp->next != NULL)
 						{
 							if(temp->mIndex == iMouseModel)
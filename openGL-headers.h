@@ -1,4 +1,19 @@
-#if defined(WIN32) || defined(linux)
+#ifndef _OPENGL_HEADERS_H_
+#define _OPENGL_HEADERS_H_
+
+#if defined(HEADLESS)
+  // Simulation core built without a window: only the GL scalar types are needed
+  typedef unsigned int GLenum;
+  typedef unsigned char GLboolean;
+  typedef void GLvoid;
+  typedef int GLint;
+  typedef unsigned int GLuint;
+  typedef unsigned char GLubyte;
+  typedef float GLfloat;
+  typedef double GLdouble;
+  #define GL_FALSE 0
+  #define GL_TRUE 1
+#elif defined(WIN32) || defined(linux)
   //#include <GL/gl.h>
   //#include <GL/glu.h>
   #include <GL/glui.h>
@@ -9,3 +24,4 @@
   #include <GLUT/glut.h>
 #endif
 
+#endif
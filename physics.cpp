@@ -2,22 +2,25 @@
  * Description: Contains functions that compute physics in real time.
  */
 
-#include "physics.h"
+#include "simulation.h"
 
 // Constructor
 phyzx::phyzx()
 {
 	model = NULL;
+	shape = NULL;
 	h = 0.0f;
 	n = 0;
 	surArea = 0.0;
-	stable = NULL;						
-	goal = NULL;				
+	numVertices = 0;
+	memset( (void*)&position, 0, sizeof(position));
+	memset( (void*)&stable, 0, sizeof(stable));
+	memset( (void*)&goal, 0, sizeof(goal));
 	mass = NULL;
 	totalMass = 0.0;
-	velocity = NULL;
+	memset( (void*)&velocity, 0, sizeof(velocity));
 	triAreas = NULL;
-	extForce = NULL;			
+	memset( (void*)&extForce, 0, sizeof(extForce));
 	alpha = 0.0f;
 	beta = 0.0f;
 	delta = 0.0f;
@@ -25,87 +28,165 @@ phyzx::phyzx()
 	dWall = 0.0f;
 	kSphere = 0.0f;
 	dSphere = 0.0f;
+	kContact = 0.0f;
+	dContact = 0.0f;
 	memset( (void*)&cmStable, 0, sizeof(cmStable));
 	memset( (void*)&cmDeformed, 0, sizeof(cmDeformed));
 	memset( (void*)&avgVel, 0, sizeof(avgVel));
-	relStableLoc = NULL;
-	relDeformedLoc = NULL;
+	sleeping = false;
+	restSteps = 0;
+	memset( (void*)&restStart, 0, sizeof(restStart));
+	memset( (void*)&relStableLoc, 0, sizeof(relStableLoc));
+	memset( (void*)&relDeformedLoc, 0, sizeof(relDeformedLoc));
 	NBTStruct = NULL;
 	NBVStruct = NULL;
 	q = NULL;
-	qT = NULL;
 	memset( (void*)&Apq, 0, sizeof(Apq));	
 	memset( (void*)&Aqq, 0, sizeof(Aqq));
 	memset( (void*)&R, 0, sizeof(R));							
+	rotQuat[0] = 1.0;
+	rotQuat[1] = rotQuat[2] = rotQuat[3] = 0.0;
+	memset( (void*)&TApq, 0, sizeof(TApq));
+	memset( (void*)&TAqq, 0, sizeof(TAqq));
+	memset( (void*)mqStable, 0, sizeof(mqStable));
+	tree = NULL;
+	contactStamp = NULL;
+	contactStampValue = 0;
+	contactList = NULL;
+	chunkSums = NULL;
+	chunkSumsSize = 0;
+	timing = NULL;
 }
 
 /* Function: phyzxInit
- * Description: Creates and initializes the phyzx object
- * Input: inputModel - Object model information
- *		  phyzxObj - current object structure 
+ * Description: Initializes the phyzx object as a new body of shape. The rest state is the one of the
+ *				shape, only the state changing while the body moves is allocated.
+ * Input: phyzxObj - current object structure 
+ *		  shape - shape of the body, given by shapeCache::Acquire
+ *		  world - world whose parameters the object starts with
  * Output: None
  */
-void phyzxInit(phyzx *phyzxObj)
+void phyzxInit(phyzx *phyzxObj, restShape *shape, simWorld *world)
 {
-	int numVertices = 0;
-	int size = 0;
-	point v1, v2, v3;
-
-	numVertices = phyzxObj->model->numvertices + 1;		// Count of the number of vertices in the Model
-
-	phyzxObj->h = gTStep;
-	phyzxObj->n = gNStep;
-	phyzxObj->alpha = gAlpha;
-	phyzxObj->beta = gBeta;
-	phyzxObj->delta = gDelta;
-	phyzxObj->kWall = gKCol;
-	phyzxObj->dWall = gDCol;
+	int numVertices = shape->numVertices;
+
+	phyzxObj->shape = shape;
+	phyzxObj->model = InstanceModel(shape);
+	phyzxObj->numVertices = numVertices;
+
+	phyzxObj->h = world->h;
+	phyzxObj->n = world->n;
+	phyzxObj->alpha = world->alpha;
+	phyzxObj->beta = world->beta;
+	phyzxObj->delta = world->delta;
+	phyzxObj->kWall = world->kWall;
+	phyzxObj->dWall = world->dWall;
 	phyzxObj->kSphere = 50.0;
 	phyzxObj->dSphere = 0.2;
-	phyzxObj->totalMass = 0.0;
+	phyzxObj->kContact = 0.05;
+	phyzxObj->dContact = 0.5;
 	phyzxObj->avgVel = vMake(0.0);
 
-	phyzxObj->velocity = (point *)calloc(numVertices, sizeof(point));
-	phyzxObj->extForce = (point *)calloc(numVertices, sizeof(point));
-	phyzxObj->stable = (point *)calloc(numVertices, sizeof(point));
-	phyzxObj->goal = (point *)calloc(numVertices, sizeof(point));
-	phyzxObj->relStableLoc = (point *)calloc(numVertices, sizeof(point));
-	phyzxObj->relDeformedLoc = (point *)calloc(numVertices, sizeof(point));
-	phyzxObj->mass = (double *)calloc(numVertices, sizeof(double));
-	phyzxObj->triAreas = (double *)calloc(phyzxObj->model->numtriangles, sizeof(double));
-	phyzxObj->q = (matrix *)calloc(numVertices, sizeof(matrix));
-	phyzxObj->qT = (matrix *)calloc(numVertices, sizeof(matrix));
+	// Rest state of the shape
+	phyzxObj->stable = shape->stable;
+	phyzxObj->mass = shape->mass;
+	phyzxObj->totalMass = shape->totalMass;
+	phyzxObj->triAreas = shape->triAreas;
+	phyzxObj->surArea = shape->surArea;
+	phyzxObj->NBTStruct = shape->NBTStruct;
+	phyzxObj->NBVStruct = shape->NBVStruct;
+	phyzxObj->cmStable = shape->cmStable;
+	phyzxObj->relStableLoc = shape->relStableLoc;
+	matCopy33(shape->Aqq, &phyzxObj->Aqq);
+	phyzxObj->TAqq = shape->TAqq;
+	memcpy( (void*)phyzxObj->mqStable, shape->mqStable, sizeof(phyzxObj->mqStable));
+	phyzxObj->q = shape->q;
+
+	soaInit(&phyzxObj->position, numVertices);
+	soaInit(&phyzxObj->velocity, numVertices);
+	soaInit(&phyzxObj->extForce, numVertices);
+	soaInit(&phyzxObj->goal, numVertices);
+	soaInit(&phyzxObj->relDeformedLoc, numVertices);
+	soaInit(&phyzxObj->restStart, numVertices);
 
 	// Initialise attributes with stable values
-	for(int index = STARTFROM; index <= numVertices; index++)
-	{
-		phyzxObj->stable[index].x = phyzxObj->model->vertices[3*index];
-		phyzxObj->stable[index].y = phyzxObj->model->vertices[3*index+1];
-		phyzxObj->stable[index].z = phyzxObj->model->vertices[3*index+2];
-		phyzxObj->mass[index] = 0.0;//param.MASS;
-		phyzxObj->extForce[index] = vMake(0.0, gGravity, 0.0);
-		phyzxObj->velocity[index] = vMake(0.01, 0.0, 0.0);
-	}
-	
-	for(unsigned int index = 0; index < phyzxObj->model->numtriangles; index++)
+	for(int index = 0; index < numVertices; index++)
 	{
-		v1 = vMake(phyzxObj->model->vertices[3*phyzxObj->model->triangles[index].vindices[0]], phyzxObj->model->vertices[3*phyzxObj->model->triangles[index].vindices[0]+1], phyzxObj->model->vertices[3*phyzxObj->model->triangles[index].vindices[0]+2]);
-		v2 = vMake(phyzxObj->model->vertices[3*phyzxObj->model->triangles[index].vindices[1]], phyzxObj->model->vertices[3*phyzxObj->model->triangles[index].vindices[1]+1], phyzxObj->model->vertices[3*phyzxObj->model->triangles[index].vindices[1]+2]);
-		v3 = vMake(phyzxObj->model->vertices[3*phyzxObj->model->triangles[index].vindices[2]], phyzxObj->model->vertices[3*phyzxObj->model->triangles[index].vindices[2]+1], phyzxObj->model->vertices[3*phyzxObj->model->triangles[index].vindices[2]+2]);
-		phyzxObj->triAreas[index] = AreaOfTri(v1, v2, v3); 
+		phyzxObj->position.x[index] = phyzxObj->stable.x[index];
+		phyzxObj->position.y[index] = phyzxObj->stable.y[index];
+		phyzxObj->position.z[index] = phyzxObj->stable.z[index];
+		soaSet(phyzxObj->extForce, index, vMake(0.0, world->gravity, 0.0));
+		soaSet(phyzxObj->velocity, index, vMake(0.01, 0.0, 0.0));
+	}
+
+	phyzxObj->tree = new bvh(shape->tree);
+	phyzxObj->contactStamp = (int *)calloc(numVertices + 1, sizeof(int));
+	phyzxObj->contactList = (int *)malloc((numVertices + 1) * sizeof(int));
+}
+
+/* Function: BuildTriangleTree
+ * Description: Builds the bounding volume hierarchy of the model triangles around the current positions.
+ *				The triangles are wound so that their normals point out of the model.
+ * Input: phyzxObj - model
+ * Output: the tree
+ */
+bvh * BuildTriangleTree(phyzx *phyzxObj)
+{
+	int numTriangles = phyzxObj->model->numtriangles;
+	int *triangles = (int *)malloc(3 * (numTriangles + 1) * sizeof(int));
+	double volume = 0.0;
+	point a, b, c, n;
+	bvh *tree;
 
-		(*phyzxObj).surArea += phyzxObj->triAreas[index];
+	for (int t = 0; t < numTriangles; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+			triangles[3*t + corner] = phyzxObj->model->triangles[t].vindices[corner] - STARTFROM;
+
+		// Signed volume of the model, negative when the triangles are wound inwards
+		a = soaGet(phyzxObj->position, triangles[3*t]);
+		b = soaGet(phyzxObj->position, triangles[3*t + 1]);
+		c = soaGet(phyzxObj->position, triangles[3*t + 2]);
+		CROSSPRODUCTp(b, c, n);
+		volume += dotProd(a, n);
 	}
-	
-	phyzxObj->NBTStruct = glmBuildNeighborStructure(phyzxObj->model);
-	phyzxObj->NBVStruct = vertexList(phyzxObj->model, phyzxObj->NBTStruct, 0.05);
-	filterNBV(phyzxObj->model, phyzxObj->NBVStruct);
-	compMass(phyzxObj->NBTStruct, phyzxObj);
 
-	CalcCM(0, phyzxObj);
-	CalcRelLoc(0, phyzxObj);
-	CalcAqq(phyzxObj);
-	calcTAqq(phyzxObj);
+	if (volume < 0.0)
+		for (int t = 0; t < numTriangles; t++)
+		{
+			int swap = triangles[3*t + 1];
+			triangles[3*t + 1] = triangles[3*t + 2];
+			triangles[3*t + 2] = swap;
+		}
+
+	tree = new bvh(triangles, numTriangles, phyzxObj->position);
+	free(triangles);
+
+	return tree;
+}
+
+/* Function: phyzxDelete
+ * Description: Frees the phyzx object together with its model, and gives its shape back to the cache
+ * Input: phyzxObj - current object structure 
+ * Output: None
+ */
+void phyzxDelete(phyzx *phyzxObj)
+{
+	soaFree(&phyzxObj->position);
+	soaFree(&phyzxObj->velocity);
+	soaFree(&phyzxObj->extForce);
+	soaFree(&phyzxObj->goal);
+	soaFree(&phyzxObj->relDeformedLoc);
+	soaFree(&phyzxObj->restStart);
+	free(phyzxObj->chunkSums);
+	free(phyzxObj->contactStamp);
+	free(phyzxObj->contactList);
+	free(phyzxObj->timing);
+	delete phyzxObj->tree;
+
+	DeleteInstanceModel(phyzxObj->model);
+	phyzxObj->shape->cache->Release(phyzxObj->shape);
+	delete phyzxObj;
 }
 
 /* Function: AreaOfTri
@@ -157,165 +238,174 @@ double adjustMass(GLMmodel *model)
 } //end adjustMass
 
 /* Function: compMass
- * Description: Computes the mass of each vertex
- * Input: NBVStruct - neighbouring triangles list for every vertex in the model
+ * Description: Computes the mass of each vertex, a third of the area of its triangles
+ * Input: NBTStruct - neighbouring triangles of every vertex in the model
  * Output: None
  */
-void compMass(GLMnode **NBTStruct, phyzx *phyzxObj)
+void compMass(GLMadjacency *NBTStruct, phyzx *phyzxObj)
 {
-	GLMnode *curNode;
 	double adj = adjustMass(phyzxObj->model);
 
 	for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
 	{
-		curNode = NBTStruct[index];
+		for(unsigned int n = NBTStruct->offset[index]; n < NBTStruct->offset[index+1]; n++)
+			phyzxObj->mass[index-STARTFROM] += phyzxObj->triAreas[NBTStruct->index[n]];
 
-		while(curNode->next != NULL)	
-		{
-			phyzxObj->mass[index] += phyzxObj->triAreas[curNode->index];
-
-			curNode = curNode->next;
-		}
-		phyzxObj->mass[index] /= 3.0;
+		phyzxObj->mass[index-STARTFROM] /= 3.0;
 
-		phyzxObj->mass[index] /= phyzxObj->surArea;
+		phyzxObj->mass[index-STARTFROM] /= phyzxObj->surArea;
 		
-		phyzxObj->mass[index] *= adj;
-		continue;
+		phyzxObj->mass[index-STARTFROM] *= adj;
 	}
 }
 
-void filterNBV(GLMmodel *obj, GLMnode **NBVStruct)
+/* Function: VertexChunks
+ * Description: Number of VERTEXCHUNK ranges the vertex loops of a model are cut into
+ * Input: numVertices - number of vertices of the model
+ * Output: number of ranges
+ */
+int VertexChunks(int numVertices)
 {
-	for(unsigned int index = STARTFROM; index <= (*obj).numvertices; index++)
-	{
-		GLMnode *currCol;
-		GLMnode *nextCol;
-		GLMnode *preNode;
-
-
-		nextCol = NBVStruct[index];
+	return (numVertices + VERTEXCHUNK - 1) / VERTEXCHUNK;
+}
 
-		while (nextCol->next != NULL)
-		{
-			currCol = nextCol;
-			preNode = currCol;
-			while (preNode->next != NULL)
-			{
-				currCol = preNode;
-				currCol = currCol->next;
+/* Function: ChunkSums
+ * Description: Makes room for stride partial sums per vertex range of the model, and clears them
+ * Input: stride - number of partial sums of every range
+ * Output: the partial sums, range i starting at i * stride
+ */
+double * ChunkSums(phyzx *phyzxObj, int stride)
+{
+	int size = VertexChunks(phyzxObj->numVertices) * stride;
 
-				if (nextCol->index == currCol->index)
-					delNode(preNode, currCol->next);
-				
-				if(preNode->next != NULL)
-					preNode = preNode->next;
-			} //end while
-			
-			if(nextCol->next != NULL)
-				nextCol = nextCol->next;
-		} //end while
-	} //end for
-} //end filterNBV
+	if (size > phyzxObj->chunkSumsSize)
+	{
+		free(phyzxObj->chunkSums);
+		phyzxObj->chunkSums = (double *)malloc(size * sizeof(double));
+		phyzxObj->chunkSumsSize = size;
+	}
+	memset( (void*)phyzxObj->chunkSums, 0, size * sizeof(double));
 
+	return phyzxObj->chunkSums;
+}
 
-void delNode(GLMnode *preNode, GLMnode *next)
+/* Function: ForEachVertexChunk
+ * Description: Runs task on every vertex range of the model, on the world thread pool if there is one.
+ *				task receives work and a range of chunk indices; chunk c covers the vertices
+ *				[c * VERTEXCHUNK, (c + 1) * VERTEXCHUNK).
+ * Input: work - model and arguments of the loop
+ *		  task - work done on the chunks [begin, end)
+ * Output: None
+ */
+void ForEachVertexChunk(vertexTask *work, threadTask task)
 {
-	delete(preNode->next);
+	int numChunks = VertexChunks(work->phyzxObj->numVertices);
 
-	if(next != NULL)
-		preNode->next = next;
-	else 
-		preNode->next = NULL;
-} //end delNode
+	ChunkSums(work->phyzxObj, work->stride);
 
-/* Function: vertexList
- * Description: Creates a structure that lists
- * Input: None
- * Output: None
+	if (work->world != NULL)
+		work->world->pool->parallelFor(numChunks, 1, task, work);
+	else
+		task(work, 0, numChunks);
+}
+
+/* Function: CombineChunks
+ * Description: Adds up the partial sums of all the vertex ranges, always in range order
+ * Input: stride - number of partial sums of every range
+ * Output: result - stride sums
  */
-GLMnode ** vertexList(GLMmodel *obj, GLMnode **NBTStruct, double radius)
+void CombineChunks(phyzx *phyzxObj, int stride, double *result)
 {
-	GLMnode *node, *temp;
-	GLMnode **NBVStruct;
+	int numChunks = VertexChunks(phyzxObj->numVertices);
 
-	NBVStruct = (GLMnode**)malloc(sizeof(GLMnode*) * ((*obj).numvertices + 1));
-	
-	for (unsigned int i = 1; i <= (*obj).numvertices; i++)
-		NBVStruct[i] = NULL;
-    
-	for(unsigned int index = STARTFROM; index <= (*obj).numvertices; index++)
-	{
-		temp = NBTStruct[index];
-		while (temp->next != NULL)
-		{
-			node = (GLMnode*)malloc(sizeof(GLMnode));
-			node->index = (*obj).triangles[temp->index].vindices[0];
-			node->next  = NBVStruct[index];
-			NBVStruct[index] = node;
-
-			node = (GLMnode*)malloc(sizeof(GLMnode));
-			node->index = (*obj).triangles[temp->index].vindices[1];
-			node->next  = NBVStruct[index];
-			NBVStruct[index] = node;
-
-			node = (GLMnode*)malloc(sizeof(GLMnode));
-			node->index = (*obj).triangles[temp->index].vindices[2];
-			node->next  = NBVStruct[index];
-			NBVStruct[index] = node;
-
-			temp = temp->next;
-		}
-	}
+	for (int k = 0; k < stride; k++)
+		result[k] = 0.0;
 
-	return NBVStruct;
-} //end vertexList
+	for (int chunk = 0; chunk < numChunks; chunk++)
+		for (int k = 0; k < stride; k++)
+			result[k] += phyzxObj->chunkSums[chunk * stride + k];
+}
 
 /* Function: CalcCM
  * Description: Computes the center of mass of the model
  * Input: toggle - value used toggle between stable CM(0) / deformed CM(1) computation
+ *		  world - world whose threads run the vertex loop (NULL for the calling thread only)
  * Output: None
  */
-void CalcCM(int toggle, phyzx *phyzxObj)
+void CalcCM(int toggle, phyzx *phyzxObj, simWorld *world)
 {
-	point numerator;
-	//double denominator = 0;
-	
-	memset( (void*)&numerator, 0, sizeof(numerator));
+	vertexTask work;
+	double sums[4];
+
+	memset( (void*)&work, 0, sizeof(work));
+	work.phyzxObj = phyzxObj;
+	work.world = world;
+	work.toggle = toggle;
+	work.stride = 4;
+
+	// numerator x, y, z and mass of every range
+	ForEachVertexChunk(&work, CalcCMChunks);
+	CombineChunks(phyzxObj, 4, sums);
 
 	switch(toggle)
 	{
 		case 0:
-			for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
-			{
-				numerator.x += phyzxObj->mass[index] * phyzxObj->stable[index].x;
-				numerator.y += phyzxObj->mass[index] * phyzxObj->stable[index].y;
-				numerator.z += phyzxObj->mass[index] * phyzxObj->stable[index].z;
-				
-				//denominator += phyzxObj->mass[index];
-				phyzxObj->totalMass += phyzxObj->mass[index];
-			}
-			phyzxObj->cmStable.x = numerator.x / phyzxObj->totalMass;
-			phyzxObj->cmStable.y = numerator.y / phyzxObj->totalMass;
-			phyzxObj->cmStable.z = numerator.z / phyzxObj->totalMass;
+			phyzxObj->totalMass += sums[3];
+			phyzxObj->cmStable.x = sums[0] / phyzxObj->totalMass;
+			phyzxObj->cmStable.y = sums[1] / phyzxObj->totalMass;
+			phyzxObj->cmStable.z = sums[2] / phyzxObj->totalMass;
 			break;
 
 		case 1:
-			for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
-			{
-				numerator.x += phyzxObj->mass[index] * phyzxObj->model->vertices[3*index];
-				numerator.y += phyzxObj->mass[index] * phyzxObj->model->vertices[3*index+1];
-				numerator.z += phyzxObj->mass[index] * phyzxObj->model->vertices[3*index+2];
-
-				//denominator += phyzxObj->mass[index];
-			}
-			phyzxObj->cmDeformed.x = numerator.x / phyzxObj->totalMass;
-			phyzxObj->cmDeformed.y = numerator.y / phyzxObj->totalMass;
-			phyzxObj->cmDeformed.z = numerator.z / phyzxObj->totalMass;
+			phyzxObj->cmDeformed.x = sums[0] / phyzxObj->totalMass;
+			phyzxObj->cmDeformed.y = sums[1] / phyzxObj->totalMass;
+			phyzxObj->cmDeformed.z = sums[2] / phyzxObj->totalMass;
 			break;
 	}
 }
 
+/* Function: CalcCMChunks
+ * Description: Vertex loop of CalcCM over the chunks [begin, end)
+ * Input: context - vertexTask of the model
+ * Output: None
+ */
+void CalcCMChunks(void *context, int begin, int end)
+{
+	vertexTask *work = (vertexTask *)context;
+	phyzx *phyzxObj = work->phyzxObj;
+	const double *mass = phyzxObj->mass;
+	const double *x, *y, *z;
+	double *sums;
+	int last;
+
+	if (work->toggle == 0)
+	{
+		x = phyzxObj->stable.x;
+		y = phyzxObj->stable.y;
+		z = phyzxObj->stable.z;
+	}
+	else
+	{
+		x = phyzxObj->position.x;
+		y = phyzxObj->position.y;
+		z = phyzxObj->position.z;
+	}
+
+	for (int chunk = begin; chunk < end; chunk++)
+	{
+		sums = phyzxObj->chunkSums + chunk * 4;
+		last = (chunk + 1) * VERTEXCHUNK < phyzxObj->numVertices ? (chunk + 1) * VERTEXCHUNK : phyzxObj->numVertices;
+
+		for(int index = chunk * VERTEXCHUNK; index < last; index++)
+		{
+			sums[0] += mass[index] * x[index];
+			sums[1] += mass[index] * y[index];
+			sums[2] += mass[index] * z[index];
+			sums[3] += mass[index];
+		}
+	}
+}
+
 
 /* Function: CalcRelLoc
  * Description: Computes the relative location of each vertex wrt center of mass of the model
@@ -328,20 +418,20 @@ void CalcRelLoc(int toggle, phyzx *phyzxObj)
 	switch(toggle)
 	{
 		case 0:
-			for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
+			for(int index = 0; index < phyzxObj->numVertices; index++)
 			{
-				phyzxObj->relStableLoc[index].x = phyzxObj->stable[index].x - phyzxObj->cmStable.x;
-				phyzxObj->relStableLoc[index].y = phyzxObj->stable[index].y - phyzxObj->cmStable.y;
-				phyzxObj->relStableLoc[index].z = phyzxObj->stable[index].z - phyzxObj->cmStable.z;
+				phyzxObj->relStableLoc.x[index] = phyzxObj->stable.x[index] - phyzxObj->cmStable.x;
+				phyzxObj->relStableLoc.y[index] = phyzxObj->stable.y[index] - phyzxObj->cmStable.y;
+				phyzxObj->relStableLoc.z[index] = phyzxObj->stable.z[index] - phyzxObj->cmStable.z;
 			}
 			break;
 
 		case 1:
-			for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
+			for(int index = 0; index < phyzxObj->numVertices; index++)
 			{
-				phyzxObj->relDeformedLoc[index].x = phyzxObj->model->vertices[3*index] - phyzxObj->cmDeformed.x;
-				phyzxObj->relDeformedLoc[index].y = phyzxObj->model->vertices[3*index+1] - phyzxObj->cmDeformed.y;
-				phyzxObj->relDeformedLoc[index].z = phyzxObj->model->vertices[3*index+2] - phyzxObj->cmDeformed.z;
+				phyzxObj->relDeformedLoc.x[index] = phyzxObj->position.x[index] - phyzxObj->cmDeformed.x;
+				phyzxObj->relDeformedLoc.y[index] = phyzxObj->position.y[index] - phyzxObj->cmDeformed.y;
+				phyzxObj->relDeformedLoc.z[index] = phyzxObj->position.z[index] - phyzxObj->cmDeformed.z;
 			}
 			break;
 	}
@@ -351,29 +441,80 @@ void CalcRelLoc(int toggle, phyzx *phyzxObj)
 /* Function: CalcApq
  * Description: Computes the Apq matrix which is the product of rotation and scaling matrices
  *				Apq = Summation(m * (p x qT))
- * Input: None
+ *				The nine sums are accumulated directly instead of building p x qT for every vertex
+ * Input: world - world whose threads run the vertex loop
  * Output: None
  */
-void CalcApq(phyzx *phyzxObj)
+void CalcApq(phyzx *phyzxObj, simWorld *world)
 {
-	matrix33 pqT, mpqT;
+	vertexTask work;
+	double sums[9];
 
-	memset( (void*)&phyzxObj->Apq, 0, sizeof(phyzxObj->Apq));
-	memset( (void*)&pqT, 0, sizeof(pqT));
-	memset( (void*)&mpqT, 0, sizeof(mpqT));
-	
-	for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
+	memset( (void*)&work, 0, sizeof(work));
+	work.phyzxObj = phyzxObj;
+	work.world = world;
+	work.stride = 9;
+
+	ForEachVertexChunk(&work, CalcApqChunks);
+	CombineChunks(phyzxObj, 9, sums);
+
+	for (int row = 0; row < 3; row++)
+		for (int col = 0; col < 3; col++)
+			phyzxObj->Apq[row][col] = sums[3*row + col];
+	return;
+}
+
+/* Function: CalcApqChunks
+ * Description: Vertex loop of CalcApq over the chunks [begin, end), also stores the relative locations
+ * Input: context - vertexTask of the model
+ * Output: None
+ */
+void CalcApqChunks(void *context, int begin, int end)
+{
+	vertexTask *work = (vertexTask *)context;
+	phyzx *phyzxObj = work->phyzxObj;
+	double a00, a01, a02, a10, a11, a12, a20, a21, a22;
+	double px, py, pz, m;
+	const double *x = phyzxObj->position.x, *y = phyzxObj->position.y, *z = phyzxObj->position.z;
+	const double *qx = phyzxObj->relStableLoc.x, *qy = phyzxObj->relStableLoc.y, *qz = phyzxObj->relStableLoc.z;
+	double *rx = phyzxObj->relDeformedLoc.x, *ry = phyzxObj->relDeformedLoc.y, *rz = phyzxObj->relDeformedLoc.z;
+	double *sums;
+	point cm = phyzxObj->cmDeformed;
+	int last;
+
+	for (int chunk = begin; chunk < end; chunk++)
 	{
-		// Compute Relative Location
-		phyzxObj->relDeformedLoc[index].x = phyzxObj->model->vertices[3*index] - phyzxObj->cmDeformed.x;
-		phyzxObj->relDeformedLoc[index].y = phyzxObj->model->vertices[3*index+1] - phyzxObj->cmDeformed.y;
-		phyzxObj->relDeformedLoc[index].z = phyzxObj->model->vertices[3*index+2] - phyzxObj->cmDeformed.z;
+		a00 = a01 = a02 = a10 = a11 = a12 = a20 = a21 = a22 = 0.0;
+		last = (chunk + 1) * VERTEXCHUNK < phyzxObj->numVertices ? (chunk + 1) * VERTEXCHUNK : phyzxObj->numVertices;
+
+		for(int index = chunk * VERTEXCHUNK; index < last; index++)
+		{
+			// Compute Relative Location
+			px = x[index] - cm.x;
+			py = y[index] - cm.y;
+			pz = z[index] - cm.z;
+			rx[index] = px;
+			ry[index] = py;
+			rz[index] = pz;
+
+			// Apq += m * (p X qT) 
+			m = phyzxObj->mass[index];
+			a00 += m * (px * qx[index]);
+			a01 += m * (px * qy[index]);
+			a02 += m * (px * qz[index]);
+			a10 += m * (py * qx[index]);
+			a11 += m * (py * qy[index]);
+			a12 += m * (py * qz[index]);
+			a20 += m * (pz * qx[index]);
+			a21 += m * (pz * qy[index]);
+			a22 += m * (pz * qz[index]);
+		}
 
-		matMult31(phyzxObj->relDeformedLoc[index], phyzxObj->relStableLoc[index], &pqT);		// p x qT
-		matScalarMult33(phyzxObj->mass[index], pqT, &mpqT);									// m * (p X qT)
-		matAdd33(phyzxObj->Apq, mpqT, &phyzxObj->Apq);											// Apq += m * (p X qT) 
+		sums = phyzxObj->chunkSums + chunk * 9;
+		sums[0] = a00; sums[1] = a01; sums[2] = a02;
+		sums[3] = a10; sums[4] = a11; sums[5] = a12;
+		sums[6] = a20; sums[7] = a21; sums[8] = a22;
 	}
-	return;
 }
 
 
@@ -392,9 +533,10 @@ void CalcAqq(phyzx *phyzxObj)
 	memset( (void*)&mqqT, 0, sizeof(mqqT));
 	memset( (void*)&Aqq, 0, sizeof(Aqq));
 	
-	for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
+	for(int index = 0; index < phyzxObj->numVertices; index++)
 	{
-		matMult31(phyzxObj->relStableLoc[index], phyzxObj->relStableLoc[index], &qqT);			// q x qT
+		point q = soaGet(phyzxObj->relStableLoc, index);
+		matMult31(q, q, &qqT);			// q x qT
 		matScalarMult33(phyzxObj->mass[index], qqT, &mqqT);									// m * (q X qT)
 		matAdd33(Aqq, mqqT, &Aqq);											// temp += m * (q X qT) 
 	}
@@ -408,15 +550,36 @@ void CalcAqq(phyzx *phyzxObj)
  * Input: None
  * Output: None
  */
-void CalcRotMat(phyzx *phyzxObj)
+void CalcRotMat(phyzx *phyzxObj, simWorld *world)
+{
+	CalcApq(phyzxObj, world);													// Apq
+	ExtractRotation(phyzxObj, world);
+}
+
+
+/* Function: ExtractRotation
+ * Description: Computes the Rotation matrix from the current Apq, with the method of world->rotationMode
+ *				ROTATION_POLAR: R = Apq x SInv, S = sqrt(ApqT x Apq)
+ *				ROTATION_ITERATIVE: iterations starting from the rotation of the last timestep, which also
+ *				give a rotation when Apq is singular or inverted
+ * Input: world - world holding the rotation mode
+ * Output: None
+ */
+void ExtractRotation(phyzx *phyzxObj, simWorld *world)
 {
 	matrix33 ApqTemp, ApqTrans, ApqSQRT, ApqInv;
+
+	if (world->rotationMode == ROTATION_ITERATIVE)
+	{
+		matRotation33(phyzxObj->Apq, phyzxObj->rotQuat, ROTATIONITERATIONS, &phyzxObj->R);
+		return;
+	} //end if
+
 	memset( (void*)&ApqTemp, 0, sizeof(ApqTemp));
 	memset( (void*)&ApqTrans, 0, sizeof(ApqTrans));
 	memset( (void*)&ApqSQRT, 0, sizeof(ApqSQRT));
 	memset( (void*)&ApqInv, 0, sizeof(ApqInv));
 
-	CalcApq(phyzxObj);													// Apq
 	matTranspose33(phyzxObj->Apq, &ApqTrans);					// ApqT		
 	matMult33(ApqTrans, phyzxObj->Apq, &ApqTemp);				// ApqT x Apq
 	matSqrt33(ApqTemp, &ApqSQRT);								// S = sqrt(ApqT x Apq)
@@ -437,11 +600,12 @@ void CalcGoalPos(phyzx *phyzxObj)
 
 	memset( (void*)&temp, 0, sizeof(temp));
 
-	for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
+	for(int index = 0; index < phyzxObj->numVertices; index++)
 	{
 		//pDIFFERENCE(phyzxObj->stable[index], phyzxObj->cmStable, temp);			// xi0 - xcm0
-		matMult3331(phyzxObj->R, phyzxObj->relStableLoc[index], &temp);				// R(xi0 - xcm0)
-		pSUM(temp, phyzxObj->cmDeformed, phyzxObj->goal[index]);					// g = R(xi0 - xcm0) + xcm
+		matMult3331(phyzxObj->R, soaGet(phyzxObj->relStableLoc, index), &temp);		// R(xi0 - xcm0)
+		pSUM(temp, phyzxObj->cmDeformed, temp);										// g = R(xi0 - xcm0) + xcm
+		soaSet(phyzxObj->goal, index, temp);
 	}
 }
 
@@ -452,11 +616,66 @@ void CalcGoalPos(phyzx *phyzxObj)
  * Input: None
  * Output: None
  */
-void ModEuler(phyzx *phyzxObj, int mIndex, int deformMode)
+void ModEuler(phyzx *phyzxObj, int mIndex, int deformMode, simWorld *world)
+{
+	vertexTask work;
+	double sums[5];
+	matrix39 R;
+
+	if (deformMode == 3)
+	{
+		phaseTimer timer(world->profiler, &phyzxObj->timing, PHASE_DEFORM);
+		quadDeformRot(&R, phyzxObj, world);
+	} //end if
+
+	memset( (void*)&work, 0, sizeof(work));
+	work.phyzxObj = phyzxObj;
+	work.world = world;
+	work.mIndex = mIndex;
+	work.deformMode = deformMode;
+	work.R = &R;
+	work.stride = 5;
+
+	ForEachVertexChunk(&work, ModEulerChunks);
+	CombineChunks(phyzxObj, 5, sums);
+
+	phyzxObj->avgVel.x = sums[0];
+	phyzxObj->avgVel.y = sums[1];
+	phyzxObj->avgVel.z = sums[2];
+	pMULTIPLY(phyzxObj->avgVel, 1.0 / phyzxObj->numVertices, phyzxObj->avgVel);
+
+	// Seconds spent by all the chunks in the integration and in the wall response
+	if (world->profiler != NULL)
+	{
+		world->profiler->Add(&phyzxObj->timing, PHASE_INTEGRATE, sums[3]);
+		world->profiler->Add(&phyzxObj->timing, PHASE_WALL, sums[4]);
+	} //end if
+} //end ModEuler()
+
+/* Function: ModEulerChunks
+ * Description: Vertex loop of ModEuler over the chunks [begin, end), keeps the velocity sum of every chunk,
+ *				and the seconds spent in the integration and in the wall response when they are measured.
+ *				FUSEDCHUNK vertices are integrated at a time before their wall response, which only
+ *				reads and writes the vertex it is called for.
+ * Input: context - vertexTask of the model
+ * Output: None
+ */
+void ModEulerChunks(void *context, int begin, int end)
 {
+	vertexTask *work = (vertexTask *)context;
+	phyzx *phyzxObj = work->phyzxObj;
+	simWorld *world = work->world;
+	int mIndex = work->mIndex;
 	point vertex, velocity, extVel, position, velDamp;
 	point vDiff, velTotal, newPos, temp;
-	matrix R, matTemp;
+	point goal, extForce, vel, velSum;
+	fixedMatrix<3, 1> matTemp;
+	unsigned char frozen[FUSEDCHUNK];
+	simdContactParams contacts;
+	bool timed = (world->profiler != NULL);
+	double integrateStart = 0.0, wallStart = 0.0, integrateTime, wallTime;
+	double lo[3], hi[3];
+	int last;
 
 	memset( (void*)&temp, 0, sizeof(temp));
 	memset((void*)&extVel, 0, sizeof(point));
@@ -465,104 +684,109 @@ void ModEuler(phyzx *phyzxObj, int mIndex, int deformMode)
 	memset((void*)&vDiff, 0, sizeof(point));
 	memset((void*)&velTotal, 0, sizeof(point));
 	memset((void*)&newPos, 0, sizeof(point));
-	memset((void*)&phyzxObj->avgVel, 0, sizeof(point));
-
-	matInit(&R, 0, 0);
-	matInit(&matTemp, 0, 0);
-
-	if (deformMode == 3)
-		quadDeformRot(&R, phyzxObj);
 
-	for (unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
+	for (int chunk = begin; chunk < end; chunk++)
 	{
-		if (deformMode == 3)
-		{
-			// Compute Quadratic Deformation Goal Positions
-			matMult(R, phyzxObj->q[index], &matTemp);						// R(q)
-			temp = matToPoint(matTemp);										// Data type conversion
-			pSUM(temp, phyzxObj->cmDeformed, phyzxObj->goal[index]);		// g = R(q) + xcm
-		} //end if
-		else
-		{
-			// Compute Goal Positions
-			matMult3331(phyzxObj->R, phyzxObj->relStableLoc[index], &temp);				// R(xi0 - xcm0)
-			pSUM(temp, phyzxObj->cmDeformed, phyzxObj->goal[index]);					// g = R(xi0 - xcm0) + xcm
-		} //end if
+		memset((void*)&velSum, 0, sizeof(point));
+		integrateTime = wallTime = 0.0;
+		last = (chunk + 1) * VERTEXCHUNK < phyzxObj->numVertices ? (chunk + 1) * VERTEXCHUNK : phyzxObj->numVertices;
 
-		vertex.x = phyzxObj->model->vertices[3*index];
-		vertex.y = phyzxObj->model->vertices[3*index + 1];
-		vertex.z = phyzxObj->model->vertices[3*index + 2];\
-
-		if (stickyFloor == 1)
-			if (vertex.y <= -WALLDIST)
-				continue;
-
-		// Add user force
-		if (mIndex == iMouseModel && lMouseVal == 2 && objectName != -1)// && index == objectName)
+		for (int from = chunk * VERTEXCHUNK; from < last; from += FUSEDCHUNK)
 		{
-			//point uForce;
-			/*GLMnode *node;
-			node = NBVStruct[objectName];
+			int to = (from + FUSEDCHUNK < last) ? from + FUSEDCHUNK : last;
 
-			while (node->next != NULL)
+			if (timed)
+				integrateStart = profileClock();
+
+			lo[0] = lo[1] = lo[2] = HUGE_VAL;
+			hi[0] = hi[1] = hi[2] = -HUGE_VAL;
+			for (int index = from; index < to; index++)
 			{
-				pSUM(phyzxObj->extForce[node->index], userForce, phyzxObj->extForce[node->index]);
-				node = node->next;
-			} //end while*/
-			/*if (index != objectName)
+				if (work->deformMode == 3)
+				{
+					// Compute Quadratic Deformation Goal Positions
+					matMult(*work->R, phyzxObj->q[index], &matTemp);				// R(q)
+					temp = matToPoint(matTemp);										// Data type conversion
+					pSUM(temp, phyzxObj->cmDeformed, goal);							// g = R(q) + xcm
+				} //end if
+				else
+				{
+					// Compute Goal Positions
+					matMult3331(phyzxObj->R, soaGet(phyzxObj->relStableLoc, index), &temp);		// R(xi0 - xcm0)
+					pSUM(temp, phyzxObj->cmDeformed, goal);										// g = R(xi0 - xcm0) + xcm
+				} //end if
+				soaSet(phyzxObj->goal, index, goal);
+
+				vertex = soaGet(phyzxObj->position, index);
+				extForce = soaGet(phyzxObj->extForce, index);
+				vel = soaGet(phyzxObj->velocity, index);
+
+				// Vertices resting on the floor are neither integrated nor pushed back
+				frozen[index - from] = (world->stickyFloor == 1 && vertex.y <= world->arena->floorY);
+				if (frozen[index - from])
+					continue;
+
+				// Add user force
+				if (mIndex == world->dragModel)
+				{
+					pSUM(extForce, world->userForce, extForce);
+				} //end if
+
+				// Explicit Euler Integrator for veloctiy -> vi(t + h)
+				pDIFFERENCE(goal, vertex, vDiff);																// gi(t) - xi(t)
+				pMULTIPLY(vDiff, (phyzxObj->alpha / phyzxObj->h), velocity);									// vi(h) = (ALPHA / h) * (gi(t) - xi(t))
+				pMULTIPLY(extForce, (phyzxObj->h / phyzxObj->mass[index]), extVel);								// (h / mi) * Fext(t)
+				pSUM(velocity, extVel, velTotal);																// vi(h) = (ALPHA / h) * (gi(t) - xi(t)) + (h / mi) * Fext(t) 
+
+				pSUM(vel, velTotal, vel);																		// vi(t + h) = vi(t) + vi(h)
+				
+				// Velocity Damping
+				pMULTIPLY(vel, -phyzxObj->delta, velDamp);
+				pSUM(vel, velDamp, vel);
+
+				// Implicity Euler Integrator for position
+				pMULTIPLY(vel, phyzxObj->h, position);															// xi(h) = h * vi(t + h)
+				pSUM(vertex, position, newPos);																// xi(t + h) = xi(t) + xi(h)
+
+				// Store new position and velocity into data structure
+				soaSet(phyzxObj->position, index, newPos);
+				soaSet(phyzxObj->velocity, index, vel);
+				soaSet(phyzxObj->extForce, index, extForce);
+
+				pSUM(velSum, vel, velSum);
+
+				// Bounding box of the vertices pushed back below
+				lo[0] = (newPos.x < lo[0]) ? newPos.x : lo[0];
+				lo[1] = (newPos.y < lo[1]) ? newPos.y : lo[1];
+				lo[2] = (newPos.z < lo[2]) ? newPos.z : lo[2];
+				hi[0] = (newPos.x > hi[0]) ? newPos.x : hi[0];
+				hi[1] = (newPos.y > hi[1]) ? newPos.y : hi[1];
+				hi[2] = (newPos.z > hi[2]) ? newPos.z : hi[2];
+			} //end for
+
+			if (timed)
+				wallStart = profileClock();
+
+			// Resets the external force to gravity and adds the wall response
+			GatherContacts(phyzxObj, lo, hi, world, &contacts);
+			for (int index = from; index < to; index++)
+				if (!frozen[index - from])
+					CheckForCollision(index, phyzxObj, &contacts);
+
+			if (timed)
 			{
-				point extPos = vMake(phyzxObj->model->vertices[3*objectName], phyzxObj->model->vertices[3*objectName+1], phyzxObj->model->vertices[3*objectName+2]);
-				double dist = vecLeng(extPos, vertex);
-				//if (dist > 0.04)
-				//{
-					pMULTIPLY(userForce, (1.0/dist), uForce);
-					pSUM(phyzxObj->extForce[index], uForce, phyzxObj->extForce[index]);
-					//pDisp("user", userForce);
-				//} //end if
-				//else
-				//{
-					//pSUM(phyzxObj->extForce[index], userForce, phyzxObj->extForce[index]);
-				//} //end else
+				integrateTime += wallStart - integrateStart;
+				wallTime += profileClock() - wallStart;
 			} //end if
-			else
-			{*/
-				pSUM(phyzxObj->extForce[index], userForce, phyzxObj->extForce[index]);
-			//} //end else
-		} //end if
-
-		// Explicit Euler Integrator for veloctiy -> vi(t + h)
-		pDIFFERENCE(phyzxObj->goal[index], vertex, vDiff);												// gi(t) - xi(t)
-		pMULTIPLY(vDiff, (phyzxObj->alpha / phyzxObj->h), velocity);									// vi(h) = (ALPHA / h) * (gi(t) - xi(t))
-		pMULTIPLY(phyzxObj->extForce[index], (phyzxObj->h / phyzxObj->mass[index]), extVel);			// (h / mi) * Fext(t)
-//		pMULTIPLY(phyzxObj->extForce[index], phyzxObj->h, extVel);			// (h / mi) * Fext(t)
-		pSUM(velocity, extVel, velTotal);																// vi(h) = (ALPHA / h) * (gi(t) - xi(t)) + (h / mi) * Fext(t) 
-
-		pSUM(phyzxObj->velocity[index], velTotal, phyzxObj->velocity[index]);							// vi(t + h) = vi(t) + vi(h)
-		
-		// Velocity Damping
-		pMULTIPLY(phyzxObj->velocity[index], -phyzxObj->delta, velDamp);
-		pSUM(phyzxObj->velocity[index], velDamp, phyzxObj->velocity[index]);
-
-		// Implicity Euler Integrator for position
-		pMULTIPLY(phyzxObj->velocity[index], phyzxObj->h, position);									// xi(h) = h * vi(t + h)
-		pSUM(vertex, position, newPos);																// xi(t + h) = xi(t) + xi(h)
-
-		// Store new position into data structure
-		phyzxObj->model->vertices[3*index] = newPos.x;
-		phyzxObj->model->vertices[3*index + 1] = newPos.y;
-		phyzxObj->model->vertices[3*index + 2] = newPos.z;
-
-		pSUM(phyzxObj->avgVel, phyzxObj->velocity[index], phyzxObj->avgVel);
+		} //end for
 
-		//if (objCollide)
-			CheckForCollision(index, phyzxObj, mIndex);
+		phyzxObj->chunkSums[5*chunk] = velSum.x;
+		phyzxObj->chunkSums[5*chunk + 1] = velSum.y;
+		phyzxObj->chunkSums[5*chunk + 2] = velSum.z;
+		phyzxObj->chunkSums[5*chunk + 3] = integrateTime;
+		phyzxObj->chunkSums[5*chunk + 4] = wallTime;
 	} //end for
-
-	pMULTIPLY(phyzxObj->avgVel, 1.0 / phyzxObj->model->numvertices, phyzxObj->avgVel);
-
-	delete[] R.data;
-	delete[] matTemp.data;
-} //end ModEuler()
+} //end ModEulerChunks()
 
 /* Function: SphereCollisionDetection
  * Description: Check for model-model collisions
@@ -580,403 +804,893 @@ int SphereCollisionDetection(point p1, point p2, double r1, double r2)
 }
 
 /* Function: boundSphereToWallCollisionDetection
- * Description: Check for model-model collisions
+ * Description: Check for model-wall collisions
  * Input: *cur - Model information
+ *		  *arena - planes and boxes of the world
  * Output: collided 1(true) / 0(false)
  */
-int boundSphereToWallCollisionDetection(pModel *cur)
+int boundSphereToWallCollisionDetection(pModel *cur, collisionWorld *arena)
 {
-	if (cur->cModel.x + cur->radius >= WALLDIST || cur->cModel.x - cur->radius <= -WALLDIST)
-		return 1;
-	if (cur->cModel.y + cur->radius >= WALLDIST || cur->cModel.y - cur->radius <= -WALLDIST)
-		return 1;
-	if (cur->cModel.z + cur->radius >= WALLDIST || cur->cModel.z - cur->radius <= -WALLDIST)
-		return 1;
-	return 0;
+	return arena->SphereTouches(cur->cModel, cur->radius) ? 1 : 0;
 } //end boundSphereToWallCollisionDetection
 
 /* Function: SphereCollisionResponse
- * Description: Perform model-model collision response
- * Input: temp - pointer to the current model structure
+ * Description: Perform model-model collision response. Adds to the vertices of the current model that
+ *				went into another model the contact forces of that model, for every pair of touching
+ *				bounding spheres the current model is part of. The pairs come from the broad phase of this
+ *				timestep, in model array order. Only the current model is written.
+ * Input: slot - index of the current model in world->modelArray
+ *		  world - world holding the other models
  * Output: 
  */
-void SphereCollisionResponse(pModel *cur)
+void SphereCollisionResponse(int slot, simWorld *world)
 {
+	pModel *cur = world->modelArray[slot];
 	pModel *temp;
-	int collided = 0;
+	int *partners = world->broad->Partners(slot);
 
-	temp = phyzxModels;
+	for (int i = 0; i < world->broad->NumPartners(slot); i++)
+	{
+		temp = world->modelArray[partners[i]];
+		VertexContactResponse(cur, temp);
+	}
+}
 
-	while(temp->next != NULL)
+/* Function: VertexContactResponse
+ * Description: Penalty forces on the vertices of cur that are inside other. The tree of cur gives its
+ *				vertices inside the box of other, and the tree of other the triangle closest to each of them;
+ *				a vertex is inside when it is behind that triangle. It is pushed out along the normal of the
+ *				triangle, and its velocity towards it is damped. Vertices deeper than CONTACTDEPTH are
+ *				pushed away from the center of other instead, with the force of that depth.
+ *				Only the vertices of cur are written, other receives its forces from its own call.
+ * Input: cur - model receiving the forces
+ *		  other - model touched by cur
+ * Output: void
+ */
+void VertexContactResponse(pModel *cur, pModel *other)
+{
+	phyzx *curObj = cur->pObj, *otherObj = other->pObj;
+	point p, closest, normal, dist, a, b, c, ab, ac, vel, triVel, relVel, force;
+	double bary[3], depth, approach, length, magnitude;
+	int count, index, tri, *v;
+
+	if (curObj->contactStampValue == INT_MAX)
 	{
-		if(cur->mIndex == temp->mIndex)
-		{
-			temp = temp->next;
+		memset( (void*)curObj->contactStamp, 0, (curObj->numVertices + 1) * sizeof(int));
+		curObj->contactStampValue = 0;
+	}
+	curObj->contactStampValue++;
+
+	// A vertex inside other is inside its box
+	count = curObj->tree->Candidates(curObj->position, otherObj->tree, 0.0,
+		curObj->contactStamp, curObj->contactStampValue, curObj->contactList);
+
+	for (int i = 0; i < count; i++)
+	{
+		index = curObj->contactList[i];
+		p = soaGet(curObj->position, index);
+
+		// Outside of the bounding sphere of other
+		pDIFFERENCE(p, other->cModel, dist);
+		if (dotProd(dist, dist) > other->radius * other->radius)
 			continue;
-		}
 
-		if(collided = SphereCollisionDetection(cur->cModel, temp->cModel, cur->radius, temp->radius))
+		tri = otherObj->tree->ClosestTriangle(otherObj->position, p, 2.0 * other->radius, &closest, bary);
+		if (tri < 0)
+			continue;
+
+		v = &otherObj->tree->triangles[3*tri];
+		a = soaGet(otherObj->position, v[0]);
+		b = soaGet(otherObj->position, v[1]);
+		c = soaGet(otherObj->position, v[2]);
+		pDIFFERENCE(b, a, ab);
+		pDIFFERENCE(c, a, ac);
+		CROSSPRODUCTp(ab, ac, normal);
+		length = sqrt(dotProd(normal, normal));
+		if (length == 0.0)
+			continue;
+		pMULTIPLY(normal, 1.0 / length, normal);
+
+		// Outside of other
+		pDIFFERENCE(p, closest, dist);
+		if (dotProd(dist, normal) >= 0.0)
+			continue;
+		depth = sqrt(dotProd(dist, dist));
+		if (depth > CONTACTDEPTH)
 		{
-			objCollide = true;
-			PenaltyPushBack(cur, temp);
-		}
-		else
-			objCollide = false;
+			// Too deep for the closest triangle to show the way out, push away from the center of other
+			depth = CONTACTDEPTH;
+			pDIFFERENCE(cur->cModel, other->cModel, normal);
+			length = sqrt(dotProd(normal, normal));
+			if (length == 0.0)
+				continue;
+			pMULTIPLY(normal, 1.0 / length, normal);
+		} //end if
 
-		temp = temp->next;
-	}
+		// Velocity of the vertex relative to the touched point of the triangle
+		vel = soaGet(curObj->velocity, index);
+		triVel.x = bary[0] * otherObj->velocity.x[v[0]] + bary[1] * otherObj->velocity.x[v[1]] + bary[2] * otherObj->velocity.x[v[2]];
+		triVel.y = bary[0] * otherObj->velocity.y[v[0]] + bary[1] * otherObj->velocity.y[v[1]] + bary[2] * otherObj->velocity.y[v[2]];
+		triVel.z = bary[0] * otherObj->velocity.z[v[0]] + bary[1] * otherObj->velocity.z[v[1]] + bary[2] * otherObj->velocity.z[v[2]];
+		pDIFFERENCE(vel, triVel, relVel);
+		approach = dotProd(relVel, normal);
+
+		// Spring on the depth and damper on the approaching velocity, never pulling in
+		magnitude = curObj->kContact * depth / curObj->h - curObj->dContact * approach;
+		if (magnitude <= 0.0)
+			continue;
+		pMULTIPLY(normal, magnitude * curObj->mass[index] / curObj->h, force);
+
+		// Add the forces to the collided vertex
+		curObj->extForce.x[index] += force.x;
+		curObj->extForce.y[index] += force.y;
+		curObj->extForce.z[index] += force.z;
+	} //end for
 }
 
 
 /* Function: computeHooksForce
- * Description: Compute Hook's Law in 3D
+ * Description: Compute Hook's Law in 3D. The spring of a wall is anchored behind it, so its length is
+ *				the depth of the vertex below the wall plus WALLPRELOAD. This is the length the walls of the
+ *				box always had (the distance pNORMALIZE gave from the vertex to a point one unit behind the
+ *				center of the box), which kWall is tuned for.
  * Input: index - index of the vertex which collided 
- *		  wallP - point on the wall where the vertex is colliding
+ *		  normal - unit normal of the wall, towards the free side
+ *		  length - length of the spring
  * Output: Computed hooks force 
  */
-point computeHooksForce(int index, point B, phyzx *phyzxObj)
+point computeHooksForce(int index, point normal, double length, phyzx *phyzxObj)
 {
-	
-	point L, unitV;
-	double mag = 0;
-	double restLength = 0, length;
-	point hooksForce, A;
-	
-	memset( (void*)&L, 0, sizeof(L));
-	memset( (void*)&unitV, 0, sizeof(unitV));
-	memset( (void*)&hooksForce, 0, sizeof(hooksForce));
-	memset( (void*)&A, 0, sizeof(A));
-
-	A = vMake(phyzxObj->model->vertices[3*index], phyzxObj->model->vertices[3*index + 1], phyzxObj->model->vertices[3*index + 2]);
-	pDIFFERENCE(A, B, L);
-	pCPY(L, unitV);
-	pNORMALIZE(unitV);
-	//xxx
-	/*length = A.y - B.y;
-	unitV.x = 0;
-	unitV.y = 1;
-	unitV.z = 0;*/
-	pMULTIPLY(unitV, -(phyzxObj->kWall) * length * phyzxObj->mass[index], hooksForce);
-	//pMULTIPLY(unitV, -(phyzxObj->kWall) * length, hooksForce);
+	point hooksForce;
+
+	pMULTIPLY(normal, phyzxObj->kWall * length * phyzxObj->mass[index], hooksForce);
 
 	return hooksForce;
 }
 
 
 /* Function: computeDampingForce
- * Description: Compute Damping in 3D
+ * Description: Compute Damping in 3D, against the velocity of the vertex
  * Input: index - index of the vertex which collided 
- *		  wallP - point on the wall where the vertex is colliding
  * Output: Computed damping force 
  */
-point computeDampingForce(int index, point B, phyzx *phyzxObj)
+point computeDampingForce(int index, phyzx *phyzxObj)
 {
-	point L, unitV, vDiff, zero;
-	double mag = 0, length;
-	double dot = 0;
-	point dampingForce, A;
-	point v1, v2;	// to store the velocities of both the points connected to the spring
-	
-	memset( (void*)&L, 0, sizeof(L));
-	memset( (void*)&unitV, 0, sizeof(unitV));
-	memset( (void*)&vDiff, 0, sizeof(vDiff));
-	memset( (void*)&dampingForce, 0, sizeof(dampingForce));
-	memset( (void*)&v1, 0, sizeof(v1));
-	memset( (void*)&v2, 0, sizeof(v2));
-	memset( (void*)&A, 0, sizeof(A));
-		
-/*	A.x = phyzxObj->model->vertices[3*index];
-	A.y = phyzxObj->model->vertices[3*index + 1];
-	A.z = phyzxObj->model->vertices[3*index + 2];
+	point dampingForce, vel;
 
-	L.x = A.x - B.x;
-	L.y = A.y - B.y;
-	L.z = A.z - B.z;
+	vel = soaGet(phyzxObj->velocity, index);
+
+	dampingForce.x = (-phyzxObj->dWall) * ( phyzxObj->mass[index] ) * (vel.x);
+	dampingForce.y = (-phyzxObj->dWall) * ( phyzxObj->mass[index] ) * (vel.y);
+	dampingForce.z = (-phyzxObj->dWall) * ( phyzxObj->mass[index] ) * (vel.z);
 
-	// Magnitude
-	mag = sqrt((L.x * L.x) + (L.y * L.y) + (L.z * L.z));*/
-	
-	unitV.x = phyzxObj->velocity[index].x;
-	unitV.y = phyzxObj->velocity[index].y;
-	unitV.z = phyzxObj->velocity[index].z;
-
-//	pNORMALIZE(unitV);
-
-	// Difference in velocities
-
-/*	v1.x = phyzxObj->velocity[index].x;
-	v1.y = phyzxObj->velocity[index].y;
-	v1.z = phyzxObj->velocity[index].z;*/
-
-	// vDiff Dot L
-	dot = (v1.x * L.x) + (v1.y * L.y) + (v1.z * L.z);
-/*
-	dampingForce.x = (-phyzxObj->dWall) * ( dot / mag ) * ( phyzxObj->mass[index] ) * (unitV.x);
-	dampingForce.y = (-phyzxObj->dWall) * ( dot / mag ) * ( phyzxObj->mass[index] ) * (unitV.y);
-	dampingForce.z = (-phyzxObj->dWall) * ( dot / mag ) * ( phyzxObj->mass[index] ) * (unitV.z);*/
-
-	/*dampingForce.x = (-phyzxObj->dWall) * ( dot / mag ) * (unitV.x);
-	dampingForce.y = (-phyzxObj->dWall) * ( dot / mag ) * (unitV.y);
-	dampingForce.z = (-phyzxObj->dWall) * ( dot / mag ) * (unitV.z);*/
-
-	dampingForce.x = (-phyzxObj->dWall) * ( phyzxObj->mass[index] ) * (unitV.x);
-	dampingForce.y = (-phyzxObj->dWall) * ( phyzxObj->mass[index] ) * (unitV.y);
-	dampingForce.z = (-phyzxObj->dWall) * ( phyzxObj->mass[index] ) * (unitV.z);
-/*
-	zero = vMake(0.0);
-	A = vMake(phyzxObj->model->vertices[3*index], phyzxObj->model->vertices[3*index + 1], phyzxObj->model->vertices[3*index + 2]);
-	pDIFFERENCE(A, B, L);
-	pCPY(L, unitV);
-	pNORMALIZE(unitV);
-	pDIFFERENCE(phyzxObj->velocity[index], zero, v1);
-	dot = dotProd(v1, L);
-	pMULTIPLY(unitV, -(phyzxObj->dWall) * (dot/length), dampingForce);
-*/	
 	return dampingForce;
 }	
 
-/* Function: penaltyForce
- * Description: Computes the penalty force between two points.
- * Input: p - Coordinates of first point
- *        pV - Velocity of first point
- *        I - Intersection point
- *        V - Velocity of Intersection point
- *        kH - K value for Hook's Law
- *        kD - K value for damping force
- * Output: Penalty force vector
- */
-point penaltyForce(point p, point pV, point I, point V, double kH, double kD)
-{
-	double mag, length, dot;
-	point dist, hForce, dForce, pVel, vDiff, pForce;
-
-	// Initialize force computation variables
-	pDIFFERENCE(p, I, dist);
-	pDIFFERENCE(pV, V, vDiff);
-	dot = dotProd(vDiff, dist);
-
-	// Compute Hooks Force
-	pNORMALIZE(dist);
-	pMULTIPLY(dist, -(kH * length), hForce);
-
-	// Compute Damping Forces
-	mag = length;
-	pNORMALIZE(pV);
-	pMULTIPLY(pV, (kD * (dot/length)), dForce);
+/* Function: PenaltyPushBack
+ * Description: Responds to the collision that is detected and performs penalty method
+ * Input: index - index of the vertex which collided 
+ *		  normal - unit normal of the wall, towards the free side
+ *		  length - length of the spring of the wall
+ * Output: void
+ */
+void PenaltyPushBack(int index, point normal, double length, phyzx *phyzxObj)
+{
+	point hooksF, dampF;
+
+	hooksF = computeHooksForce(index, normal, length, phyzxObj);
+	dampF = computeDampingForce(index, phyzxObj);
 	
-	// Compute Penalty Force
-	pSUM(hForce, dForce, pForce);
+	// Add the forces to the collided vertex
+	phyzxObj->extForce.x[index] += hooksF.x + dampF.x;
+	phyzxObj->extForce.y[index] += hooksF.y + dampF.y;
+	phyzxObj->extForce.z[index] += hooksF.z + dampF.z;
+}
 
-	return pForce;
-} //end penaltyForce
 
-/* Function: PenaltyPushBack
- * Description: Responds to the collision that is detected and performs penalty method for model spheres
- * Input: cur - current model structure
- *		  p2 - center of the other model
- *		  r1 - radius of the other model
+/* Function: GatherContacts
+ * Description: Fills the contact parameters of a range of vertices of a model: the planes and boxes of
+ *				the collision world that the bounding box of their positions reaches, and the wall
+ *				response of the model
+ * Input: lo, hi - corners of the bounding box of the vertices
+ *		  world - world holding the collision world
+ * Output: contacts - contact parameters, without frozen vertices
+ */
+void GatherContacts(phyzx *phyzxObj, const double lo[3], const double hi[3], simWorld *world, simdContactParams *contacts)
+{
+	world->arena->Gather(lo, hi, contacts);
+	contacts->gravity = world->gravity;
+	contacts->kWall = phyzxObj->kWall;
+	contacts->dWall = phyzxObj->dWall;
+	contacts->mass = phyzxObj->mass;
+	contacts->x = phyzxObj->position.x;
+	contacts->y = phyzxObj->position.y;
+	contacts->z = phyzxObj->position.z;
+	contacts->vx = phyzxObj->velocity.x;
+	contacts->vy = phyzxObj->velocity.y;
+	contacts->vz = phyzxObj->velocity.z;
+	contacts->fx = phyzxObj->extForce.x;
+	contacts->fy = phyzxObj->extForce.y;
+	contacts->fz = phyzxObj->extForce.z;
+	contacts->frozen = NULL;
+} //end GatherContacts
+
+
+/* Function: CheckForCollision
+ * Description: Checks for collision with the planes and boxes of the collision world and invokes penalty
+ *				method for collision response
+ * Input: index - index of the vertex whose collision status is to be determined
+ *		  contacts - planes and boxes the vertex may touch, from GatherContacts
  * Output: void
  */
-void PenaltyPushBack(pModel *cur, pModel *next)
+void CheckForCollision(int index, phyzx *phyzxObj, const simdContactParams *contacts)
 {
-	point distCI, distIC, inter, velDir, cVel;
-	double length;
+	point vertex, normal;
+	double dot, length;
+
+	// Store vertex position
+	vertex = soaGet(phyzxObj->position, index);
 
-	pDIFFERENCE(cur->cModel, next->cModel, inter);
-	pNORMALIZE(inter);
-	pCPY(next->pObj->avgVel, velDir);
-	pNORMALIZE(velDir);
-	pCPY(cur->pObj->avgVel, cVel);
-	pNORMALIZE(cVel);
+	phyzxObj->extForce.x[index]  = 0.0;
+	phyzxObj->extForce.y[index]  = contacts->gravity;
+	phyzxObj->extForce.z[index]  = 0.0;
 
-	pMULTIPLY(inter, next->radius, inter);
-	
-	for (unsigned int index = STARTFROM; index <= cur->pObj->model->numvertices; index++)
+	// A vertex on a plane already touches it
+	for (int i = 0; i < contacts->numPlanes; i++)
 	{
-		point cP = vMake(cur->pObj->model->vertices[3*index], cur->pObj->model->vertices[3*index + 1], cur->pObj->model->vertices[3*index + 2]);
-		length = vecLeng(cP, inter);
-		point pForce = penaltyForce(cP, cur->pObj->velocity[index], inter, velDir, cur->pObj->kSphere, cur->pObj->dSphere);
+		dot = contacts->nx[i] * vertex.x + contacts->ny[i] * vertex.y + contacts->nz[i] * vertex.z;
+		if (dot <= contacts->offset[i])
+		{
+			normal.x = contacts->nx[i];
+			normal.y = contacts->ny[i];
+			normal.z = contacts->nz[i];
+			PenaltyPushBack(index, normal, contacts->anchor[i] - dot, phyzxObj);
+		} //end if
+	} //end for
 
-		// Add the forces to the collided vertex
-		pMULTIPLY(pForce, (1.0 / (length * length)) * cur->pObj->mass[index], pForce);
-		pSUM(cur->pObj->extForce[index] , pForce, cur->pObj->extForce[index]);
+	for (int i = 0; i < contacts->numBoxes; i++)
+		if (collisionWorld::BoxContact(&contacts->boxes[i], contacts->preload, vertex, &normal, &length))
+			PenaltyPushBack(index, normal, length, phyzxObj);
+}
 
-		point nP = vMake(next->pObj->model->vertices[3*index], next->pObj->model->vertices[3*index + 1], next->pObj->model->vertices[3*index + 2]);
-		length = vecLeng(nP, inter);
-		point nForce = penaltyForce(nP, next->pObj->velocity[index], inter, cVel, next->pObj->kSphere, next->pObj->dSphere);
 
-		// Add the forces to the collided vertex
-		pMULTIPLY(nForce, -(1.0 / (length * length)) * next->pObj->mass[index], nForce);
-		pSUM(next->pObj->extForce[index], nForce, next->pObj->extForce[index]);
+/* Function: CallPerFrame
+ * Description: All the computations are performed for the new frame to obtain the new goal position.
+ *				Every model is first stepped on its own, then the broad phase lists the pairs of touching
+ *				bounding spheres once, and every model gathers the forces of its pairs. The models of one
+ *				vertex range are stepped in parallel with each other on the world thread pool; the larger
+ *				ones are stepped after them one at a time, each with its vertex ranges spread over the
+ *				whole pool (see ChunkParallel). Both phases only write to the model they work on, so the
+ *				result does not depend on the thread count.
+ *				Sleeping models are skipped by both phases, but stay in the broad phase so that a moving
+ *				model touching them wakes them up.
+ * Input: world - world holding the models to be stepped
+ * Output: None
+ */
+void CallPerFrame(simWorld *world)
+{
+	phaseTimer stepTimer(world->profiler, NULL, PHASE_STEP);
+
+	world->CollectModels();
+
+	// Per-model phase
+	world->pool->parallelFor(world->numModels, 1, StepModels, world);
+	for (int i = 0; i < world->numModels; i++)
+		if (ChunkParallel(world->modelArray[i], world))
+			StepAwakeModel(world->modelArray[i], world);
+
+	// Model-model contact phase, on the pairs found by the broad phase
+	{
+		phaseTimer broadTimer(world->profiler, NULL, PHASE_BROAD);
+		world->broad->Update(world->modelArray, world->numModels, world->modelsChanged);
+		WakeTouchedModels(world);
 	}
+	world->pool->parallelFor(world->numModels, 1, RespondModels, world);
+
+	world->objCollide = (world->broad->numPairs > 0);
+	world->time += world->h;
 }
 
-/* Function: PenaltyPushBack
- * Description: Responds to the collision that is detected and performs penalty method
- * Input: index - index of the vertex which collided 
- *		  wallP - point on the wall where the vertex is colliding
- * Output: void
+
+/* Function: ChunkParallel
+ * Description: Tells whether a model is stepped on its own with its vertex ranges spread over the thread
+ *				pool, instead of in parallel with the other models. A vertex loop started from inside the
+ *				parallel loop over the models would run its ranges one after the other on one thread.
+ * Input: temp - model
+ *		  world - world holding the model
+ * Output: true if the pool has several threads and the model more than one vertex range
  */
-void PenaltyPushBack(int index, point wallP, phyzx *phyzxObj)
+bool ChunkParallel(pModel *temp, simWorld *world)
 {
-	GLMnode *node;
-	point hooksF, dampF, temp;
-	
-	memset( (void*)&hooksF, 0, sizeof(hooksF));
-	memset( (void*)&dampF, 0, sizeof(dampF));
+	return world->pool->NumThreads() > 1 && VertexChunks(temp->pObj->numVertices) > 1;
+}
 
-	hooksF = computeHooksForce(index, wallP, phyzxObj);
-	dampF = computeDampingForce(index, wallP, phyzxObj);
-	
-	// Add the forces to the collided vertex
-	phyzxObj->extForce[index].x += hooksF.x + dampF.x;
-	phyzxObj->extForce[index].y += hooksF.y + dampF.y;
-	phyzxObj->extForce[index].z += hooksF.z + dampF.z;
+
+/* Function: StepModels
+ * Description: Thread pool task stepping the models [begin, end) of world->modelArray, except the ones
+ *				CallPerFrame steps afterwards with ChunkParallel
+ * Input: context - the simWorld
+ * Output: None
+ */
+void StepModels(void *context, int begin, int end)
+{
+	simWorld *world = (simWorld *)context;
+
+	for (int i = begin; i < end; i++)
+		if (!ChunkParallel(world->modelArray[i], world))
+			StepAwakeModel(world->modelArray[i], world);
 }
 
 
-/* Function: CheckForCollision
- * Description: Checks for collision with the walls and invokes penalty method for collision response
- * Input: index - index of the vertex whose collision status is to be determined
- * Output: void
+/* Function: StepAwakeModel
+ * Description: Steps a model unless it sleeps, and updates its sleep state
+ * Input: temp - model
+ *		  world - world holding the model
+ * Output: None
  */
-void CheckForCollision(int index, phyzx *phyzxObj, int mIndex)
+void StepAwakeModel(pModel *temp, simWorld *world)
 {
+	// The user dragging a model wakes it up
+	if (temp->mIndex == world->dragModel)
+		WakeModel(temp->pObj);
 
-	point wallP, vertex, extPos, curPos, uForce;
+	if (!temp->pObj->sleeping)
+	{
+		StepModel(temp, world);
+		UpdateSleep(temp, world);
+	} //end if
+}
 
-	// Store vertex position
-	vertex.x = phyzxObj->model->vertices[3*index];
-	vertex.y = phyzxObj->model->vertices[3*index + 1];
-	vertex.z = phyzxObj->model->vertices[3*index + 2];
-
-	memset( (void*)&wallP, 0, sizeof(wallP));
-    
-	phyzxObj->extForce[index].x  = 0.0;
-	phyzxObj->extForce[index].y  = gGravity;
-	phyzxObj->extForce[index].z  = 0.0;
-
-
-	if(vertex.x > WALLDIST)
-	{	// collision with right face
-		// RIGHT -> (2, y, z)
-		wallP.x = -1.0;
-		wallP.y = vertex.y;
-		wallP.z = vertex.z;
-		
-		PenaltyPushBack(index, wallP, phyzxObj);
-		memset( (void*)&wallP, 0, sizeof(wallP));
-	}
 
-	if(vertex.x < -WALLDIST)
-	{	// collision with left face
-		// LEFT -> (-2, y, z)
-		wallP.x = 1.0;
-		wallP.y = vertex.y;
-		wallP.z = vertex.z;
-		
-		PenaltyPushBack(index, wallP, phyzxObj);
-		memset( (void*)&wallP, 0, sizeof(wallP));
-	}
+/* Function: RespondModels
+ * Description: Thread pool task running the model-model collision response of the models [begin, end)
+ * Input: context - the simWorld
+ * Output: None
+ */
+void RespondModels(void *context, int begin, int end)
+{
+	simWorld *world = (simWorld *)context;
 
-	if(vertex.y > WALLDIST)
-	{	// collision with top face
-		// TOP -> (x, 2, z)
-		wallP.x = vertex.x;
-		wallP.y = -1.0;
-		wallP.z = vertex.z;
-		
-		PenaltyPushBack(index, wallP, phyzxObj);
-		memset( (void*)&wallP, 0, sizeof(wallP));
-	}
+	for (int i = begin; i < end; i++)
+		if (!world->modelArray[i]->pObj->sleeping)
+		{
+			phaseTimer timer(world->profiler, &world->modelArray[i]->pObj->timing, PHASE_SPHERE);
+			SphereCollisionResponse(i, world);
+		} //end if
+}
 
-	if(vertex.y <= -WALLDIST)
-	{	// collision with bottom face
-		// BOTTOM -> (x, -2, z)
-		wallP.x = vertex.x;
-		wallP.y = 1.0;
-		wallP.z = vertex.z;
-		
-		PenaltyPushBack(index, wallP, phyzxObj);
-		//phyzxObj->extForce[index] = vMake(0.0);
-		memset( (void*)&wallP, 0, sizeof(wallP));
-	}
 
-	if(vertex.z > WALLDIST)
-	{	// collision with back face
-		// BACK -> (x, y, 2)
-		wallP.x = vertex.x;
-		wallP.y = vertex.y;
-		wallP.z = -1.0;
-		
-		PenaltyPushBack(index, wallP, phyzxObj);
-		memset( (void*)&wallP, 0, sizeof(wallP));
-	}
+/* Function: UpdateSleep
+ * Description: Puts a model to sleep once it has been at rest for world->sleepSteps timesteps.
+ *				The model is at rest while its average velocity stays under world->sleepVel, and it
+ *				falls asleep when, at the end of such a window, no vertex has moved faster than
+ *				world->sleepVel on average over the window. The vertices touching a wall or another
+ *				model keep bouncing on their penalty forces at a higher speed at every timestep, so
+ *				their velocity is only looked at over the whole window.
+ * Input: temp - model that was just stepped
+ *		  world - world holding the sleep parameters
+ * Output: None
+ */
+void UpdateSleep(pModel *temp, simWorld *world)
+{
+	phyzx *phyzxObj = temp->pObj;
+	const double *x = phyzxObj->position.x, *y = phyzxObj->position.y, *z = phyzxObj->position.z;
+	const double *x0 = phyzxObj->restStart.x, *y0 = phyzxObj->restStart.y, *z0 = phyzxObj->restStart.z;
+	double maxDist, dist2, maxDist2 = 0.0;
 
-	if(vertex.z < -WALLDIST)
-	{	// collision with front face
-		// FRONT -> (x, y, -2)
-		wallP.x = vertex.x;
-		wallP.y = vertex.y;
-		wallP.z = 1.0;
-		
-		PenaltyPushBack(index, wallP, phyzxObj);
-		memset( (void*)&wallP, 0, sizeof(wallP));
-	}
+	if (world->sleepSteps <= 0 || IsMoving(temp, world))
+	{
+		phyzxObj->restSteps = 0;
+		return;
+	} //end if
+
+	if (phyzxObj->restSteps > 0 && phyzxObj->restSteps < world->sleepSteps)
+	{
+		phyzxObj->restSteps++;
+		return;
+	} //end if
+
+	if (phyzxObj->restSteps > 0)
+	{
+		// End of the window: largest distance of a vertex from where it started
+		for (int index = 0; index < phyzxObj->numVertices; index++)
+		{
+			dist2 = (x[index] - x0[index]) * (x[index] - x0[index]) + (y[index] - y0[index]) * (y[index] - y0[index]) + (z[index] - z0[index]) * (z[index] - z0[index]);
+			if (dist2 > maxDist2)
+				maxDist2 = dist2;
+		}
+
+		maxDist = world->sleepVel * world->sleepSteps * phyzxObj->h;
+		if (maxDist2 <= maxDist * maxDist)
+		{
+			phyzxObj->sleeping = true;
+			phyzxObj->restSteps = 0;
+			return;
+		} //end if
+	} //end if
+
+	// Start a new window from the current positions
+	memcpy( (void*)x0, x, phyzxObj->numVertices * sizeof(double));
+	memcpy( (void*)y0, y, phyzxObj->numVertices * sizeof(double));
+	memcpy( (void*)z0, z, phyzxObj->numVertices * sizeof(double));
+	phyzxObj->restSteps = 1;
 }
 
 
-/* Function: CallPerFrame
- * Description: All the computations are performed for the new frame to obtain the new goal position
- * Input: None
+/* Function: IsMoving
+ * Description: Tells whether the average velocity of an awake model is over world->sleepVel
+ * Input: temp - model to be tested
+ *		  world - world holding the sleep parameters
+ * Output: true if the model is awake and moving
+ */
+bool IsMoving(pModel *temp, simWorld *world)
+{
+	point avgVel = temp->pObj->avgVel;
+
+	if (temp->pObj->sleeping)
+		return false;
+	return (avgVel.x * avgVel.x + avgVel.y * avgVel.y + avgVel.z * avgVel.z >= world->sleepVel * world->sleepVel);
+}
+
+
+/* Function: WakeModel
+ * Description: Wakes a model up, it is stepped again from the next timestep on
+ * Input: phyzxObj - model to be woken up
  * Output: None
  */
-void CallPerFrame()
+void WakeModel(phyzx *phyzxObj)
 {
-	pModel *temp;
+	phyzxObj->sleeping = false;
+	phyzxObj->restSteps = 0;
+}
+
+
+/* Function: WakeTouchedModels
+ * Description: Wakes the sleeping models touched by a moving model, from the pairs of the broad phase.
+ *				A model woken here is not moving yet, so it does not wake its own partners in the same
+ *				timestep and the result does not depend on the order of the pairs. Two models resting
+ *				against each other do not wake each other up.
+ * Input: world - world holding the models and the broad phase
+ * Output: None
+ */
+void WakeTouchedModels(simWorld *world)
+{
+	pModel *first, *second;
+
+	for (int i = 0; i < world->broad->numPairs; i++)
+	{
+		first = world->modelArray[world->broad->pairs[2*i]];
+		second = world->modelArray[world->broad->pairs[2*i + 1]];
+
+		if (first->pObj->sleeping && IsMoving(second, world))
+			WakeModel(first->pObj);
+		else if (second->pObj->sleeping && IsMoving(first, world))
+			WakeModel(second->pObj);
+	} //end for
+}
+
+
+/* Function: StepModel
+ * Description: Performs one timestep of a single model, without the model-model collisions.
+ *				Only reads and writes the data of this model.
+ * Input: temp - model to be stepped
+ *		  world - world holding the step parameters
+ * Output: None
+ */
+void StepModel(pModel *temp, simWorld *world)
+{
+	phaseProfiler *profiler = world->profiler;
+	phaseRecord **timing = &temp->pObj->timing;
 
-	temp = phyzxModels;
+	if (world->fusedStep)
+	{
+		// Same computations in a reduction pass and an integration pass
+		FusedStep(temp, world);
+		return;
+	} //end if
 
-	while(temp->next != NULL)
+	// Compute the center of mass
 	{
-		// Compute the center of mass
-		CalcCM(1, temp->pObj);
+		phaseTimer timer(profiler, timing, PHASE_CM);
+		CalcCM(1, temp->pObj, world);
+	}
 
-		// Compute the relative positions of the model vertices  from center of mass
-		//CalcRelLoc(1, temp->pObj);
+	// Compute the relative positions of the model vertices  from center of mass
+	//CalcRelLoc(1, temp->pObj);
 
-		// Compute the Rotational matrix using Apq
-		CalcRotMat(temp->pObj);
+	// Compute the Rotational matrix using Apq (CalcRotMat)
+	{
+		phaseTimer timer(profiler, timing, PHASE_APQ);
+		CalcApq(temp->pObj, world);
+	}
+	{
+		phaseTimer timer(profiler, timing, PHASE_ROTATION);
+		ExtractRotation(temp->pObj, world);
+	}
 
+	if (temp->pObj->deformMode == 1 || temp->pObj->deformMode == 2)
+	{
+		phaseTimer timer(profiler, timing, PHASE_DEFORM);
 		if (temp->pObj->deformMode == 1)
 			rigidBody(temp->pObj);  // Rigid Body Deformation
-		else if (temp->pObj->deformMode == 2)
+		else
 			linearDeform(temp->pObj);  // Linear Deformation
+	} //end if
 
-		// Compute the Goal position for the current frame
-/*		if (temp->deformMode == 3)
-			quadDeform(temp->pObj);  // Quadratic Deformation
-		else
-			CalcGoalPos(temp->pObj);*/
+	// Compute the Goal position for the current frame
+/*	if (temp->deformMode == 3)
+		quadDeform(temp->pObj, world);  // Quadratic Deformation
+	else
+		CalcGoalPos(temp->pObj);*/
 
-		// Time step using modified Euler
-		/*if (boundSphereToWallCollisionDetection(temp) == 1)
-			objCollide = true;
-		else
-			objCollide = false;*/
-		ModEuler(temp->pObj, temp->mIndex, temp->pObj->deformMode);
+	// Time step using modified Euler
+	/*if (boundSphereToWallCollisionDetection(temp, world->arena) == 1)
+		objCollide = true;
+	else
+		objCollide = false;*/
+	ModEuler(temp->pObj, temp->mIndex, temp->pObj->deformMode, world);
 
-		// Check for collision and perform the response action upon collision
-		//CollisionDetectionAndResponse(temp);
-		
-		// Compute the center of the model with  the radius of the bounding sphere
-		glmMeshGeometricParameters(temp->pObj->model, &temp->cModel.x, &temp->cModel.y, &temp->cModel.z, &temp->radius);
+	// Check for collision and perform the response action upon collision
+	//CollisionDetectionAndResponse(temp);
+	
+	// Compute the center of the model with  the radius of the bounding sphere
+	phaseTimer timer(profiler, timing, PHASE_BOUNDS);
+	CalcBoundSphere(temp->pObj, &temp->cModel, &temp->radius);
+
+	// Bounding volumes of the triangles for the model-model contacts
+	temp->pObj->tree->Refit(temp->pObj->position);
+}
+
+
+/* Function: FusedStep
+ * Description: Performs one timestep of a model like CallPerFrame does, with two passes over the vertices.
+ *				The first pass accumulates the center of mass together with Apq (and TApq for quadratic
+ *				deformation) using Apq = Summation(m * x * qT) - xcm * Summation(m * qT).
+ *				The second pass computes the goal positions, integrates, responds to the walls and sums
+ *				the center of the bounding sphere, one chunk of FUSEDCHUNK vertices at a time so the
+ *				wall response reads vertices that are still in cache. relDeformedLoc and goal are not stored.
+ *				The bounding sphere and the triangle tree are then updated from the new positions.
+ *				The per-vertex work is done by the kernels of world->simdLevel; the center of mass is
+ *				timed with Apq, in PHASE_APQ.
+ * Input: cur - model to be stepped
+ *		  world - world holding the models and the step parameters
+ * Output: None
+ */
+void FusedStep(pModel *cur, simWorld *world)
+{
+	phyzx *phyzxObj = cur->pObj;
+	const simdKernels *kernels = simdGetKernels(world->simdLevel);
+	const int numVertices = phyzxObj->numVertices;
+	const int cols = (phyzxObj->deformMode == 3) ? 9 : 3;
+	double sums[30], sum[3][9], center[3];
+	simdStepParams params;
+	vertexTask work;
+	point cm;
+	matrix39 R;
+
+	memset( (void*)&work, 0, sizeof(work));
+	work.phyzxObj = phyzxObj;
+	work.cur = cur;
+	work.world = world;
+	work.kernels = kernels;
+	work.params = &params;
+	work.cols = cols;
+
+	// Pass 1: center of mass and Apq
+	{
+		phaseTimer timer(world->profiler, &phyzxObj->timing, PHASE_APQ);
+		work.stride = 30;
+		ForEachVertexChunk(&work, FusedReduceChunks);
+		CombineChunks(phyzxObj, 30, sums);
+		memcpy( (void*)sum, sums + 3, sizeof(sum));
+	}
 
-		// Compute the radius of the best bounding sphere around the model
-		glmMeshRadius(temp->pObj->model,  temp->cModel.x, temp->cModel.y, temp->cModel.z, &temp->radius);
+	cm.x = sums[0] / phyzxObj->totalMass;
+	cm.y = sums[1] / phyzxObj->totalMass;
+	cm.z = sums[2] / phyzxObj->totalMass;
+	phyzxObj->cmDeformed = cm;
 
-		SphereCollisionResponse(temp);
+	for (int col = 0; col < 3; col++)
+	{
+		phyzxObj->Apq[0][col] = sum[0][col] - cm.x * phyzxObj->mqStable[col];
+		phyzxObj->Apq[1][col] = sum[1][col] - cm.y * phyzxObj->mqStable[col];
+		phyzxObj->Apq[2][col] = sum[2][col] - cm.z * phyzxObj->mqStable[col];
+	} //end for
 
-		temp = temp->next;
+	{
+		phaseTimer timer(world->profiler, &phyzxObj->timing, PHASE_ROTATION);
+		ExtractRotation(phyzxObj, world);
 	}
-}
\ No newline at end of file
+
+	memset( (void*)&params, 0, sizeof(params));
+
+	if (phyzxObj->deformMode != 0)
+	{
+		phaseTimer timer(world->profiler, &phyzxObj->timing, PHASE_DEFORM);
+		if (phyzxObj->deformMode == 1)
+			rigidBody(phyzxObj);  // Rigid Body Deformation
+		else if (phyzxObj->deformMode == 2)
+			linearDeform(phyzxObj);  // Linear Deformation
+		else if (phyzxObj->deformMode == 3)
+		{
+			// Quadratic Deformation
+			for (int col = 0; col < 9; col++)
+			{
+				phyzxObj->TApq.data[col] = sum[0][col] - cm.x * phyzxObj->mqStable[col];
+				phyzxObj->TApq.data[9 + col] = sum[1][col] - cm.y * phyzxObj->mqStable[col];
+				phyzxObj->TApq.data[18 + col] = sum[2][col] - cm.z * phyzxObj->mqStable[col];
+			} //end for
+
+			quadBlendRot(&R, phyzxObj);
+			memcpy( (void*)params.G, R.data, sizeof(params.G));
+		} //end if
+	} //end if
+
+	if (cols == 3)
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				params.G[row][col] = phyzxObj->R[row][col];
+
+	params.cols = cols;
+	params.cm[0] = cm.x;
+	params.cm[1] = cm.y;
+	params.cm[2] = cm.z;
+	params.alphaOverH = phyzxObj->alpha / phyzxObj->h;
+	params.h = phyzxObj->h;
+	params.delta = phyzxObj->delta;
+	if (cur->mIndex == world->dragModel)
+	{
+		params.force[0] = world->userForce.x;
+		params.force[1] = world->userForce.y;
+		params.force[2] = world->userForce.z;
+	} //end if
+	params.frozenY = (world->stickyFloor == 1) ? world->arena->floorY : -HUGE_VAL;
+	params.mass = phyzxObj->mass;
+	params.qx = phyzxObj->relStableLoc.x;
+	params.qy = phyzxObj->relStableLoc.y;
+	params.qz = phyzxObj->relStableLoc.z;
+	params.fx = phyzxObj->extForce.x;
+	params.fy = phyzxObj->extForce.y;
+	params.fz = phyzxObj->extForce.z;
+	params.x = phyzxObj->position.x;
+	params.y = phyzxObj->position.y;
+	params.z = phyzxObj->position.z;
+	params.vx = phyzxObj->velocity.x;
+	params.vy = phyzxObj->velocity.y;
+	params.vz = phyzxObj->velocity.z;
+
+	// Pass 2: goal positions, integration and wall response
+	work.stride = 8;
+	ForEachVertexChunk(&work, FusedIntegrateChunks);
+	CombineChunks(phyzxObj, 8, sums);
+	if (world->profiler != NULL)
+	{
+		world->profiler->Add(&phyzxObj->timing, PHASE_INTEGRATE, sums[6]);
+		world->profiler->Add(&phyzxObj->timing, PHASE_WALL, sums[7]);
+	} //end if
+
+	phyzxObj->avgVel.x = sums[0];
+	phyzxObj->avgVel.y = sums[1];
+	phyzxObj->avgVel.z = sums[2];
+	pMULTIPLY(phyzxObj->avgVel, 1.0 / numVertices, phyzxObj->avgVel);
+
+	// Bounding sphere around the new positions
+	phaseTimer boundsTimer(world->profiler, &phyzxObj->timing, PHASE_BOUNDS);
+	center[0] = sums[3] / numVertices;
+	center[1] = sums[4] / numVertices;
+	center[2] = sums[5] / numVertices;
+	cur->cModel.x = center[0];
+	cur->cModel.y = center[1];
+	cur->cModel.z = center[2];
+
+	memcpy( (void*)params.cm, center, sizeof(center));
+	work.stride = 1;
+	ForEachVertexChunk(&work, FusedRadiusChunks);
+
+	// Largest distance of all the chunks, the order does not matter for a maximum
+	sums[0] = 0.0;
+	for (int chunk = 0; chunk < VertexChunks(phyzxObj->numVertices); chunk++)
+		if (phyzxObj->chunkSums[chunk] > sums[0])
+			sums[0] = phyzxObj->chunkSums[chunk];
+	cur->radius = sqrt(sums[0]);
+
+	// Bounding volumes of the triangles for the model-model contacts
+	phyzxObj->tree->Refit(phyzxObj->position);
+} //end FusedStep
+
+/* Function: FusedReduceChunks
+ * Description: First pass of FusedStep over the chunks [begin, end), keeps Summation(m * x) and
+ *				Summation(m * x * qT) of every chunk
+ * Input: context - vertexTask of the model
+ * Output: None
+ */
+void FusedReduceChunks(void *context, int begin, int end)
+{
+	vertexTask *work = (vertexTask *)context;
+	phyzx *phyzxObj = work->phyzxObj;
+	double *sums;
+	int first, last;
+
+	for (int chunk = begin; chunk < end; chunk++)
+	{
+		first = chunk * VERTEXCHUNK;
+		last = (first + VERTEXCHUNK < phyzxObj->numVertices) ? first + VERTEXCHUNK : phyzxObj->numVertices;
+		sums = phyzxObj->chunkSums + chunk * 30;
+
+		// VERTEXCHUNK is a multiple of SOAWIDTH, so every chunk starts on an aligned vertex
+		work->kernels->reduce(phyzxObj->mass + first, phyzxObj->position.x + first, phyzxObj->position.y + first,
+			phyzxObj->position.z + first, phyzxObj->relStableLoc.x + first, phyzxObj->relStableLoc.y + first,
+			phyzxObj->relStableLoc.z + first, last - first, work->cols, sums, (double (*)[9])(sums + 3));
+	} //end for
+} //end FusedReduceChunks
+
+
+/* Function: FusedIntegrateChunks
+ * Description: Second pass of FusedStep over the chunks [begin, end), keeps the velocity sum and
+ *				the position sum of every chunk, and the seconds spent in the integration and in the
+ *				wall response when they are measured
+ * Input: context - vertexTask of the model
+ * Output: None
+ */
+void FusedIntegrateChunks(void *context, int begin, int end)
+{
+	vertexTask *work = (vertexTask *)context;
+	phyzx *phyzxObj = work->phyzxObj;
+	simWorld *world = work->world;
+	const simdStepParams *params = work->params;
+	unsigned char frozen[FUSEDCHUNK];
+	simdContactParams contacts;
+	bool timed = (world->profiler != NULL);
+	double integrateStart = 0.0, wallStart = 0.0;
+	double lo[3], hi[3], x, y, z;
+	double *sums;
+	int first, last;
+
+	memset( (void*)frozen, 0, sizeof(frozen));
+
+	for (int chunk = begin; chunk < end; chunk++)
+	{
+		first = chunk * VERTEXCHUNK;
+		last = (first + VERTEXCHUNK < phyzxObj->numVertices) ? first + VERTEXCHUNK : phyzxObj->numVertices;
+		sums = phyzxObj->chunkSums + chunk * 8;
+
+		for (int from = first; from < last; from += FUSEDCHUNK)
+		{
+			int to = (from + FUSEDCHUNK < last) ? from + FUSEDCHUNK : last;
+
+			if (timed)
+				integrateStart = profileClock();
+
+			// Vertices resting on the floor are neither integrated nor pushed back
+			if (world->stickyFloor == 1)
+				for (int index = from; index < to; index++)
+					frozen[index - from] = (params->y[index] <= params->frozenY);
+
+			work->kernels->integrate(params, from, to, sums);
+
+			if (timed)
+				wallStart = profileClock();
+
+			// Position sums and bounding box of the new positions
+			lo[0] = lo[1] = lo[2] = HUGE_VAL;
+			hi[0] = hi[1] = hi[2] = -HUGE_VAL;
+			for (int index = from; index < to; index++)
+			{
+				x = params->x[index];
+				y = params->y[index];
+				z = params->z[index];
+				sums[3] += x;
+				sums[4] += y;
+				sums[5] += z;
+				lo[0] = (x < lo[0]) ? x : lo[0];
+				lo[1] = (y < lo[1]) ? y : lo[1];
+				lo[2] = (z < lo[2]) ? z : lo[2];
+				hi[0] = (x > hi[0]) ? x : hi[0];
+				hi[1] = (y > hi[1]) ? y : hi[1];
+				hi[2] = (z > hi[2]) ? z : hi[2];
+			} //end for
+
+			// Resets the external force to gravity and adds the wall response
+			GatherContacts(phyzxObj, lo, hi, world, &contacts);
+			contacts.frozen = (world->stickyFloor == 1) ? frozen : NULL;
+			work->kernels->collide(&contacts, from, to);
+
+			if (timed)
+			{
+				sums[6] += wallStart - integrateStart;
+				sums[7] += profileClock() - wallStart;
+			} //end if
+		} //end for
+	} //end for
+} //end FusedIntegrateChunks
+
+
+/* Function: FusedRadiusChunks
+ * Description: Largest squared distance of the vertices of every chunk in [begin, end) from params->cm
+ * Input: context - vertexTask of the model
+ * Output: None
+ */
+void FusedRadiusChunks(void *context, int begin, int end)
+{
+	vertexTask *work = (vertexTask *)context;
+	phyzx *phyzxObj = work->phyzxObj;
+	int first, last;
+
+	for (int chunk = begin; chunk < end; chunk++)
+	{
+		first = chunk * VERTEXCHUNK;
+		last = (first + VERTEXCHUNK < phyzxObj->numVertices) ? first + VERTEXCHUNK : phyzxObj->numVertices;
+		phyzxObj->chunkSums[chunk] = work->kernels->boundRadius2(phyzxObj->position.x + first,
+			phyzxObj->position.y + first, phyzxObj->position.z + first, last - first, work->params->cm);
+	} //end for
+} //end FusedRadiusChunks
+
+
+/* Function: CalcBoundSphere
+ * Description: Computes the center of the model as the mean of its vertices and the radius of
+ *				the bounding sphere around that center, from the simulated positions
+ * Input: center - receives the center of the model
+ *		  radius - receives the radius of the bounding sphere
+ * Output: None
+ */
+void CalcBoundSphere(phyzx *phyzxObj, point *center, double *radius)
+{
+	const double *x = phyzxObj->position.x, *y = phyzxObj->position.y, *z = phyzxObj->position.z;
+	double cx = 0.0, cy = 0.0, cz = 0.0;
+
+	for(int index = 0; index < phyzxObj->numVertices; index++)
+	{
+		cx += x[index];
+		cy += y[index];
+		cz += z[index];
+	}
+	cx /= phyzxObj->numVertices;
+	cy /= phyzxObj->numVertices;
+	cz /= phyzxObj->numVertices;
+
+	center->x = cx;
+	center->y = cy;
+	center->z = cz;
+	CalcBoundRadius(phyzxObj, *center, radius);
+}
+
+
+/* Function: CalcBoundRadius
+ * Description: Computes the radius of the bounding sphere of the model around a given center
+ * Input: center - center of the bounding sphere
+ *		  radius - receives the radius of the bounding sphere
+ * Output: None
+ */
+void CalcBoundRadius(phyzx *phyzxObj, point center, double *radius)
+{
+	const double *x = phyzxObj->position.x, *y = phyzxObj->position.y, *z = phyzxObj->position.z;
+	double radius2 = 0.0, dist2;
+
+	for(int index = 0; index < phyzxObj->numVertices; index++)
+	{
+		dist2 = (center.x - x[index]) * (center.x - x[index]) + (center.y - y[index]) * (center.y - y[index]) + (center.z - z[index]) * (center.z - z[index]);
+		if (dist2 > radius2)
+			radius2 = dist2;
+	}
+
+	*radius = sqrt(radius2);
+}
+
+
+/* Function: WriteRenderPositions
+ * Description: Copies the simulated positions into the model vertices used for drawing, picking and export.
+ *				Only needed once per displayed frame, not per substep.
+ * Input: None
+ * Output: None
+ */
+void WriteRenderPositions(phyzx *phyzxObj)
+{
+	GLfloat *vertices = phyzxObj->model->vertices + 3*STARTFROM;
+
+	for(int index = 0; index < phyzxObj->numVertices; index++)
+	{
+		vertices[3*index] = (GLfloat)phyzxObj->position.x[index];
+		vertices[3*index + 1] = (GLfloat)phyzxObj->position.y[index];
+		vertices[3*index + 2] = (GLfloat)phyzxObj->position.z[index];
+	}
+}
@@ -5,13 +5,33 @@
 #ifndef _PHYSICS_H_
 #define _PHYSICS_H_
 
-#include "render.h"
-#include "matrix.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <iostream>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include "openGL-headers.h"
+#include "glme.h"
+#include "vector.h"
+#include "matrix.h"
+#include "threadPool.h"
+#include "bvh.h"
 
 #define STARTFROM 1
 #define WALLDIST 1.9985
 #define PENETRATE 2.0015
+#define FUSEDCHUNK 256				// vertices integrated at a time by FusedStep before their wall response
+#define VERTEXCHUNK 4096			// vertices per range of the parallel vertex loops, a multiple of SOAWIDTH and FUSEDCHUNK.
+									// Fixed so that the partial sums, and the results, do not depend on the thread count
+#define CONTACTDEPTH 0.02			// Vertices deeper into another model are pushed back as if they were this deep
+#define ROTATION_POLAR 0			// R = Apq x (ApqT x Apq)^-1/2 through an eigen decomposition
+#define ROTATION_ITERATIVE 1		// R by iterations on a quaternion, warm started from the last timestep
+#define ROTATIONITERATIONS 20		// Most iterations of ROTATION_ITERATIVE in one timestep
+
+struct restShape;
+struct phaseRecord;
 
 //6.0     0.006
 class phyzx
@@ -21,40 +41,60 @@ public:
 		int n;						// display every nth timepoint  
 		int deformMode;				// Deformation mode Basic Shapematching / Linear / Rigid / Quadratic
 		GLMmodel *model;			// Model information
-		point *stable;				// Initial vertices position
-		point *goal;				// Final positions of each vertex due to shapematching
+		restShape *shape;			// Rest state shared with the bodies of the same file, which
+									// stable, mass, triAreas, relStableLoc, q and the adjacency point into
+		int numVertices;			// Number of simulated vertices, vertex i of the model is entry i - STARTFROM
+		soaVec position;			// Current vertices position, model->vertices only receives copies for rendering
+		soaVec stable;				// Initial vertices position
+		soaVec goal;				// Final positions of each vertex due to shapematching
 		double *mass;				// Masses of each model vertex
 		double totalMass;			// The total mass of the object model
-		point *velocity;			// Current velocity values of each model vertex
-		point *extForce;			// External force values	
+		soaVec velocity;			// Current velocity values of each model vertex
+		soaVec extForce;			// External force values	
 		double alpha;				// Stiffness [0..1]
 		double beta;				// Linear and Quadratic deformation value
 		double delta;				// Velocity Damping
 		point cmStable;				// Center of mass in stable state
 		point cmDeformed;			// Center of mass in deformed position
-		point *relStableLoc;		// Relative location of each model vertex 
+		soaVec relStableLoc;		// Relative location of each model vertex 
 									// from the Center of mass in stable state
-		point *relDeformedLoc;		// Relative Location of each model vertex
+		soaVec relDeformedLoc;		// Relative Location of each model vertex
 									// from the Center of mass in Deformed state
 		point avgVel;				// velocity of the object model 
+		bool sleeping;				// At rest, not stepped by CallPerFrame until woken
+		int restSteps;				// Timesteps since the start of the current rest window (0 when moving)
+		soaVec restStart;			// Vertices position at the start of the rest window
 		matrix33 Apq;				// 3x3 matrix to store Apq
 		matrix33 Aqq;				// 3x3 matrix to store Aqq
 		matrix33 R;					// 3x3 Rotation matrix 
-		matrix TApq;				// 9x9 matrix
-		matrix TAqq;				// 9x9 matrix
-		matrix *q;					// Relative location of each model vertex for quadratic deformation
-		matrix *qT;					// Relative location of each model vertex transpose
+		double rotQuat[4];			// Rotation extracted from Apq in the last timestep, as a quaternion (w, x, y, z)
+		matrix39 TApq;				// 3x9 matrix
+		matrix99 TAqq;				// 9x9 matrix
+		double mqStable[9];			// Summation(m * q) of the quadratic rest coordinates, used by the fused step
+		matrix91 *q;				// Relative location of each model vertex for quadratic deformation
 		double kWall;				// Hooks law co-efficient
 		double dWall;				// Damping co-efficient
 		double kSphere;				// Hooks co-efficient for models bounding sphere collision
 		double dSphere;				// Damping co-efficient for models bounding sphere collision
+		double kContact;			// Part of the depth of a vertex inside another model removed in one timestep
+		double dContact;			// Part of the velocity of a vertex into another model removed in one timestep
 		double *triAreas;			// Areas of all the triangles in the model
 		double surArea;				// Surface area of the model
 		
-		GLMnode **NBTStruct;		// list of lists having triangles for every vertex of the model
-		GLMnode **NBVStruct;		// list of lists having adjacent vertices of every vertex in the model
+		GLMadjacency *NBTStruct;	// triangles of every vertex of the model
+		GLMadjacency *NBVStruct;	// adjacent vertices of every vertex in the model
+
+		bvh *tree;					// Bounding volumes of the deformed triangles, refitted every timestep
+		int *contactStamp;			// Per vertex, contactStampValue when already tested in the current contact query
+		int contactStampValue;
+		int *contactList;			// Vertices tested in the current contact query
+
+		double *chunkSums;			// Partial sums of the vertex ranges of the current parallel loop
+		int chunkSumsSize;			// Allocated size of chunkSums
 
-		phyzx::phyzx();
+		phaseRecord *timing;		// Last times of the phases of the timesteps, when the world measures them
+
+		phyzx();
 };
 
 struct pModel
@@ -67,41 +107,87 @@ struct pModel
 	double radius;
 	struct pModel *next;
 };
-extern struct pModel *phyzxModels;
+class simWorld;
+struct simdKernels;
+struct simdStepParams;
+struct simdContactParams;
+class collisionWorld;
 
-void phyzxInit(phyzx *phyzxObj);
+// Arguments of the parallel vertex loops of one model
+struct vertexTask
+{
+	phyzx *phyzxObj;
+	pModel *cur;
+	simWorld *world;
+	int toggle;							// CalcCM
+	int mIndex;							// ModEuler
+	int deformMode;						// ModEuler
+	matrix39 *R;						// ModEuler, 3x9 quadratic matrix
+	const simdKernels *kernels;			// FusedStep
+	simdStepParams *params;				// FusedStep
+	int cols;							// FusedStep
+	int stride;							// Number of partial sums of every range in phyzxObj->chunkSums
+};
+
+void phyzxInit(phyzx *phyzxObj, restShape *shape, simWorld *world);
+void phyzxDelete(phyzx *phyzxObj);
 double AreaOfTri(point A, point B, point C);
-void compMass(GLMnode **NBTStruct, phyzx *phyzxObj);
-void filterNBV(GLMmodel *obj, GLMnode **NBVStruct);
-void delNode(GLMnode *current, GLMnode *next);
-GLMnode ** vertexList(GLMmodel *obj, GLMnode **NBTStruct, double radius);
-void CalcCM(int toggle, phyzx *phyzxObj);
+double adjustMass(GLMmodel *model);
+void compMass(GLMadjacency *NBTStruct, phyzx *phyzxObj);
+int VertexChunks(int numVertices);
+double * ChunkSums(phyzx *phyzxObj, int stride);
+void ForEachVertexChunk(vertexTask *work, threadTask task);
+void CombineChunks(phyzx *phyzxObj, int stride, double *result);
+void CalcCM(int toggle, phyzx *phyzxObj, simWorld *world);
+void CalcCMChunks(void *context, int begin, int end);
 void CalcRelLoc(int toggle, phyzx *phyzxObj);
-void CalcApq(phyzx *phyzxObj);
+void CalcApq(phyzx *phyzxObj, simWorld *world);
+void CalcApqChunks(void *context, int begin, int end);
 void CalcAqq(phyzx *phyzxObj);
-void CalcRotMat(phyzx *phyzxObj);
+void CalcRotMat(phyzx *phyzxObj, simWorld *world);
+void ExtractRotation(phyzx *phyzxObj, simWorld *world);
 void CalcGoalPos(phyzx *phyzxObj);
-void ModEuler(phyzx *phyzxObj, int mIndex, int deformMode);
+void ModEuler(phyzx *phyzxObj, int mIndex, int deformMode, simWorld *world);
+void ModEulerChunks(void *context, int begin, int end);
 int SphereCollisionDetection(point p1, point p2, double r1, double r2);
-void SphereCollisionResponse(pModel *cur);
-point computeHooksForce(int index, point B, phyzx *phyzxObj, bool penetrate);
-point computeDampingForce(int index, point B, phyzx *phyzxObj, bool penetrate);
-point penaltyForce(point p, point pV, point I, point V, double kH, double kD);
-void PenaltyPushBack(pModel *cur, pModel *next);
-void PenaltyPushBack(int index, point wallP, phyzx *phyzxObj, bool penetrate);
-//void CheckForCollision(int index, pModel *temp);
-void CheckForCollision(int index, phyzx *phyzxObj, int mIndex);
-void CallPerFrame();
+void SphereCollisionResponse(int slot, simWorld *world);
+int boundSphereToWallCollisionDetection(pModel *cur, collisionWorld *arena);
+point computeHooksForce(int index, point normal, double length, phyzx *phyzxObj);
+point computeDampingForce(int index, phyzx *phyzxObj);
+void VertexContactResponse(pModel *cur, pModel *other);
+bvh * BuildTriangleTree(phyzx *phyzxObj);
+void PenaltyPushBack(int index, point normal, double length, phyzx *phyzxObj);
+void GatherContacts(phyzx *phyzxObj, const double lo[3], const double hi[3], simWorld *world, simdContactParams *contacts);
+void CheckForCollision(int index, phyzx *phyzxObj, const simdContactParams *contacts);
+void CallPerFrame(simWorld *world);
+void UpdateSleep(pModel *temp, simWorld *world);
+bool IsMoving(pModel *temp, simWorld *world);
+void WakeModel(phyzx *phyzxObj);
+void WakeTouchedModels(simWorld *world);
+bool ChunkParallel(pModel *temp, simWorld *world);
+void StepModels(void *context, int begin, int end);
+void StepAwakeModel(pModel *temp, simWorld *world);
+void RespondModels(void *context, int begin, int end);
+void StepModel(pModel *temp, simWorld *world);
+void FusedStep(pModel *cur, simWorld *world);
+void FusedReduceChunks(void *context, int begin, int end);
+void FusedIntegrateChunks(void *context, int begin, int end);
+void FusedRadiusChunks(void *context, int begin, int end);
+void CalcBoundSphere(phyzx *phyzxObj, point *center, double *radius);
+void CalcBoundRadius(phyzx *phyzxObj, point center, double *radius);
+void WriteRenderPositions(phyzx *phyzxObj);
 
-void defaultDeform(phyzx *phyzxObj);
+void defaultDeform(phyzx *phyzxObj, simWorld *world);
 void rigidBody(phyzx *phyzxObj);
 void linearDeform(phyzx *phyzxObj);
-void quadRotMat(matrix *rot, phyzx *phyzxObj);
-void calcQ(point p, matrix *q);
-void calcTAqq(phyzx *phyzxObj);
+void quadRotMat(matrix39 *rot, phyzx *phyzxObj);
+void calcQ(point p, matrix91 *q);
+void calcTApq(phyzx *phyzxObj, simWorld *world);
+void calcTApqChunks(void *context, int begin, int end);
 void calcTAqq(phyzx *phyzxObj);
-void quadDeformRot(matrix *R, phyzx *phyzxObj);
-void quadDeform(phyzx *phyzxObj);
+void quadDeformRot(matrix39 *R, phyzx *phyzxObj, simWorld *world);
+void quadBlendRot(matrix39 *R, phyzx *phyzxObj);
+void quadDeform(phyzx *phyzxObj, simWorld *world);
 
 void reset();
 void resetModel(phyzx *phyzxObj);
@@ -0,0 +1,420 @@
+/* Source: profiler
+ * Description: Rolling times of the phases of a timestep, per body and per thread.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "simulation.h"
+
+#ifdef WIN32
+  #include <windows.h>
+  #define THREADLOCAL __declspec(thread)
+#else
+  #include <time.h>
+  #define THREADLOCAL __thread
+#endif
+
+const char *phaseNames[NUMPHASES] = {"cm", "apq", "rotation", "deform", "integrate", "wall", "bounds", "sphere", "broad", "step"};
+
+// Number of the calling thread in phaseProfiler::threads, -1 until it measures its first phase
+static THREADLOCAL int threadSlot = -1;
+static volatile long numThreadSlots = 0;
+
+// Resets of all the profilers, so that a new profiler does not take the records of an old one for its own
+static unsigned int numResets = 0;
+
+/* Function: profileClock
+ * Description: Monotonic clock of the timers
+ * Input: None
+ * Output: seconds from an arbitrary start
+ */
+double profileClock()
+{
+#ifdef WIN32
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER count;
+
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&count);
+	return (double)count.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + 1e-9 * now.tv_nsec;
+#endif
+}
+
+// Gives the calling thread its number the first time it measures a phase
+static int ThreadSlot()
+{
+	if (threadSlot < 0)
+	{
+#ifdef WIN32
+		threadSlot = InterlockedIncrement(&numThreadSlots) - 1;
+#else
+		threadSlot = __sync_fetch_and_add(&numThreadSlots, 1);
+#endif
+	}
+	return threadSlot;
+}
+
+// Number of threads with totals of their own in phaseProfiler::threads
+static int ThreadCount()
+{
+	return (numThreadSlots < MAXPROFILETHREADS) ? (int)numThreadSlots : MAXPROFILETHREADS;
+}
+
+// Writes a string as a JSON string
+static void WriteJSONString(FILE *file, const char *text)
+{
+	fputc('"', file);
+	for (; *text != '\0'; text++)
+	{
+		if (*text == '"' || *text == '\\')
+			fputc('\\', file);
+		fputc(*text, file);
+	} //end for
+	fputc('"', file);
+}
+
+// Sorts times in increasing order
+static int CompareSeconds(const void *a, const void *b)
+{
+	float x = *(const float *)a, y = *(const float *)b;
+
+	return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+// Constructor
+phaseProfiler::phaseProfiler()
+{
+	worldRecord = NULL;
+	Reset();
+}
+
+// Destructor
+phaseProfiler::~phaseProfiler()
+{
+	free(worldRecord);
+}
+
+/* Function: Add
+ * Description: Keeps the time of a phase in the record of a body, allocating or clearing the record if
+ *				it has none since the last Reset, and adds it to the totals of the calling thread. Only
+ *				the thread stepping a body writes to its record.
+ * Input: record - record of the body (phyzx::timing), NULL for worldRecord
+ *		  phase - PHASE_CM .. PHASE_STEP
+ *		  seconds - time of the phase
+ * Output: None
+ */
+void phaseProfiler::Add(phaseRecord **record, int phase, double seconds)
+{
+	phaseRecord *times;
+	phaseThread *thread;
+	int slot = ThreadSlot();
+
+	if (record == NULL)
+		record = &worldRecord;
+	times = *record;
+
+	if (times == NULL)
+		times = *record = (phaseRecord *)calloc(1, sizeof(phaseRecord));
+	if (times->generation != generation)
+	{
+		memset( (void*)times, 0, sizeof(phaseRecord));
+		times->generation = generation;
+	} //end if
+
+	times->seconds[phase][times->count[phase] % PROFILEWINDOW] = (float)seconds;
+	times->count[phase]++;
+
+	// The threads after MAXPROFILETHREADS share the last totals, which may then miss some times
+	thread = &threads[(slot < MAXPROFILETHREADS) ? slot : MAXPROFILETHREADS - 1];
+	thread->seconds[phase] += seconds;
+	thread->count[phase]++;
+	if (seconds > thread->maxSeconds[phase])
+		thread->maxSeconds[phase] = seconds;
+}
+
+/* Function: Reset
+ * Description: Forgets every time taken so far, the records of the bodies are cleared when they get
+ *				their next time
+ * Input: None
+ * Output: None
+ */
+void phaseProfiler::Reset()
+{
+	generation = ++numResets;
+	memset( (void*)threads, 0, sizeof(threads));
+	if (worldRecord != NULL)
+		memset( (void*)worldRecord, 0, sizeof(phaseRecord));
+}
+
+/* Function: Total
+ * Description: Time spent in a phase by all the threads since the last Reset, not only over the rolling windows
+ * Input: phase - PHASE_CM .. PHASE_STEP
+ * Output: seconds spent in the phase
+ */
+double phaseProfiler::Total(int phase)
+{
+	double seconds = 0.0;
+
+	for (int thread = 0; thread < ThreadCount(); thread++)
+		seconds += threads[thread].seconds[phase];
+	return seconds;
+}
+
+/* Function: Stats
+ * Description: Minimum, mean, median and 99th percentile (nearest rank) of the times of a phase in the
+ *				rolling windows of some records
+ * Input: records - records whose windows are put together
+ *		  numRecords - number of records
+ *		  phase - PHASE_CM .. PHASE_STEP
+ * Output: stats - statistics, samples is 0 if no time was taken
+ */
+void phaseProfiler::Stats(phaseRecord **records, int numRecords, int phase, phaseStats *stats)
+{
+	float *sorted;
+	double sum = 0.0;
+	int n = 0, count;
+
+	memset( (void*)stats, 0, sizeof(phaseStats));
+	for (int i = 0; i < numRecords; i++)
+		n += (records[i]->count[phase] < PROFILEWINDOW) ? records[i]->count[phase] : PROFILEWINDOW;
+	if (n == 0)
+		return;
+
+	sorted = (float *)malloc(n * sizeof(float));
+	n = 0;
+	for (int i = 0; i < numRecords; i++)
+	{
+		count = (records[i]->count[phase] < PROFILEWINDOW) ? records[i]->count[phase] : PROFILEWINDOW;
+		memcpy(sorted + n, records[i]->seconds[phase], count * sizeof(float));
+		n += count;
+	} //end for
+	qsort(sorted, n, sizeof(float), CompareSeconds);
+
+	for (int i = 0; i < n; i++)
+		sum += sorted[i];
+	stats->samples = n;
+	stats->min = sorted[0];
+	stats->mean = sum / n;
+	stats->p50 = sorted[(int)ceil(0.50 * n) - 1];
+	stats->p99 = sorted[(int)ceil(0.99 * n) - 1];
+	free(sorted);
+}
+
+/* Function: CollectRecords
+ * Description: Lists the records of the bodies of world that got times since the last Reset
+ * Input: world - world whose bodies are listed
+ * Output: records - records in the order of the list of bodies, to be freed; NULL for the bodies without one
+ *		   returns the number of bodies
+ */
+int phaseProfiler::CollectRecords(simWorld *world, phaseRecord ***records)
+{
+	pModel *temp;
+	int count = 0;
+
+	for (temp = world->models; temp->next != NULL; temp = temp->next)
+		count++;
+	*records = (phaseRecord **)calloc(count + 1, sizeof(phaseRecord *));
+
+	count = 0;
+	for (temp = world->models; temp->next != NULL; temp = temp->next, count++)
+		if (temp->pObj->timing != NULL && temp->pObj->timing->generation == generation)
+			(*records)[count] = temp->pObj->timing;
+
+	return count;
+}
+
+/* Function: WriteCSV
+ * Description: Writes the statistics of the rolling window of every body and phase, of all the bodies
+ *				together, of the world phases, and the totals of every thread. Times are in microseconds,
+ *				totals in milliseconds; the statistics a row does not have are left empty.
+ *				The world must not be stepped meanwhile.
+ * Input: filename - CSV file
+ *		  world - world whose bodies are written
+ * Output: true if the file was written
+ */
+bool phaseProfiler::WriteCSV(const char *filename, simWorld *world)
+{
+	FILE *file = fopen(filename, "w");
+	phaseRecord **records, **all;
+	phaseStats stats;
+	pModel *temp;
+	int numRecords, numAll = 0, body;
+
+	if (file == NULL)
+		return false;
+
+	numRecords = CollectRecords(world, &records);
+	all = (phaseRecord **)calloc(numRecords + 1, sizeof(phaseRecord *));
+	for (int i = 0; i < numRecords; i++)
+		if (records[i] != NULL)
+			all[numAll++] = records[i];
+
+	fprintf(file, "scope,id,file,vertices,phase,samples,min_us,mean_us,p50_us,p99_us,total_ms\n");
+	for (temp = world->models, body = 0; temp->next != NULL; temp = temp->next, body++)
+	{
+		if (records[body] == NULL)
+			continue;
+		for (int phase = 0; phase < NUMPHASES; phase++)
+		{
+			Stats(&records[body], 1, phase, &stats);
+			if (stats.samples > 0)
+				fprintf(file, "body,%d,%s,%d,%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", temp->mIndex, temp->file, temp->pObj->numVertices,
+					phaseNames[phase], stats.samples, 1e6 * stats.min, 1e6 * stats.mean, 1e6 * stats.p50, 1e6 * stats.p99,
+					1e3 * stats.mean * stats.samples);
+		} //end for
+	} //end for
+
+	for (int phase = 0; phase < NUMPHASES; phase++)
+	{
+		Stats(all, numAll, phase, &stats);
+		if (stats.samples > 0)
+			fprintf(file, "bodies,,,,%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", phaseNames[phase], stats.samples,
+				1e6 * stats.min, 1e6 * stats.mean, 1e6 * stats.p50, 1e6 * stats.p99, 1e3 * stats.mean * stats.samples);
+
+		if (worldRecord == NULL)
+			continue;
+		Stats(&worldRecord, 1, phase, &stats);
+		if (stats.samples > 0)
+			fprintf(file, "world,,,,%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", phaseNames[phase], stats.samples,
+				1e6 * stats.min, 1e6 * stats.mean, 1e6 * stats.p50, 1e6 * stats.p99, 1e3 * stats.mean * stats.samples);
+	} //end for
+
+	for (int thread = 0; thread < ThreadCount(); thread++)
+		for (int phase = 0; phase < NUMPHASES; phase++)
+			if (threads[thread].count[phase] > 0)
+				fprintf(file, "thread,%d,,,%s,%lld,,%.3f,,,%.3f\n", thread, phaseNames[phase], threads[thread].count[phase],
+					1e6 * threads[thread].seconds[phase] / threads[thread].count[phase], 1e3 * threads[thread].seconds[phase]);
+
+	free(all);
+	free(records);
+	return (fclose(file) == 0);
+}
+
+// Writes the statistics of the phases of some records as a JSON object
+static void WriteJSONPhases(FILE *file, phaseRecord **records, int numRecords)
+{
+	phaseStats stats;
+	bool first = true;
+
+	fprintf(file, "{");
+	for (int phase = 0; phase < NUMPHASES; phase++)
+	{
+		phaseProfiler::Stats(records, numRecords, phase, &stats);
+		if (stats.samples == 0)
+			continue;
+		fprintf(file, "%s\"%s\": {\"samples\": %d, \"min_us\": %.3f, \"mean_us\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f}",
+			first ? "" : ", ", phaseNames[phase], stats.samples, 1e6 * stats.min, 1e6 * stats.mean, 1e6 * stats.p50, 1e6 * stats.p99);
+		first = false;
+	} //end for
+	fprintf(file, "}");
+}
+
+/* Function: WriteJSON
+ * Description: Writes the same statistics as WriteCSV as a JSON object. The world must not be stepped meanwhile.
+ * Input: filename - JSON file
+ *		  world - world whose bodies are written
+ * Output: true if the file was written
+ */
+bool phaseProfiler::WriteJSON(const char *filename, simWorld *world)
+{
+	FILE *file = fopen(filename, "w");
+	phaseRecord **records, **all;
+	pModel *temp;
+	int numRecords, numAll = 0, body;
+	bool first = true;
+
+	if (file == NULL)
+		return false;
+
+	numRecords = CollectRecords(world, &records);
+	all = (phaseRecord **)calloc(numRecords + 1, sizeof(phaseRecord *));
+	for (int i = 0; i < numRecords; i++)
+		if (records[i] != NULL)
+			all[numAll++] = records[i];
+
+	fprintf(file, "{\n  \"window\": %d,\n  \"bodies\": [", PROFILEWINDOW);
+	for (temp = world->models, body = 0; temp->next != NULL; temp = temp->next, body++)
+	{
+		if (records[body] == NULL)
+			continue;
+		fprintf(file, "%s\n    {\"id\": %d, \"file\": ", first ? "" : ",", temp->mIndex);
+		WriteJSONString(file, temp->file);
+		fprintf(file, ", \"vertices\": %d, \"phases\": ", temp->pObj->numVertices);
+		WriteJSONPhases(file, &records[body], 1);
+		fprintf(file, "}");
+		first = false;
+	} //end for
+
+	fprintf(file, "\n  ],\n  \"all_bodies\": ");
+	WriteJSONPhases(file, all, numAll);
+	fprintf(file, ",\n  \"world\": ");
+	WriteJSONPhases(file, &worldRecord, (worldRecord != NULL) ? 1 : 0);
+
+	fprintf(file, ",\n  \"threads\": [");
+	for (int thread = 0; thread < ThreadCount(); thread++)
+	{
+		fprintf(file, "%s\n    {\"id\": %d, \"phases\": {", (thread > 0) ? "," : "", thread);
+		first = true;
+		for (int phase = 0; phase < NUMPHASES; phase++)
+		{
+			if (threads[thread].count[phase] == 0)
+				continue;
+			fprintf(file, "%s\"%s\": {\"samples\": %lld, \"mean_us\": %.3f, \"max_us\": %.3f, \"total_ms\": %.3f}",
+				first ? "" : ", ", phaseNames[phase], threads[thread].count[phase],
+				1e6 * threads[thread].seconds[phase] / threads[thread].count[phase],
+				1e6 * threads[thread].maxSeconds[phase], 1e3 * threads[thread].seconds[phase]);
+			first = false;
+		} //end for
+		fprintf(file, "}}");
+	} //end for
+	fprintf(file, "\n  ]\n}\n");
+
+	free(all);
+	free(records);
+	return (fclose(file) == 0);
+}
+
+/* Function: PrintSummary
+ * Description: Prints the mean time of every phase of a body and of a timestep over the rolling windows.
+ *				The world must not be stepped meanwhile.
+ * Input: world - world whose bodies are summed up
+ * Output: None
+ */
+void phaseProfiler::PrintSummary(simWorld *world)
+{
+	phaseRecord **records, **all;
+	phaseStats stats;
+	int numRecords, numAll = 0;
+
+	numRecords = CollectRecords(world, &records);
+	all = (phaseRecord **)calloc(numRecords + 1, sizeof(phaseRecord *));
+	for (int i = 0; i < numRecords; i++)
+		if (records[i] != NULL)
+			all[numAll++] = records[i];
+
+	printf("mean us per body:");
+	for (int phase = 0; phase < PHASE_BROAD; phase++)
+	{
+		Stats(all, numAll, phase, &stats);
+		if (stats.samples > 0)
+			printf(" %s %.1f", phaseNames[phase], 1e6 * stats.mean);
+	} //end for
+	for (int phase = PHASE_BROAD; phase < NUMPHASES && worldRecord != NULL; phase++)
+	{
+		Stats(&worldRecord, 1, phase, &stats);
+		if (stats.samples > 0)
+			printf(", %s %.1f", phaseNames[phase], 1e6 * stats.mean);
+	} //end for
+	printf("\n");
+
+	free(all);
+	free(records);
+}
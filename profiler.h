@@ -0,0 +1,111 @@
+/* Header: profiler
+ * Description: Header file for the timers of the phases of a timestep. A phaseTimer measures one phase of
+ *				one body (or of the whole world) from its construction to the end of its scope, and hands
+ *				the time to the world's phaseProfiler, which keeps the last PROFILEWINDOW times of every
+ *				body and phase and adds them to the totals of the thread that measured them. The minimum,
+ *				mean, median and 99th percentile over that rolling window are written to a CSV or JSON file
+ *				on demand. Without a profiler (simWorld::profiler is NULL) a timer costs one test.
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+// Phases of a timestep
+#define PHASE_CM 0					// Center of mass (part of PHASE_APQ for FusedStep)
+#define PHASE_APQ 1					// Apq, and TApq for quadratic deformation
+#define PHASE_ROTATION 2			// Rotation extracted from Apq
+#define PHASE_DEFORM 3				// Rigid, linear or quadratic adjustment of the deformation
+#define PHASE_INTEGRATE 4			// Goal positions and integration
+#define PHASE_WALL 5				// Response to the walls
+#define PHASE_BOUNDS 6				// Bounding sphere and triangle tree
+#define PHASE_SPHERE 7				// Model-model collision response
+#define PHASE_BROAD 8				// Broad phase and waking the touched models, for the whole world
+#define PHASE_STEP 9				// Whole timestep, for the whole world
+#define NUMPHASES 10
+
+#define PROFILEWINDOW 512			// Last timesteps whose times are kept for every body and phase
+#define MAXPROFILETHREADS 64		// Threads with totals of their own, the next ones share them
+
+class simWorld;
+
+// Names of the phases in the files written
+extern const char *phaseNames[NUMPHASES];
+
+// Seconds from an arbitrary start, with the best resolution of the system
+double profileClock();
+
+// Last times of every phase of a body
+struct phaseRecord
+{
+	unsigned int generation;		// Reset of the profiler the times were taken after
+	int count[NUMPHASES];			// Times taken, the last PROFILEWINDOW are kept
+	float seconds[NUMPHASES][PROFILEWINDOW];	// Ring of the times, time i at i % PROFILEWINDOW
+};
+
+// Totals of the phases measured on one thread
+struct phaseThread
+{
+	double seconds[NUMPHASES];
+	double maxSeconds[NUMPHASES];
+	long long count[NUMPHASES];
+};
+
+// Statistics of the rolling window of one phase
+struct phaseStats
+{
+	int samples;
+	double min;
+	double mean;
+	double p50;
+	double p99;
+};
+
+class phaseProfiler
+{
+public:
+		phaseProfiler();
+		~phaseProfiler();
+
+		void Add(phaseRecord **record, int phase, double seconds);
+		void Reset();
+		bool WriteCSV(const char *filename, simWorld *world);
+		bool WriteJSON(const char *filename, simWorld *world);
+		void PrintSummary(simWorld *world);
+		double Total(int phase);
+
+		static void Stats(phaseRecord **records, int numRecords, int phase, phaseStats *stats);
+
+		phaseRecord *worldRecord;		// Times of the world phases (PHASE_BROAD, PHASE_STEP)
+		phaseThread threads[MAXPROFILETHREADS];	// Totals of every thread, numbered in the order they measured their first phase
+
+protected:
+		int CollectRecords(simWorld *world, phaseRecord ***records);
+
+		unsigned int generation;
+};
+
+// Measures a phase from its construction to the end of its scope
+class phaseTimer
+{
+public:
+		phaseTimer(phaseProfiler *profiler, phaseRecord **record, int phase)
+		{
+			this->profiler = profiler;
+			this->record = record;
+			this->phase = phase;
+			start = (profiler != NULL) ? profileClock() : 0.0;
+		}
+		~phaseTimer()
+		{
+			if (profiler != NULL)
+				profiler->Add(record, phase, profileClock() - start);
+		}
+
+protected:
+		phaseProfiler *profiler;
+		phaseRecord **record;
+		int phase;
+		double start;
+};
+
+#endif
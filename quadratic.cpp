@@ -9,13 +9,13 @@
  * Input: None
  * Output: None
  */
-void quadRotMat(matrix *rot, phyzx *phyzxObj)
+void quadRotMat(matrix39 *rot, phyzx *phyzxObj)
 {
-	matInit(rot, 3, 9);
+	matZero(rot);
 
-	for (int row = 0; row < (*rot).row * (*rot).col; row+=(*rot).col)
+	for (int row = 0; row < 3; row++)
 		for (int col = 0; col < 3; col++)
-			(*rot).data[row+col] = phyzxObj->R[(int)(row/(*rot).col)][col];
+			(*rot).data[9*row + col] = phyzxObj->R[row][col];
 } //end quadRotMat
 
 
@@ -24,10 +24,8 @@ void quadRotMat(matrix *rot, phyzx *phyzxObj)
  * Input: None
  * Output: None
  */
-void calcQ(point p, matrix *q)
+void calcQ(point p, matrix91 *q)
 {
-	matInit(q, 9, 1);
-
 	(*q).data[0] = p.x;
 	(*q).data[1] = p.y;
 	(*q).data[2] = p.z;
@@ -41,98 +39,136 @@ void calcQ(point p, matrix *q)
 	(*q).data[8] = p.z * p.x;
 } //end calcQ
 
-void calcTApq(phyzx *phyzxObj)
+/* Function: calcTApq
+ * Description: Computes the 3x9 TApq matrix of the quadratic deformation
+ *				TApq = Summation(m * (p x qT))
+ * Input: world - world whose threads run the vertex loop
+ * Output: None
+ */
+void calcTApq(phyzx *phyzxObj, simWorld *world)
 {
-	matrix pqT, p, mpqT;
-
-	matInit(&p, 3, 1);
-	matInit(&phyzxObj->TApq, 3, 9);
-	
-	for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
-	{
-		p.data[0] = phyzxObj->relDeformedLoc[index].x;
-		p.data[1] = phyzxObj->relDeformedLoc[index].y;
-		p.data[2] = phyzxObj->relDeformedLoc[index].z;
+	vertexTask work;
 
-		//calcQ(phyzxObj->relStableLoc[index], &q);
-		//matTranspose(q, &qT);
-		matMult(p, phyzxObj->qT[index], &pqT);					// p x qT
-		matSMult(phyzxObj->mass[index], pqT, &mpqT);			// m * (p X qT)
-		matAdd(phyzxObj->TApq, mpqT, &phyzxObj->TApq);			// Apq += m * (p X qT)  
-	}
+	memset( (void*)&work, 0, sizeof(work));
+	work.phyzxObj = phyzxObj;
+	work.world = world;
+	work.stride = 27;
 
-	delete[] pqT.data;
-	delete[] p.data;
-	delete[] mpqT.data;
+	ForEachVertexChunk(&work, calcTApqChunks);
+	CombineChunks(phyzxObj, 27, phyzxObj->TApq.data);
 } //end calcTApq
 
+/* Function: calcTApqChunks
+ * Description: Vertex loop of calcTApq over the chunks [begin, end)
+ * Input: context - vertexTask of the model
+ * Output: None
+ */
+void calcTApqChunks(void *context, int begin, int end)
+{
+	vertexTask *work = (vertexTask *)context;
+	phyzx *phyzxObj = work->phyzxObj;
+	double p[3], m, *sums;
+	int last;
+
+	for (int chunk = begin; chunk < end; chunk++)
+	{
+		sums = phyzxObj->chunkSums + chunk * 27;
+		last = ((chunk + 1) * VERTEXCHUNK < phyzxObj->numVertices) ? (chunk + 1) * VERTEXCHUNK : phyzxObj->numVertices;
+
+		for (int index = chunk * VERTEXCHUNK; index < last; index++)
+		{
+			p[0] = phyzxObj->relDeformedLoc.x[index];
+			p[1] = phyzxObj->relDeformedLoc.y[index];
+			p[2] = phyzxObj->relDeformedLoc.z[index];
+			m = phyzxObj->mass[index];
+
+			// TApq += m * (p X qT)
+			for (int row = 0; row < 3; row++)
+				for (int col = 0; col < 9; col++)
+					sums[9*row + col] += m * (p[row] * phyzxObj->q[index].data[col]);
+		}
+	}
+} //end calcTApqChunks
+
+/* Function: calcTAqq
+ * Description: Computes the 9x9 TAqq matrix of the quadratic deformation from the rest shape, with the
+ *				quadratic coordinates q of every vertex
+ *				TAqq = Inverse(Summation(m * (q x qT)))
+ * Input: None
+ * Output: None
+ */
 void calcTAqq(phyzx *phyzxObj)
 {
-	matrix qqT, mqqT, TAqqInv;
+	fixedMatrix<1, 9> qT;
+	matrix99 qqT, mqqT, TAqqInv;
 
-	matInit(&phyzxObj->TAqq, 9, 9);
-	matInit(&TAqqInv, 9, 9);
+	matZero(&TAqqInv);
+	memset( (void*)phyzxObj->mqStable, 0, sizeof(phyzxObj->mqStable));
 	
-	for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
+	for(int index = 0; index < phyzxObj->numVertices; index++)
 	{
-		calcQ(phyzxObj->relStableLoc[index], &phyzxObj->q[index]);
-		matTranspose(phyzxObj->q[index], &phyzxObj->qT[index]);
-		matMult(phyzxObj->q[index], phyzxObj->qT[index], &qqT);			// q x qT
+		calcQ(soaGet(phyzxObj->relStableLoc, index), &phyzxObj->q[index]);
+		for (int j = 0; j < 9; j++)
+			phyzxObj->mqStable[j] += phyzxObj->mass[index] * phyzxObj->q[index].data[j];	// Summation(m * q)
+		matTranspose(phyzxObj->q[index], &qT);
+		matMult(phyzxObj->q[index], qT, &qqT);							// q x qT
 		matSMult(phyzxObj->mass[index], qqT, &mqqT);					// m * (q X qT)
 		matAdd(TAqqInv, mqqT, &TAqqInv);								// Aqq += m * (q X qT)  
 	}
 
-	matInverse(TAqqInv, &phyzxObj->TAqq);
-	
-	delete[] qqT.data;
-	delete[] mqqT.data;
-	delete[] TAqqInv.data;
-} //end calcTApq
+	if (!matInverse(TAqqInv, &phyzxObj->TAqq))
+		matZero(&phyzxObj->TAqq);
+} //end calcTAqq
 
 /* Function: quadDeformRot
  * Description: Calculates the rotational matrix for Quadratic Deformation.
  * Input: None
  * Output: None
  */
-void quadDeformRot(matrix *R, phyzx *phyzxObj)
+void quadDeformRot(matrix39 *R, phyzx *phyzxObj, simWorld *world)
+{
+	calcTApq(phyzxObj, world);
+	quadBlendRot(R, phyzxObj);
+} //end quadDeformRot
+
+/* Function: quadBlendRot
+ * Description: Blends the current TApq and rotation matrix into the 3x9 matrix used for the goal positions.
+ *				R = beta * (TApq x TAqq) + (1 - beta) * [R 0 0]
+ * Input: None
+ * Output: None
+ */
+void quadBlendRot(matrix39 *R, phyzx *phyzxObj)
 {
-	matrix A, rot, bA, bR;
+	matrix39 A, rot, bA, bR;
 
-	calcTApq(phyzxObj);
 	matMult(phyzxObj->TApq, phyzxObj->TAqq, &A);
 	matSMult(phyzxObj->beta, A, &bA);
 
 	quadRotMat(&rot, phyzxObj);
 	matSMult((1.0 - phyzxObj->beta), rot, &bR);
 	matAdd(bA, bR, R);
-
-	delete[] A.data;
-	delete[] rot.data;
-	delete[] bA.data;
-	delete[] bR.data;
-} //end quadDeformRot
+} //end quadBlendRot
 
 /* Function: quadDeform
  * Description: Calculates the rotational matrix for Quadratic Deformation.
  * Input: None
  * Output: None
  */
-void quadDeform(phyzx *phyzxObj)
+void quadDeform(phyzx *phyzxObj, simWorld *world)
 {
 	point temp;
-	matrix R, matTemp;
+	matrix39 R;
+	fixedMatrix<3, 1> matTemp;
 
-	quadDeformRot(&R, phyzxObj);
+	quadDeformRot(&R, phyzxObj, world);
 
 	// Calculate Goal Position with 3x9 Matrix R
-	for(unsigned int index = STARTFROM; index <= phyzxObj->model->numvertices; index++)
+	for(int index = 0; index < phyzxObj->numVertices; index++)
 	{
 		//calcQ(phyzxObj->relStableLoc[index], &q);
 		matMult(R, phyzxObj->q[index], &matTemp);						// R(q)
 		temp = matToPoint(matTemp);										// Data type conversion
-		pSUM(temp, phyzxObj->cmDeformed, phyzxObj->goal[index]);		// g = R(q) + xcm
+		pSUM(temp, phyzxObj->cmDeformed, temp);							// g = R(q) + xcm
+		soaSet(phyzxObj->goal, index, temp);
 	}
-
-	delete[] R.data;
-	delete[] matTemp.data;
 } //end quadDeform
\ No newline at end of file
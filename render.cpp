@@ -11,7 +11,6 @@
 #include "physics.h"
 #include "input.h"
 #include "ui.h"
-#include "performanceCounter.h"
 
 /* Global Variables BEGIN */
 // Window settings
@@ -22,10 +21,10 @@ int mainWindowId = 0;
 char filename[50];
 
 // Application controls
-int pause, saveScreenToFile, sprite;
+int pause, saveScreenToFile, sprite, exportMode = EXPORTCACHE;
 GLUI *glui;
 float gTStep, gKCol, gDCol, gGravity, gAlpha, gBeta, gDelta, gMass;
-int gNStep, gNextModelID = 0, boxType = 3, axis = 1, stickyFloor = 0, gFRateON = 0;
+int gNStep, gNextModelID = 0, boxType = 3, axis = 1, stickyFloor = 0, restFiles = 0, gFRateON = 0;
 
 // Light controls
 int lighting;
@@ -46,7 +45,7 @@ int camFol;
 
 // Object File Data Structure
 GLMmodel *objModel;
-bool objCollide, renderLine;
+bool renderLine;
 
 //GLUquadricObj* quad;
 GLUquadricObj* sphere;
@@ -55,13 +54,17 @@ GLUquadricObj* sphere;
 int gDeformMode;
 
 // Models
-struct pModel *phyzxModels;
-int modelCounter = -1;
+simWorld gWorld;
+simThread gSim(&gWorld);
+frameCache gFrames;
+exportWriter gExport(EXPORTSLOTS, EXPORTBLOCK);
 char gCrateName[30];
 
+// Model the OBJ files are written from on the export writer thread, and its shape
+GLMmodel *gExportModel = NULL;
+restShape *gExportShape = NULL;
+bool gExporting = false;
 
-// Frame rate counter
-PerformanceCounter pCounter;
 
 /* Global Variables END */
 
@@ -154,8 +157,8 @@ void display(void)
 	glMatrixMode(GL_MODELVIEW);
 
 	// Setup camera position
-	if (camFol == 1 && phyzxModels->mIndex != -1)
-		cameraFollow(phyzxModels->pObj->model);
+	if (camFol == 1 && gWorld.models->mIndex != -1)
+		cameraFollow(gWorld.models->pObj->model);
 	
 	setCamera();
 
@@ -167,7 +170,7 @@ void display(void)
 		renderAxis();
 	
 	// Display all the models in the List
-	pModel *temp = phyzxModels;
+	pModel *temp = gWorld.models;
 	if(temp != NULL)
 	{
 		while(temp->next != NULL)
@@ -201,7 +204,7 @@ void display(void)
 		point mouse = getCoord(mousePos.x, mousePos.y);
 		point pMouse = getCoord(pMousePos.x, pMousePos.y);
 
-		pModel *temp = phyzxModels;
+		pModel *temp = gWorld.models;
 	
 		while(temp->next != NULL)
 		{
@@ -242,6 +245,10 @@ void display(void)
 	
 	changeBox(boxType);
 
+	// The back buffer is copied before it is swapped
+	if (saveScreenToFile == 1 && exportMode == EXPORTSCREENSHOT)
+		exportScreen();
+
 	glutSwapBuffers();
 } //end display
 
@@ -252,55 +259,39 @@ void display(void)
  */
 void idle(void)
 {
-	char ssname[20]="modxxxx.obj";
-	double frameRate = 0.0;
+	static double reportStart = 0.0, reportTime = 0.0;
+	static int reportFrames = 0;
+	double frameRate = 0.0, frameTime = 0.0;
+	bool fresh;
 
-	// save screen to file
-	ssname[3] = 48 + (sprite / 1000);
-	ssname[4] = 48 + (sprite % 1000) / 100;
-	ssname[5] = 48 + (sprite % 100 ) / 10;
-	ssname[6] = 48 + sprite % 10;
+	// The simulation thread steps gNStep timesteps per frame, take the newest one it finished
+	syncWorld();
+	fresh = gSim.ReadFrame(&frameRate, &frameTime);
 
-	if (saveScreenToFile == 1)
-	{
-		//saveScreenshot(WINRESX, WINRESY, ssname);
-		glmWriteOBJ(phyzxModels->pObj->model, ssname, GLM_SMOOTH, 1); 
-	//	saveScreenToFile = 1; // save only once, change this if you want continuos image generation (i.e. animation)
-		sprite++;
-	} //end if
-
-	if (sprite >= 9999)
+	// Printed once a second, printing every frame slowed down what was measured
+	if (fresh && gFRateON)
 	{
-		sprite = 0;
-	} //end if
-
-	if (pause == 0)
-	{
-		// insert code which appropriately performs one step of the cube simulation:
-//		for (int i = 1; i <= phyzxObj->n; i++)
-//		{
-			// Recompute the goal position. Timestep using modified Euler
-			// Collision detection and response and the final position is updated
-		for(int i = 0; i < gNStep; i++)
+		reportTime += frameRate;
+		reportFrames++;
+		if (profileClock() - reportStart >= 1.0)
 		{
-			if(gFRateON)
-			{
-				pCounter.StartCounter();
-				CallPerFrame();
-				pCounter.StopCounter();
-				frameRate = pCounter.GetElapsedTime();
-				printf("Frame rate = %lf\n", 1.0 / frameRate);
-			}
-			else
-			{
-				CallPerFrame();
-			}
-		}
-		
-//		} //end for*/
-		//pause = 1 - pause;
+			printf("Frame rate = %lf\n", reportFrames / reportTime);
+			gSim.Lock();
+			if (gWorld.profiler != NULL)
+				gWorld.profiler->PrintSummary(&gWorld);
+			gSim.Unlock();
+			reportStart = profileClock();
+			reportTime = 0.0;
+			reportFrames = 0;
+		} //end if
 	} //end if
 
+	// save the frames to file, the export writer thread writes them
+	if (saveScreenToFile == 1)
+		exportFrame(fresh, frameTime);
+	else if (gExporting)
+		stopExport();
+
 	/* According to the GLUT specification, the current window is 
      undefined during an idle callback.  So we need to explicitly change
      it if necessary */
@@ -329,6 +320,38 @@ void reshape (int w, int h)
 	setCamera();
 } //end reshape
 
+/* Function: syncWorld
+ * Description: Hands the user controls over to the simulation thread, which copies them into
+ *				the world before its next frame
+ * Input: None
+ * Output: None
+ */
+void syncWorld()
+{
+	simControls controls;
+
+	controls.h = gTStep;
+	controls.n = gNStep;
+	controls.alpha = gAlpha;
+	controls.beta = gBeta;
+	controls.delta = gDelta;
+	controls.kWall = gKCol;
+	controls.dWall = gDCol;
+	controls.gravity = gGravity;
+	controls.deformMode = gDeformMode;
+	controls.stickyFloor = stickyFloor;
+	controls.userForce = userForce;
+	controls.paused = (pause != 0);
+	controls.profile = (gFRateON != 0);
+
+	if (lMouseVal == 2 && objectName != -1)
+		controls.dragModel = iMouseModel;
+	else
+		controls.dragModel = -1;
+
+	gSim.SetControls(&controls);
+} //end syncWorld
+
 /* Function: AddModel
  * Description: adds a new model from the information present in the filename into the list
  * Input: filename - name of model input file
@@ -337,80 +360,50 @@ void reshape (int w, int h)
 void AddModel(char *filename, int position)
 {
 	double random = 0;
-
+	point translate;
+	int mode = gDeformMode;
 	pModel *node;
-	node = (pModel*)malloc(sizeof(pModel));
-	node->next = phyzxModels;
-	phyzxModels = node;
-
-	phyzxModels->mIndex = ++modelCounter;
-
-	phyzxModels->pObj = new phyzx();
 
-	strcpy(phyzxModels->file, filename);
-	phyzxModels->pObj->model = glmReadOBJ(phyzxModels->file);
-
-	if(gNextModelID != 4)
-	{
-		strcpy(phyzxModels->pObj->model->materials[1].textureFile, gCrateName);
-		glmSetUpTextures(phyzxModels->pObj->model, GL_MODULATE);
-	}
-
-	// Initialize the Physics module
-	phyzxInit(phyzxModels->pObj);
-	
 	if(position == RANDOMPOS) 
 	{
 		random = (double)(rand() % (200 + 1));
 		random -= 100;
 		random /= 100;
-		phyzxModels->translate.x = random;
+		translate.x = random;
 
-		phyzxModels->translate.y = 0.0f;
+		translate.y = 0.0f;
 
 		random = (double)(rand() % (200 + 1));
 		random -= 100;
 		random /= 100;
-		phyzxModels->translate.z = random;
-
-		phyzxModels->pObj->deformMode = gDeformMode;
+		translate.z = random;
 	}
 	else if(position == TESTCASE1POS)
 	{
-		phyzxModels->translate.x = -0.5;
-		phyzxModels->translate.y = 0.0f;
-		phyzxModels->translate.z = 0.0;
-
-		phyzxModels->pObj->deformMode = 0;
+		translate = vMake(-0.5, 0.0, 0.0);
+		mode = 0;
 	}
 	else if(position == TESTCASE2POS)
 	{
-		phyzxModels->translate.x = 0.5;
-		phyzxModels->translate.y = 0.0f;
-		phyzxModels->translate.z = 0.0;
-
-		phyzxModels->pObj->deformMode = 1;
-	}
-	
-	for (unsigned int index = STARTFROM; index <= phyzxModels->pObj->model->numvertices; index++)
-	{
-		phyzxModels->pObj->model->vertices[3*index] += phyzxModels->translate.x;
-		phyzxModels->pObj->model->vertices[3*index + 1] += phyzxModels->translate.y;
-		phyzxModels->pObj->model->vertices[3*index + 2] += phyzxModels->translate.z;
-
-		phyzxModels->pObj->model->verticesRest[3*index] += phyzxModels->translate.x;
-		phyzxModels->pObj->model->verticesRest[3*index + 1] += phyzxModels->translate.y;
-		phyzxModels->pObj->model->verticesRest[3*index + 2] += phyzxModels->translate.z;
+		translate = vMake(0.5, 0.0, 0.0);
+		mode = 1;
 	}
 
-	// Compute the center of the model with  the radius of the bounding sphere
-	glmMeshGeometricParameters(phyzxModels->pObj->model, &phyzxModels->cModel.x, &phyzxModels->cModel.y, &phyzxModels->cModel.z, &phyzxModels->radius);
+	// Load the model and initialize the Physics module
+	syncWorld();
+	gSim.Lock();
+	gSim.ApplyControls();
+	gWorld.shapes->restFiles = (restFiles == 1);
+	node = gWorld.AddModel(filename, translate, mode);
+	gSim.Unlock();
 
-	// Compute the radius of the best bounding sphere around the model
-	glmMeshRadius(phyzxModels->pObj->model,  phyzxModels->cModel.x, phyzxModels->cModel.y, phyzxModels->cModel.z, &phyzxModels->radius);
+	if(gNextModelID != 4)
+	{
+		ShapeTexture(node->pObj->model, node->pObj->shape, 1, gCrateName, GL_MODULATE);
+	}
 
 	// Display the live variables of the first model in GLUI
-	dispPhysics(phyzxModels->pObj);
+	dispPhysics(node->pObj);
 }
 
 
@@ -421,44 +414,169 @@ void RunTestCase()
 }
 
 
-/* Function: DeleteModels
- * Description: clears all the models in the list
- * Input: None
+// Writes the positions copied by exportFrame into a modXXXX.obj file, on the writer thread
+static bool writeOBJJob(exportJob *job)
+{
+	GLMmodel *model = (GLMmodel *)job->context;
+
+	memcpy(model->vertices + 3*STARTFROM, job->data, job->size);
+	glmWriteOBJ(model, job->name, GLM_SMOOTH, 1);
+	return true;
+}
+
+// Frees the model of the OBJ export once the writer is done with it
+static void releaseExportModel()
+{
+	if (gExportModel == NULL)
+		return;
+
+	gExport.Drain();
+	DeleteInstanceModel(gExportModel);
+	gSim.Lock();
+	gExportShape->cache->Release(gExportShape);
+	gSim.Unlock();
+	gExportModel = NULL;
+	gExportShape = NULL;
+}
+
+/* Function: exportFrame
+ * Description: Copies the frame read from the simulation thread into a job of the export writer, which
+ *				writes it to the frame cache or to the next modXXXX.obj file
+ * Input: fresh - the frame was not exported yet
+ *		  time - simulated time of the frame
  * Output: None
  */
-/*
-void DeleteModels()
+void exportFrame(bool fresh, double time)
 {
-	pModel *next, *cur;
-	
-	next = phyzxModels;
-	while(next->next->next != NULL)
+	restShape *shape;
+	exportJob *job;
+
+	if (exportMode == EXPORTCACHE)
 	{
-		cur = next;
-		next = next->next;	
-		free(cur);
+		if (!gFrames.IsOpen() && !gFrames.Create(FRAMECACHEFILE, &gExport))
+		{
+			printf("Cannot write the frame cache %s\n", FRAMECACHEFILE);
+			saveScreenToFile = 0;
+			return;
+		}
+		gExporting = true;
+		if (fresh && !gFrames.WriteFrame(&gWorld, time))
+		{
+			printf("Cannot write frame %d to the frame cache %s\n", gFrames.numFrames, FRAMECACHEFILE);
+			saveScreenToFile = 0;
+		} //end if
 	}
-	phyzxModels = next;
-	phyzxModels->mIndex = 0;
+	else if (exportMode == EXPORTOBJ && fresh && gWorld.models->next != NULL)
+	{
+		// The writer thread writes the positions of the first model with a model of its own
+		shape = gWorld.models->pObj->shape;
+		if (shape != gExportShape)
+		{
+			releaseExportModel();
+			gSim.Lock();
+			shape->refCount++;
+			gSim.Unlock();
+			gExportShape = shape;
+			gExportModel = InstanceModel(shape);
+		} //end if
+		gExporting = true;
+
+		job = gExport.Begin(3 * shape->numVertices * sizeof(GLfloat));
+		if (job == NULL)
+			return;
+		job->encode = writeOBJJob;
+		job->context = gExportModel;
+		sprintf(job->name, "mod%04d.obj", sprite);
+		exportWriter::Append(job, gWorld.models->pObj->model->vertices + 3*STARTFROM, 3 * shape->numVertices * sizeof(GLfloat));
+		gExport.Commit(job);
 
-	modelCounter = 1;
+		sprite++;
+		if (sprite >= 9999)
+		{
+			sprite = 0;
+		} //end if
+	} //end if
 }
-*/
-void DeleteModels()
+
+/* Function: exportScreen
+ * Description: Copies the window into a job of the export writer, which writes it to the next
+ *				picXXXX.ppm file
+ * Input: None
+ * Output: None
+ */
+void exportScreen()
 {
-	pModel *next, *cur;
-	
-	next = phyzxModels;
-	while(next->next != NULL)
+	char ssname[20];
+
+	sprintf(ssname, "pic%04d.ppm", sprite);
+	gExporting = true;
+	if (!queueScreenshot(&gExport, glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT), ssname))
+		return;
+
+	sprite++;
+	if (sprite >= 9999)
 	{
-		cur = next;
-		next = next->next;	
-		free(cur);
-	}
-	phyzxModels = next;
-	phyzxModels->mIndex = -1;
+		sprite = 0;
+	} //end if
+}
+
+/* Function: stopExport
+ * Description: Waits for the frames still queued, finishes the frame cache and prints what the export
+ *				writer did during the recording; also called when the application exits
+ * Input: None
+ * Output: None
+ */
+void stopExport()
+{
+	int numFrames = gFrames.numFrames;
+
+	if (!gExporting)
+		return;
+	gExporting = false;
+
+	gExport.Drain();
+	if (gFrames.IsOpen())
+	{
+		if (gFrames.Close())
+			printf("Saved %d frames to %s\n", numFrames, FRAMECACHEFILE);
+		else
+			printf("Cannot finish the frame cache %s\n", FRAMECACHEFILE);
+	} //end if
+	releaseExportModel();
+
+	gExport.PrintStats("Export writer");
+	gExport.Stop();
+	gExport.ResetStats();
+}
+
+/* Function: dumpTiming
+ * Description: Writes the times of the phases of the last timesteps to TIMINGFILE.csv and TIMINGFILE.json
+ * Input: None
+ * Output: None
+ */
+void dumpTiming()
+{
+	gSim.Lock();
+	if (gWorld.profiler == NULL)
+		printf("Turn the frame rate on to measure the phases of the timesteps\n");
+	else if (gWorld.profiler->WriteCSV(TIMINGFILE ".csv", &gWorld) && gWorld.profiler->WriteJSON(TIMINGFILE ".json", &gWorld))
+		printf("Saved the phase times to %s.csv and %s.json\n", TIMINGFILE, TIMINGFILE);
+	else
+		printf("Cannot write the phase times to %s.csv and %s.json\n", TIMINGFILE, TIMINGFILE);
+	gSim.Unlock();
+}
 
-	modelCounter = -1;
+/* Function: DeleteModels
+ * Description: clears all the models in the list
+ * Input: None
+ * Output: None
+ */
+void DeleteModels()
+{
+	gSim.Lock();
+	gWorld.DeleteModels();
+	gSim.ClearFrames();
+	gSim.Unlock();
 }
 
 /* Main Loop */
@@ -484,10 +602,6 @@ int main(int argc, char** argv)
 	initialize();
 	LoadImages();
 
-	phyzxModels = (pModel*)malloc(sizeof(pModel));
-	
-	phyzxModels->next = NULL;
-
 //	AddModel(filename, RANDOMPOS);
 	
 	// Redraws window if window is resized
@@ -500,6 +614,13 @@ int main(int argc, char** argv)
 	glutDisplayFunc(display);
 	GLUI_Master.set_glutIdleFunc(idle);
 
+	// Step the models on their own thread
+	syncWorld();
+	gSim.Start();
+
+	// The frames queued are written and the frame cache gets its index even if the application is left while recording
+	atexit(stopExport);
+
 	// Read User Mouse Input
 	glutMouseFunc(mouse);
 	glutMotionFunc(motion);
@@ -23,6 +23,9 @@
 #include "matrix.h"
 #include "texture.h"
 #include "pic.h"
+#include "simulation.h"
+#include "simThread.h"
+#include "frameCache.h"
 
 // Mathematics Definitions
 #define PI 3.141592653589793238462643383279
@@ -37,6 +40,13 @@
 #define MAROON 1
 #define FLESH 2
 
+// What is saved while saveScreenToFile is on
+#define EXPORTCACHE 0			// Every frame of the bodies into the frame cache FRAMECACHEFILE
+#define EXPORTOBJ 1				// The first model into modXXXX.obj files
+#define EXPORTSCREENSHOT 2		// The window into picXXXX.ppm files
+#define FRAMECACHEFILE "frames" FRAMECACHESUFFIX
+#define TIMINGFILE "timing"		// Files the phase times are written to, with .csv and .json
+
 #define RANDOMPOS 1
 #define TESTCASE1POS 2
 #define TESTCASE2POS 3
@@ -51,10 +61,10 @@ extern char filename[50];
 extern int mainWindowId;
 
 // Application controls
-extern int pause, saveScreenToFile, sprite;
+extern int pause, saveScreenToFile, sprite, exportMode;
 extern GLUI *glui;
 extern float gTStep, gKCol, gDCol, gGravity, gAlpha, gBeta, gDelta, gMass;
-extern int gNStep, gNextModelID, boxType, axis, stickyFloor, gFRateON;
+extern int gNStep, gNextModelID, boxType, axis, stickyFloor, restFiles, gFRateON;
 
 // Light Settings
 extern int lighting;
@@ -84,11 +94,14 @@ struct boundBox
 //extern struct boundBox box;
 
 // Models
-extern struct pModel *phyzxModels;
+extern simWorld gWorld;
+extern simThread gSim;
+extern frameCache gFrames;
+extern exportWriter gExport;
 
 // Object File Data Structure
 extern GLMmodel *objModel;
-extern bool objCollide, renderLine;
+extern bool renderLine;
 
 // Deformation Controls
 extern int gDeformMode;
@@ -96,6 +109,21 @@ extern int gDeformMode;
 // Run the test case
 void RunTestCase();
 
+// Hands the user controls over to the simulation thread
+void syncWorld();
+
+// Copies a frame from the simulation thread for the export writer (EXPORTCACHE, EXPORTOBJ)
+void exportFrame(bool fresh, double time);
+
+// Copies the window for the export writer (EXPORTSCREENSHOT)
+void exportScreen();
+
+// Writes the frames still queued and closes the files being recorded
+void stopExport();
+
+// Writes the times of the phases of the last timesteps
+void dumpTiming();
+
 // Adds a new model to the simulation
 void AddModel(char *filename, int position);
 
@@ -0,0 +1,116 @@
+/* Source: scenes
+ * Description: Contains the canonical scenes of the headless tools.
+ */
+
+#include "scenes.h"
+
+benchScene benchScenes[] =
+{
+	{"crates8", "crate.obj", 8, 0, LAYOUT_RANDOM, 0.0, 0.0, ARENASIZE, GEOMETRY_BOX, true},
+	{"crates16", "crate.obj", 16, 0, LAYOUT_RANDOM, 0.0, 0.0, ARENASIZE, GEOMETRY_BOX, true},
+	{"sphere0", "sphere.obj", 1, 0, LAYOUT_DROP, 0.5, 0.0, ARENASIZE, GEOMETRY_BOX, false},
+	{"sphere1", "sphere.obj", 1, 1, LAYOUT_DROP, 0.5, 0.0, ARENASIZE, GEOMETRY_BOX, false},
+	{"sphere2", "sphere.obj", 1, 2, LAYOUT_DROP, 0.5, 0.0, ARENASIZE, GEOMETRY_BOX, false},
+	{"sphere3", "sphere.obj", 1, 3, LAYOUT_DROP, 0.5, 0.0, ARENASIZE, GEOMETRY_BOX, false},
+	{"rabbit", "rabbit.obj", 1, 1, LAYOUT_DROP, 1.3, 0.0, ARENASIZE, GEOMETRY_BOX, false},
+	{"flourpile", "flourSack.obj", 4, 1, LAYOUT_STACK, -0.15, 0.1, ARENASIZE, GEOMETRY_BOX, true},
+	{"arena16", "crate.obj", 8, 0, LAYOUT_RANDOM, -14.0, 0.0, 16.0, GEOMETRY_BOX, true},
+	{"ramp", "sphere.obj", 1, 1, LAYOUT_DROP, 0.5, 0.0, ARENASIZE, GEOMETRY_RAMP, false},
+};
+const int numBenchScenes = (int)(sizeof(benchScenes) / sizeof(benchScenes[0]));
+
+/* Function: FindScene
+ * Description: Looks a scene up by its name
+ * Input: name - name of the scene
+ * Output: the scene, NULL if there is none of that name
+ */
+benchScene * FindScene(const char *name)
+{
+	for (int i = 0; i < numBenchScenes; i++)
+		if (strcmp(benchScenes[i].name, name) == 0)
+			return &benchScenes[i];
+	return NULL;
+}
+
+/* Function: BuildGeometry
+ * Description: Sets the collision world of a scene: the walls of its arena, and for GEOMETRY_RAMP a floor
+ *				sloping down along x, 1.2 below the center of the arena, and a box turned by 30 degrees
+ *				about y, half sunk into that floor in the way of the bodies rolling down
+ * Input: arena - collision world of the world of the scene
+ *		  scene - scene to build
+ * Output: None
+ */
+static void BuildGeometry(collisionWorld *arena, benchScene *scene)
+{
+	point normal, center, axisX, axisY, half;
+
+	arena->SetArena(scene->size);
+	if (scene->geometry != GEOMETRY_RAMP)
+		return;
+
+	normal.x = 0.25;
+	normal.y = 1.0;
+	normal.z = 0.0;
+	arena->AddPlane(normal, -1.2 / sqrt(normal.x * normal.x + normal.y * normal.y));
+
+	center.x = 1.1;
+	center.y = -1.3;
+	center.z = -0.34;
+	axisX.x = cos(M_PI / 6.0);
+	axisX.y = 0.0;
+	axisX.z = sin(M_PI / 6.0);
+	axisY.x = 0.0;
+	axisY.y = 1.0;
+	axisY.z = 0.0;
+	half.x = half.y = half.z = 0.25;
+	arena->AddBox(center, axisX, axisY, half);
+}
+
+/* Function: BuildScene
+ * Description: Sets the collision world of a scene and adds its bodies to a world
+ * Input: world - world receiving the bodies, usually empty
+ *		  scene - scene to build
+ * Output: number of vertices of the bodies added
+ */
+int BuildScene(simWorld *world, benchScene *scene)
+{
+	char filename[50];
+	point translate;
+	double random;
+	pModel *node;
+	int numVertices = 0;
+
+	BuildGeometry(world->arena, scene);
+
+	strncpy(filename, scene->file, sizeof(filename) - 1);
+	filename[sizeof(filename) - 1] = '\0';
+
+	srand(1);
+	for (int i = 0; i < scene->numBodies; i++)
+	{
+		translate = vMake(0.0);
+		if (scene->layout == LAYOUT_RANDOM)
+		{
+			random = (double)(rand() % (200 + 1));
+			random -= 100;
+			random /= 100;
+			translate.x = random;
+
+			random = (double)(rand() % (200 + 1));
+			random -= 100;
+			random /= 100;
+			translate.z = random;
+		}
+		else if (scene->layout == LAYOUT_STACK)
+		{
+			translate.x = (i % 2 == 0) ? -0.1 : 0.1;
+			translate.z = ((i / 2) % 2 == 0) ? -0.1 : 0.1;
+		} //end if
+		translate.y = scene->height + i * scene->spacing;
+
+		node = world->AddModel(filename, translate, scene->mode);
+		numVertices += node->pObj->numVertices;
+	} //end for
+
+	return numVertices;
+}
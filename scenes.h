@@ -0,0 +1,42 @@
+/* Header: scenes
+ * Description: Header file for the canonical scenes the headless tools build without a window: the
+ *				benchmark (simBench) and the golden trajectories (simGolden) step the same named scenes,
+ *				placed the same way every time.
+ */
+
+#ifndef _SCENES_H_
+#define _SCENES_H_
+
+#include "simulation.h"
+
+// Placement of the bodies of a scene
+#define LAYOUT_RANDOM 0				// Random x and z in [-1, 1] with a fixed seed, like the RANDOMPOS models of the GUI
+#define LAYOUT_DROP 1				// Every body above the center of the box
+#define LAYOUT_STACK 2				// Bodies piled up along y, shifted alternately along x and z
+
+// Collision geometry of a scene
+#define GEOMETRY_BOX 0				// The walls of the arena only
+#define GEOMETRY_RAMP 1				// The walls, a floor sloping down along x and a box turned about y on it
+
+// A named scene
+struct benchScene
+{
+	const char *name;
+	const char *file;				// Model file of every body
+	int numBodies;
+	int mode;						// Deformation mode of the bodies
+	int layout;						// LAYOUT_RANDOM, LAYOUT_DROP or LAYOUT_STACK
+	double height;					// Offset along y of the first body
+	double spacing;					// Offset along y between the bodies of a stack
+	double size;					// Half size of the arena
+	int geometry;					// GEOMETRY_BOX or GEOMETRY_RAMP
+	bool contact;					// Bodies touch each other, simGolden compares them one timestep at a time
+};
+
+extern benchScene benchScenes[];
+extern const int numBenchScenes;
+
+benchScene * FindScene(const char *name);
+int BuildScene(simWorld *world, benchScene *scene);
+
+#endif
@@ -0,0 +1,500 @@
+/* Source: shapeCache
+ * Description: Rest shapes shared by the bodies loaded from the same model file.
+ */
+
+#include "simulation.h"
+
+// Constructor
+shapeCache::shapeCache()
+{
+	binaryFiles = true;
+	restFiles = false;
+	numShapes = 0;
+	shapes = NULL;
+}
+
+// Destructor, the bodies of the shapes have to be deleted before
+shapeCache::~shapeCache()
+{
+	restShape *shape;
+
+	while (shapes != NULL)
+	{
+		shape = shapes;
+		shapes = shapes->next;
+		Delete(shape);
+	}
+}
+
+/* Function: Acquire
+ * Description: Finds the shape of a model file, loading it when no body uses it yet, and counts the new
+ *				body using it
+ * Input: filename - name of model input file
+ *		  world - world whose threads run the vertex loops of a new shape
+ * Output: The shape, to be given back with Release
+ */
+restShape * shapeCache::Acquire(char *filename, simWorld *world)
+{
+	restShape *shape;
+
+	for (shape = shapes; shape != NULL; shape = shape->next)
+		if (strcmp(shape->file, filename) == 0)
+		{
+			shape->refCount++;
+			return shape;
+		} //end if
+
+	shape = Build(filename, world);
+	shape->refCount = 1;
+	shape->cache = this;
+	shape->next = shapes;
+	shapes = shape;
+	numShapes++;
+
+	return shape;
+}
+
+/* Function: Release
+ * Description: A body stops using shape, which is freed with its last body
+ * Input: shape - shape given by Acquire
+ * Output: None
+ */
+void shapeCache::Release(restShape *shape)
+{
+	restShape **link;
+
+	if (--shape->refCount > 0)
+		return;
+
+	for (link = &shapes; *link != NULL; link = &(*link)->next)
+		if (*link == shape)
+		{
+			*link = shape->next;
+			numShapes--;
+			break;
+		} //end if
+	Delete(shape);
+}
+
+/* Function: RestHash
+ * Description: Hash (64 bit FNV-1a over 32 bit words) of everything the rest state is computed from:
+ *				the vertices and triangles of the mesh, and the mass adjustment of its vertex count
+ * Input: model - mesh
+ * Output: the hash
+ */
+static unsigned long long RestHash(GLMmodel *model)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	unsigned int word;
+	double adjust = adjustMass(model);
+
+#define RESTHASH(w)	hash = (hash ^ (w)) * 1099511628211ULL
+	RESTHASH(model->numvertices);
+	RESTHASH(model->numtriangles);
+	for (int k = 0; k < 2; k++)
+	{
+		memcpy(&word, (char *)&adjust + k * sizeof(word), sizeof(word));
+		RESTHASH(word);
+	}
+	for (unsigned int index = 3 * STARTFROM; index < 3 * (model->numvertices + 1); index++)
+	{
+		memcpy(&word, &model->vertices[index], sizeof(word));
+		RESTHASH(word);
+	}
+	for (unsigned int index = 0; index < model->numtriangles; index++)
+	{
+		RESTHASH(model->triangles[index].vindices[0]);
+		RESTHASH(model->triangles[index].vindices[1]);
+		RESTHASH(model->triangles[index].vindices[2]);
+	}
+#undef RESTHASH
+
+	return hash;
+}
+
+// First bytes of a rest file, followed by the arrays of the shape
+struct restFileHeader
+{
+	char magic[4];					// "REST"
+	int version;					// RESTVERSION
+	int sizes[4];					// sizeof(point), sizeof(matrix91), sizeof(bvhNode) and BVHLEAF,
+									// the file is only read back with the same layout
+	unsigned long long hash;		// RestHash of the mesh
+	int numVertices;
+	int numTriangles;
+	double surArea;
+	double totalMass;
+	point cmStable;
+	matrix33 Aqq;
+	matrix99 TAqq;
+	double mqStable[9];
+};
+
+// Writes count elements of size bytes
+static bool WriteArray(FILE *file, const void *data, size_t size, size_t count)
+{
+	return fwrite(data, size, count, file) == count;
+}
+
+// Reads count elements of size bytes
+static bool ReadArray(FILE *file, void *data, size_t size, size_t count)
+{
+	return fread(data, size, count, file) == count;
+}
+
+// Writes the rows of an adjacency
+static bool WriteAdjacency(FILE *file, GLMadjacency *adjacency)
+{
+	return WriteArray(file, adjacency->offset, sizeof(GLuint), adjacency->numvertices + 2) &&
+		WriteArray(file, adjacency->index, sizeof(GLuint), adjacency->offset[adjacency->numvertices + 1]);
+}
+
+// Reads the rows of an adjacency of numVertices vertices, with at most maxSize entries
+static GLMadjacency * ReadAdjacency(FILE *file, GLuint numVertices, unsigned long long maxSize)
+{
+	GLMadjacency *adjacency = (GLMadjacency *)malloc(sizeof(GLMadjacency));
+	GLuint size;
+
+	adjacency->numvertices = numVertices;
+	adjacency->offset = (GLuint *)malloc((numVertices + 2) * sizeof(GLuint));
+	adjacency->index = NULL;
+	if (ReadArray(file, adjacency->offset, sizeof(GLuint), numVertices + 2))
+	{
+		size = adjacency->offset[numVertices + 1];
+		adjacency->index = (GLuint *)malloc((size + 1) * sizeof(GLuint));
+		if (size <= maxSize && ReadArray(file, adjacency->index, sizeof(GLuint), size))
+			return adjacency;
+	} //end if
+
+	glmDeleteAdjacency(adjacency);
+	return NULL;
+}
+
+/* Function: Build
+ * Description: Loads a model file and its rest state, from the rest file next to it when that one was
+ *				made from the same mesh, or else by computing it (and writing the rest file)
+ * Input: filename - name of model input file
+ *		  world - world whose threads run the vertex loops
+ * Output: The shape, not counted by any body yet
+ */
+restShape * shapeCache::Build(char *filename, simWorld *world)
+{
+	restShape *shape;
+	GLMmodel *model;
+	char restFile[sizeof(shape->file) + sizeof(RESTSUFFIX)];
+	unsigned long long hash;
+	int numVertices;
+
+	shape = (restShape *)calloc(1, sizeof(restShape));
+	strcpy(shape->file, filename);
+	shape->model = binaryFiles ? glmReadOBJCached(filename) : glmReadOBJ(filename);
+	model = shape->model;
+	numVertices = model->numvertices;
+	shape->numVertices = numVertices;
+
+	soaInit(&shape->stable, numVertices);
+	soaInit(&shape->relStableLoc, numVertices);
+	shape->mass = soaAlloc(numVertices);
+	shape->triAreas = (double *)calloc(model->numtriangles, sizeof(double));
+	shape->q = (matrix91 *)calloc(numVertices, sizeof(matrix91));
+
+	for (int index = 0; index < numVertices; index++)
+	{
+		shape->stable.x[index] = model->vertices[3*(index+STARTFROM)];
+		shape->stable.y[index] = model->vertices[3*(index+STARTFROM)+1];
+		shape->stable.z[index] = model->vertices[3*(index+STARTFROM)+2];
+	}
+
+	if (!restFiles)
+	{
+		ComputeRest(shape, world);
+		return shape;
+	} //end if
+
+	sprintf(restFile, "%s%s", filename, RESTSUFFIX);
+	hash = RestHash(model);
+	if (!ReadRest(shape, restFile, hash))
+	{
+		ComputeRest(shape, world);
+		if (!WriteRest(shape, restFile, hash))
+			printf("Unable to write the rest state of %s to %s\n", filename, restFile);
+	} //end if
+
+	return shape;
+}
+
+/* Function: ComputeRest
+ * Description: Computes the rest state of a shape whose model and rest positions are loaded. It is
+ *				computed by the same functions as before the shapes were shared, on a body whose arrays
+ *				are the ones of the shape.
+ * Input: shape - shape
+ *		  world - world whose threads run the vertex loops
+ * Output: None
+ */
+void shapeCache::ComputeRest(restShape *shape, simWorld *world)
+{
+	GLMmodel *model = shape->model;
+	phyzx proto;
+	point v1, v2, v3;
+
+	shape->surArea = 0.0;
+	for (unsigned int index = 0; index < model->numtriangles; index++)
+	{
+		v1 = vMake(model->vertices[3*model->triangles[index].vindices[0]], model->vertices[3*model->triangles[index].vindices[0]+1], model->vertices[3*model->triangles[index].vindices[0]+2]);
+		v2 = vMake(model->vertices[3*model->triangles[index].vindices[1]], model->vertices[3*model->triangles[index].vindices[1]+1], model->vertices[3*model->triangles[index].vindices[1]+2]);
+		v3 = vMake(model->vertices[3*model->triangles[index].vindices[2]], model->vertices[3*model->triangles[index].vindices[2]+1], model->vertices[3*model->triangles[index].vindices[2]+2]);
+		shape->triAreas[index] = AreaOfTri(v1, v2, v3);
+		shape->surArea += shape->triAreas[index];
+	}
+	for (int index = 0; index < shape->numVertices; index++)
+		shape->mass[index] = 0.0;
+
+	shape->NBTStruct = glmBuildTriangleAdjacency(model);
+	shape->NBVStruct = glmBuildVertexAdjacency(model, shape->NBTStruct);
+
+	proto.model = model;
+	proto.numVertices = shape->numVertices;
+	proto.stable = shape->stable;
+	proto.position = shape->stable;
+	proto.mass = shape->mass;
+	proto.triAreas = shape->triAreas;
+	proto.surArea = shape->surArea;
+	proto.relStableLoc = shape->relStableLoc;
+	proto.q = shape->q;
+
+	compMass(shape->NBTStruct, &proto);
+	CalcCM(0, &proto, world);
+	CalcRelLoc(0, &proto);
+	CalcAqq(&proto);
+	calcTAqq(&proto);
+
+	shape->totalMass = proto.totalMass;
+	shape->cmStable = proto.cmStable;
+	matCopy33(proto.Aqq, &shape->Aqq);
+	shape->TAqq = proto.TAqq;
+	memcpy( (void*)shape->mqStable, proto.mqStable, sizeof(shape->mqStable));
+	shape->tree = BuildTriangleTree(&proto);
+	free(proto.chunkSums);
+}
+
+/* Function: ReadRest
+ * Description: Reads the rest state of a shape from a file written by WriteRest, if the file was
+ *				written for the same mesh and with the same layout
+ * Input: shape - shape whose model and rest positions are loaded
+ *		  filename - name of the rest file
+ *		  hash - RestHash of the mesh
+ * Output: true if the rest state was read
+ */
+bool shapeCache::ReadRest(restShape *shape, char *filename, unsigned long long hash)
+{
+	restFileHeader header;
+	int numVertices = shape->numVertices, numTriangles = shape->model->numtriangles;
+	bool valid;
+	FILE *file;
+
+	file = fopen(filename, "rb");
+	if (file == NULL)
+		return false;
+
+	valid = ReadArray(file, &header, sizeof(header), 1) && memcmp(header.magic, "REST", 4) == 0 &&
+		header.version == RESTVERSION && header.sizes[0] == sizeof(point) && header.sizes[1] == sizeof(matrix91) &&
+		header.sizes[2] == sizeof(bvhNode) && header.sizes[3] == BVHLEAF && header.hash == hash &&
+		header.numVertices == numVertices && header.numTriangles == numTriangles;
+
+	valid = valid && ReadArray(file, shape->triAreas, sizeof(double), numTriangles) &&
+		ReadArray(file, shape->mass, sizeof(double), numVertices) &&
+		ReadArray(file, shape->relStableLoc.x, sizeof(double), numVertices) &&
+		ReadArray(file, shape->relStableLoc.y, sizeof(double), numVertices) &&
+		ReadArray(file, shape->relStableLoc.z, sizeof(double), numVertices) &&
+		ReadArray(file, shape->q, sizeof(matrix91), numVertices);
+	if (valid)
+		valid = (shape->NBTStruct = ReadAdjacency(file, numVertices, 3ULL * numTriangles)) != NULL;
+	if (valid)
+		valid = (shape->NBVStruct = ReadAdjacency(file, numVertices, 6ULL * numTriangles)) != NULL;
+	if (valid)
+		valid = (shape->tree = bvh::Read(file, numTriangles)) != NULL;
+	fclose(file);
+
+	if (!valid)
+	{
+		glmDeleteAdjacency(shape->NBTStruct);
+		glmDeleteAdjacency(shape->NBVStruct);
+		shape->NBTStruct = shape->NBVStruct = NULL;
+		return false;
+	} //end if
+
+	shape->surArea = header.surArea;
+	shape->totalMass = header.totalMass;
+	shape->cmStable = header.cmStable;
+	matCopy33(header.Aqq, &shape->Aqq);
+	shape->TAqq = header.TAqq;
+	memcpy( (void*)shape->mqStable, header.mqStable, sizeof(shape->mqStable));
+
+	return true;
+}
+
+/* Function: WriteRest
+ * Description: Writes the rest state of a shape, to be read back by ReadRest
+ * Input: shape - shape whose rest state is computed
+ *		  filename - name of the rest file
+ *		  hash - RestHash of the mesh
+ * Output: true if the whole file was written
+ */
+bool shapeCache::WriteRest(restShape *shape, char *filename, unsigned long long hash)
+{
+	restFileHeader header;
+	int numVertices = shape->numVertices, numTriangles = shape->model->numtriangles;
+	bool written;
+	FILE *file;
+
+	memset( (void*)&header, 0, sizeof(header));
+	memcpy(header.magic, "REST", 4);
+	header.version = RESTVERSION;
+	header.sizes[0] = sizeof(point);
+	header.sizes[1] = sizeof(matrix91);
+	header.sizes[2] = sizeof(bvhNode);
+	header.sizes[3] = BVHLEAF;
+	header.hash = hash;
+	header.numVertices = numVertices;
+	header.numTriangles = numTriangles;
+	header.surArea = shape->surArea;
+	header.totalMass = shape->totalMass;
+	header.cmStable = shape->cmStable;
+	matCopy33(shape->Aqq, &header.Aqq);
+	header.TAqq = shape->TAqq;
+	memcpy( (void*)header.mqStable, shape->mqStable, sizeof(header.mqStable));
+
+	file = fopen(filename, "wb");
+	if (file == NULL)
+		return false;
+
+	written = WriteArray(file, &header, sizeof(header), 1) &&
+		WriteArray(file, shape->triAreas, sizeof(double), numTriangles) &&
+		WriteArray(file, shape->mass, sizeof(double), numVertices) &&
+		WriteArray(file, shape->relStableLoc.x, sizeof(double), numVertices) &&
+		WriteArray(file, shape->relStableLoc.y, sizeof(double), numVertices) &&
+		WriteArray(file, shape->relStableLoc.z, sizeof(double), numVertices) &&
+		WriteArray(file, shape->q, sizeof(matrix91), numVertices) &&
+		WriteAdjacency(file, shape->NBTStruct) &&
+		WriteAdjacency(file, shape->NBVStruct) &&
+		shape->tree->Write(file);
+	written = (fclose(file) == 0) && written;
+
+	return written;
+}
+
+/* Function: Delete
+ * Description: Frees a shape together with its model and textures
+ * Input: shape - shape no body uses any more
+ * Output: None
+ */
+void shapeCache::Delete(restShape *shape)
+{
+	restTexture *texture;
+
+	while (shape->textures != NULL)
+	{
+		texture = shape->textures;
+		shape->textures = texture->next;
+#ifndef HEADLESS
+		glDeleteTextures(1, &texture->name);
+#endif
+		free(texture->data);
+		free(texture);
+	}
+
+	glmDeleteAdjacency(shape->NBVStruct);
+	glmDeleteAdjacency(shape->NBTStruct);
+	soaFree(&shape->stable);
+	soaFree(&shape->relStableLoc);
+	soaRelease(shape->mass);
+	free(shape->triAreas);
+	free(shape->q);
+	delete shape->tree;
+	glmDelete(shape->model);
+	free(shape);
+}
+
+/* Function: InstanceModel
+ * Description: Model of a new body of shape. The body gets its own vertices, which it is drawn with,
+ *				and its own materials, which it is textured with; everything else is the shape model.
+ * Input: shape - shape of the body
+ * Output: The model, freed with DeleteInstanceModel
+ */
+GLMmodel * InstanceModel(restShape *shape)
+{
+	GLMmodel *model = (GLMmodel *)malloc(sizeof(GLMmodel));
+	int size = 3 * (shape->model->numvertices + 1) * sizeof(GLfloat);
+
+	*model = *shape->model;
+	model->vertices = (GLfloat *)malloc(size);
+	memcpy( (void*)model->vertices, shape->model->vertices, size);
+	model->verticesRest = (GLfloat *)malloc(size);
+	memcpy( (void*)model->verticesRest, shape->model->verticesRest, size);
+	model->materials = (GLMmaterial *)malloc(shape->model->nummaterials * sizeof(GLMmaterial));
+	memcpy( (void*)model->materials, shape->model->materials, shape->model->nummaterials * sizeof(GLMmaterial));
+
+	return model;
+}
+
+/* Function: DeleteInstanceModel
+ * Description: Frees the model of a body, leaving the parts it shares with its shape
+ * Input: model - model given by InstanceModel
+ * Output: None
+ */
+void DeleteInstanceModel(GLMmodel *model)
+{
+	free(model->vertices);
+	free(model->verticesRest);
+	free(model->materials);
+	free(model);
+}
+
+#ifndef HEADLESS
+/* Function: ShapeTexture
+ * Description: Textures a material of a body with an image file. Every image is read and uploaded once
+ *				for the bodies of a shape, through glmSetUpTextures on a model holding only that material.
+ * Input: model - model of the body, given by InstanceModel
+ *		  shape - shape of the body
+ *		  material - material of the model drawn with the texture
+ *		  textureFile - image file, in the folder of the model file
+ *		  mode - texture mode of glmSetUpTextures
+ * Output: None
+ */
+void ShapeTexture(GLMmodel *model, restShape *shape, int material, char *textureFile, int mode)
+{
+	restTexture *texture;
+	GLMmaterial loaded;
+	GLMmodel loader;
+
+	for (texture = shape->textures; texture != NULL; texture = texture->next)
+		if (texture->material == material && strcmp(texture->file, textureFile) == 0)
+			break;
+
+	if (texture == NULL)
+	{
+		loaded = shape->model->materials[material];
+		loaded.textureFile = textureFile;
+		loaded.textureData = NULL;
+		loaded.textureName = 0;
+		loader = *shape->model;
+		loader.nummaterials = 1;
+		loader.materials = &loaded;
+		if (glmSetUpTextures(&loader, mode) != 0)
+			return;
+
+		texture = (restTexture *)malloc(sizeof(restTexture));
+		texture->material = material;
+		strcpy(texture->file, textureFile);
+		texture->name = loaded.textureName;
+		texture->data = loaded.textureData;
+		texture->textureMode = loader.textureMode;
+		texture->next = shape->textures;
+		shape->textures = texture;
+	} //end if
+
+	model->materials[material].textureName = texture->name;
+	model->materials[material].textureData = texture->data;
+	model->textureMode = texture->textureMode;
+}
+#endif
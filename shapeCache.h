@@ -0,0 +1,90 @@
+/* Header: shapeCache
+ * Description: Header file for the rest shapes shared by the bodies loaded from the same model file.
+ *				Everything a body derives from its file before the first timestep - the mesh with its
+ *				topology and texture coordinates, the vertex masses, the rest positions relative to the
+ *				center of mass, the inverses of Aqq and of the quadratic TAqq, the quadratic coordinates
+ *				q and the triangle tree - is the same for every body of the file. It is computed once
+ *				into a restShape, which is never changed after that, and counted by the bodies using it.
+ *				A new body of a loaded file only allocates its own mutable state.
+ *				With restFiles set, the rest state is also kept in a file next to the model file (model
+ *				file + RESTSUFFIX), checked against a hash of the mesh it was computed from, so that loading
+ *				a large model again only reads it instead of computing it.
+ */
+
+#ifndef _SHAPECACHE_H_
+#define _SHAPECACHE_H_
+
+#include "physics.h"
+
+#define RESTVERSION 1				// Version of the rest files, changed with their layout or with the rest state computation
+#define RESTSUFFIX ".rest"			// Appended to the model file name to make the rest file name
+
+class shapeCache;
+
+// Texture loaded for the bodies of a shape, shared by all of them
+struct restTexture
+{
+	int material;					// Material of the shape model the texture is drawn with
+	char file[50];					// Texture file, in the folder of the model file
+	GLuint name;					// OpenGL texture object
+	GLubyte *data;					// Texture image
+	GLuint textureMode;				// GLMmodel::textureMode given to the bodies drawn with it
+	struct restTexture *next;
+};
+
+// Immutable rest state of one model file
+struct restShape
+{
+	char file[50];					// Model file, the key of the shape
+	int refCount;					// Bodies using the shape
+	shapeCache *cache;				// Cache the shape is released to
+	GLMmodel *model;				// Mesh as loaded, the bodies only copy its vertices
+	int numVertices;
+	soaVec stable;					// Rest positions
+	double *mass;					// Masses of each vertex
+	double totalMass;
+	double *triAreas;				// Areas of all the triangles
+	double surArea;
+	GLMadjacency *NBTStruct;		// Triangles of every vertex
+	GLMadjacency *NBVStruct;		// Adjacent vertices of every vertex
+	point cmStable;					// Center of mass of the rest positions
+	soaVec relStableLoc;			// Rest positions relative to cmStable
+	matrix33 Aqq;					// Inverse of Summation(m * (q x qT))
+	matrix99 TAqq;					// Inverse of the quadratic Summation(m * (q x qT))
+	double mqStable[9];				// Summation(m * q) of the quadratic rest coordinates
+	matrix91 *q;					// Quadratic rest coordinates of each vertex
+	bvh *tree;						// Triangle tree around the rest positions, copied by every body
+	restTexture *textures;			// Textures loaded for the bodies of the shape
+	struct restShape *next;
+};
+
+class shapeCache
+{
+public:
+		shapeCache();
+		~shapeCache();
+
+		restShape * Acquire(char *filename, simWorld *world);
+		void Release(restShape *shape);
+
+		bool binaryFiles;				// Meshes are mapped from and written to binary files (true) or always parsed
+		bool restFiles;					// Rest states are read from and written to rest files (true) or always computed (false, default)
+		int numShapes;					// Number of shapes in the cache
+
+protected:
+		restShape * Build(char *filename, simWorld *world);
+		void ComputeRest(restShape *shape, simWorld *world);
+		bool ReadRest(restShape *shape, char *filename, unsigned long long hash);
+		bool WriteRest(restShape *shape, char *filename, unsigned long long hash);
+		void Delete(restShape *shape);
+
+		restShape *shapes;				// Loaded shapes, used by at least one body
+};
+
+GLMmodel * InstanceModel(restShape *shape);
+void DeleteInstanceModel(GLMmodel *model);
+#ifndef HEADLESS
+void ShapeTexture(GLMmodel *model, restShape *shape, int material, char *textureFile, int mode);
+#endif
+
+#endif
@@ -0,0 +1,230 @@
+/* Source: simBench
+ * Description: Headless benchmark of the simulation. Builds named scenes without a window, steps each of
+ *				them a fixed number of timesteps and reports the timesteps per second, the nanoseconds
+ *				spent per vertex and timestep in every phase and the peak resident memory, on the console
+ *				and in a JSON or CSV file to track regressions.
+ *				Usage: simBench [scene name, all (default) or list] [number of steps, default 200]
+ *				[fused step, default 0] [number of threads, default 1, 0 for one per hardware thread]
+ *				[results file, .json or .csv, default none]
+ *				[instruction set: 0 scalar, 1 SSE2, 2 AVX2, 3 AVX-512, default best available, lowered to what the CPU supports]
+ *				[rest files: 1 reads and writes the rest state in model file + .rest, default 0]
+ */
+
+#include "scenes.h"
+#include "performanceCounter.h"
+
+#ifdef WIN32
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+#define BENCHWARMUP 20				// Timesteps run before measuring, not counted
+
+// Results of a scene
+struct benchResult
+{
+	benchScene *scene;
+	int numVertices;				// Vertices of all the bodies
+	int numSteps;
+	double seconds;					// Time of the measured timesteps
+	double nsPerVertex[NUMPHASES];	// Nanoseconds per vertex and timestep spent in every phase
+	long peakKB;					// Peak resident memory of the process after the scene
+};
+
+/* Function: peakMemory
+ * Description: Peak resident memory of the process so far
+ * Input: None
+ * Output: kilobytes, 0 if unknown
+ */
+static long peakMemory()
+{
+#ifdef WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+  #ifdef __APPLE__
+	return usage.ru_maxrss / 1024;
+  #else
+	return usage.ru_maxrss;
+  #endif
+#endif
+}
+
+/* Function: runScene
+ * Description: Builds a scene in a new world, steps it BENCHWARMUP timesteps, then measures numSteps timesteps
+ * Input: scene - scene to run
+ *		  numSteps - measured timesteps
+ *		  fused - step the bodies with FusedStep
+ *		  numThreads - threads of the world
+ *		  simdLevel - instruction set of FusedStep
+ *		  restFiles - read and write the rest states in rest files
+ * Output: result - results of the scene
+ */
+static void runScene(benchScene *scene, int numSteps, bool fused, int numThreads, int simdLevel, bool restFiles, benchResult *result)
+{
+	simWorld *world = new simWorld();
+	PerformanceCounter counter;
+
+	world->fusedStep = fused;
+	world->simdLevel = simdLevel;
+	world->SetThreads(numThreads);
+	world->SetProfiling(true);
+	world->shapes->restFiles = restFiles;
+
+	memset( (void*)result, 0, sizeof(benchResult));
+	result->scene = scene;
+	result->numSteps = numSteps;
+	result->numVertices = BuildScene(world, scene);
+
+	world->step(BENCHWARMUP);
+	world->profiler->Reset();
+
+	counter.StartCounter();
+	world->step(numSteps);
+	counter.StopCounter();
+
+	result->seconds = counter.GetElapsedTime();
+	for (int phase = 0; phase < NUMPHASES; phase++)
+		result->nsPerVertex[phase] = 1e9 * world->profiler->Total(phase) / ((double)numSteps * result->numVertices);
+	delete world;
+	result->peakKB = peakMemory();
+}
+
+/* Function: writeResults
+ * Description: Writes the results of the scenes run, as JSON if the name ends in .json and as CSV otherwise
+ * Input: filename - results file
+ *		  results - results of the scenes
+ *		  numResults - number of scenes
+ *		  fused, numThreads, simdLevel - settings the scenes were run with
+ * Output: true if the file was written
+ */
+static bool writeResults(const char *filename, benchResult *results, int numResults, bool fused, int numThreads, int simdLevel)
+{
+	FILE *file = fopen(filename, "w");
+	size_t len = strlen(filename);
+	benchResult *result;
+
+	if (file == NULL)
+		return false;
+
+	if (len > 5 && strcmp(filename + len - 5, ".json") == 0)
+	{
+		fprintf(file, "{\n  \"fused\": %s,\n  \"simd\": \"%s\",\n  \"threads\": %d,\n  \"warmup\": %d,\n  \"scenes\": [",
+			fused ? "true" : "false", fused ? simdName(simdLevel) : "none", numThreads, BENCHWARMUP);
+		for (int i = 0; i < numResults; i++)
+		{
+			result = &results[i];
+			fprintf(file, "%s\n    {\"name\": \"%s\", \"file\": \"%s\", \"bodies\": %d, \"mode\": %d, \"vertices\": %d, \"steps\": %d, "
+				"\"seconds\": %.6f, \"steps_per_s\": %.3f, \"peak_rss_kb\": %ld, \"ns_per_vertex_step\": {",
+				(i > 0) ? "," : "", result->scene->name, result->scene->file, result->scene->numBodies, result->scene->mode,
+				result->numVertices, result->numSteps, result->seconds, result->numSteps / result->seconds, result->peakKB);
+			for (int phase = 0; phase < NUMPHASES; phase++)
+				fprintf(file, "%s\"%s\": %.3f", (phase > 0) ? ", " : "", phaseNames[phase], result->nsPerVertex[phase]);
+			fprintf(file, "}}");
+		} //end for
+		fprintf(file, "\n  ]\n}\n");
+	}
+	else
+	{
+		fprintf(file, "scene,file,bodies,mode,vertices,fused,simd,threads,steps,seconds,steps_per_s,peak_rss_kb");
+		for (int phase = 0; phase < NUMPHASES; phase++)
+			fprintf(file, ",%s_ns", phaseNames[phase]);
+		fprintf(file, "\n");
+		for (int i = 0; i < numResults; i++)
+		{
+			result = &results[i];
+			fprintf(file, "%s,%s,%d,%d,%d,%d,%s,%d,%d,%.6f,%.3f,%ld", result->scene->name, result->scene->file,
+				result->scene->numBodies, result->scene->mode, result->numVertices, fused ? 1 : 0,
+				fused ? simdName(simdLevel) : "none", numThreads, result->numSteps, result->seconds,
+				result->numSteps / result->seconds, result->peakKB);
+			for (int phase = 0; phase < NUMPHASES; phase++)
+				fprintf(file, ",%.3f", result->nsPerVertex[phase]);
+			fprintf(file, "\n");
+		} //end for
+	} //end if
+
+	return (fclose(file) == 0);
+}
+
+/* Main Loop */
+int main(int argc, char** argv)
+{
+	const char *sceneName = "all";
+	int numSteps = 200;
+	bool fused = false;
+	int numThreads = 1;
+	int simdLevel = simdDetect();
+	bool restFiles = false;
+	char *resultsName = NULL;
+	benchResult *results;
+	benchResult *result;
+	int numResults = 0;
+
+	if (argc > 1)
+		sceneName = argv[1];
+	if (argc > 2)
+		numSteps = atoi(argv[2]);
+	if (argc > 3)
+		fused = (atoi(argv[3]) != 0);
+	if (argc > 4)
+		numThreads = (atoi(argv[4]) > 0) ? atoi(argv[4]) : threadPool::hardwareThreads();
+	if (argc > 5 && strcmp(argv[5], "-") != 0)
+		resultsName = argv[5];
+	if (argc > 6)
+		simdLevel = simdClamp(atoi(argv[6]));
+	if (argc > 7)
+		restFiles = (atoi(argv[7]) != 0);
+	if (numSteps < 1)
+		numSteps = 1;
+
+	if (strcmp(sceneName, "list") == 0)
+	{
+		for (int i = 0; i < numBenchScenes; i++)
+			printf("%s: %d x %s, deformation mode %d, arena of half size %g%s\n", benchScenes[i].name, benchScenes[i].numBodies,
+				benchScenes[i].file, benchScenes[i].mode, benchScenes[i].size, (benchScenes[i].geometry == GEOMETRY_RAMP) ? " with a ramp and a box" : "");
+		return 0;
+	} //end if
+
+	printf("%d steps, %s, %d threads\n", numSteps, fused ? simdName(simdLevel) : "separate passes", numThreads);
+	results = (benchResult *)calloc(numBenchScenes, sizeof(benchResult));
+	for (int i = 0; i < numBenchScenes; i++)
+	{
+		if (strcmp(sceneName, "all") != 0 && strcmp(sceneName, benchScenes[i].name) != 0)
+			continue;
+
+		result = &results[numResults++];
+		runScene(&benchScenes[i], numSteps, fused, numThreads, simdLevel, restFiles, result);
+
+		printf("%-10s %6d vertices %10.2f steps/s %8ld KB peak, ns/vertex/step:", result->scene->name, result->numVertices,
+			result->numSteps / result->seconds, result->peakKB);
+		for (int phase = 0; phase < NUMPHASES; phase++)
+			printf(" %s %.1f", phaseNames[phase], result->nsPerVertex[phase]);
+		printf("\n");
+	} //end for
+
+	if (numResults == 0)
+	{
+		printf("No scene named %s, simBench list shows the scenes\n", sceneName);
+		free(results);
+		return 1;
+	} //end if
+
+	if (resultsName != NULL && !writeResults(resultsName, results, numResults, fused, numThreads, simdLevel))
+	{
+		printf("Cannot write the results to %s\n", resultsName);
+		free(results);
+		return 1;
+	} //end if
+
+	free(results);
+	return 0;
+}
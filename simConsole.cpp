@@ -0,0 +1,136 @@
+/* Source: simConsole
+ * Description: Console driver that steps the simulation world without opening a window.
+ *				Usage: simConsole [object file] [number of bodies] [number of steps] [deformation mode] [fused step]
+ *				[instruction set: 0 scalar, 1 SSE2, 2 AVX2, 3 AVX-512, default best available, lowered to what the CPU supports]
+ *				[number of threads, default 1, 0 for one per hardware thread]
+ *				[rotation: 0 polar decomposition, 1 iterative (default)]
+ *				[frame cache file recording every timestep, default or - for none]
+ *				[export policy of the frame cache writer: 0 block (default), 1 drop, 2 grow]
+ *				[file the times of the phases are written to, .json or .csv, default none]
+ *				[half size of the arena, default 2]
+ *				[rest files: 1 reads and writes the rest state in model file + .rest, default 0]
+ */
+
+#include "simulation.h"
+#include "frameCache.h"
+#include "performanceCounter.h"
+
+/* Main Loop */
+int main(int argc, char** argv)
+{
+	char filename[50] = "crate.obj";
+	int numBodies = 2;
+	int numSteps = 1000;
+	int mode = 0;
+	double random = 0;
+	point translate;
+	simWorld world;
+	exportWriter writer(EXPORTSLOTS, EXPORTBLOCK);
+	frameCache cache;
+	char *cacheName = NULL, *timingName = NULL;
+	PerformanceCounter counter;
+	size_t len;
+	bool written;
+
+	if (argc > 1)
+		strncpy(filename, argv[1], sizeof(filename) - 1);
+	if (argc > 2)
+		numBodies = atoi(argv[2]);
+	if (argc > 3)
+		numSteps = atoi(argv[3]);
+	if (argc > 4)
+		mode = atoi(argv[4]);
+	if (argc > 5)
+		world.fusedStep = (atoi(argv[5]) != 0);
+	if (argc > 6)
+		world.simdLevel = simdClamp(atoi(argv[6]));
+	if (argc > 7)
+		world.SetThreads(atoi(argv[7]) > 0 ? atoi(argv[7]) : threadPool::hardwareThreads());
+	if (argc > 8)
+		world.rotationMode = (atoi(argv[8]) == ROTATION_POLAR) ? ROTATION_POLAR : ROTATION_ITERATIVE;
+	if (argc > 9 && strcmp(argv[9], "-") != 0)
+		cacheName = argv[9];
+	if (argc > 10)
+		writer.policy = atoi(argv[10]);
+	if (argc > 11 && strcmp(argv[11], "-") != 0)
+		timingName = argv[11];
+	if (argc > 12 && atof(argv[12]) > 0.0)
+		world.arena->SetArena(atof(argv[12]));
+	if (argc > 13)
+		world.shapes->restFiles = (atoi(argv[13]) != 0);
+	world.SetProfiling(timingName != NULL);
+
+	// Same placement as the RANDOMPOS models of the GUI, with a fixed seed
+	srand(1);
+	for (int i = 0; i < numBodies; i++)
+	{
+		random = (double)(rand() % (200 + 1));
+		random -= 100;
+		random /= 100;
+		translate.x = random;
+
+		translate.y = 0.0f;
+
+		random = (double)(rand() % (200 + 1));
+		random -= 100;
+		random /= 100;
+		translate.z = random;
+
+		world.AddModel(filename, translate, mode);
+	} //end for
+
+	if (cacheName != NULL && !cache.Create(cacheName, &writer))
+	{
+		printf("Cannot write the frame cache %s\n", cacheName);
+		return 1;
+	} //end if
+
+	counter.StartCounter();
+	if (cacheName == NULL)
+		world.step(numSteps);
+	else
+	{
+		for (int i = 0; i < numSteps; i++)
+		{
+			world.step(1);
+			world.WriteRenderPositions();
+			if (!cache.WriteFrame(&world, world.time))
+			{
+				printf("Cannot write frame %d to the frame cache %s\n", i, cacheName);
+				return 1;
+			} //end if
+		}
+	} //end if
+	counter.StopCounter();
+
+	printf("%d bodies, %d steps in %lf s (%lf steps/s)\n", numBodies, numSteps,
+		counter.GetElapsedTime(), numSteps / counter.GetElapsedTime());
+	if (world.fusedStep)
+		printf("fused step kernels: %s\n", simdName(world.simdLevel));
+	printf("threads: %d\n", world.pool->NumThreads());
+	if (cacheName != NULL)
+	{
+		printf("frame cache: %d frames, %.1f MB\n", cache.numFrames, cache.numBytes / 1e6);
+		if (!cache.Close())
+			printf("Cannot finish the frame cache %s\n", cacheName);
+		writer.PrintStats("frame cache writer");
+	} //end if
+
+	if (timingName != NULL)
+	{
+		world.profiler->PrintSummary(&world);
+		len = strlen(timingName);
+		if (len > 5 && strcmp(timingName + len - 5, ".json") == 0)
+			written = world.profiler->WriteJSON(timingName, &world);
+		else
+			written = world.profiler->WriteCSV(timingName, &world);
+		if (!written)
+			printf("Cannot write the phase times to %s\n", timingName);
+	} //end if
+
+	for (pModel *temp = world.models; temp->next != NULL; temp = temp->next)
+		printf("model %d: center (%lf, %lf, %lf) radius %lf\n", temp->mIndex,
+			temp->cModel.x, temp->cModel.y, temp->cModel.z, temp->radius);
+
+	return 0;
+}
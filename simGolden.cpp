@@ -0,0 +1,441 @@
+/* Source: simGolden
+ * Description: Golden trajectory harness. Records the trajectories of the canonical scenes stepped by the
+ *				reference implementation (separate passes, scalar, one thread), then steps the scenes again
+ *				with the optimized variants and reports how far every sample moves away from the recording.
+ *				Usage: simGolden record [scene name or all (default)] [number of steps, default 400] [steps between samples, default 10]
+ *				       simGolden compare [scene name or all (default)] [variant name or all (default)]
+ *				       [center of mass tolerance] [rotation tolerance] [vertex tolerance] [CSV file of every sample, default none]
+ *				       simGolden list
+ *				The trajectories are kept in scene + TRAJECTORYSUFFIX files in the current folder. compare exits
+ *				with 1 when a variant goes past a tolerance. In the scenes whose bodies touch, the contacts
+ *				amplify the rounding differences of the variants within a few timesteps, so there compare
+ *				restarts the variant from the state of the reference at every sample and checks the one
+ *				timestep that follows, while the reference itself is checked against the recording.
+ */
+
+#include "scenes.h"
+#include "trajectory.h"
+
+// Default tolerances of compare
+#define GOLDENCMTOLERANCE 1.0e-6
+#define GOLDENROTATIONTOLERANCE 1.0e-5
+#define GOLDENVERTEXTOLERANCE 1.0e-5
+
+// One way of stepping the scenes
+struct goldenVariant
+{
+	const char *name;
+	bool fused;						// FusedStep instead of the separate passes
+	int simdLevel;					// Instruction set of FusedStep, -1 for the best available
+	int numThreads;
+	int rotationMode;				// ROTATION_POLAR or ROTATION_ITERATIVE
+	bool float32;					// Positions and velocities rounded to float after every timestep
+};
+
+static goldenVariant variants[] =
+{
+	{"reference", false, SIMD_SCALAR, 1, ROTATION_ITERATIVE, false},
+	{"fused-scalar", true, SIMD_SCALAR, 1, ROTATION_ITERATIVE, false},
+	{"fused-sse2", true, SIMD_SSE2, 1, ROTATION_ITERATIVE, false},
+	{"fused-avx2", true, SIMD_AVX2, 1, ROTATION_ITERATIVE, false},
+	{"fused-avx512", true, SIMD_AVX512, 1, ROTATION_ITERATIVE, false},
+	{"threads4", false, SIMD_SCALAR, 4, ROTATION_ITERATIVE, false},
+	{"fused-threads4", true, -1, 4, ROTATION_ITERATIVE, false},
+	{"polar", false, SIMD_SCALAR, 1, ROTATION_POLAR, false},
+	{"float32", false, SIMD_SCALAR, 1, ROTATION_ITERATIVE, true},
+};
+#define NUMVARIANTS (int)(sizeof(variants) / sizeof(variants[0]))
+
+/* Function: variantAvailable
+ * Description: Tells whether the instruction set of a variant is compiled in and supported by the CPU
+ * Input: variant - variant to run
+ * Output: true if it runs as named
+ */
+static bool variantAvailable(goldenVariant *variant)
+{
+	return variant->simdLevel < 0 || (variant->simdLevel <= simdDetect() && simdClamp(variant->simdLevel) == variant->simdLevel);
+}
+
+/* Function: roundToFloat
+ * Description: Rounds the positions and velocities of every body to float, as if they were stored in float
+ * Input: world - world whose bodies are rounded
+ * Output: None
+ */
+static void roundToFloat(simWorld *world)
+{
+	phyzx *phyzxObj;
+
+	for (pModel *temp = world->models; temp->next != NULL; temp = temp->next)
+	{
+		phyzxObj = temp->pObj;
+		for (int index = 0; index < phyzxObj->numVertices; index++)
+		{
+			phyzxObj->position.x[index] = (float)phyzxObj->position.x[index];
+			phyzxObj->position.y[index] = (float)phyzxObj->position.y[index];
+			phyzxObj->position.z[index] = (float)phyzxObj->position.z[index];
+			phyzxObj->velocity.x[index] = (float)phyzxObj->velocity.x[index];
+			phyzxObj->velocity.y[index] = (float)phyzxObj->velocity.y[index];
+			phyzxObj->velocity.z[index] = (float)phyzxObj->velocity.z[index];
+		} //end for
+	} //end for
+}
+
+/* Function: copySoa
+ * Description: Copies the first size vectors of a structure of arrays into another
+ * Input: to - vectors receiving the copy
+ *		  from - vectors copied
+ *		  size - number of vectors
+ * Output: None
+ */
+static void copySoa(soaVec to, soaVec from, int size)
+{
+	memcpy(to.x, from.x, size * sizeof(double));
+	memcpy(to.y, from.y, size * sizeof(double));
+	memcpy(to.z, from.z, size * sizeof(double));
+}
+
+/* Function: copyWorldState
+ * Description: Gives the bodies of a world the state of the same bodies in another world built from the
+ *				same scene, so that both continue from the same start. This is everything a timestep
+ *				reads that the previous ones wrote, the rest shapes are the same in both worlds.
+ * Input: to - world receiving the state
+ *		  from - world whose state is copied
+ * Output: None
+ */
+static void copyWorldState(simWorld *to, simWorld *from)
+{
+	pModel *dst = to->models;
+	phyzx *a, *b;
+
+	for (pModel *src = from->models; src->next != NULL; src = src->next, dst = dst->next)
+	{
+		a = dst->pObj;
+		b = src->pObj;
+		copySoa(a->position, b->position, b->numVertices);
+		copySoa(a->goal, b->goal, b->numVertices);
+		copySoa(a->velocity, b->velocity, b->numVertices);
+		copySoa(a->extForce, b->extForce, b->numVertices);
+		copySoa(a->relDeformedLoc, b->relDeformedLoc, b->numVertices);
+		copySoa(a->restStart, b->restStart, b->numVertices);
+		a->cmDeformed = b->cmDeformed;
+		a->avgVel = b->avgVel;
+		a->sleeping = b->sleeping;
+		a->restSteps = b->restSteps;
+		memcpy(a->Apq, b->Apq, sizeof(matrix33));
+		memcpy(a->R, b->R, sizeof(matrix33));
+		memcpy(a->rotQuat, b->rotQuat, sizeof(a->rotQuat));
+		a->TApq = b->TApq;
+		delete a->tree;
+		a->tree = new bvh(b->tree);
+		dst->cModel = src->cModel;
+		dst->radius = src->radius;
+	} //end for
+
+	to->time = from->time;
+	to->objCollide = from->objCollide;
+}
+
+/* Function: variantWorld
+ * Description: Builds a scene in a new world set up to be stepped by a variant
+ * Input: scene - scene to build
+ *		  variant - how to step it
+ * Output: the world
+ */
+static simWorld * variantWorld(benchScene *scene, goldenVariant *variant)
+{
+	simWorld *world = new simWorld();
+
+	world->fusedStep = variant->fused;
+	world->simdLevel = (variant->simdLevel < 0) ? simdDetect() : variant->simdLevel;
+	world->SetThreads(variant->numThreads);
+	world->rotationMode = variant->rotationMode;
+	BuildScene(world, scene);
+	return world;
+}
+
+/* Function: runVariant
+ * Description: Builds a scene in a new world and records its trajectory stepped by a variant
+ * Input: scene - scene to step
+ *		  variant - how to step it
+ *		  numSteps - timesteps to perform
+ *		  every - timesteps between two samples
+ * Output: result - trajectory recorded
+ */
+static void runVariant(benchScene *scene, goldenVariant *variant, int numSteps, int every, trajectory *result)
+{
+	simWorld *world = variantWorld(scene, variant);
+
+	result->Start(world, scene->name, every);
+	for (int step = 1; step <= numSteps; step++)
+	{
+		world->step(1);
+		if (variant->float32)
+			roundToFloat(world);
+		if (step % result->every == 0)
+			result->Record(world, step);
+	} //end for
+
+	delete world;
+}
+
+/* Function: runRestarted
+ * Description: Steps a scene with the reference variant and records its trajectory. Before every sample,
+ *				a second world stepped by the variant is given the state of the reference and both perform
+ *				the same timestep, so that each sample of the variant is one timestep away from the
+ *				reference instead of the whole trajectory.
+ * Input: scene - scene to step
+ *		  variant - how to step the sampled timesteps
+ *		  numSteps - timesteps to perform
+ *		  every - timesteps between two samples
+ * Output: reference - trajectory of the reference
+ *		   result - trajectory of the variant, sampled at the same timesteps
+ */
+static void runRestarted(benchScene *scene, goldenVariant *variant, int numSteps, int every, trajectory *reference, trajectory *result)
+{
+	simWorld *refWorld = variantWorld(scene, &variants[0]);
+	simWorld *world = variantWorld(scene, variant);
+
+	reference->Start(refWorld, scene->name, every);
+	result->Start(world, scene->name, every);
+	for (int step = 1; step <= numSteps; step++)
+	{
+		if (step % every == 0)
+		{
+			copyWorldState(world, refWorld);
+			world->step(1);
+			if (variant->float32)
+				roundToFloat(world);
+			result->Record(world, step);
+		} //end if
+
+		refWorld->step(1);
+		if (step % every == 0)
+			reference->Record(refWorld, step);
+	} //end for
+
+	delete world;
+	delete refWorld;
+}
+
+/* Function: withinTolerance
+ * Description: Tells whether a divergence stays within the tolerances
+ * Input: divergence - distances between two samples
+ *		  tolerance - tolerances of the center of mass, rotation and vertex distances
+ * Output: true if no distance is past its tolerance (or NaN)
+ */
+static bool withinTolerance(const trajectoryDivergence &divergence, const double tolerance[3])
+{
+	return divergence.cm <= tolerance[0] && divergence.rotation <= tolerance[1] && divergence.vertex <= tolerance[2];
+}
+
+// Name of the trajectory file of a scene
+static void goldenName(benchScene *scene, char *filename)
+{
+	sprintf(filename, "%s%s", scene->name, TRAJECTORYSUFFIX);
+}
+
+/* Function: recordScenes
+ * Description: Records the trajectories of the scenes with the reference variant
+ * Input: sceneName - scene to record, or all
+ *		  numSteps - timesteps to perform
+ *		  every - timesteps between two samples
+ * Output: 0 if every trajectory was written
+ */
+static int recordScenes(const char *sceneName, int numSteps, int every)
+{
+	trajectory golden;
+	char filename[64];
+	int numScenes = 0, status = 0;
+
+	for (int i = 0; i < numBenchScenes; i++)
+	{
+		if (strcmp(sceneName, "all") != 0 && strcmp(sceneName, benchScenes[i].name) != 0)
+			continue;
+
+		numScenes++;
+		runVariant(&benchScenes[i], &variants[0], numSteps, every, &golden);
+		goldenName(&benchScenes[i], filename);
+		if (golden.Write(filename))
+			printf("%s: %d samples of %d bodies, every %d steps\n", filename, golden.numSamples, golden.numBodies, golden.every);
+		else
+		{
+			printf("Cannot write the trajectory %s\n", filename);
+			status = 1;
+		} //end if
+	} //end for
+
+	if (numScenes == 0)
+	{
+		printf("No scene named %s, simGolden list shows the scenes\n", sceneName);
+		return 1;
+	} //end if
+	return status;
+}
+
+/* Function: compareScenes
+ * Description: Steps the recorded scenes with the variants and compares every sample with the recording.
+ *				In the scenes whose bodies touch, every sample of a variant is compared with the one of the
+ *				reference it restarted from, and the reference with the recording (runRestarted).
+ *				Prints the largest divergence of every scene and variant, and the first sample past a tolerance.
+ * Input: sceneName - scene to compare, or all
+ *		  variantName - variant to run, or all
+ *		  tolerance - tolerances of the center of mass, rotation and vertex divergences
+ *		  csvName - file receiving the divergence of every sample, NULL for none
+ * Output: 0 if no variant went past a tolerance
+ */
+static int compareScenes(const char *sceneName, const char *variantName, const double tolerance[3], char *csvName)
+{
+	trajectory golden, reference, replay;
+	trajectoryDivergence divergence, largest;
+	goldenVariant *variant;
+	benchScene *scene;
+	FILE *csv = NULL;
+	char filename[64];
+	int numRuns = 0, status = 0, failed, failedBody, drifted;
+	bool past;
+
+	if (csvName != NULL)
+	{
+		csv = fopen(csvName, "w");
+		if (csv == NULL)
+		{
+			printf("Cannot write the divergences to %s\n", csvName);
+			return 1;
+		} //end if
+		fprintf(csv, "scene,variant,step,time,cm,rotation,vertex,body,pass\n");
+	} //end if
+
+	printf("%-10s %-15s %8s %12s %12s %12s  %s\n", "scene", "variant", "samples", "cm", "rotation", "vertex", "result");
+	for (int i = 0; i < numBenchScenes; i++)
+	{
+		scene = &benchScenes[i];
+		if (strcmp(sceneName, "all") != 0 && strcmp(sceneName, scene->name) != 0)
+			continue;
+
+		goldenName(scene, filename);
+		if (!golden.Read(filename) || golden.numSamples == 0)
+		{
+			printf("%-10s no trajectory in %s, run simGolden record first\n", scene->name, filename);
+			status = 1;
+			continue;
+		} //end if
+
+		for (int v = 0; v < NUMVARIANTS; v++)
+		{
+			variant = &variants[v];
+			if ((strcmp(variantName, "all") != 0 && strcmp(variantName, variant->name) != 0) || !variantAvailable(variant))
+				continue;
+
+			numRuns++;
+			if (scene->contact)
+				runRestarted(scene, variant, golden.steps[golden.numSamples - 1], golden.every, &reference, &replay);
+			else
+				runVariant(scene, variant, golden.steps[golden.numSamples - 1], golden.every, &replay);
+			if (!replay.SameBodies(golden) || replay.numSamples != golden.numSamples)
+			{
+				printf("%-10s %-15s the bodies differ from the trajectory in %s\n", scene->name, variant->name, filename);
+				status = 1;
+				continue;
+			} //end if
+
+			memset( (void*)&largest, 0, sizeof(largest));
+			failed = drifted = -1;
+			failedBody = 0;
+			for (int sample = 0; sample < golden.numSamples; sample++)
+			{
+				if (scene->contact)
+				{
+					trajectory::Compare(golden, sample, reference, sample, &divergence);
+					if (drifted < 0 && !withinTolerance(divergence, tolerance))
+						drifted = sample;
+					trajectory::Compare(reference, sample, replay, sample, &divergence);
+				}
+				else
+					trajectory::Compare(golden, sample, replay, sample, &divergence);
+				past = !withinTolerance(divergence, tolerance);
+				if (past && failed < 0)
+				{
+					failed = sample;
+					failedBody = divergence.body;
+				} //end if
+
+				if (!(divergence.cm <= largest.cm))
+					largest.cm = divergence.cm;
+				if (!(divergence.rotation <= largest.rotation))
+					largest.rotation = divergence.rotation;
+				if (!(divergence.vertex <= largest.vertex))
+					largest.vertex = divergence.vertex;
+
+				if (csv != NULL)
+					fprintf(csv, "%s,%s,%d,%.6f,%.3e,%.3e,%.3e,%d,%d\n", scene->name, variant->name, golden.steps[sample],
+						golden.times[sample], divergence.cm, divergence.rotation, divergence.vertex, divergence.body, past ? 0 : 1);
+			} //end for
+
+			printf("%-10s %-15s %8d %12.3e %12.3e %12.3e  ", scene->name, variant->name, golden.numSamples,
+				largest.cm, largest.rotation, largest.vertex);
+			if (drifted >= 0)
+			{
+				printf("FAIL the reference leaves the recording from step %d\n", golden.steps[drifted]);
+				status = 1;
+			}
+			else if (failed < 0)
+				printf("pass%s\n", scene->contact ? " (one timestep)" : "");
+			else
+			{
+				printf("FAIL from step %d (body %d)\n", golden.steps[failed], failedBody);
+				status = 1;
+			} //end if
+		} //end for
+	} //end for
+
+	if (csv != NULL && fclose(csv) != 0)
+	{
+		printf("Cannot write the divergences to %s\n", csvName);
+		status = 1;
+	} //end if
+	if (numRuns == 0 && status == 0)
+	{
+		printf("Nothing to compare for scene %s and variant %s, simGolden list shows them\n", sceneName, variantName);
+		status = 1;
+	} //end if
+	return status;
+}
+
+/* Main Loop */
+int main(int argc, char** argv)
+{
+	const char *command = (argc > 1) ? argv[1] : "list";
+	const char *sceneName = (argc > 2) ? argv[2] : "all";
+	double tolerance[3] = {GOLDENCMTOLERANCE, GOLDENROTATIONTOLERANCE, GOLDENVERTEXTOLERANCE};
+	int numSteps = 400, every = 10;
+
+	if (strcmp(command, "record") == 0)
+	{
+		if (argc > 3)
+			numSteps = atoi(argv[3]);
+		if (argc > 4)
+			every = atoi(argv[4]);
+		if (every < 1)
+			every = 1;
+		if (numSteps < every)
+			numSteps = every;
+		return recordScenes(sceneName, numSteps, every);
+	}
+	else if (strcmp(command, "compare") == 0)
+	{
+		for (int i = 0; i < 3; i++)
+			if (argc > 4 + i)
+				tolerance[i] = atof(argv[4 + i]);
+		return compareScenes(sceneName, (argc > 3) ? argv[3] : "all", tolerance, (argc > 7) ? argv[7] : NULL);
+	} //end if
+
+	printf("scenes:");
+	for (int i = 0; i < numBenchScenes; i++)
+		printf(" %s", benchScenes[i].name);
+	printf("\nvariants:");
+	for (int v = 0; v < NUMVARIANTS; v++)
+		if (variantAvailable(&variants[v]))
+			printf(" %s", variants[v].name);
+	printf("\n");
+	return (strcmp(command, "list") == 0) ? 0 : 1;
+}
@@ -0,0 +1,422 @@
+/* Source: simThread
+ * Description: Thread stepping the simulation world at a fixed timestep, and the triple buffer handing
+ *				its frames to the renderer.
+ */
+
+#include <stdlib.h>
+#include "simThread.h"
+#include "performanceCounter.h"
+
+#ifdef WIN32
+  #include <process.h>
+#else
+  #include <unistd.h>
+#endif
+
+#ifdef WIN32
+static unsigned __stdcall simMain(void *sim)
+{
+	((simThread *)sim)->threadLoop();
+	return 0;
+}
+#else
+static void * simMain(void *sim)
+{
+	((simThread *)sim)->threadLoop();
+	return NULL;
+}
+#endif
+
+// Gives the processor away for about a millisecond
+static void napMilliseconds()
+{
+#ifdef WIN32
+	Sleep(1);
+#else
+	usleep(1000);
+#endif
+}
+
+/* Function: simThread
+ * Description: Prepares the thread stepping world, which only starts running with Start
+ * Input: world - world to be stepped
+ */
+simThread::simThread(simWorld *world)
+{
+	this->world = world;
+	running = false;
+	quit = false;
+
+	memset( (void*)&controls, 0, sizeof(controls));
+	controls.h = world->h;
+	controls.n = world->n;
+	controls.alpha = world->alpha;
+	controls.beta = world->beta;
+	controls.delta = world->delta;
+	controls.kWall = world->kWall;
+	controls.dWall = world->dWall;
+	controls.gravity = world->gravity;
+	controls.deformMode = world->deformMode;
+	controls.stickyFloor = world->stickyFloor;
+	controls.dragModel = -1;
+	controls.paused = true;
+	controls.profile = false;
+
+	memset( (void*)frames, 0, sizeof(frames));
+	back = 0;
+	ready = 1;
+	front = 2;
+	fresh = false;
+
+#ifdef WIN32
+	InitializeCriticalSection(&worldLock);
+	InitializeCriticalSection(&frameLock);
+	InitializeCriticalSection(&controlLock);
+#else
+	pthread_mutex_init(&worldLock, NULL);
+	pthread_mutex_init(&frameLock, NULL);
+	pthread_mutex_init(&controlLock, NULL);
+#endif
+}
+
+/* Function: ~simThread
+ * Description: Stops the thread and frees the frames
+ */
+simThread::~simThread()
+{
+	Stop();
+
+	for (int i = 0; i < 3; i++)
+	{
+		free(frames[i].models);
+		free(frames[i].offsets);
+		free(frames[i].vertices);
+	}
+
+#ifdef WIN32
+	DeleteCriticalSection(&controlLock);
+	DeleteCriticalSection(&frameLock);
+	DeleteCriticalSection(&worldLock);
+#else
+	pthread_mutex_destroy(&controlLock);
+	pthread_mutex_destroy(&frameLock);
+	pthread_mutex_destroy(&worldLock);
+#endif
+}
+
+/* Function: Start
+ * Description: Starts stepping the world on its own thread
+ * Input: None
+ * Output: None
+ */
+void simThread::Start()
+{
+	if (running)
+		return;
+
+	quit = false;
+	running = true;
+#ifdef WIN32
+	thread = (HANDLE)_beginthreadex(NULL, 0, simMain, this, 0, NULL);
+#else
+	pthread_create(&thread, NULL, simMain, this);
+#endif
+}
+
+/* Function: Stop
+ * Description: Stops the thread once it is done with its current frame, and waits for it
+ * Input: None
+ * Output: None
+ */
+void simThread::Stop()
+{
+	if (!running)
+		return;
+
+	LockControls();
+	quit = true;
+	UnlockControls();
+
+#ifdef WIN32
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, NULL);
+#endif
+	running = false;
+}
+
+/* Function: threadLoop
+ * Description: Steps the world whenever the real time passed since the last frame covers the n
+ *				timesteps of a frame, and publishes every frame. When the frames take longer to
+ *				compute than the time they cover, the backlog is dropped after MAXBACKLOG frames
+ *				so that the simulation slows down instead of falling further and further behind.
+ * Input: None
+ * Output: None
+ */
+void simThread::threadLoop()
+{
+	PerformanceCounter clock, stepClock;
+	double accumulator = 0.0, frameTime, stepTime = 0.0;
+	bool paused, leave;
+
+	clock.StartCounter();
+	while (true)
+	{
+		clock.StopCounter();
+		accumulator += clock.GetElapsedTime();
+		clock.StartCounter();
+
+		LockControls();
+		leave = quit;
+		paused = controls.paused;
+		frameTime = controls.n * controls.h;
+		UnlockControls();
+
+		if (leave)
+			break;
+
+		if (paused || frameTime <= 0.0)
+		{
+			accumulator = 0.0;
+			napMilliseconds();
+			continue;
+		} //end if
+
+		if (accumulator < frameTime)
+		{
+			napMilliseconds();
+			continue;
+		} //end if
+
+		if (accumulator > MAXBACKLOG * frameTime)
+			accumulator = frameTime;
+
+		Lock();
+		ApplyControls();
+		for (int i = 0; i < world->n; i++)
+		{
+			stepClock.StartCounter();
+			CallPerFrame(world);
+			stepClock.StopCounter();
+			stepTime = stepClock.GetElapsedTime();
+		}
+		Publish(stepTime);
+		Unlock();
+
+		accumulator -= frameTime;
+	} //end while
+} //end threadLoop
+
+/* Function: Lock
+ * Description: Takes the world lock; the thread holds it while it steps a frame, and the user interface
+ *				while it changes the models
+ * Input: None
+ * Output: None
+ */
+void simThread::Lock()
+{
+#ifdef WIN32
+	EnterCriticalSection(&worldLock);
+#else
+	pthread_mutex_lock(&worldLock);
+#endif
+}
+
+void simThread::Unlock()
+{
+#ifdef WIN32
+	LeaveCriticalSection(&worldLock);
+#else
+	pthread_mutex_unlock(&worldLock);
+#endif
+}
+
+void simThread::LockFrames()
+{
+#ifdef WIN32
+	EnterCriticalSection(&frameLock);
+#else
+	pthread_mutex_lock(&frameLock);
+#endif
+}
+
+void simThread::UnlockFrames()
+{
+#ifdef WIN32
+	LeaveCriticalSection(&frameLock);
+#else
+	pthread_mutex_unlock(&frameLock);
+#endif
+}
+
+void simThread::LockControls()
+{
+#ifdef WIN32
+	EnterCriticalSection(&controlLock);
+#else
+	pthread_mutex_lock(&controlLock);
+#endif
+}
+
+void simThread::UnlockControls()
+{
+#ifdef WIN32
+	LeaveCriticalSection(&controlLock);
+#else
+	pthread_mutex_unlock(&controlLock);
+#endif
+}
+
+/* Function: SetControls
+ * Description: Hands the user controls over to the thread, they are applied before the next frame
+ * Input: newControls - controls of the user interface
+ * Output: None
+ */
+void simThread::SetControls(const simControls *newControls)
+{
+	LockControls();
+	controls = *newControls;
+	UnlockControls();
+}
+
+/* Function: ApplyControls
+ * Description: Copies the latest user controls into the world. A change of the gravity or of the floor
+ *				wakes every model up. The world lock must be held.
+ * Input: None
+ * Output: None
+ */
+void simThread::ApplyControls()
+{
+	simControls current;
+
+	LockControls();
+	current = controls;
+	UnlockControls();
+
+	if (world->gravity != current.gravity || world->stickyFloor != current.stickyFloor)
+		world->WakeModels();
+
+	world->h = current.h;
+	world->n = current.n;
+	world->alpha = current.alpha;
+	world->beta = current.beta;
+	world->delta = current.delta;
+	world->kWall = current.kWall;
+	world->dWall = current.dWall;
+	world->gravity = current.gravity;
+	world->deformMode = current.deformMode;
+	world->stickyFloor = current.stickyFloor;
+	world->userForce = current.userForce;
+	world->dragModel = current.dragModel;
+	world->SetProfiling(current.profile);
+}
+
+/* Function: Publish
+ * Description: Copies the positions of the models into the back frame and makes it the newest one.
+ *				The world lock must be held.
+ * Input: stepTime - seconds spent on the last timestep
+ * Output: None
+ */
+void simThread::Publish(double stepTime)
+{
+	simFrame *frame = &frames[back];
+	int numValues = 0, swap;
+	phyzx *phyzxObj;
+	GLfloat *vertices;
+
+	if (world->numModels > frame->modelCapacity)
+	{
+		frame->modelCapacity = world->numModels;
+		frame->models = (pModel **)realloc(frame->models, frame->modelCapacity * sizeof(pModel *));
+		frame->offsets = (int *)realloc(frame->offsets, frame->modelCapacity * sizeof(int));
+	}
+	for (int i = 0; i < world->numModels; i++)
+	{
+		frame->models[i] = world->modelArray[i];
+		frame->offsets[i] = numValues;
+		numValues += 3 * world->modelArray[i]->pObj->numVertices;
+	}
+	if (numValues > frame->vertexCapacity)
+	{
+		frame->vertexCapacity = numValues;
+		frame->vertices = (GLfloat *)realloc(frame->vertices, frame->vertexCapacity * sizeof(GLfloat));
+	}
+
+	for (int i = 0; i < world->numModels; i++)
+	{
+		phyzxObj = world->modelArray[i]->pObj;
+		vertices = frame->vertices + frame->offsets[i];
+		for (int index = 0; index < phyzxObj->numVertices; index++)
+		{
+			vertices[3*index] = (GLfloat)phyzxObj->position.x[index];
+			vertices[3*index + 1] = (GLfloat)phyzxObj->position.y[index];
+			vertices[3*index + 2] = (GLfloat)phyzxObj->position.z[index];
+		}
+	}
+	frame->numModels = world->numModels;
+	frame->stepTime = stepTime;
+	frame->time = world->time;
+
+	LockFrames();
+	swap = ready;
+	ready = back;
+	back = swap;
+	fresh = true;
+	UnlockFrames();
+}
+
+/* Function: ReadFrame
+ * Description: Copies the newest frame into the vertices the models are drawn with, if the renderer
+ *				has not read it yet. Only called by the thread drawing the models.
+ * Input: stepTime - receives the seconds spent on the last timestep of the frame (can be NULL)
+ *		  time - receives the simulated time of the frame (can be NULL)
+ * Output: true if a new frame was read
+ */
+bool simThread::ReadFrame(double *stepTime, double *time)
+{
+	simFrame *frame;
+	phyzx *phyzxObj;
+	int swap;
+
+	LockFrames();
+	if (!fresh)
+	{
+		UnlockFrames();
+		return false;
+	} //end if
+	swap = front;
+	front = ready;
+	ready = swap;
+	fresh = false;
+	UnlockFrames();
+
+	frame = &frames[front];
+	for (int i = 0; i < frame->numModels; i++)
+	{
+		phyzxObj = frame->models[i]->pObj;
+		memcpy( (void*)(phyzxObj->model->vertices + 3*STARTFROM), frame->vertices + frame->offsets[i],
+			3 * phyzxObj->numVertices * sizeof(GLfloat));
+	}
+
+	if (stepTime != NULL)
+		*stepTime = frame->stepTime;
+	if (time != NULL)
+		*time = frame->time;
+	return true;
+}
+
+/* Function: ClearFrames
+ * Description: Forgets the published frames, after models were deleted. The world lock must be held,
+ *				by the thread reading the frames.
+ * Input: None
+ * Output: None
+ */
+void simThread::ClearFrames()
+{
+	LockFrames();
+	for (int i = 0; i < 3; i++)
+		frames[i].numModels = 0;
+	fresh = false;
+	UnlockFrames();
+}
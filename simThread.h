@@ -0,0 +1,108 @@
+/* Header: simThread
+ * Description: Header file for the thread stepping the simulation world of the interactive application.
+ *				The thread advances the world at a fixed timestep h, paced by the real time that has passed
+ *				(a time accumulator): every n timesteps make a frame, which is published to the renderer
+ *				through a triple buffer of vertex positions. The thread only holds the buffer lock to swap
+ *				two buffer indices, so drawing never waits for a frame to be computed, and stepping never
+ *				waits for one to be drawn.
+ *				The user interface hands its controls over with SetControls, applied before the next
+ *				frame, and takes the world lock around the changes it makes to the models (adding,
+ *				deleting, changing their parameters), which waits for at most one frame.
+ *				Same interface under Windows (Win32 threads) and Linux / Mac OS X (pthreads).
+ */
+
+#ifndef _SIMTHREAD_H_
+#define _SIMTHREAD_H_
+
+#ifdef WIN32
+  #include <windows.h>
+#else
+  #include <pthread.h>
+#endif
+
+#include "simulation.h"
+
+#define MAXBACKLOG 4				// Frames of real time the thread may lag behind before it drops the backlog
+
+// User controls copied into the world before every frame
+struct simControls
+{
+	double h;
+	int n;
+	double alpha;
+	double beta;
+	double delta;
+	double kWall;
+	double dWall;
+	double gravity;
+	int deformMode;
+	int stickyFloor;
+	point userForce;
+	int dragModel;
+	bool paused;
+	bool profile;					// Measure the phases of the timesteps
+};
+
+// Rendered positions of every model after one frame
+struct simFrame
+{
+	pModel **models;				// Models of the frame, in the order of the world model array
+	int *offsets;					// First value of model i in vertices
+	int numModels;
+	int modelCapacity;
+	GLfloat *vertices;				// Positions as in GLMmodel::vertices, 3 values per vertex from STARTFROM on
+	int vertexCapacity;
+	double stepTime;				// Seconds spent on the last timestep of the frame
+	double time;					// Simulated time of the frame
+};
+
+class simThread
+{
+public:
+		simThread(simWorld *world);
+		~simThread();
+
+		void Start();
+		void Stop();
+		void Lock();
+		void Unlock();
+		void ApplyControls();
+		void SetControls(const simControls *newControls);
+		bool ReadFrame(double *stepTime, double *time = NULL);
+		void ClearFrames();
+
+		void threadLoop();				// Body of the thread, not to be called directly
+
+protected:
+		void Publish(double stepTime);
+		void LockFrames();
+		void UnlockFrames();
+		void LockControls();
+		void UnlockControls();
+
+		simWorld *world;
+		bool running;
+		bool quit;						// The thread leaves when set, guarded by the controls lock
+		simControls controls;			// Latest controls of the user interface, guarded by the controls lock
+
+		// Triple buffer: the thread fills back, the renderer reads front, ready holds the newest frame
+		simFrame frames[3];
+		int back;
+		int ready;
+		int front;
+		bool fresh;						// ready holds a frame the renderer has not taken yet
+
+#ifdef WIN32
+		HANDLE thread;
+		CRITICAL_SECTION worldLock;
+		CRITICAL_SECTION frameLock;
+		CRITICAL_SECTION controlLock;
+#else
+		pthread_t thread;
+		pthread_mutex_t worldLock;
+		pthread_mutex_t frameLock;
+		pthread_mutex_t controlLock;
+#endif
+};
+
+#endif
@@ -0,0 +1,123 @@
+/* Source: simd
+ * Description: Scalar versions of the fused step kernels and the runtime choice of instruction set.
+ */
+
+#include "simd.h"
+#include "simdKernels.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h>
+#endif
+
+static const simdKernels scalarKernels = { scalarReduce, scalarIntegrate, scalarBoundRadius2, scalarEigen3, scalarCollide };
+
+/* Function: simdCpuLevel
+ * Description: Asks the CPU for the best instruction set it supports, whatever this build provides
+ * Input: None
+ * Output: SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 or SIMD_AVX512
+ */
+static int simdCpuLevel()
+{
+	int level = SIMD_SCALAR;
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+		level = SIMD_SSE2;
+	if (level == SIMD_SSE2 && __builtin_cpu_supports("avx2"))
+		level = SIMD_AVX2;
+	if (level == SIMD_AVX2 && __builtin_cpu_supports("avx512f"))
+		level = SIMD_AVX512;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int info[4];
+	__cpuid(info, 1);
+	if (info[3] & (1 << 26))
+		level = SIMD_SSE2;
+  #if _MSC_VER >= 1600
+	// AVX state has to be enabled by the OS (OSXSAVE and XCR0) before AVX2 / AVX-512 can be used
+	if (level == SIMD_SSE2 && (info[2] & (1 << 27)))
+	{
+		unsigned __int64 xcr0 = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+		if ((xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)))
+			level = SIMD_AVX2;
+		if (level == SIMD_AVX2 && (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)))
+			level = SIMD_AVX512;
+	}
+  #endif
+#endif
+
+	return level;
+} //end simdCpuLevel
+
+/* Function: simdDetect
+ * Description: Finds the best instruction set supported by both the CPU and this build
+ * Input: None
+ * Output: SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 or SIMD_AVX512
+ */
+int simdDetect()
+{
+	return simdClamp(SIMD_AVX512);
+} //end simdDetect
+
+/* Function: simdClamp
+ * Description: Lowers an instruction set level to the best one both supported by the CPU and compiled in,
+ *				so that a level asked for on the command line never runs instructions the CPU lacks.
+ *				Any lower level, down to the scalar kernels, is kept as asked.
+ * Input: level - requested level
+ * Output: level that simdGetKernels will use
+ */
+int simdClamp(int level)
+{
+	static const int cpuLevel = simdCpuLevel();
+
+	if (level > cpuLevel)
+		level = cpuLevel;
+	if (level >= SIMD_AVX512 && simdKernelsAVX512() == NULL)
+		level = SIMD_AVX2;
+	if (level >= SIMD_AVX2 && simdKernelsAVX2() == NULL)
+		level = SIMD_SSE2;
+	if (level >= SIMD_SSE2 && simdKernelsSSE2() == NULL)
+		level = SIMD_SCALAR;
+	if (level < SIMD_SCALAR)
+		level = SIMD_SCALAR;
+	return level;
+} //end simdClamp
+
+/* Function: simdName
+ * Description: Name of an instruction set level
+ * Input: level - instruction set level
+ * Output: name
+ */
+const char * simdName(int level)
+{
+	switch (simdClamp(level))
+	{
+		case SIMD_SSE2:
+			return "SSE2";
+		case SIMD_AVX2:
+			return "AVX2";
+		case SIMD_AVX512:
+			return "AVX-512";
+	}
+	return "scalar";
+} //end simdName
+
+/* Function: simdGetKernels
+ * Description: Kernel table of an instruction set level, lowered to what the CPU and this build provide
+ * Input: level - instruction set level
+ * Output: kernel table
+ */
+const simdKernels * simdGetKernels(int level)
+{
+	switch (simdClamp(level))
+	{
+		case SIMD_SSE2:
+			return simdKernelsSSE2();
+		case SIMD_AVX2:
+			return simdKernelsAVX2();
+		case SIMD_AVX512:
+			return simdKernelsAVX512();
+	}
+	return &scalarKernels;
+} //end simdGetKernels
@@ -0,0 +1,108 @@
+/* Header: simd
+ * Description: Header file for the vectorized per-vertex kernels of the fused step and of the wall
+ *				response, and of the batched 3x3 eigen decomposition.
+ *				Every kernel exists as a scalar version and, when the compiler supports it, as
+ *				SSE2, AVX2 and AVX-512 versions. The version used is chosen at runtime from the
+ *				instruction sets the CPU supports, and the scalar one can always be forced for
+ *				verification.
+ */
+
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include <stdlib.h>
+
+// Instruction set levels, in increasing order
+#define SIMD_SCALAR 0
+#define SIMD_SSE2 1
+#define SIMD_AVX2 2
+#define SIMD_AVX512 3
+
+#define CONTACTPLANES 32			// Most planes of a collision world
+#define CONTACTBOXES 16				// Most oriented boxes of a collision world
+
+// Per-body values shared by all the vertices integrated in one timestep
+struct simdStepParams
+{
+	double G[3][9];				// Goal matrix, R in the first 3 columns or the 3x9 quadratic matrix
+	int cols;					// Number of used columns of G (3 or 9)
+	double cm[3];				// Center of mass in deformed position
+	double alphaOverH;			// ALPHA / h
+	double h;					// timestep
+	double delta;				// Velocity Damping
+	double force[3];			// Force added to every external force (user force, or zero)
+	double frozenY;				// Vertices with y <= frozenY are not integrated (sticky floor)
+
+	const double *mass;
+	const double *qx, *qy, *qz;		// relStableLoc
+	const double *fx, *fy, *fz;		// extForce
+	double *x, *y, *z;				// position
+	double *vx, *vy, *vz;			// velocity
+};
+
+// Oriented box the vertices are kept out of
+struct simdContactBox
+{
+	double center[3];
+	double axis[3][3];				// Unit axes of the box, one per row
+	double half[3];					// Half extents along the axes
+};
+
+// Planes and boxes a range of vertices can touch, with the wall response of their body.
+// A vertex x touches plane i when n[i] . x <= offset[i], and is pushed along n[i] by a spring of
+// length anchor[i] - n[i] . x. A vertex inside a box is pushed out through its nearest face by a
+// spring of length depth + preload.
+struct simdContactParams
+{
+	double gravity;					// y of the external force every vertex starts from
+	double kWall;					// Hooks law co-efficient
+	double dWall;					// Damping co-efficient
+	double preload;					// Length of the box springs at depth 0
+
+	int numPlanes;
+	double nx[CONTACTPLANES], ny[CONTACTPLANES], nz[CONTACTPLANES];	// Unit normals, towards the free side
+	double offset[CONTACTPLANES];
+	double anchor[CONTACTPLANES];
+	int numBoxes;
+	simdContactBox boxes[CONTACTBOXES];
+
+	const double *mass;
+	const double *x, *y, *z;		// position
+	const double *vx, *vy, *vz;		// velocity
+	double *fx, *fy, *fz;			// extForce
+	const unsigned char *frozen;	// Vertices left untouched where set, indexed from begin, NULL for none
+};
+
+// Table of the kernels of one instruction set
+struct simdKernels
+{
+	// cmSum = Summation(m * x), sum[r][c] = Summation(m * x[r] * q[c]) for c < cols (3 or 9)
+	void (*reduce)(const double *mass, const double *x, const double *y, const double *z,
+				   const double *qx, const double *qy, const double *qz,
+				   int count, int cols, double cmSum[3], double sum[3][9]);
+
+	// Integrates the vertices [begin, end) and adds their new velocities to velSum
+	void (*integrate)(const simdStepParams *p, int begin, int end, double velSum[3]);
+
+	// Largest squared distance of the first count vertices from center
+	double (*boundRadius2)(const double *x, const double *y, const double *z, int count, const double center[3]);
+
+	// Eigen decomposition of count symmetric 3x3 matrices (9 values each, row major), one matrix per lane,
+	// as eigen_analytic: eigenvectors in the columns of V, eigenvalues in increasing order in d (3 each)
+	void (*eigen3)(const double *A, double *V, double *d, int count);
+
+	// Resets the external forces of the vertices [begin, end) to gravity and adds the response of the
+	// planes and boxes they touch
+	void (*collide)(const simdContactParams *p, int begin, int end);
+};
+
+int simdDetect();
+int simdClamp(int level);
+const char * simdName(int level);
+const simdKernels * simdGetKernels(int level);
+
+const simdKernels * simdKernelsSSE2();
+const simdKernels * simdKernelsAVX2();
+const simdKernels * simdKernelsAVX512();
+
+#endif
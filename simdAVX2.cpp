@@ -0,0 +1,44 @@
+/* Source: simdAVX2
+ * Description: AVX2 versions of the fused step kernels, 4 vertices per instruction.
+ *				Only built when the compiler targets AVX2 for this file (-mavx2, /arch:AVX2).
+ */
+
+#include "simd.h"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define VWIDTH 4
+#define VEC __m256d
+#define VMASK __m256d
+#define VLOAD(p) _mm256_loadu_pd(p)
+#define VSTORE(p, v) _mm256_storeu_pd(p, v)
+#define VSET1(d) _mm256_set1_pd(d)
+#define VZERO() _mm256_setzero_pd()
+#define VADD(a, b) _mm256_add_pd(a, b)
+#define VSUB(a, b) _mm256_sub_pd(a, b)
+#define VMUL(a, b) _mm256_mul_pd(a, b)
+#define VDIV(a, b) _mm256_div_pd(a, b)
+#define VSQRT(a) _mm256_sqrt_pd(a)
+#define VMAX(a, b) _mm256_max_pd(a, b)
+#define VACTIVE(y, t) _mm256_cmp_pd(y, t, _CMP_NLE_UQ)
+#define VSELECT(m, a, b) _mm256_blendv_pd(b, a, m)
+
+#include "simdKernels.h"
+
+static const simdKernels kernels = { vecReduce, vecIntegrate, vecBoundRadius2, vecEigen3, vecCollide };
+
+const simdKernels * simdKernelsAVX2()
+{
+	return &kernels;
+}
+
+#else
+
+const simdKernels * simdKernelsAVX2()
+{
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,44 @@
+/* Source: simdAVX512
+ * Description: AVX-512 versions of the fused step kernels, 8 vertices per instruction.
+ *				Only built when the compiler targets AVX-512F for this file (-mavx512f, /arch:AVX512).
+ */
+
+#include "simd.h"
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+
+#define VWIDTH 8
+#define VEC __m512d
+#define VMASK __mmask8
+#define VLOAD(p) _mm512_loadu_pd(p)
+#define VSTORE(p, v) _mm512_storeu_pd(p, v)
+#define VSET1(d) _mm512_set1_pd(d)
+#define VZERO() _mm512_setzero_pd()
+#define VADD(a, b) _mm512_add_pd(a, b)
+#define VSUB(a, b) _mm512_sub_pd(a, b)
+#define VMUL(a, b) _mm512_mul_pd(a, b)
+#define VDIV(a, b) _mm512_div_pd(a, b)
+#define VSQRT(a) _mm512_sqrt_pd(a)
+#define VMAX(a, b) _mm512_max_pd(a, b)
+#define VACTIVE(y, t) _mm512_cmp_pd_mask(y, t, _CMP_NLE_UQ)
+#define VSELECT(m, a, b) _mm512_mask_blend_pd(m, b, a)
+
+#include "simdKernels.h"
+
+static const simdKernels kernels = { vecReduce, vecIntegrate, vecBoundRadius2, vecEigen3, vecCollide };
+
+const simdKernels * simdKernelsAVX512()
+{
+	return &kernels;
+}
+
+#else
+
+const simdKernels * simdKernelsAVX512()
+{
+	return NULL;
+}
+
+#endif
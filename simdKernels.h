@@ -0,0 +1,803 @@
+/* Header: simdKernels
+ * Description: Bodies of the fused step kernels, included by simd.cpp and by every instruction set
+ *				source (simdSSE2.cpp, simdAVX2.cpp, simdAVX512.cpp). The scalar versions are always
+ *				defined and also handle the vertices left over at the end of a vector loop. The vector
+ *				versions are defined when the including file has set up the macros below:
+ *
+ *				VWIDTH				number of doubles per register
+ *				VEC, VMASK			register and comparison mask types
+ *				VLOAD(p), VSTORE(p, v), VSET1(d), VZERO()
+ *				VADD, VSUB, VMUL, VDIV, VMAX(a, b)	(VMAX returns b when either is NaN)
+ *				VACTIVE(y, t)		mask of the lanes where !(y <= t)
+ *				VSELECT(m, a, b)	a where m is set, b elsewhere
+ *				VSQRT(a)
+ *
+ *				The integration and the wall response only use separate multiplies and adds in the same
+ *				order as the scalar code, so every instruction set produces the same positions and forces. The reductions add the
+ *				lanes in a different order and only agree up to rounding.
+ */
+
+#ifndef _SIMD_KERNELS_H_
+#define _SIMD_KERNELS_H_
+
+#include <string.h>
+#include "simd.h"
+#include "vector.h"
+#include "eig3.h"
+
+#ifndef VWIDTH
+
+/* Function: scalarReduce
+ * Description: Accumulates the center of mass and Apq (TApq) sums of the vertices one at a time
+ * Input: count - number of vertices
+ *		  cols - number of columns of the sums (3 or 9)
+ * Output: cmSum, sum
+ */
+static void scalarReduce(const double *mass, const double *x, const double *y, const double *z,
+						 const double *qx, const double *qy, const double *qz,
+						 int count, int cols, double cmSum[3], double sum[3][9])
+{
+	double qq[9];
+	double m, px, py, pz;
+
+	memset( (void*)cmSum, 0, 3 * sizeof(double));
+	memset( (void*)sum, 0, 27 * sizeof(double));
+
+	for (int index = 0; index < count; index++)
+	{
+		m = mass[index];
+		px = x[index];
+		py = y[index];
+		pz = z[index];
+
+		cmSum[0] += m * px;
+		cmSum[1] += m * py;
+		cmSum[2] += m * pz;
+
+		qq[0] = qx[index];
+		qq[1] = qy[index];
+		qq[2] = qz[index];
+		if (cols == 9)
+		{
+			qq[3] = qq[0] * qq[0];
+			qq[4] = qq[1] * qq[1];
+			qq[5] = qq[2] * qq[2];
+			qq[6] = qq[0] * qq[1];
+			qq[7] = qq[1] * qq[2];
+			qq[8] = qq[2] * qq[0];
+		} //end if
+
+		for (int col = 0; col < cols; col++)
+		{
+			sum[0][col] += m * (px * qq[col]);
+			sum[1][col] += m * (py * qq[col]);
+			sum[2][col] += m * (pz * qq[col]);
+		} //end for
+	} //end for
+} //end scalarReduce
+
+#endif
+
+/* Function: scalarIntegrateVertex
+ * Description: Computes the goal position of one vertex and integrates it with modified Euler
+ *				vi(t + h) = (vi(t) + (ALPHA / h) * (gi(t) - xi(t)) + (h / mi) * Fext(t)) * (1 - delta)
+ *				xi(t + h) = xi(t) + h * vi(t + h)
+ * Input: p - step parameters
+ *		  index - vertex to integrate
+ * Output: velSum - the new velocity is added to it
+ */
+static inline void scalarIntegrateVertex(const simdStepParams *p, int index, double velSum[3])
+{
+	double qq[9], g[3], v[3], pos[3], f[3];
+	double hm, damp;
+
+	if (p->y[index] <= p->frozenY)
+		return;
+
+	qq[0] = p->qx[index];
+	qq[1] = p->qy[index];
+	qq[2] = p->qz[index];
+
+	if (p->cols == 9)
+	{
+		qq[3] = qq[0] * qq[0];
+		qq[4] = qq[1] * qq[1];
+		qq[5] = qq[2] * qq[2];
+		qq[6] = qq[0] * qq[1];
+		qq[7] = qq[1] * qq[2];
+		qq[8] = qq[2] * qq[0];
+
+		for (int row = 0; row < 3; row++)
+		{
+			g[row] = 0.0;
+			for (int col = 0; col < 9; col++)
+				g[row] += p->G[row][col] * qq[col];
+		} //end for
+	} //end if
+	else
+	{
+		for (int row = 0; row < 3; row++)
+			g[row] = p->G[row][0] * qq[0] + p->G[row][1] * qq[1] + p->G[row][2] * qq[2];
+	} //end else
+
+	pos[0] = p->x[index];
+	pos[1] = p->y[index];
+	pos[2] = p->z[index];
+	v[0] = p->vx[index];
+	v[1] = p->vy[index];
+	v[2] = p->vz[index];
+	f[0] = p->fx[index] + p->force[0];
+	f[1] = p->fy[index] + p->force[1];
+	f[2] = p->fz[index] + p->force[2];
+	hm = p->h / p->mass[index];
+
+	for (int k = 0; k < 3; k++)
+	{
+		g[k] = g[k] + p->cm[k];
+		v[k] = v[k] + ((g[k] - pos[k]) * p->alphaOverH + f[k] * hm);
+		damp = v[k] * -p->delta;
+		v[k] = v[k] + damp;
+		pos[k] = pos[k] + v[k] * p->h;
+		velSum[k] += v[k];
+	} //end for
+
+	p->x[index] = pos[0];
+	p->y[index] = pos[1];
+	p->z[index] = pos[2];
+	p->vx[index] = v[0];
+	p->vy[index] = v[1];
+	p->vz[index] = v[2];
+} //end scalarIntegrateVertex
+
+#ifndef VWIDTH
+
+/* Function: scalarIntegrate
+ * Description: Integrates the vertices [begin, end) one at a time
+ * Input: p - step parameters
+ * Output: velSum - the new velocities are added to it
+ */
+static void scalarIntegrate(const simdStepParams *p, int begin, int end, double velSum[3])
+{
+	for (int index = begin; index < end; index++)
+		scalarIntegrateVertex(p, index, velSum);
+} //end scalarIntegrate
+
+#endif
+
+/* Function: scalarBoundRadius2
+ * Description: Largest squared distance of the vertices from a center
+ * Input: count - number of vertices
+ *		  center - center of the bounding sphere
+ * Output: squared radius
+ */
+static double scalarBoundRadius2(const double *x, const double *y, const double *z, int count, const double center[3])
+{
+	double radius2 = 0.0, dist2;
+
+	for (int index = 0; index < count; index++)
+	{
+		dist2 = (center[0] - x[index]) * (center[0] - x[index]) + (center[1] - y[index]) * (center[1] - y[index]) + (center[2] - z[index]) * (center[2] - z[index]);
+		if (dist2 > radius2)
+			radius2 = dist2;
+	} //end for
+
+	return radius2;
+} //end scalarBoundRadius2
+
+#ifndef VWIDTH
+
+/* Function: scalarEigen3
+ * Description: Eigen decomposition of symmetric 3x3 matrices one at a time
+ * Input: A - count matrices of 9 values, row major
+ *		  count - number of matrices
+ * Output: V - eigenvectors in the columns of every matrix
+ *		   d - 3 eigenvalues per matrix, in increasing order
+ */
+static void scalarEigen3(const double *A, double *V, double *d, int count)
+{
+	for (int i = 0; i < count; i++)
+		eigen_analytic( (const double (*)[3])(A + 9*i), (double (*)[3])(V + 9*i), d + 3*i);
+} //end scalarEigen3
+
+#endif
+
+/* Function: scalarCollideVertex
+ * Description: Resets the external force of one vertex to gravity and adds the response of the planes and
+ *				boxes it touches: a spring along the normal of the plane, or of the nearest face of the box,
+ *				and a damping against the velocity of the vertex, both scaled by its mass
+ * Input: p - contact parameters
+ *		  index - vertex pushed back
+ * Output: None
+ */
+static inline void scalarCollideVertex(const simdContactParams *p, int index)
+{
+	const simdContactBox *box;
+	double pos[3], vel[3], f[3], damp[3], d[3], l[3], gap[3], n[3];
+	double m, dot, s;
+	int face;
+
+	pos[0] = p->x[index];
+	pos[1] = p->y[index];
+	pos[2] = p->z[index];
+	vel[0] = p->vx[index];
+	vel[1] = p->vy[index];
+	vel[2] = p->vz[index];
+	m = p->mass[index];
+
+	f[0] = 0.0;
+	f[1] = p->gravity;
+	f[2] = 0.0;
+	for (int k = 0; k < 3; k++)
+		damp[k] = (-p->dWall) * m * vel[k];
+
+	for (int i = 0; i < p->numPlanes; i++)
+	{
+		dot = p->nx[i] * pos[0] + p->ny[i] * pos[1] + p->nz[i] * pos[2];
+		if (dot <= p->offset[i])
+		{
+			s = p->kWall * (p->anchor[i] - dot) * m;
+			f[0] += p->nx[i] * s + damp[0];
+			f[1] += p->ny[i] * s + damp[1];
+			f[2] += p->nz[i] * s + damp[2];
+		} //end if
+	} //end for
+
+	for (int i = 0; i < p->numBoxes; i++)
+	{
+		box = &p->boxes[i];
+		for (int k = 0; k < 3; k++)
+			d[k] = pos[k] - box->center[k];
+
+		// Nearest face: the axis with the smallest gap between the vertex and the faces
+		face = 0;
+		for (int a = 0; a < 3; a++)
+		{
+			l[a] = box->axis[a][0] * d[0] + box->axis[a][1] * d[1] + box->axis[a][2] * d[2];
+			gap[a] = box->half[a] - fabs(l[a]);
+			if (!(gap[face] <= gap[a]))
+				face = a;
+		} //end for
+		if (gap[face] <= 0.0)
+			continue;
+
+		for (int k = 0; k < 3; k++)
+			n[k] = (0.0 <= l[face]) ? box->axis[face][k] : -box->axis[face][k];
+		s = p->kWall * (gap[face] + p->preload) * m;
+		for (int k = 0; k < 3; k++)
+			f[k] += n[k] * s + damp[k];
+	} //end for
+
+	p->fx[index] = f[0];
+	p->fy[index] = f[1];
+	p->fz[index] = f[2];
+} //end scalarCollideVertex
+
+#ifndef VWIDTH
+
+/* Function: scalarCollide
+ * Description: Wall response of the vertices [begin, end) one at a time
+ * Input: p - contact parameters
+ * Output: None
+ */
+static void scalarCollide(const simdContactParams *p, int begin, int end)
+{
+	for (int index = begin; index < end; index++)
+		if (p->frozen == NULL || !p->frozen[index - begin])
+			scalarCollideVertex(p, index);
+} //end scalarCollide
+
+#endif
+
+#ifdef VWIDTH
+
+/* Function: vecHSum
+ * Description: Adds the lanes of a register in order
+ */
+static inline double vecHSum(VEC v)
+{
+	double lanes[VWIDTH];
+	double result = 0.0;
+
+	VSTORE(lanes, v);
+	for (int i = 0; i < VWIDTH; i++)
+		result += lanes[i];
+	return result;
+} //end vecHSum
+
+/* Function: vecReduce
+ * Description: Vector version of scalarReduce. Runs over the SoA padding, whose masses are zero.
+ */
+static void vecReduce(const double *mass, const double *x, const double *y, const double *z,
+					  const double *qx, const double *qy, const double *qz,
+					  int count, int cols, double cmSum[3], double sum[3][9])
+{
+	VEC cm0 = VZERO(), cm1 = VZERO(), cm2 = VZERO();
+	VEC s[3][9];
+	VEC m, px, py, pz, qq[9];
+	const int padded = soaStride(count);
+	int col;
+
+	for (col = 0; col < 9; col++)
+		s[0][col] = s[1][col] = s[2][col] = VZERO();
+
+	for (int index = 0; index < padded; index += VWIDTH)
+	{
+		m = VLOAD(mass + index);
+		px = VLOAD(x + index);
+		py = VLOAD(y + index);
+		pz = VLOAD(z + index);
+
+		cm0 = VADD(cm0, VMUL(m, px));
+		cm1 = VADD(cm1, VMUL(m, py));
+		cm2 = VADD(cm2, VMUL(m, pz));
+
+		qq[0] = VLOAD(qx + index);
+		qq[1] = VLOAD(qy + index);
+		qq[2] = VLOAD(qz + index);
+		if (cols == 9)
+		{
+			qq[3] = VMUL(qq[0], qq[0]);
+			qq[4] = VMUL(qq[1], qq[1]);
+			qq[5] = VMUL(qq[2], qq[2]);
+			qq[6] = VMUL(qq[0], qq[1]);
+			qq[7] = VMUL(qq[1], qq[2]);
+			qq[8] = VMUL(qq[2], qq[0]);
+		} //end if
+
+		// m * (p * q) keeps the scalar grouping, with m * p hoisted it would not
+		for (col = 0; col < cols; col++)
+		{
+			s[0][col] = VADD(s[0][col], VMUL(m, VMUL(px, qq[col])));
+			s[1][col] = VADD(s[1][col], VMUL(m, VMUL(py, qq[col])));
+			s[2][col] = VADD(s[2][col], VMUL(m, VMUL(pz, qq[col])));
+		} //end for
+	} //end for
+
+	cmSum[0] = vecHSum(cm0);
+	cmSum[1] = vecHSum(cm1);
+	cmSum[2] = vecHSum(cm2);
+
+	memset( (void*)sum, 0, 27 * sizeof(double));
+	for (int row = 0; row < 3; row++)
+		for (col = 0; col < cols; col++)
+			sum[row][col] = vecHSum(s[row][col]);
+} //end vecReduce
+
+/* Function: vecIntegrate
+ * Description: Vector version of scalarIntegrate. The vertices after the last full register are
+ *				integrated by scalarIntegrateVertex.
+ */
+static void vecIntegrate(const simdStepParams *p, int begin, int end, double velSum[3])
+{
+	VEC G[3][9], cm[3], force[3];
+	VEC alphaOverH = VSET1(p->alphaOverH), h = VSET1(p->h), negDelta = VSET1(-p->delta);
+	VEC frozenY = VSET1(p->frozenY);
+	VEC sumX = VZERO(), sumY = VZERO(), sumZ = VZERO();
+	VEC qq[9], g[3], pos[3], vel[3], v[3], newPos[3], f[3], hm;
+	VMASK active;
+	double *outPos[3] = { p->x, p->y, p->z };
+	double *outVel[3] = { p->vx, p->vy, p->vz };
+	const double *inF[3] = { p->fx, p->fy, p->fz };
+	int index, row, col;
+
+	for (row = 0; row < 3; row++)
+	{
+		for (col = 0; col < p->cols; col++)
+			G[row][col] = VSET1(p->G[row][col]);
+		cm[row] = VSET1(p->cm[row]);
+		force[row] = VSET1(p->force[row]);
+	} //end for
+
+	for (index = begin; index + VWIDTH <= end; index += VWIDTH)
+	{
+		qq[0] = VLOAD(p->qx + index);
+		qq[1] = VLOAD(p->qy + index);
+		qq[2] = VLOAD(p->qz + index);
+
+		if (p->cols == 9)
+		{
+			qq[3] = VMUL(qq[0], qq[0]);
+			qq[4] = VMUL(qq[1], qq[1]);
+			qq[5] = VMUL(qq[2], qq[2]);
+			qq[6] = VMUL(qq[0], qq[1]);
+			qq[7] = VMUL(qq[1], qq[2]);
+			qq[8] = VMUL(qq[2], qq[0]);
+
+			for (row = 0; row < 3; row++)
+			{
+				g[row] = VZERO();
+				for (col = 0; col < 9; col++)
+					g[row] = VADD(g[row], VMUL(G[row][col], qq[col]));
+			} //end for
+		} //end if
+		else
+		{
+			for (row = 0; row < 3; row++)
+				g[row] = VADD(VADD(VMUL(G[row][0], qq[0]), VMUL(G[row][1], qq[1])), VMUL(G[row][2], qq[2]));
+		} //end else
+
+		hm = VDIV(h, VLOAD(p->mass + index));
+		active = VACTIVE(VLOAD(p->y + index), frozenY);
+
+		for (row = 0; row < 3; row++)
+		{
+			pos[row] = VLOAD(outPos[row] + index);
+			vel[row] = VLOAD(outVel[row] + index);
+			f[row] = VADD(VLOAD(inF[row] + index), force[row]);
+
+			g[row] = VADD(g[row], cm[row]);
+			v[row] = VADD(vel[row], VADD(VMUL(VSUB(g[row], pos[row]), alphaOverH), VMUL(f[row], hm)));
+			v[row] = VADD(v[row], VMUL(v[row], negDelta));
+			newPos[row] = VADD(pos[row], VMUL(v[row], h));
+
+			VSTORE(outPos[row] + index, VSELECT(active, newPos[row], pos[row]));
+			VSTORE(outVel[row] + index, VSELECT(active, v[row], vel[row]));
+			v[row] = VSELECT(active, v[row], VZERO());
+		} //end for
+
+		sumX = VADD(sumX, v[0]);
+		sumY = VADD(sumY, v[1]);
+		sumZ = VADD(sumZ, v[2]);
+	} //end for
+
+	velSum[0] += vecHSum(sumX);
+	velSum[1] += vecHSum(sumY);
+	velSum[2] += vecHSum(sumZ);
+
+	for (; index < end; index++)
+		scalarIntegrateVertex(p, index, velSum);
+} //end vecIntegrate
+
+/* Function: vecBoundRadius2
+ * Description: Vector version of scalarBoundRadius2
+ */
+static double vecBoundRadius2(const double *x, const double *y, const double *z, int count, const double center[3])
+{
+	VEC cx = VSET1(center[0]), cy = VSET1(center[1]), cz = VSET1(center[2]);
+	VEC best = VZERO(), dx, dy, dz, dist2;
+	double lanes[VWIDTH];
+	double radius2 = 0.0;
+	int index;
+
+	for (index = 0; index + VWIDTH <= count; index += VWIDTH)
+	{
+		dx = VSUB(cx, VLOAD(x + index));
+		dy = VSUB(cy, VLOAD(y + index));
+		dz = VSUB(cz, VLOAD(z + index));
+		dist2 = VADD(VADD(VMUL(dx, dx), VMUL(dy, dy)), VMUL(dz, dz));
+		best = VMAX(dist2, best);
+	} //end for
+
+	VSTORE(lanes, best);
+	for (int i = 0; i < VWIDTH; i++)
+		if (lanes[i] > radius2)
+			radius2 = lanes[i];
+
+	if (index < count)
+	{
+		double tail = scalarBoundRadius2(x + index, y + index, z + index, count - index, center);
+		if (tail > radius2)
+			radius2 = tail;
+	} //end if
+
+	return radius2;
+} //end vecBoundRadius2
+
+
+/* Function: vecCross
+ * Description: c = a x b, lane by lane
+ */
+static inline void vecCross(const VEC a[3], const VEC b[3], VEC c[3])
+{
+	c[0] = VSUB(VMUL(a[1], b[2]), VMUL(a[2], b[1]));
+	c[1] = VSUB(VMUL(a[2], b[0]), VMUL(a[0], b[2]));
+	c[2] = VSUB(VMUL(a[0], b[1]), VMUL(a[1], b[0]));
+} //end vecCross
+
+/* Function: vecAbs
+ * Description: |a|, lane by lane
+ */
+static inline VEC vecAbs(VEC a)
+{
+	return VMAX(a, VSUB(VZERO(), a));
+} //end vecAbs
+
+/* Function: vecEigenIsolated
+ * Description: Vector version of eigenIsolated (eig3.cpp)
+ */
+static inline void vecEigenIsolated(VEC B[3][3], VEC lambda, VEC v[3])
+{
+	VEC r[3][3], c[3][3], len2[3], best[3], bestLen2, inv;
+	VMASK larger, valid;
+	int i, j;
+
+	for (i = 0; i < 3; i++)
+		for (j = 0; j < 3; j++)
+			r[i][j] = (i == j) ? VSUB(B[i][j], lambda) : B[i][j];
+
+	vecCross(r[0], r[1], c[0]);
+	vecCross(r[0], r[2], c[1]);
+	vecCross(r[1], r[2], c[2]);
+	for (i = 0; i < 3; i++)
+		len2[i] = VADD(VADD(VMUL(c[i][0], c[i][0]), VMUL(c[i][1], c[i][1])), VMUL(c[i][2], c[i][2]));
+
+	bestLen2 = len2[0];
+	for (j = 0; j < 3; j++)
+		best[j] = c[0][j];
+	for (i = 1; i < 3; i++)
+	{
+		larger = VACTIVE(len2[i], bestLen2);
+		for (j = 0; j < 3; j++)
+			best[j] = VSELECT(larger, c[i][j], best[j]);
+		bestLen2 = VSELECT(larger, len2[i], bestLen2);
+	} //end for
+
+	valid = VACTIVE(bestLen2, VZERO());
+	inv = VDIV(VSET1(1.0), VSQRT(VSELECT(valid, bestLen2, VSET1(1.0))));
+	v[0] = VSELECT(valid, VMUL(best[0], inv), VSET1(1.0));
+	v[1] = VSELECT(valid, VMUL(best[1], inv), VZERO());
+	v[2] = VSELECT(valid, VMUL(best[2], inv), VZERO());
+} //end vecEigenIsolated
+
+/* Function: vecEigenPlane
+ * Description: Vector version of eigenPlane (eig3.cpp)
+ */
+static inline void vecEigenPlane(VEC B[3][3], const VEC w[3], VEC lo[3], VEC hi[3], VEC d[2])
+{
+	VEC u[3], t[3], Bu[3], Bt[3], ux[3], uy[3], e1[3], e2[3];
+	VEC one = VSET1(1.0), invX, invY, m00, m01, m11, tau, tn, cs, sn, d1, d2;
+	VMASK xLarger, rotate, swap;
+	int i;
+
+	// u, t: orthonormal basis of the plane orthogonal to w, with u x t = w
+	invX = VDIV(one, VSQRT(VADD(VMUL(w[0], w[0]), VMUL(w[2], w[2]))));
+	invY = VDIV(one, VSQRT(VADD(VMUL(w[1], w[1]), VMUL(w[2], w[2]))));
+	ux[0] = VMUL(VSUB(VZERO(), w[2]), invX);
+	ux[1] = VZERO();
+	ux[2] = VMUL(w[0], invX);
+	uy[0] = VZERO();
+	uy[1] = VMUL(w[2], invY);
+	uy[2] = VMUL(VSUB(VZERO(), w[1]), invY);
+	xLarger = VACTIVE(vecAbs(w[0]), vecAbs(w[1]));
+	for (i = 0; i < 3; i++)
+		u[i] = VSELECT(xLarger, ux[i], uy[i]);
+	vecCross(w, u, t);
+
+	for (i = 0; i < 3; i++)
+	{
+		Bu[i] = VADD(VADD(VMUL(B[i][0], u[0]), VMUL(B[i][1], u[1])), VMUL(B[i][2], u[2]));
+		Bt[i] = VADD(VADD(VMUL(B[i][0], t[0]), VMUL(B[i][1], t[1])), VMUL(B[i][2], t[2]));
+	} //end for
+	m00 = VADD(VADD(VMUL(u[0], Bu[0]), VMUL(u[1], Bu[1])), VMUL(u[2], Bu[2]));
+	m01 = VADD(VADD(VMUL(u[0], Bt[0]), VMUL(u[1], Bt[1])), VMUL(u[2], Bt[2]));
+	m11 = VADD(VADD(VMUL(t[0], Bt[0]), VMUL(t[1], Bt[1])), VMUL(t[2], Bt[2]));
+
+	// Jacobi rotation zeroing m01, tn = tan of its angle (0 in the lanes where m01 already is)
+	rotate = VACTIVE(vecAbs(m01), VZERO());
+	tau = VDIV(VSUB(m11, m00), VMUL(VSET1(2.0), VSELECT(rotate, m01, one)));
+	tn = VDIV(one, VADD(vecAbs(tau), VSQRT(VADD(one, VMUL(tau, tau)))));
+	tn = VSELECT(VACTIVE(VZERO(), tau), VSUB(VZERO(), tn), tn);
+	tn = VSELECT(rotate, tn, VZERO());
+	cs = VDIV(one, VSQRT(VADD(one, VMUL(tn, tn))));
+	sn = VMUL(tn, cs);
+	d1 = VSUB(m00, VMUL(tn, m01));
+	d2 = VADD(m11, VMUL(tn, m01));
+
+	// e1 x e2 = w, the order is swapped by turning e1 around
+	swap = VACTIVE(d1, d2);
+	for (i = 0; i < 3; i++)
+	{
+		e1[i] = VSUB(VMUL(cs, u[i]), VMUL(sn, t[i]));
+		e2[i] = VADD(VMUL(sn, u[i]), VMUL(cs, t[i]));
+		lo[i] = VSELECT(swap, e2[i], e1[i]);
+		hi[i] = VSELECT(swap, VSUB(VZERO(), e1[i]), e2[i]);
+	} //end for
+	d[0] = VSELECT(swap, d2, d1);
+	d[1] = VSELECT(swap, d1, d2);
+} //end vecEigenPlane
+
+/* Function: vecEigen3
+ * Description: Vector version of scalarEigen3, one matrix per lane, with the steps of eigen_analytic.
+ *				Every branch of the scalar version becomes a lane select. As there is no vector acos
+ *				or cos, c = cos(acos(r) / 3) is solved from the triple angle formula written as
+ *				(2c - 1) sqrt(c + 1) = sqrt(2) t with t = sqrt((1 + r) / 2), whose derivative does not
+ *				vanish on [1/2, 1]: three Newton steps from a quadratic guess in t reach the rounding
+ *				of acos / cos for every r. The matrices after the last full register are decomposed by
+ *				eigen_analytic.
+ */
+static void vecEigen3(const double *A, double *V, double *d, int count)
+{
+	static const int upper[6][2] = { {0, 0}, {0, 1}, {0, 2}, {1, 1}, {1, 2}, {2, 2} };
+	double lanes[9][VWIDTH], out[12][VWIDTH];
+	VEC a[6], B[3][3], w[3], Bw[3], lo[3], hi[3], col[3], plane[2], beta[3];
+	VEC one = VSET1(1.0), half = VSET1(0.5), scale, q, p2, p, invP, r, t, c, s, root, isolated;
+	VMASK degenerate, smallest;
+	int index, lane, i, j, k;
+
+	for (index = 0; index + VWIDTH <= count; index += VWIDTH)
+	{
+		for (lane = 0; lane < VWIDTH; lane++)
+			for (k = 0; k < 6; k++)
+				lanes[k][lane] = A[9*(index + lane) + 3*upper[k][0] + upper[k][1]];
+
+		scale = VZERO();
+		for (k = 0; k < 6; k++)
+		{
+			a[k] = VLOAD(lanes[k]);
+			scale = VMAX(vecAbs(a[k]), scale);
+		} //end for
+		scale = VSELECT(VACTIVE(scale, VZERO()), scale, one);
+		for (k = 0; k < 6; k++)
+		{
+			a[k] = VDIV(a[k], scale);
+			B[upper[k][0]][upper[k][1]] = B[upper[k][1]][upper[k][0]] = a[k];
+		} //end for
+
+		q = VDIV(VADD(VADD(B[0][0], B[1][1]), B[2][2]), VSET1(3.0));
+		for (i = 0; i < 3; i++)
+			B[i][i] = VSUB(B[i][i], q);
+		p2 = VADD(VADD(VMUL(B[0][0], B[0][0]), VMUL(B[1][1], B[1][1])), VMUL(B[2][2], B[2][2]));
+		p2 = VADD(p2, VMUL(VSET1(2.0), VADD(VADD(VMUL(B[0][1], B[0][1]), VMUL(B[0][2], B[0][2])), VMUL(B[1][2], B[1][2]))));
+		p2 = VDIV(p2, VSET1(6.0));
+
+		// The lanes of multiples of the identity run on p = 1 and are replaced at the end
+		degenerate = VACTIVE(VSET1(EIG3DEGENERATE), p2);
+		p = VSQRT(VSELECT(degenerate, one, p2));
+		invP = VDIV(one, p);
+		for (i = 0; i < 3; i++)
+			for (j = 0; j < 3; j++)
+				B[i][j] = VMUL(B[i][j], invP);
+
+		r = VMUL(B[0][0], VSUB(VMUL(B[1][1], B[2][2]), VMUL(B[1][2], B[1][2])));
+		r = VSUB(r, VMUL(B[0][1], VSUB(VMUL(B[0][1], B[2][2]), VMUL(B[1][2], B[0][2]))));
+		r = VADD(r, VMUL(B[0][2], VSUB(VMUL(B[0][1], B[1][2]), VMUL(B[1][1], B[0][2]))));
+		r = VMUL(half, r);
+		r = VMAX(r, VSET1(-1.0));
+		r = VSELECT(VACTIVE(r, one), one, r);
+
+		t = VSQRT(VMUL(half, VADD(one, r)));
+		c = VADD(half, VMUL(t, VSUB(VSET1(0.5773502691896258), VMUL(VSET1(0.0773502691896258), t))));
+		for (k = 0; k < 3; k++)
+		{
+			root = VSQRT(VADD(c, one));
+			c = VSUB(c, VDIV(VSUB(VMUL(VSET1(2.0), VMUL(VSUB(VADD(c, c), one), VADD(c, one))),
+								  VMUL(VSET1(2.0 * 1.4142135623730951), VMUL(t, root))),
+							 VADD(VMUL(VSET1(6.0), c), VSET1(3.0))));
+		} //end for
+		s = VSQRT(VMAX(VSUB(one, VMUL(c, c)), VZERO()));
+
+		// r < 0: the smallest eigenvalue is the isolated one, otherwise the largest
+		smallest = VACTIVE(VZERO(), r);
+		vecEigenIsolated(B, VSELECT(smallest, VSUB(VSUB(VZERO(), c), VMUL(VSET1(SQRT3), s)), VADD(c, c)), w);
+
+		for (i = 0; i < 3; i++)
+			Bw[i] = VADD(VADD(VMUL(B[i][0], w[0]), VMUL(B[i][1], w[1])), VMUL(B[i][2], w[2]));
+		isolated = VADD(VADD(VMUL(w[0], Bw[0]), VMUL(w[1], Bw[1])), VMUL(w[2], Bw[2]));
+		vecEigenPlane(B, w, lo, hi, plane);
+
+		for (i = 0; i < 3; i++)
+		{
+			col[0] = VSELECT(smallest, w[i], lo[i]);
+			col[1] = VSELECT(smallest, lo[i], hi[i]);
+			col[2] = VSELECT(smallest, hi[i], w[i]);
+			for (j = 0; j < 3; j++)
+				VSTORE(out[3*i + j], VSELECT(degenerate, (i == j) ? one : VZERO(), col[j]));
+		} //end for
+
+		beta[0] = VSELECT(smallest, isolated, plane[0]);
+		beta[1] = VSELECT(smallest, plane[0], plane[1]);
+		beta[2] = VSELECT(smallest, plane[1], isolated);
+		for (i = 0; i < 3; i++)
+			VSTORE(out[9 + i], VMUL(VADD(q, VSELECT(degenerate, VZERO(), VMUL(p, beta[i]))), scale));
+
+		for (lane = 0; lane < VWIDTH; lane++)
+		{
+			for (k = 0; k < 9; k++)
+				V[9*(index + lane) + k] = out[k][lane];
+			for (k = 0; k < 3; k++)
+				d[3*(index + lane) + k] = out[9 + k][lane];
+		} //end for
+	} //end for
+
+	for (; index < count; index++)
+		eigen_analytic( (const double (*)[3])(A + 9*index), (double (*)[3])(V + 9*index), d + 3*index);
+} //end vecEigen3
+
+/* Function: vecCollide
+ * Description: Vector version of scalarCollide. Every vertex is tested against every plane and box, and
+ *				the responses are kept in the lanes that touch them only, without a branch. The vertices
+ *				after the last full register are pushed back by scalarCollideVertex.
+ */
+static void vecCollide(const simdContactParams *p, int begin, int end)
+{
+	const simdContactBox *box;
+	VEC zero = VZERO(), kWall = VSET1(p->kWall), negDWall = VSET1(-p->dWall), preload = VSET1(p->preload);
+	VEC pos[3], f[3], damp[3], n[3], d[3], l[3], gap[3], m, dot, s, best, side;
+	VMASK outside, closer, negative, inside, frozen;
+	double *outF[3] = { p->fx, p->fy, p->fz };
+	double flags[VWIDTH];
+	int index, k, a;
+
+	for (index = begin; index + VWIDTH <= end; index += VWIDTH)
+	{
+		pos[0] = VLOAD(p->x + index);
+		pos[1] = VLOAD(p->y + index);
+		pos[2] = VLOAD(p->z + index);
+		m = VLOAD(p->mass + index);
+
+		f[0] = zero;
+		f[1] = VSET1(p->gravity);
+		f[2] = zero;
+		damp[0] = VMUL(VMUL(negDWall, m), VLOAD(p->vx + index));
+		damp[1] = VMUL(VMUL(negDWall, m), VLOAD(p->vy + index));
+		damp[2] = VMUL(VMUL(negDWall, m), VLOAD(p->vz + index));
+
+		for (int i = 0; i < p->numPlanes; i++)
+		{
+			n[0] = VSET1(p->nx[i]);
+			n[1] = VSET1(p->ny[i]);
+			n[2] = VSET1(p->nz[i]);
+			dot = VADD(VADD(VMUL(n[0], pos[0]), VMUL(n[1], pos[1])), VMUL(n[2], pos[2]));
+			outside = VACTIVE(dot, VSET1(p->offset[i]));
+			s = VMUL(VMUL(kWall, VSUB(VSET1(p->anchor[i]), dot)), m);
+			for (k = 0; k < 3; k++)
+				f[k] = VADD(f[k], VSELECT(outside, zero, VADD(VMUL(n[k], s), damp[k])));
+		} //end for
+
+		for (int i = 0; i < p->numBoxes; i++)
+		{
+			box = &p->boxes[i];
+			for (k = 0; k < 3; k++)
+				d[k] = VSUB(pos[k], VSET1(box->center[k]));
+			for (a = 0; a < 3; a++)
+			{
+				l[a] = VADD(VADD(VMUL(VSET1(box->axis[a][0]), d[0]), VMUL(VSET1(box->axis[a][1]), d[1])),
+					VMUL(VSET1(box->axis[a][2]), d[2]));
+				gap[a] = VSUB(VSET1(box->half[a]), vecAbs(l[a]));
+			} //end for
+
+			// Nearest face of every lane, and the side of the box it is on
+			best = gap[0];
+			side = l[0];
+			for (k = 0; k < 3; k++)
+				n[k] = VSET1(box->axis[0][k]);
+			for (a = 1; a < 3; a++)
+			{
+				closer = VACTIVE(best, gap[a]);
+				best = VSELECT(closer, gap[a], best);
+				side = VSELECT(closer, l[a], side);
+				for (k = 0; k < 3; k++)
+					n[k] = VSELECT(closer, VSET1(box->axis[a][k]), n[k]);
+			} //end for
+
+			inside = VACTIVE(best, zero);
+			negative = VACTIVE(zero, side);
+			s = VMUL(VMUL(kWall, VADD(best, preload)), m);
+			for (k = 0; k < 3; k++)
+			{
+				n[k] = VSELECT(negative, VSUB(zero, n[k]), n[k]);
+				f[k] = VADD(f[k], VSELECT(inside, VADD(VMUL(n[k], s), damp[k]), zero));
+			} //end for
+		} //end for
+
+		if (p->frozen != NULL)
+		{
+			for (k = 0; k < VWIDTH; k++)
+				flags[k] = p->frozen[index - begin + k] ? 1.0 : 0.0;
+			frozen = VACTIVE(VLOAD(flags), zero);
+			for (k = 0; k < 3; k++)
+				f[k] = VSELECT(frozen, VLOAD(outF[k] + index), f[k]);
+		} //end if
+
+		for (k = 0; k < 3; k++)
+			VSTORE(outF[k] + index, f[k]);
+	} //end for
+
+	for (; index < end; index++)
+		if (p->frozen == NULL || !p->frozen[index - begin])
+			scalarCollideVertex(p, index);
+} //end vecCollide
+
+#endif
+
+#endif
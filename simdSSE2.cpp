@@ -0,0 +1,43 @@
+/* Source: simdSSE2
+ * Description: SSE2 versions of the fused step kernels, 2 vertices per instruction.
+ */
+
+#include "simd.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+#define VWIDTH 2
+#define VEC __m128d
+#define VMASK __m128d
+#define VLOAD(p) _mm_loadu_pd(p)
+#define VSTORE(p, v) _mm_storeu_pd(p, v)
+#define VSET1(d) _mm_set1_pd(d)
+#define VZERO() _mm_setzero_pd()
+#define VADD(a, b) _mm_add_pd(a, b)
+#define VSUB(a, b) _mm_sub_pd(a, b)
+#define VMUL(a, b) _mm_mul_pd(a, b)
+#define VDIV(a, b) _mm_div_pd(a, b)
+#define VSQRT(a) _mm_sqrt_pd(a)
+#define VMAX(a, b) _mm_max_pd(a, b)
+#define VACTIVE(y, t) _mm_cmpnle_pd(y, t)
+#define VSELECT(m, a, b) _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b))
+
+#include "simdKernels.h"
+
+static const simdKernels kernels = { vecReduce, vecIntegrate, vecBoundRadius2, vecEigen3, vecCollide };
+
+const simdKernels * simdKernelsSSE2()
+{
+	return &kernels;
+}
+
+#else
+
+const simdKernels * simdKernelsSSE2()
+{
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,225 @@
+/* Source: simulation
+ * Description: Contains the simulation world that owns the bodies and steps them.
+ */
+
+#include "simulation.h"
+
+// Constructor
+simWorld::simWorld()
+{
+	h = 0.002;
+	n = 4;
+	alpha = 0.1;
+	beta = 0.15;
+	delta = 0.01;
+	kWall = 70.0;
+	dWall = 0.2;
+	gravity = -0.7;
+	deformMode = 0;
+	stickyFloor = 0;
+	fusedStep = false;
+	simdLevel = simdDetect();
+	rotationMode = ROTATION_ITERATIVE;
+	sleepVel = 0.05;
+	sleepSteps = 200;
+	userForce = vMake(0.0);
+	dragModel = -1;
+	time = 0.0;
+	objCollide = false;
+	modelCounter = -1;
+
+	pool = new threadPool(1);
+	modelArray = NULL;
+	numModels = 0;
+	modelCapacity = 0;
+	modelsChanged = true;
+	broad = new broadPhase();
+	arena = new collisionWorld();
+	shapes = new shapeCache();
+	profiler = NULL;
+
+	// The list always ends with an empty node
+	models = (pModel*)malloc(sizeof(pModel));
+	memset( (void*)models, 0, sizeof(pModel));
+	models->mIndex = -1;
+	models->next = NULL;
+}
+
+// Destructor
+simWorld::~simWorld()
+{
+	DeleteModels();
+	free(models);
+	free(modelArray);
+	delete broad;
+	delete arena;
+	delete shapes;
+	delete pool;
+	delete profiler;
+}
+
+/* Function: AddModel
+ * Description: Adds a body of a model file to the front of the list, loading the file and its rest
+ *				state only for its first body
+ * Input: filename - name of model input file
+ *		  translate - offset applied to the model vertices after loading
+ *		  mode - deformation mode of the new body
+ * Output: The new body
+ */
+pModel * simWorld::AddModel(char *filename, point translate, int mode)
+{
+	pModel *node;
+	node = (pModel*)malloc(sizeof(pModel));
+	node->next = models;
+	models = node;
+
+	node->mIndex = ++modelCounter;
+	node->pObj = new phyzx();
+
+	strcpy(node->file, filename);
+
+	// Initialize the Physics module
+	phyzxInit(node->pObj, shapes->Acquire(node->file, this), this);
+
+	node->translate = translate;
+	node->pObj->deformMode = mode;
+
+	for (int index = 0; index < node->pObj->numVertices; index++)
+	{
+		node->pObj->position.x[index] += node->translate.x;
+		node->pObj->position.y[index] += node->translate.y;
+		node->pObj->position.z[index] += node->translate.z;
+	}
+
+	for (unsigned int index = STARTFROM; index <= node->pObj->model->numvertices; index++)
+	{
+		node->pObj->model->vertices[3*index] += node->translate.x;
+		node->pObj->model->vertices[3*index + 1] += node->translate.y;
+		node->pObj->model->vertices[3*index + 2] += node->translate.z;
+
+		node->pObj->model->verticesRest[3*index] += node->translate.x;
+		node->pObj->model->verticesRest[3*index + 1] += node->translate.y;
+		node->pObj->model->verticesRest[3*index + 2] += node->translate.z;
+	}
+
+	// Compute the center of the model with  the radius of the bounding sphere
+	CalcBoundSphere(node->pObj, &node->cModel, &node->radius);
+	node->pObj->tree->Refit(node->pObj->position);
+
+	return node;
+}
+
+/* Function: DeleteModels
+ * Description: Removes and frees all the bodies in the list
+ * Input: None
+ * Output: None
+ */
+void simWorld::DeleteModels()
+{
+	pModel *next, *cur;
+
+	next = models;
+	while(next->next != NULL)
+	{
+		cur = next;
+		next = next->next;
+		phyzxDelete(cur->pObj);
+		free(cur);
+	}
+	models = next;
+	models->mIndex = -1;
+
+	modelCounter = -1;
+}
+
+/* Function: SetThreads
+ * Description: Replaces the thread pool by one with the given number of threads
+ * Input: numThreads - threads stepping the bodies, including the calling one
+ * Output: None
+ */
+void simWorld::SetThreads(int numThreads)
+{
+	if (numThreads < 1)
+		numThreads = 1;
+	if (numThreads == pool->NumThreads())
+		return;
+
+	delete pool;
+	pool = new threadPool(numThreads);
+}
+
+/* Function: SetProfiling
+ * Description: Starts or stops measuring the phases of the timesteps, starting again drops the old times
+ * Input: on - measure the phases
+ * Output: None
+ */
+void simWorld::SetProfiling(bool on)
+{
+	if (on && profiler == NULL)
+		profiler = new phaseProfiler();
+	else if (!on && profiler != NULL)
+	{
+		delete profiler;
+		profiler = NULL;
+	} //end if
+}
+
+/* Function: CollectModels
+ * Description: Fills modelArray with the bodies of the list, in list order, and notes whether
+ *				it changed since the last call
+ * Input: None
+ * Output: None
+ */
+void simWorld::CollectModels()
+{
+	int count = 0;
+
+	modelsChanged = false;
+	for (pModel *temp = models; temp->next != NULL; temp = temp->next)
+	{
+		if (count == modelCapacity)
+		{
+			modelCapacity = (modelCapacity == 0) ? 16 : 2 * modelCapacity;
+			modelArray = (pModel **)realloc(modelArray, modelCapacity * sizeof(pModel *));
+		}
+		if (count >= numModels || modelArray[count] != temp)
+			modelsChanged = true;
+		modelArray[count++] = temp;
+	}
+	if (count != numModels)
+		modelsChanged = true;
+	numModels = count;
+}
+
+/* Function: WakeModels
+ * Description: Wakes every body, after a change of the parameters all of them are stepped with
+ * Input: None
+ * Output: None
+ */
+void simWorld::WakeModels()
+{
+	for (pModel *temp = models; temp->next != NULL; temp = temp->next)
+		WakeModel(temp->pObj);
+}
+
+/* Function: WriteRenderPositions
+ * Description: Copies the simulated positions of every body into its model vertices
+ * Input: None
+ * Output: None
+ */
+void simWorld::WriteRenderPositions()
+{
+	for (pModel *temp = models; temp->next != NULL; temp = temp->next)
+		::WriteRenderPositions(temp->pObj);
+}
+
+/* Function: step
+ * Description: Advances every body in the world by a number of timesteps
+ * Input: steps - number of timesteps of length h to perform
+ * Output: None
+ */
+void simWorld::step(int steps)
+{
+	for (int i = 0; i < steps; i++)
+		CallPerFrame(this);
+}
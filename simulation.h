@@ -0,0 +1,69 @@
+/* Header: simulation
+ * Description: Header file for the simulation world. The world owns every body in the
+ *				scene together with the parameters used to step them, and does not depend
+ *				on OpenGL, GLUT or GLUI so that it can be driven without a window.
+ */
+
+#ifndef _SIMULATION_H_
+#define _SIMULATION_H_
+
+#include "physics.h"
+#include "simd.h"
+#include "threadPool.h"
+#include "broadPhase.h"
+#include "collisionWorld.h"
+#include "shapeCache.h"
+#include "profiler.h"
+
+class simWorld
+{
+public:
+		double h;					// timestep
+		int n;						// number of substeps per displayed frame
+		double alpha;				// Stiffness [0..1] given to new bodies
+		double beta;				// Linear and Quadratic deformation value given to new bodies
+		double delta;				// Velocity Damping given to new bodies
+		double kWall;				// Hooks law co-efficient given to new bodies
+		double dWall;				// Damping co-efficient given to new bodies
+		double gravity;				// Gravity along the y axis
+		int deformMode;				// Deformation mode given to new bodies
+		int stickyFloor;			// Vertices touching the floor are not integrated (1) or are (0)
+		bool fusedStep;				// Step the bodies with FusedStep (true) or the separate passes (false)
+		int simdLevel;				// Instruction set used by FusedStep (SIMD_SCALAR .. SIMD_AVX512)
+		int rotationMode;			// Rotation of Apq by ROTATION_POLAR or ROTATION_ITERATIVE
+		double sleepVel;			// Bodies whose vertices stay slower than this fall asleep
+		int sleepSteps;				// Timesteps a body has to stay that slow before it sleeps (0 never sleeps)
+
+		point userForce;			// Force applied by the user to the dragged body
+		int dragModel;				// mIndex of the body being dragged by the user (-1 for none)
+
+		double time;				// Simulated seconds, advanced by h every timestep
+		bool objCollide;			// Some bodies' bounding spheres touched in the last timestep
+		pModel *models;				// List of bodies, terminated by an empty node
+		int modelCounter;			// Index given to the last body added
+
+		threadPool *pool;			// Threads stepping the bodies
+		pModel **modelArray;		// The bodies of the list, indexed for the thread pool
+		int numModels;				// Number of bodies in modelArray
+		int modelCapacity;			// Allocated size of modelArray
+		bool modelsChanged;			// modelArray differs from the one of the last timestep
+
+		broadPhase *broad;			// Touching pairs of bounding spheres, found once per timestep
+		collisionWorld *arena;		// Planes and boxes the vertices collide with, the walls of the box by default
+		shapeCache *shapes;			// Rest shapes of the loaded model files
+		phaseProfiler *profiler;	// Times of the phases of the timesteps, NULL when they are not measured
+
+		simWorld();
+		~simWorld();
+
+		pModel * AddModel(char *filename, point translate, int mode);
+		void DeleteModels();
+		void SetThreads(int numThreads);
+		void SetProfiling(bool on);
+		void CollectModels();
+		void WakeModels();
+		void WriteRenderPositions();
+		void step(int steps);
+};
+
+#endif
@@ -0,0 +1,270 @@
+/* Source: threadPool
+ * Description: Fixed pool of worker threads used to run the per-body and per-vertex loops in parallel.
+ */
+
+#include <stdlib.h>
+#include "threadPool.h"
+
+#ifdef WIN32
+  #include <process.h>
+#else
+  #include <unistd.h>
+#endif
+
+#ifdef WIN32
+static unsigned __stdcall workerMain(void *pool)
+{
+	((threadPool *)pool)->workerLoop();
+	return 0;
+}
+#else
+static void * workerMain(void *pool)
+{
+	((threadPool *)pool)->workerLoop();
+	return NULL;
+}
+#endif
+
+/* Function: threadPool
+ * Description: Starts numThreads - 1 workers, the thread calling parallelFor is the last one
+ * Input: numThreads - number of threads running the parallel loops (at least 1)
+ */
+threadPool::threadPool(int numThreads)
+{
+	if (numThreads < 1)
+		numThreads = 1;
+
+	this->numThreads = numThreads;
+	quit = false;
+	busy = false;
+	task = NULL;
+	context = NULL;
+	count = 0;
+	grain = 1;
+	next = 0;
+	remaining = 0;
+	generation = 0;
+
+#ifdef WIN32
+	InitializeCriticalSection(&lock);
+	InitializeConditionVariable(&workReady);
+	InitializeConditionVariable(&workDone);
+	threads = (HANDLE *)calloc(numThreads, sizeof(HANDLE));
+	for (int i = 0; i < numThreads - 1; i++)
+		threads[i] = (HANDLE)_beginthreadex(NULL, 0, workerMain, this, 0, NULL);
+#else
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&workReady, NULL);
+	pthread_cond_init(&workDone, NULL);
+	threads = (pthread_t *)calloc(numThreads, sizeof(pthread_t));
+	for (int i = 0; i < numThreads - 1; i++)
+		pthread_create(&threads[i], NULL, workerMain, this);
+#endif
+}
+
+/* Function: ~threadPool
+ * Description: Stops and joins the workers
+ */
+threadPool::~threadPool()
+{
+	Lock();
+	quit = true;
+	WakeAll(0);
+	Unlock();
+
+	for (int i = 0; i < numThreads - 1; i++)
+	{
+#ifdef WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else
+		pthread_join(threads[i], NULL);
+#endif
+	}
+	free(threads);
+
+#ifdef WIN32
+	DeleteCriticalSection(&lock);
+#else
+	pthread_cond_destroy(&workDone);
+	pthread_cond_destroy(&workReady);
+	pthread_mutex_destroy(&lock);
+#endif
+}
+
+/* Function: hardwareThreads
+ * Description: Number of hardware threads of the machine
+ * Input: None
+ * Output: number of threads, at least 1
+ */
+int threadPool::hardwareThreads()
+{
+	int result = 1;
+
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	result = (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	result = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+	return (result < 1) ? 1 : result;
+}
+
+/* Function: parallelFor
+ * Description: Runs task on the ranges [i * grain, (i + 1) * grain) of [0, count) using all the threads
+ * Input: count - number of items
+ *		  grain - number of items per range
+ *		  task - work done on one range
+ *		  context - passed to task
+ * Output: None, returns when every range is done
+ */
+void threadPool::parallelFor(int count, int grain, threadTask task, void *context)
+{
+	bool serial = false;
+
+	if (count <= 0)
+		return;
+	if (grain < 1)
+		grain = 1;
+
+	if (numThreads == 1 || count <= grain)
+		serial = true;
+	else
+	{
+		Lock();
+		if (busy)
+			serial = true;
+		else
+		{
+			busy = true;
+			this->task = task;
+			this->context = context;
+			this->count = count;
+			this->grain = grain;
+			next = 0;
+			remaining = (count + grain - 1) / grain;
+			generation++;
+			WakeAll(0);
+		}
+		Unlock();
+	}
+
+	if (serial)
+	{
+		for (int begin = 0; begin < count; begin += grain)
+			task(context, begin, (begin + grain < count) ? begin + grain : count);
+		return;
+	}
+
+	RunRanges();
+
+	Lock();
+	while (remaining > 0)
+		Wait(1);
+	busy = false;
+	this->task = NULL;
+	Unlock();
+}
+
+/* Function: RunRanges
+ * Description: Takes ranges of the current parallel loop and runs them until none are left
+ * Input: None
+ * Output: None
+ */
+void threadPool::RunRanges()
+{
+	int begin, end;
+	threadTask curTask;
+	void *curContext;
+
+	for (;;)
+	{
+		Lock();
+		if (task == NULL || next >= count)
+		{
+			Unlock();
+			return;
+		}
+		begin = next;
+		end = (begin + grain < count) ? begin + grain : count;
+		next = end;
+		curTask = task;
+		curContext = context;
+		Unlock();
+
+		curTask(curContext, begin, end);
+
+		Lock();
+		remaining--;
+		if (remaining == 0)
+			WakeAll(1);
+		Unlock();
+	}
+}
+
+/* Function: workerLoop
+ * Description: Waits for parallel loops and helps running them until the pool is deleted
+ * Input: None
+ * Output: None
+ */
+void threadPool::workerLoop()
+{
+	unsigned int seen;
+
+	Lock();
+	seen = generation;
+	for (;;)
+	{
+		while (!quit && seen == generation)
+			Wait(0);
+		if (quit)
+			break;
+		seen = generation;
+		Unlock();
+
+		RunRanges();
+
+		Lock();
+	}
+	Unlock();
+}
+
+void threadPool::Lock()
+{
+#ifdef WIN32
+	EnterCriticalSection(&lock);
+#else
+	pthread_mutex_lock(&lock);
+#endif
+}
+
+void threadPool::Unlock()
+{
+#ifdef WIN32
+	LeaveCriticalSection(&lock);
+#else
+	pthread_mutex_unlock(&lock);
+#endif
+}
+
+// Waits on workDone (done = 1) or workReady (done = 0), the lock must be held
+void threadPool::Wait(int done)
+{
+#ifdef WIN32
+	SleepConditionVariableCS(done ? &workDone : &workReady, &lock, INFINITE);
+#else
+	pthread_cond_wait(done ? &workDone : &workReady, &lock);
+#endif
+}
+
+// Wakes every thread waiting on workDone (done = 1) or workReady (done = 0)
+void threadPool::WakeAll(int done)
+{
+#ifdef WIN32
+	WakeAllConditionVariable(done ? &workDone : &workReady);
+#else
+	pthread_cond_broadcast(done ? &workDone : &workReady);
+#endif
+}
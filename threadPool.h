@@ -0,0 +1,70 @@
+/* Header: threadPool
+ * Description: Header file for a fixed pool of worker threads that runs loops in parallel.
+ *				A loop over [0, count) is cut into ranges of grain items; the calling thread and the
+ *				workers take ranges until none are left, and parallelFor returns when all are done.
+ *				The ranges only depend on count and grain, never on the number of threads, so a task
+ *				that keeps one partial result per range gives the same result with any thread count.
+ *				A parallelFor started while the pool is already running one (e.g. from inside a task)
+ *				runs its ranges in order on the calling thread.
+ *				Same interface under Windows (Win32 threads, Vista or later) and Linux / Mac OS X (pthreads).
+ */
+
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#ifdef WIN32
+  #include <windows.h>
+#else
+  #include <pthread.h>
+#endif
+
+// Work done on the items [begin, end) of a parallel loop
+typedef void (*threadTask)(void *context, int begin, int end);
+
+class threadPool
+{
+public:
+		threadPool(int numThreads);
+		~threadPool();
+
+		int NumThreads() { return numThreads; }
+		void parallelFor(int count, int grain, threadTask task, void *context);
+
+		static int hardwareThreads();
+
+		void workerLoop();				// Body of the worker threads, not to be called directly
+
+protected:
+		void RunRanges();
+		void Lock();
+		void Unlock();
+		void Wait(int done);
+		void WakeAll(int done);
+
+		int numThreads;					// Threads running parallel loops, including the caller
+		bool quit;						// Workers leave when set
+		bool busy;						// A parallel loop is running
+
+		// Current parallel loop
+		threadTask task;
+		void *context;
+		int count;
+		int grain;
+		int next;						// First item of the next range to hand out
+		int remaining;					// Ranges not finished yet
+		unsigned int generation;		// Incremented for every parallel loop
+
+#ifdef WIN32
+		HANDLE *threads;
+		CRITICAL_SECTION lock;
+		CONDITION_VARIABLE workReady;
+		CONDITION_VARIABLE workDone;
+#else
+		pthread_t *threads;
+		pthread_mutex_t lock;
+		pthread_cond_t workReady;
+		pthread_cond_t workDone;
+#endif
+};
+
+#endif
@@ -0,0 +1,256 @@
+/* Source: trajectory
+ * Description: Golden trajectories of the bodies of a scene, recorded, stored and compared.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "trajectory.h"
+
+// Writes count elements of size bytes
+static bool WriteArray(FILE *file, const void *data, size_t size, size_t count)
+{
+	return fwrite(data, size, count, file) == count;
+}
+
+// Reads count elements of size bytes
+static bool ReadArray(FILE *file, void *data, size_t size, size_t count)
+{
+	return fread(data, size, count, file) == count;
+}
+
+// Keeps the largest of the values given, a value that is not a number staying the largest
+static bool KeepLargest(double value, double *largest)
+{
+	if (*largest != *largest || value <= *largest)
+		return false;
+	*largest = value;
+	return true;
+}
+
+// Constructor
+trajectory::trajectory()
+{
+	scene[0] = '\0';
+	numBodies = 0;
+	every = 1;
+	numVertices = NULL;
+	numSamples = 0;
+	steps = NULL;
+	times = NULL;
+	values = NULL;
+	capacity = 0;
+}
+
+// Destructor
+trajectory::~trajectory()
+{
+	Clear();
+}
+
+/* Function: Clear
+ * Description: Frees the samples and the bodies
+ * Input: None
+ * Output: None
+ */
+void trajectory::Clear()
+{
+	free(numVertices);
+	free(steps);
+	free(times);
+	free(values);
+	numVertices = NULL;
+	steps = NULL;
+	times = NULL;
+	values = NULL;
+	numBodies = 0;
+	numSamples = 0;
+	capacity = 0;
+}
+
+/* Function: Start
+ * Description: Drops the samples and takes the bodies of a world, whose samples are recorded next
+ * Input: world - world with the bodies of the scene
+ *		  scene - name of the scene
+ *		  every - timesteps between two samples
+ * Output: None
+ */
+void trajectory::Start(simWorld *world, const char *scene, int every)
+{
+	pModel *temp;
+	int body;
+
+	Clear();
+	strncpy(this->scene, scene, sizeof(this->scene) - 1);
+	this->scene[sizeof(this->scene) - 1] = '\0';
+	this->every = (every > 0) ? every : 1;
+
+	for (temp = world->models; temp->next != NULL; temp = temp->next)
+		numBodies++;
+	numVertices = (int *)malloc( (numBodies + 1) * sizeof(int));
+	for (temp = world->models, body = 0; temp->next != NULL; temp = temp->next, body++)
+		numVertices[body] = temp->pObj->numVertices;
+}
+
+/* Function: Record
+ * Description: Appends the center of mass, the rotation and the sampled vertices of every body of a world
+ * Input: world - world given to Start, after the timestep
+ *		  step - number of timesteps done
+ * Output: None
+ */
+void trajectory::Record(simWorld *world, int step)
+{
+	double *value;
+	phyzx *phyzxObj;
+	pModel *temp;
+	int vertex;
+
+	if (numSamples == capacity)
+	{
+		capacity = (capacity == 0) ? 64 : 2 * capacity;
+		steps = (int *)realloc(steps, capacity * sizeof(int));
+		times = (double *)realloc(times, capacity * sizeof(double));
+		values = (double *)realloc(values, (size_t)capacity * numBodies * TRAJECTORYVALUES * sizeof(double));
+	} //end if
+
+	steps[numSamples] = step;
+	times[numSamples] = world->time;
+	value = values + (size_t)numSamples * numBodies * TRAJECTORYVALUES;
+	for (temp = world->models; temp->next != NULL; temp = temp->next)
+	{
+		phyzxObj = temp->pObj;
+		*value++ = phyzxObj->cmDeformed.x;
+		*value++ = phyzxObj->cmDeformed.y;
+		*value++ = phyzxObj->cmDeformed.z;
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				*value++ = phyzxObj->R[row][col];
+		for (int i = 0; i < TRAJECTORYVERTICES; i++)
+		{
+			vertex = (int)( (long long)i * phyzxObj->numVertices / TRAJECTORYVERTICES);
+			*value++ = phyzxObj->position.x[vertex];
+			*value++ = phyzxObj->position.y[vertex];
+			*value++ = phyzxObj->position.z[vertex];
+		} //end for
+	} //end for
+	numSamples++;
+}
+
+/* Function: Write
+ * Description: Writes the trajectory to a file
+ * Input: filename - trajectory file
+ * Output: true if the file was written
+ */
+bool trajectory::Write(char *filename)
+{
+	FILE *file = fopen(filename, "wb");
+	trajectoryHeader header;
+	bool written;
+
+	if (file == NULL)
+		return false;
+
+	memset( (void*)&header, 0, sizeof(header));
+	memcpy(header.magic, "TRAJ", 4);
+	header.version = TRAJECTORYVERSION;
+	strcpy(header.scene, scene);
+	header.numBodies = numBodies;
+	header.every = every;
+	header.numSamples = numSamples;
+
+	written = WriteArray(file, &header, sizeof(header), 1) && WriteArray(file, numVertices, sizeof(int), numBodies);
+	for (int i = 0; i < numSamples && written; i++)
+		written = WriteArray(file, &steps[i], sizeof(int), 1) && WriteArray(file, &times[i], sizeof(double), 1) &&
+			WriteArray(file, values + (size_t)i * numBodies * TRAJECTORYVALUES, sizeof(double), numBodies * TRAJECTORYVALUES);
+
+	return (fclose(file) == 0) && written;
+}
+
+/* Function: Read
+ * Description: Reads a trajectory written by Write
+ * Input: filename - trajectory file
+ * Output: true if the file was read, the trajectory is left empty otherwise
+ */
+bool trajectory::Read(char *filename)
+{
+	FILE *file = fopen(filename, "rb");
+	trajectoryHeader header;
+	bool valid;
+
+	Clear();
+	if (file == NULL)
+		return false;
+
+	valid = ReadArray(file, &header, sizeof(header), 1) && memcmp(header.magic, "TRAJ", 4) == 0 &&
+		header.version == TRAJECTORYVERSION && header.numBodies >= 0 && header.numSamples >= 0;
+	if (valid)
+	{
+		memcpy(scene, header.scene, sizeof(scene));
+		scene[sizeof(scene) - 1] = '\0';
+		numBodies = header.numBodies;
+		every = header.every;
+		capacity = (header.numSamples > 0) ? header.numSamples : 1;
+		numVertices = (int *)malloc( (numBodies + 1) * sizeof(int));
+		steps = (int *)malloc(capacity * sizeof(int));
+		times = (double *)malloc(capacity * sizeof(double));
+		values = (double *)malloc( (size_t)capacity * numBodies * TRAJECTORYVALUES * sizeof(double) + 1);
+		valid = ReadArray(file, numVertices, sizeof(int), numBodies);
+	} //end if
+
+	for (numSamples = 0; valid && numSamples < header.numSamples; numSamples++)
+		valid = ReadArray(file, &steps[numSamples], sizeof(int), 1) && ReadArray(file, &times[numSamples], sizeof(double), 1) &&
+			ReadArray(file, values + (size_t)numSamples * numBodies * TRAJECTORYVALUES, sizeof(double), numBodies * TRAJECTORYVALUES);
+
+	fclose(file);
+	if (!valid)
+		Clear();
+	return valid;
+}
+
+/* Function: SameBodies
+ * Description: Tells whether two trajectories have the same bodies, so that their samples can be compared
+ * Input: other - other trajectory
+ * Output: true if both have as many bodies with the same numbers of vertices
+ */
+bool trajectory::SameBodies(const trajectory &other)
+{
+	if (numBodies != other.numBodies)
+		return false;
+	for (int body = 0; body < numBodies; body++)
+		if (numVertices[body] != other.numVertices[body])
+			return false;
+	return true;
+}
+
+/* Function: Compare
+ * Description: Largest distances between the bodies of two samples of trajectories with the same bodies
+ * Input: a, sampleA - first trajectory and its sample
+ *		  b, sampleB - second trajectory and its sample
+ * Output: divergence - largest distances
+ */
+void trajectory::Compare(const trajectory &a, int sampleA, const trajectory &b, int sampleB, trajectoryDivergence *divergence)
+{
+	const double *valueA = a.values + (size_t)sampleA * a.numBodies * TRAJECTORYVALUES;
+	const double *valueB = b.values + (size_t)sampleB * b.numBodies * TRAJECTORYVALUES;
+	double dx, dy, dz;
+
+	memset( (void*)divergence, 0, sizeof(trajectoryDivergence));
+	for (int body = 0; body < a.numBodies; body++, valueA += TRAJECTORYVALUES, valueB += TRAJECTORYVALUES)
+	{
+		dx = valueA[0] - valueB[0];
+		dy = valueA[1] - valueB[1];
+		dz = valueA[2] - valueB[2];
+		KeepLargest(sqrt(dx * dx + dy * dy + dz * dz), &divergence->cm);
+
+		for (int i = 3; i < 12; i++)
+			KeepLargest(fabs(valueA[i] - valueB[i]), &divergence->rotation);
+
+		for (int i = 12; i < TRAJECTORYVALUES; i += 3)
+		{
+			dx = valueA[i] - valueB[i];
+			dy = valueA[i + 1] - valueB[i + 1];
+			dz = valueA[i + 2] - valueB[i + 2];
+			if (KeepLargest(sqrt(dx * dx + dy * dy + dz * dz), &divergence->vertex))
+				divergence->body = body;
+		} //end for
+	} //end for
+}
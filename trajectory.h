@@ -0,0 +1,70 @@
+/* Header: trajectory
+ * Description: Header file for the golden trajectories, the state of every body of a scene sampled every
+ *				few timesteps: its center of mass, its rotation and some of its vertices, in double. A
+ *				trajectory recorded from the reference implementation is kept in a file, and the same
+ *				scene stepped another way (fused, vectorized, on several threads, ...) is compared with it
+ *				sample by sample, so that a change of the physics shows how far it moves the bodies away.
+ *				The file is a header, the number of vertices of every body, then every sample: its
+ *				timestep and time followed by TRAJECTORYVALUES doubles per body.
+ */
+
+#ifndef _TRAJECTORY_H_
+#define _TRAJECTORY_H_
+
+#include "simulation.h"
+
+#define TRAJECTORYVERSION 1			// Version of the trajectory files, changed with their layout
+#define TRAJECTORYSUFFIX ".golden"	// Suffix of the trajectory files
+#define TRAJECTORYVERTICES 16		// Vertices sampled per body, spread evenly over its vertices
+#define TRAJECTORYVALUES (3 + 9 + 3 * TRAJECTORYVERTICES)	// Doubles per body and sample: center of mass, R, vertices
+
+// First bytes of a trajectory file
+struct trajectoryHeader
+{
+	char magic[4];					// "TRAJ"
+	int version;					// TRAJECTORYVERSION
+	char scene[32];					// Scene the trajectory was recorded from
+	int numBodies;
+	int every;						// Timesteps between two samples
+	int numSamples;
+	int reserved;
+};
+
+// Largest distance between two samples of the same bodies
+struct trajectoryDivergence
+{
+	double cm;						// Between the centers of mass
+	double rotation;				// Between the elements of R
+	double vertex;					// Between the sampled vertices
+	int body;						// Body of the largest vertex distance, in the order of the list of bodies
+};
+
+class trajectory
+{
+public:
+		trajectory();
+		~trajectory();
+
+		void Start(simWorld *world, const char *scene, int every);
+		void Record(simWorld *world, int step);
+		bool Write(char *filename);
+		bool Read(char *filename);
+		void Clear();
+		bool SameBodies(const trajectory &other);
+
+		static void Compare(const trajectory &a, int sampleA, const trajectory &b, int sampleB, trajectoryDivergence *divergence);
+
+		char scene[32];
+		int numBodies;
+		int every;
+		int *numVertices;				// Vertices of every body, in the order of the list of bodies
+		int numSamples;
+		int *steps;						// Timestep of every sample
+		double *times;					// Simulated time of every sample
+		double *values;					// numBodies * TRAJECTORYVALUES doubles per sample
+
+protected:
+		int capacity;					// Samples allocated
+};
+
+#endif
@@ -16,7 +16,7 @@ void control_cb(int control)
 		case MODE:
 			if (iMouseModel != -1)
 			{
-				temp = phyzxModels;
+				temp = gWorld.models;
 				while(temp->next != NULL)
 				{
 					if(temp->mIndex == iMouseModel)
@@ -40,27 +40,33 @@ void control_cb(int control)
 		case TSTEP:
 			if (gTStep < 0.0)
 				gTStep = 0.001;
-			temp = phyzxModels;
+			gSim.Lock();
+			temp = gWorld.models;
 			while(temp->next != NULL)
 			{
 				temp->pObj->h = gTStep;
 				temp = temp->next;
 			}
+			gWorld.WakeModels();
+			gSim.Unlock();
 			break;
 		case NSTEP:
 			if (gNStep < 1)
 				gNStep = 1;
-			temp = phyzxModels;
+			gSim.Lock();
+			temp = gWorld.models;
 			while(temp->next != NULL)
 			{
 				temp->pObj->n = gNStep;
 				temp = temp->next;
 			}
+			gWorld.WakeModels();
+			gSim.Unlock();
 			break;
 		case KCOL:
 			if (iMouseModel != -1)
 			{
-				temp = phyzxModels;
+				temp = gWorld.models;
 				while(temp->next != NULL)
 				{
 					if(temp->mIndex == iMouseModel)
@@ -75,7 +81,7 @@ void control_cb(int control)
 		case KDAMP:
 			if (iMouseModel != -1)
 			{
-				temp = phyzxModels;
+				temp = gWorld.models;
 				while(temp->next != NULL)
 				{
 					if(temp->mIndex == iMouseModel)
@@ -94,7 +100,7 @@ void control_cb(int control)
 				gAlpha = 1.0;
 			if (iMouseModel != -1)
 			{
-				temp = phyzxModels;
+				temp = gWorld.models;
 				while(temp->next != NULL)
 				{
 					if(temp->mIndex == iMouseModel)
@@ -113,7 +119,7 @@ void control_cb(int control)
 				gBeta = 1.0;
 			if (iMouseModel != -1)
 			{
-				temp = phyzxModels;
+				temp = gWorld.models;
 				while(temp->next != NULL)
 				{
 					if(temp->mIndex == iMouseModel)
@@ -132,7 +138,7 @@ void control_cb(int control)
 				gDelta = 1.0;
 			if (iMouseModel != -1)
 			{
-				temp = phyzxModels;
+				temp = gWorld.models;
 				while(temp->next != NULL)
 				{
 					if(temp->mIndex == iMouseModel)
@@ -184,12 +190,13 @@ void control_cb(int control)
 }
 
 /* Function: setGlobal
- * Description: Applies the user input into the physics calculations.
+ * Description: Applies the user input into the physics calculations, and wakes the object up.
  * Input: phyzxObj - Physics information for an object
  * Output: None
  */
 void setGlobal(phyzx *phyzxObj)
 {
+	gSim.Lock();
 	phyzxObj->h = gTStep;
 	phyzxObj->n = gNStep;
 	phyzxObj->kWall = gKCol;
@@ -198,6 +205,8 @@ void setGlobal(phyzx *phyzxObj)
 	phyzxObj->beta = gBeta;
 	phyzxObj->delta = gDelta;
 	phyzxObj->deformMode = gDeformMode;
+	WakeModel(phyzxObj);
+	gSim.Unlock();
 } //end setGlobal
 
 /* Function: dispPhysics
@@ -275,6 +284,7 @@ void createGLUI()
 
 			glui->add_checkbox_to_panel( environ_panel, "World Axis", &axis );
 				glui->add_checkbox_to_panel( environ_panel, "Sticky Floor", &stickyFloor );
+				glui->add_checkbox_to_panel( environ_panel, "Rest Files", &restFiles );
 			
 			glui->add_separator_to_panel(main_panel);
 
@@ -3,6 +3,11 @@
  * Description: Contains vector mathematics functions.
  */
 
+#include <stdlib.h>
+#include <string.h>
+#ifdef WIN32
+#include <malloc.h>
+#endif
 #include "vector.h"
 
 /* Function: pArrayInit
@@ -23,6 +28,113 @@ void pArrayInit(struct pArray *pA, int size)
 	} //end for
 } //end pArrayInit
 
+/* Function: soaStride
+ * Description: Rounds a number of points up to the padded length of a structure of arrays
+ * Input: size - Number of points
+ * Output: Padded number of points
+ */
+int soaStride(int size)
+{
+	return ((size + SOAWIDTH - 1) / SOAWIDTH) * SOAWIDTH;
+} //end soaStride
+
+/* Function: soaAlloc
+ * Description: Allocates a zeroed array of doubles aligned and padded to SOAWIDTH
+ * Input: size - Number of values
+ * Output: Pointer to the array, to be freed with soaRelease
+ */
+double * soaAlloc(int size)
+{
+	void *data = NULL;
+	size_t bytes = sizeof(double) * (size_t)soaStride(size > 0 ? size : 1);
+
+#ifdef WIN32
+	data = _aligned_malloc(bytes, SOAWIDTH * sizeof(double));
+#else
+	if (posix_memalign(&data, SOAWIDTH * sizeof(double), bytes) != 0)
+		data = NULL;
+#endif
+	if (data == NULL)
+	{
+		fprintf(stderr, "soaAlloc: Can't allocate %d bytes of memory, aborting\n", (int)bytes);
+		exit(1);
+	}
+	memset(data, 0, bytes);
+
+	return (double *)data;
+} //end soaAlloc
+
+/* Function: soaRelease
+ * Description: Frees an array allocated with soaAlloc
+ * Input: data - Array of doubles
+ * Output: Nothing
+ */
+void soaRelease(double *data)
+{
+#ifdef WIN32
+	_aligned_free(data);
+#else
+	free(data);
+#endif
+} //end soaRelease
+
+/* Function: soaInit
+ * Description: Allocates the three arrays of a structure of arrays
+ * Input: sV - Structure of arrays
+ *        size - Number of points
+ * Output: Nothing
+ */
+void soaInit(struct soaVec *sV, int size)
+{
+	(*sV).x = soaAlloc(size);
+	(*sV).y = soaAlloc(size);
+	(*sV).z = soaAlloc(size);
+} //end soaInit
+
+/* Function: soaFree
+ * Description: Frees the three arrays of a structure of arrays
+ * Input: sV - Structure of arrays
+ * Output: Nothing
+ */
+void soaFree(struct soaVec *sV)
+{
+	soaRelease((*sV).x);
+	soaRelease((*sV).y);
+	soaRelease((*sV).z);
+	(*sV).x = (*sV).y = (*sV).z = NULL;
+} //end soaFree
+
+/* Function: soaGet
+ * Description: Reads one point out of a structure of arrays
+ * Input: sV - Structure of arrays
+ *        index - Index of the point
+ * Output: returns the point
+ */
+point soaGet(struct soaVec sV, int index)
+{
+	point p;
+
+	p.x = sV.x[index];
+	p.y = sV.y[index];
+	p.z = sV.z[index];
+
+	return p;
+} //end soaGet
+
+/* Function: soaSet
+ * Description: Writes one point into a structure of arrays
+ * Input: sV - Structure of arrays
+ *        index - Index of the point
+ *        p - Point to be stored
+ * Output: Nothing
+ */
+void soaSet(struct soaVec sV, int index, point p)
+{
+	sV.x[index] = p.x;
+	sV.y[index] = p.y;
+	sV.z[index] = p.z;
+} //end soaSet
+
 /* Function: pDisp
  * Description: Displays the coordinates of a point
  * Input: name - Name of point
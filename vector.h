@@ -24,6 +24,18 @@ struct pArray
 	point *p;
 };
 
+// number of doubles every structure of arrays is padded to (one 64 byte cache line)
+#define SOAWIDTH 8
+
+// data structure for a 3D quantity of many points stored as a structure of arrays
+// x, y and z are each aligned to SOAWIDTH doubles and padded with zeros to a multiple of it
+struct soaVec
+{
+	double *x;
+	double *y;
+	double *z;
+};
+
 /***********************************  VECTOR MATHEMATICS ****************************************/
 
 // computes crossproduct of three vectors, which are given as points
@@ -90,6 +102,13 @@ struct pArray
 
 /*** Functions ***/
 void pArrayInit(struct pArray *pA, int size);
+int soaStride(int size);
+double * soaAlloc(int size);
+void soaRelease(double *data);
+void soaInit(struct soaVec *sV, int size);
+void soaFree(struct soaVec *sV);
+point soaGet(struct soaVec sV, int index);
+void soaSet(struct soaVec sV, int index, point p);
 void pDisp(char *name, point p);
 void vecDisp(point p1);
 point vMake(float val);